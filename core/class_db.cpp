@@ -265,6 +265,7 @@ ClassDB::ClassInfo::ClassInfo() {
 	inherits_ptr = NULL;
 	disabled = false;
 	exposed = false;
+	class_ptr = NULL;
 }
 
 ClassDB::ClassInfo::~ClassInfo() {
@@ -285,6 +286,16 @@ bool ClassDB::is_parent_class(const StringName &p_class, const StringName &p_inh
 
 	return false;
 }
+
+void *ClassDB::get_class_ptr(const StringName &p_class) {
+
+	OBJTYPE_RLOCK;
+
+	ClassInfo *ti = classes.getptr(p_class);
+	ERR_FAIL_COND_V(!ti, NULL);
+	return ti->class_ptr;
+}
+
 void ClassDB::get_class_list(List<StringName> *p_classes) {
 
 	OBJTYPE_RLOCK;
@@ -548,7 +559,7 @@ bool ClassDB::can_instance(const StringName &p_class) {
 	return (!ti->disabled && ti->creation_func != NULL);
 }
 
-void ClassDB::_add_class2(const StringName &p_class, const StringName &p_inherits) {
+void ClassDB::_add_class2(const StringName &p_class, const StringName &p_inherits, void *p_class_ptr) {
 
 	OBJTYPE_WLOCK;
 
@@ -561,6 +572,7 @@ void ClassDB::_add_class2(const StringName &p_class, const StringName &p_inherit
 	ti.name = name;
 	ti.inherits = p_inherits;
 	ti.api = current_api;
+	ti.class_ptr = p_class_ptr;
 
 	if (ti.inherits) {
 
@@ -136,6 +136,7 @@ public:
 		StringName name;
 		bool disabled;
 		bool exposed;
+		void *class_ptr;
 		Object *(*creation_func)();
 		ClassInfo();
 		~ClassInfo();
@@ -159,7 +160,7 @@ public:
 
 	static APIType current_api;
 
-	static void _add_class2(const StringName &p_class, const StringName &p_inherits);
+	static void _add_class2(const StringName &p_class, const StringName &p_inherits, void *p_class_ptr);
 
 	static HashMap<StringName, HashMap<StringName, Variant> > default_values;
 
@@ -168,7 +169,7 @@ public:
 	template <class T>
 	static void _add_class() {
 
-		_add_class2(T::get_class_static(), T::get_parent_class_static());
+		_add_class2(T::get_class_static(), T::get_parent_class_static(), T::get_class_ptr_static());
 	}
 
 	template <class T>
@@ -219,6 +220,7 @@ public:
 	static StringName get_parent_class(const StringName &p_class);
 	static bool class_exists(const StringName &p_class);
 	static bool is_parent_class(const StringName &p_class, const StringName &p_inherits);
+	static void *get_class_ptr(const StringName &p_class);
 	static bool can_instance(const StringName &p_class);
 	static Object *instance(const StringName &p_class);
 	static APIType get_api_type(const StringName &p_class);
@@ -0,0 +1,138 @@
+/*************************************************************************/
+/*  frame_vector.h                                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef FRAME_VECTOR_H
+#define FRAME_VECTOR_H
+
+#include "core/error_macros.h"
+#include "core/os/frame_allocator.h"
+#include "core/os/memory.h"
+
+/**
+ * Growable array in frame memory, for temporaries built and dropped within
+ * the frame. Unlike Vector it is not shared or copy-on-write, so it can't
+ * be copied; copy the elements out if they have to outlive it.
+ */
+template <class T>
+class FrameVector {
+
+	T *data;
+	int count;
+	int capacity;
+
+	FrameVector(const FrameVector &);
+	void operator=(const FrameVector &);
+
+public:
+	_FORCE_INLINE_ int size() const { return count; }
+	_FORCE_INLINE_ bool empty() const { return count == 0; }
+
+	_FORCE_INLINE_ T *ptr() { return data; }
+	_FORCE_INLINE_ const T *ptr() const { return data; }
+
+	_FORCE_INLINE_ T &operator[](int p_index) {
+
+		CRASH_BAD_INDEX(p_index, count);
+		return data[p_index];
+	}
+
+	_FORCE_INLINE_ const T &operator[](int p_index) const {
+
+		CRASH_BAD_INDEX(p_index, count);
+		return data[p_index];
+	}
+
+	void reserve(int p_capacity) {
+
+		if (p_capacity <= capacity)
+			return;
+
+		T *mem = (T *)FrameAllocator::realloc(data, sizeof(T) * p_capacity);
+		ERR_FAIL_COND(!mem);
+		data = mem;
+		capacity = p_capacity;
+	}
+
+	_FORCE_INLINE_ void push_back(const T &p_elem) {
+
+		if (unlikely(count == capacity)) {
+			reserve(MAX(capacity * 2, 8));
+		}
+
+		memnew_placement(&data[count], T(p_elem));
+		count++;
+	}
+
+	void resize(int p_size) {
+
+		ERR_FAIL_COND(p_size < 0);
+
+		if (p_size > count) {
+
+			reserve(p_size);
+			if (!__has_trivial_constructor(T)) {
+				for (int i = count; i < p_size; i++) {
+					memnew_placement(&data[i], T);
+				}
+			}
+		} else if (!__has_trivial_destructor(T)) {
+
+			for (int i = p_size; i < count; i++) {
+				data[i].~T();
+			}
+		}
+
+		count = p_size;
+	}
+
+	void invert() {
+
+		for (int i = 0; i < count / 2; i++) {
+			SWAP(data[i], data[count - i - 1]);
+		}
+	}
+
+	_FORCE_INLINE_ void clear() { resize(0); }
+
+	_FORCE_INLINE_ FrameVector() {
+
+		data = NULL;
+		count = 0;
+		capacity = 0;
+	}
+
+	_FORCE_INLINE_ ~FrameVector() {
+
+		clear();
+		FrameAllocator::free(data);
+	}
+};
+
+#endif // FRAME_VECTOR_H
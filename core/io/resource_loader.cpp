@@ -389,6 +389,13 @@ RES ResourceLoader::load(const String &p_path, const String &p_type_hint, bool p
 		if (ResourceCache::lock) {
 			ResourceCache::lock->read_unlock();
 		}
+
+		//being loaded in the background by another thread, share the result
+		RES loaded;
+		if (_wait_for_threaded_load(local_path, &loaded, r_error)) {
+			_remove_from_loading_map(local_path);
+			return loaded;
+		}
 	}
 
 	bool xl_remapped = false;
@@ -397,6 +404,7 @@ RES ResourceLoader::load(const String &p_path, const String &p_type_hint, bool p
 	if (path == "") {
 		if (!p_no_cache) {
 			_remove_from_loading_map(local_path);
+			_finish_threaded_load(local_path, RES(), ERR_FILE_BAD_PATH);
 		}
 		ERR_EXPLAIN("Remapping '" + local_path + "'failed.");
 		ERR_FAIL_V(RES());
@@ -408,6 +416,7 @@ RES ResourceLoader::load(const String &p_path, const String &p_type_hint, bool p
 	if (res.is_null()) {
 		if (!p_no_cache) {
 			_remove_from_loading_map(local_path);
+			_finish_threaded_load(local_path, RES(), r_error ? *r_error : ERR_CANT_ACQUIRE_RESOURCE);
 		}
 		return RES();
 	}
@@ -429,6 +438,7 @@ RES ResourceLoader::load(const String &p_path, const String &p_type_hint, bool p
 
 	if (!p_no_cache) {
 		_remove_from_loading_map(local_path);
+		_finish_threaded_load(local_path, res, OK);
 	}
 
 	if (_loaded_callback) {
@@ -438,6 +448,471 @@ RES ResourceLoader::load(const String &p_path, const String &p_type_hint, bool p
 	return res;
 }
 
+/* Background loading.
+
+   Each requested path gets a task, shared by every request of that path.
+   Worker threads pick queued tasks and load them with load(). load() itself
+   checks the tasks, so whichever thread asks for a path first (a worker, a
+   sub-resource load inside another task or a regular load() on the main
+   thread) claims the task and loads it, the others wait and share the
+   result. A queued task is never waited on, it gets claimed instead, so
+   dependencies can't starve the pool. */
+
+void ResourceLoader::_thread_load_function(void *p_userdata) {
+
+	while (true) {
+
+		thread_load_semaphore->wait();
+
+		thread_load_mutex->lock();
+		if (thread_load_exit) {
+			thread_load_mutex->unlock();
+			break;
+		}
+		if (thread_load_queue.empty()) {
+			thread_load_mutex->unlock();
+			continue;
+		}
+		String path = thread_load_queue.front()->get();
+		thread_load_queue.pop_front();
+		thread_load_mutex->unlock();
+
+		_run_thread_load_task(path);
+	}
+}
+
+void ResourceLoader::_run_thread_load_task(const String &p_path) {
+
+	thread_load_mutex->lock();
+
+	ThreadLoadTask **tptr = thread_load_tasks.getptr(p_path);
+	if (!tptr || (*tptr)->started) {
+		//released, or already claimed by a thread that needed it
+		thread_load_mutex->unlock();
+		return;
+	}
+
+	ThreadLoadTask *task = *tptr;
+	task->started = true;
+	task->loader_id = Thread::get_caller_id();
+	String type_hint = task->type_hint;
+	bool use_sub_threads = task->use_sub_threads;
+
+	thread_load_mutex->unlock();
+
+	if (use_sub_threads) {
+
+		//queue dependencies first, so other threads can load them while this one parses
+		List<String> deps;
+		get_dependencies(p_path, &deps, true);
+
+		Vector<String> sub_tasks;
+		for (List<String>::Element *E = deps.front(); E; E = E->next()) {
+
+			String dep = E->get();
+			String dep_type;
+			if (dep.find("::") != -1) {
+				dep_type = dep.get_slice("::", 1);
+				dep = dep.get_slice("::", 0);
+			}
+			dep = dep.is_rel_path() ? "res://" + dep : ProjectSettings::get_singleton()->localize_path(dep);
+
+			if (_request_threaded_load(dep, dep_type, true, false) == OK) {
+				sub_tasks.push_back(dep);
+			}
+		}
+
+		thread_load_mutex->lock();
+		task->sub_tasks = sub_tasks; //task can't be freed while in progress
+		thread_load_mutex->unlock();
+	}
+
+	Error err = OK;
+	RES res = load(p_path, type_hint, false, &err);
+
+	//no-op if load() already finished it, but it doesn't when the resource was cached
+	_finish_threaded_load(p_path, res, err);
+}
+
+Error ResourceLoader::_request_threaded_load(const String &p_path, const String &p_type_hint, bool p_use_sub_threads, bool p_notify) {
+
+	ERR_FAIL_COND_V(!thread_load_mutex, ERR_UNAVAILABLE);
+
+	thread_load_mutex->lock();
+
+	if (!thread_load_initialized) {
+
+		thread_load_initialized = true;
+		thread_load_exit = false;
+		thread_load_semaphore = Semaphore::create();
+
+		int thread_count = GLOBAL_GET("application/run/resource_loader_threads");
+		for (int i = 0; i < thread_count && thread_load_semaphore; i++) {
+			Thread *thread = Thread::create(_thread_load_function, NULL);
+			if (!thread)
+				break;
+			thread_load_threads.push_back(thread);
+		}
+	}
+
+	ThreadLoadTask **tptr = thread_load_tasks.getptr(p_path);
+	if (tptr) {
+
+		(*tptr)->request_count++;
+		if (p_notify) {
+			(*tptr)->notify = true;
+		}
+		thread_load_mutex->unlock();
+		return OK;
+	}
+
+	ThreadLoadTask *task = memnew(ThreadLoadTask);
+	task->local_path = p_path;
+	task->type_hint = p_type_hint;
+	task->started = false;
+	task->loader_id = 0;
+	task->semaphore = Semaphore::create();
+	task->awaiters_count = 0;
+	task->request_count = 1;
+	task->use_sub_threads = p_use_sub_threads;
+	task->notify = p_notify;
+	task->status = THREAD_LOAD_IN_PROGRESS;
+	task->error = OK;
+	thread_load_tasks[p_path] = task;
+
+	bool cached = ResourceCache::has(p_path);
+	if (cached) {
+		task->started = true;
+		task->loader_id = Thread::get_caller_id();
+	} else if (thread_load_threads.size()) {
+		thread_load_queue.push_back(p_path);
+		thread_load_semaphore->post();
+	}
+
+	thread_load_mutex->unlock();
+
+	if (cached) {
+		_finish_threaded_load(p_path, ResourceCache::get(p_path), OK);
+	} else if (thread_load_threads.empty()) {
+		//no threads available, load right away
+		_run_thread_load_task(p_path);
+	}
+
+	return OK;
+}
+
+bool ResourceLoader::_wait_for_threaded_load(const String &p_path, RES *r_resource, Error *r_error) {
+
+	if (!thread_load_mutex) {
+		return false;
+	}
+
+	thread_load_mutex->lock();
+
+	ThreadLoadTask **tptr = thread_load_tasks.getptr(p_path);
+	if (!tptr) {
+		//the task may have finished and been released after the caller checked the cache
+		RES cached(ResourceCache::get(p_path));
+		thread_load_mutex->unlock();
+		if (cached.is_null()) {
+			return false;
+		}
+		*r_resource = cached;
+		if (r_error) {
+			*r_error = OK;
+		}
+		return true;
+	}
+
+	ThreadLoadTask *task = *tptr;
+
+	if (task->status == THREAD_LOAD_FAILED) {
+		//let the caller try on its own, and report its own error
+		thread_load_mutex->unlock();
+		return false;
+	}
+
+	if (task->status == THREAD_LOAD_LOADED) {
+		//finished after the caller checked the cache, share it instead of loading it again
+		*r_resource = task->resource;
+		if (r_error) {
+			*r_error = task->error;
+		}
+		thread_load_mutex->unlock();
+		return true;
+	}
+
+	Thread::ID caller = Thread::get_caller_id();
+
+	if (!task->started) {
+		//claim it, the caller loads it and load() publishes the result
+		task->started = true;
+		task->loader_id = caller;
+		thread_load_mutex->unlock();
+		return false;
+	}
+
+	if (task->loader_id == caller) {
+		thread_load_mutex->unlock();
+		return false;
+	}
+
+	//make sure the loading thread is not (indirectly) waiting for this one
+	Thread::ID waiting_id = task->loader_id;
+	for (uint32_t i = 0; i <= thread_load_waiting.size(); i++) {
+		ThreadLoadTask **wptr = thread_load_waiting.getptr(waiting_id);
+		if (!wptr) {
+			break;
+		}
+		waiting_id = (*wptr)->loader_id;
+		if (waiting_id == caller) {
+			thread_load_mutex->unlock();
+			if (r_error) {
+				*r_error = ERR_CYCLIC_LINK;
+			}
+			ERR_EXPLAIN("Resource: '" + p_path + "' is already being loaded. Cyclic reference?");
+			ERR_FAIL_V(true);
+		}
+	}
+
+	task->awaiters_count++;
+	thread_load_waiting[caller] = task;
+	thread_load_mutex->unlock();
+
+	task->semaphore->wait();
+
+	thread_load_mutex->lock();
+	thread_load_waiting.erase(caller);
+	task->awaiters_count--;
+	*r_resource = task->resource;
+	if (r_error) {
+		*r_error = task->error;
+	}
+	_release_thread_load_task(task);
+	thread_load_mutex->unlock();
+
+	return true;
+}
+
+void ResourceLoader::_finish_threaded_load(const String &p_path, const RES &p_resource, Error p_error) {
+
+	if (!thread_load_mutex) {
+		return;
+	}
+
+	thread_load_mutex->lock();
+
+	ThreadLoadTask **tptr = thread_load_tasks.getptr(p_path);
+	if (!tptr || !(*tptr)->started || (*tptr)->loader_id != Thread::get_caller_id() || (*tptr)->status != THREAD_LOAD_IN_PROGRESS) {
+		thread_load_mutex->unlock();
+		return;
+	}
+
+	ThreadLoadTask *task = *tptr;
+	task->resource = p_resource;
+	if (p_resource.is_valid()) {
+		task->status = THREAD_LOAD_LOADED;
+		task->error = OK;
+	} else {
+		task->status = THREAD_LOAD_FAILED;
+		task->error = p_error != OK ? p_error : ERR_CANT_ACQUIRE_RESOURCE;
+	}
+	Error error = task->error;
+
+	for (int i = 0; i < task->awaiters_count; i++) {
+		task->semaphore->post();
+	}
+
+	bool notify = task->notify;
+
+	//dependencies were only requested to have them loaded in parallel
+	Vector<String> sub_tasks = task->sub_tasks;
+	task->sub_tasks.clear();
+	for (int i = 0; i < sub_tasks.size(); i++) {
+		ThreadLoadTask **sptr = thread_load_tasks.getptr(sub_tasks[i]);
+		if (sptr) {
+			(*sptr)->request_count--;
+			_release_thread_load_task(*sptr);
+		}
+	}
+
+	_release_thread_load_task(task);
+
+	thread_load_mutex->unlock();
+
+	if (notify && threaded_load_notify) {
+		threaded_load_notify(threaded_load_notify_ud, p_path, error);
+	}
+}
+
+void ResourceLoader::_release_thread_load_task(ThreadLoadTask *p_task) {
+
+	//must be called with thread_load_mutex locked, frees the task once nobody needs it
+	if (p_task->status == THREAD_LOAD_IN_PROGRESS || p_task->request_count > 0 || p_task->awaiters_count > 0) {
+		return;
+	}
+
+	thread_load_tasks.erase(p_task->local_path);
+	memdelete(p_task->semaphore);
+	memdelete(p_task);
+}
+
+Error ResourceLoader::load_threaded_request(const String &p_path, const String &p_type_hint, bool p_use_sub_threads) {
+
+	String local_path;
+	if (p_path.is_rel_path())
+		local_path = "res://" + p_path;
+	else
+		local_path = ProjectSettings::get_singleton()->localize_path(p_path);
+
+	return _request_threaded_load(local_path, p_type_hint, p_use_sub_threads, true);
+}
+
+ResourceLoader::ThreadLoadStatus ResourceLoader::load_threaded_get_status(const String &p_path, float *r_progress) {
+
+	if (!thread_load_mutex) {
+		return THREAD_LOAD_INVALID_RESOURCE;
+	}
+
+	String local_path;
+	if (p_path.is_rel_path())
+		local_path = "res://" + p_path;
+	else
+		local_path = ProjectSettings::get_singleton()->localize_path(p_path);
+
+	thread_load_mutex->lock();
+
+	ThreadLoadTask **tptr = thread_load_tasks.getptr(local_path);
+	if (!tptr) {
+		thread_load_mutex->unlock();
+		return THREAD_LOAD_INVALID_RESOURCE;
+	}
+
+	ThreadLoadTask *task = *tptr;
+	ThreadLoadStatus status = task->status;
+
+	if (r_progress) {
+		if (status != THREAD_LOAD_IN_PROGRESS) {
+			*r_progress = 1.0;
+		} else {
+			//each finished dependency counts as a step, the resource itself as the last one
+			int done = 0;
+			for (int i = 0; i < task->sub_tasks.size(); i++) {
+				ThreadLoadTask **sptr = thread_load_tasks.getptr(task->sub_tasks[i]);
+				if (!sptr || (*sptr)->status != THREAD_LOAD_IN_PROGRESS) {
+					done++;
+				}
+			}
+			*r_progress = float(done) / float(task->sub_tasks.size() + 1);
+		}
+	}
+
+	thread_load_mutex->unlock();
+
+	return status;
+}
+
+RES ResourceLoader::load_threaded_get(const String &p_path, Error *r_error) {
+
+	if (r_error)
+		*r_error = ERR_INVALID_PARAMETER;
+
+	ERR_FAIL_COND_V(!thread_load_mutex, RES());
+
+	String local_path;
+	if (p_path.is_rel_path())
+		local_path = "res://" + p_path;
+	else
+		local_path = ProjectSettings::get_singleton()->localize_path(p_path);
+
+	thread_load_mutex->lock();
+
+	ThreadLoadTask **tptr = thread_load_tasks.getptr(local_path);
+	if (!tptr) {
+		thread_load_mutex->unlock();
+		ERR_EXPLAIN("Resource: '" + local_path + "' was not requested with load_threaded_request().");
+		ERR_FAIL_V(RES());
+	}
+
+	if ((*tptr)->status == THREAD_LOAD_IN_PROGRESS) {
+
+		//block until done, loading it on this thread if no worker took it yet
+		String type_hint = (*tptr)->type_hint;
+		thread_load_mutex->unlock();
+
+		Error err = OK;
+		RES res = load(local_path, type_hint, false, &err);
+
+		thread_load_mutex->lock();
+		tptr = thread_load_tasks.getptr(local_path); //still requested, can't be freed
+		ERR_FAIL_COND_V(!tptr, RES());
+
+		if ((*tptr)->status == THREAD_LOAD_IN_PROGRESS) {
+			//load() failed before it could reach the task (ie, cyclic load on this thread)
+			(*tptr)->request_count--;
+			thread_load_mutex->unlock();
+			if (r_error)
+				*r_error = err;
+			return res;
+		}
+	}
+
+	ThreadLoadTask *task = *tptr;
+	RES res = task->resource;
+	if (r_error)
+		*r_error = task->error;
+
+	task->request_count--;
+	_release_thread_load_task(task);
+
+	thread_load_mutex->unlock();
+
+	return res;
+}
+
+void ResourceLoader::clear_thread_load_tasks() {
+
+	if (!thread_load_mutex) {
+		return;
+	}
+
+	thread_load_mutex->lock();
+	if (!thread_load_initialized) {
+		thread_load_mutex->unlock();
+		return;
+	}
+	thread_load_exit = true;
+	thread_load_queue.clear();
+	thread_load_mutex->unlock();
+
+	//tasks already started are finished, there's no way to interrupt a loader
+	for (int i = 0; i < thread_load_threads.size(); i++) {
+		thread_load_semaphore->post();
+	}
+	for (int i = 0; i < thread_load_threads.size(); i++) {
+		Thread::wait_to_finish(thread_load_threads[i]);
+		memdelete(thread_load_threads[i]);
+	}
+	thread_load_threads.clear();
+
+	thread_load_mutex->lock();
+	const String *K = NULL;
+	while ((K = thread_load_tasks.next(K))) {
+		ThreadLoadTask *task = thread_load_tasks[*K];
+		memdelete(task->semaphore);
+		memdelete(task);
+	}
+	thread_load_tasks.clear();
+	thread_load_waiting.clear();
+
+	if (thread_load_semaphore) {
+		memdelete(thread_load_semaphore);
+		thread_load_semaphore = NULL;
+	}
+	thread_load_initialized = false;
+	thread_load_mutex->unlock();
+}
+
 bool ResourceLoader::exists(const String &p_path, const String &p_type_hint) {
 
 	String local_path;
@@ -996,14 +1471,31 @@ void ResourceLoader::remove_custom_loaders() {
 Mutex *ResourceLoader::loading_map_mutex = NULL;
 HashMap<ResourceLoader::LoadingMapKey, int, ResourceLoader::LoadingMapKeyHasher> ResourceLoader::loading_map;
 
+Mutex *ResourceLoader::thread_load_mutex = NULL;
+Semaphore *ResourceLoader::thread_load_semaphore = NULL;
+HashMap<String, ResourceLoader::ThreadLoadTask *> ResourceLoader::thread_load_tasks;
+HashMap<Thread::ID, ResourceLoader::ThreadLoadTask *> ResourceLoader::thread_load_waiting;
+List<String> ResourceLoader::thread_load_queue;
+Vector<Thread *> ResourceLoader::thread_load_threads;
+bool ResourceLoader::thread_load_initialized = false;
+bool ResourceLoader::thread_load_exit = false;
+
+void *ResourceLoader::threaded_load_notify_ud = NULL;
+ResourceThreadedLoadNotify ResourceLoader::threaded_load_notify = NULL;
+
 void ResourceLoader::initialize() {
 #ifndef NO_THREADS
 	loading_map_mutex = Mutex::create();
+	thread_load_mutex = Mutex::create();
 #endif
 }
 
 void ResourceLoader::finalize() {
 #ifndef NO_THREADS
+	clear_thread_load_tasks();
+	memdelete(thread_load_mutex);
+	thread_load_mutex = NULL;
+
 	const LoadingMapKey *K = NULL;
 	while ((K = loading_map.next(K))) {
 		ERR_PRINTS("Exited while resource is being loaded: " + K->path);
@@ -31,6 +31,7 @@
 #ifndef RESOURCE_LOADER_H
 #define RESOURCE_LOADER_H
 
+#include "core/os/semaphore.h"
 #include "core/os/thread.h"
 #include "core/resource.h"
 /**
@@ -91,6 +92,7 @@ typedef void (*DependencyErrorNotify)(void *p_ud, const String &p_loading, const
 
 typedef Error (*ResourceLoaderImport)(const String &p_path);
 typedef void (*ResourceLoadedCallback)(RES p_resource, const String &p_path);
+typedef void (*ResourceThreadedLoadNotify)(void *p_ud, const String &p_path, Error p_error);
 
 class ResourceLoader {
 
@@ -98,6 +100,16 @@ class ResourceLoader {
 		MAX_LOADERS = 64
 	};
 
+public:
+	enum ThreadLoadStatus {
+		THREAD_LOAD_INVALID_RESOURCE,
+		THREAD_LOAD_IN_PROGRESS,
+		THREAD_LOAD_FAILED,
+		THREAD_LOAD_LOADED
+	};
+
+private:
+
 	static Ref<ResourceFormatLoader> loader[MAX_LOADERS];
 	static int loader_count;
 	static bool timestamp_on_load;
@@ -144,11 +156,58 @@ class ResourceLoader {
 	static void _remove_from_loading_map(const String &p_path);
 	static void _remove_from_loading_map_and_thread(const String &p_path, Thread::ID p_thread);
 
+	//background loading, tasks are shared by all requests of the same path
+	struct ThreadLoadTask {
+		String local_path;
+		String type_hint;
+		bool started;
+		Thread::ID loader_id; //valid once started
+		Semaphore *semaphore; //posted once per awaiter when finished
+		int awaiters_count;
+		int request_count; //requests not yet released by load_threaded_get()
+		bool use_sub_threads;
+		bool notify;
+		ThreadLoadStatus status;
+		Error error;
+		RES resource;
+		Vector<String> sub_tasks; //dependencies requested for this task
+	};
+
+	static Mutex *thread_load_mutex;
+	static Semaphore *thread_load_semaphore;
+	static HashMap<String, ThreadLoadTask *> thread_load_tasks;
+	static HashMap<Thread::ID, ThreadLoadTask *> thread_load_waiting; //used to detect cyclic waits
+	static List<String> thread_load_queue;
+	static Vector<Thread *> thread_load_threads;
+	static bool thread_load_initialized;
+	static bool thread_load_exit;
+
+	static void *threaded_load_notify_ud;
+	static ResourceThreadedLoadNotify threaded_load_notify;
+
+	static void _thread_load_function(void *p_userdata);
+	static void _run_thread_load_task(const String &p_path);
+	static Error _request_threaded_load(const String &p_path, const String &p_type_hint, bool p_use_sub_threads, bool p_notify);
+	static bool _wait_for_threaded_load(const String &p_path, RES *r_resource, Error *r_error);
+	static void _finish_threaded_load(const String &p_path, const RES &p_resource, Error p_error);
+	static void _release_thread_load_task(ThreadLoadTask *p_task);
+
 public:
 	static Ref<ResourceInteractiveLoader> load_interactive(const String &p_path, const String &p_type_hint = "", bool p_no_cache = false, Error *r_error = NULL);
 	static RES load(const String &p_path, const String &p_type_hint = "", bool p_no_cache = false, Error *r_error = NULL);
 	static bool exists(const String &p_path, const String &p_type_hint = "");
 
+	static Error load_threaded_request(const String &p_path, const String &p_type_hint = "", bool p_use_sub_threads = false);
+	static ThreadLoadStatus load_threaded_get_status(const String &p_path, float *r_progress = NULL);
+	static RES load_threaded_get(const String &p_path, Error *r_error = NULL);
+	static void clear_thread_load_tasks();
+
+	//called from the thread that finished loading
+	static void set_threaded_load_notify_func(void *p_ud, ResourceThreadedLoadNotify p_notify) {
+		threaded_load_notify = p_notify;
+		threaded_load_notify_ud = p_ud;
+	}
+
 	static void get_recognized_extensions_for_type(const String &p_type, List<String> *p_extensions);
 	static void add_resource_format_loader(Ref<ResourceFormatLoader> p_format_loader, bool p_at_front = false);
 	static void remove_resource_format_loader(Ref<ResourceFormatLoader> p_format_loader);
@@ -31,16 +31,86 @@
 #include "a_star.h"
 
 #include "core/math/geometry.h"
+#include "core/os/thread_work_pool.h"
+#include "core/project_settings.h"
 #include "core/script_language.h"
+#include "core/sort_array.h"
 #include "scene/scene_string_names.h"
 
+ThreadWorkPool *AStar::path_pool = NULL;
+Mutex *AStar::path_pool_lock = NULL;
+
+void AStar::SearchState::prepare(int p_point_count) {
+
+	int from = open_pass.size();
+	if (from >= p_point_count)
+		return;
+
+	open_pass.resize(p_point_count);
+	closed_pass.resize(p_point_count);
+	g_score.resize(p_point_count);
+	prev.resize(p_point_count);
+
+	uint32_t *op = open_pass.ptrw();
+	uint32_t *cp = closed_pass.ptrw();
+	for (int i = from; i < p_point_count; i++) {
+		op[i] = 0;
+		cp[i] = 0;
+	}
+}
+
+uint32_t AStar::SearchState::next_pass() {
+
+	pass++;
+	if (pass == 0) {
+		// Wrapped around, forget every mark left by old searches.
+		uint32_t *op = open_pass.ptrw();
+		uint32_t *cp = closed_pass.ptrw();
+		for (int i = 0; i < open_pass.size(); i++) {
+			op[i] = 0;
+			cp[i] = 0;
+		}
+		pass = 1;
+	}
+
+	open_size = 0;
+	return pass;
+}
+
+void AStar::SearchState::push(int p_index, real_t p_f_score) {
+
+	if (open_size == open.size()) {
+		open.resize(MAX(open_size * 2, 64));
+	}
+
+	OpenEntry e;
+	e.f_score = p_f_score;
+	e.index = p_index;
+
+	SortArray<OpenEntry, OpenComparator> sorter;
+	sorter.push_heap(0, open_size, 0, e, open.ptrw());
+	open_size++;
+}
+
+int AStar::SearchState::pop() {
+
+	OpenEntry *o = open.ptrw();
+	int index = o[0].index;
+
+	SortArray<OpenEntry, OpenComparator> sorter;
+	sorter.pop_heap(0, open_size, o);
+	open_size--;
+
+	return index;
+}
+
 int AStar::get_available_point_id() const {
 
-	if (points.empty()) {
+	if (point_list.empty()) {
 		return 1;
 	}
 
-	return points.back()->key() + 1;
+	return max_id + 1;
 }
 
 void AStar::add_point(int p_id, const Vector3 &p_pos, real_t p_weight_scale) {
@@ -51,15 +121,24 @@ void AStar::add_point(int p_id, const Vector3 &p_pos, real_t p_weight_scale) {
 	if (!points.has(p_id)) {
 		Point *pt = memnew(Point);
 		pt->id = p_id;
+		pt->index = point_list.size();
 		pt->pos = p_pos;
 		pt->weight_scale = p_weight_scale;
-		pt->prev_point = NULL;
-		pt->last_pass = 0;
 		pt->enabled = true;
-		points[p_id] = pt;
+		pt->cluster = NULL;
+		pt->portal = false;
+		pt->portal_index = -1;
+		points.set(p_id, pt);
+		point_list.push_back(pt);
+		max_id = MAX(max_id, p_id);
+
+		if (cluster_size > 0) {
+			_add_to_cluster(pt);
+		}
+		_graph_changed();
 	} else {
-		points[p_id]->pos = p_pos;
-		points[p_id]->weight_scale = p_weight_scale;
+		set_point_position(p_id, p_pos);
+		set_point_weight_scale(p_id, p_weight_scale);
 	}
 }
 
@@ -67,21 +146,33 @@ Vector3 AStar::get_point_position(int p_id) const {
 
 	ERR_FAIL_COND_V(!points.has(p_id), Vector3());
 
-	return points[p_id]->pos;
+	return _get_point(p_id)->pos;
 }
 
 void AStar::set_point_position(int p_id, const Vector3 &p_pos) {
 
 	ERR_FAIL_COND(!points.has(p_id));
 
-	points[p_id]->pos = p_pos;
+	Point *p = _get_point(p_id);
+	p->pos = p_pos;
+
+	if (p->cluster && !(_get_cluster_key(p_pos) == p->cluster->key)) {
+		// Moving to another cluster changes which of the neighbours are portals.
+		_make_point_dirty(p, true);
+		_remove_from_cluster(p);
+		_add_to_cluster(p);
+		_make_point_dirty(p, true);
+	} else {
+		_make_point_dirty(p, false);
+	}
+	_graph_changed();
 }
 
 real_t AStar::get_point_weight_scale(int p_id) const {
 
 	ERR_FAIL_COND_V(!points.has(p_id), 0);
 
-	return points[p_id]->weight_scale;
+	return _get_point(p_id)->weight_scale;
 }
 
 void AStar::set_point_weight_scale(int p_id, real_t p_weight_scale) {
@@ -89,27 +180,51 @@ void AStar::set_point_weight_scale(int p_id, real_t p_weight_scale) {
 	ERR_FAIL_COND(!points.has(p_id));
 	ERR_FAIL_COND(p_weight_scale < 1);
 
-	points[p_id]->weight_scale = p_weight_scale;
+	Point *p = _get_point(p_id);
+	p->weight_scale = p_weight_scale;
+
+	_make_point_dirty(p, false);
+	_graph_changed();
 }
 
 void AStar::remove_point(int p_id) {
 
 	ERR_FAIL_COND(!points.has(p_id));
 
-	Point *p = points[p_id];
+	Point *p = _get_point(p_id);
 
-	Map<int, Point *>::Element *PE = points.front();
-	while (PE) {
-		for (Set<Point *>::Element *E = PE->get()->neighbours.front(); E; E = E->next()) {
-			Segment s(p_id, E->get()->id);
-			segments.erase(s);
-			E->get()->neighbours.erase(p);
-		}
-		PE = PE->next();
+	_make_point_dirty(p, true);
+
+	for (int i = 0; i < p->neighbours.size(); i++) {
+		Point *n = p->neighbours[i];
+		segments.erase(Segment(p_id, n->id));
+		n->incoming.erase(p);
+	}
+	for (int i = 0; i < p->incoming.size(); i++) {
+		Point *n = p->incoming[i];
+		segments.erase(Segment(p_id, n->id));
+		n->neighbours.erase(p);
 	}
 
+	_remove_from_cluster(p);
+
+	// Keep the point list compact, so it can index the search scratch arrays.
+	int last = point_list.size() - 1;
+	Point *moved = point_list[last];
+	point_list.write[p->index] = moved;
+	moved->index = p->index;
+	point_list.resize(last);
+
 	memdelete(p);
-	points.erase(p_id);
+	points.remove(p_id);
+
+	if (p_id == max_id) {
+		max_id = -1;
+		for (int i = 0; i < point_list.size(); i++) {
+			max_id = MAX(max_id, point_list[i]->id);
+		}
+	}
+	_graph_changed();
 }
 
 void AStar::connect_points(int p_id, int p_with_id, bool bidirectional) {
@@ -118,12 +233,18 @@ void AStar::connect_points(int p_id, int p_with_id, bool bidirectional) {
 	ERR_FAIL_COND(!points.has(p_with_id));
 	ERR_FAIL_COND(p_id == p_with_id);
 
-	Point *a = points[p_id];
-	Point *b = points[p_with_id];
-	a->neighbours.insert(b);
+	Point *a = _get_point(p_id);
+	Point *b = _get_point(p_with_id);
 
-	if (bidirectional)
-		b->neighbours.insert(a);
+	if (a->neighbours.find(b) == -1) {
+		a->neighbours.push_back(b);
+		b->incoming.push_back(a);
+	}
+
+	if (bidirectional && b->neighbours.find(a) == -1) {
+		b->neighbours.push_back(a);
+		a->incoming.push_back(b);
+	}
 
 	Segment s(p_id, p_with_id);
 	if (s.from == p_id) {
@@ -135,6 +256,10 @@ void AStar::connect_points(int p_id, int p_with_id, bool bidirectional) {
 	}
 
 	segments.insert(s);
+
+	_make_point_dirty(a, false);
+	_make_point_dirty(b, false);
+	_graph_changed();
 }
 void AStar::disconnect_points(int p_id, int p_with_id) {
 
@@ -143,10 +268,16 @@ void AStar::disconnect_points(int p_id, int p_with_id) {
 
 	segments.erase(s);
 
-	Point *a = points[p_id];
-	Point *b = points[p_with_id];
+	Point *a = _get_point(p_id);
+	Point *b = _get_point(p_with_id);
 	a->neighbours.erase(b);
+	b->incoming.erase(a);
 	b->neighbours.erase(a);
+	a->incoming.erase(b);
+
+	_make_point_dirty(a, false);
+	_make_point_dirty(b, false);
+	_graph_changed();
 }
 
 bool AStar::has_point(int p_id) const {
@@ -156,13 +287,19 @@ bool AStar::has_point(int p_id) const {
 
 Array AStar::get_points() {
 
-	Array point_list;
+	Vector<int> ids;
+	ids.resize(point_list.size());
+	for (int i = 0; i < point_list.size(); i++) {
+		ids.write[i] = point_list[i]->id;
+	}
+	ids.sort();
 
-	for (const Map<int, Point *>::Element *E = points.front(); E; E = E->next()) {
-		point_list.push_back(E->key());
+	Array ret;
+	for (int i = 0; i < ids.size(); i++) {
+		ret.push_back(ids[i]);
 	}
 
-	return point_list;
+	return ret;
 }
 
 PoolVector<int> AStar::get_point_connections(int p_id) {
@@ -171,10 +308,10 @@ PoolVector<int> AStar::get_point_connections(int p_id) {
 
 	PoolVector<int> point_list;
 
-	Point *p = points[p_id];
+	Point *p = _get_point(p_id);
 
-	for (Set<Point *>::Element *E = p->neighbours.front(); E; E = E->next()) {
-		point_list.push_back(E->get()->id);
+	for (int i = 0; i < p->neighbours.size(); i++) {
+		point_list.push_back(p->neighbours[i]->id);
 	}
 
 	return point_list;
@@ -188,12 +325,23 @@ bool AStar::are_points_connected(int p_id, int p_with_id) const {
 
 void AStar::clear() {
 
-	for (const Map<int, Point *>::Element *E = points.front(); E; E = E->next()) {
+	for (int i = 0; i < point_list.size(); i++) {
+
+		memdelete(point_list[i]);
+	}
 
-		memdelete(E->get());
+	const ClusterKey *K = NULL;
+	while ((K = clusters.next(K))) {
+		memdelete(clusters[*K]);
 	}
+
+	clusters.clear();
+	dirty_clusters.clear();
 	segments.clear();
 	points.clear();
+	point_list.clear();
+	max_id = -1;
+	path_cache.clear();
 }
 
 int AStar::get_closest_point(const Vector3 &p_point) const {
@@ -201,12 +349,13 @@ int AStar::get_closest_point(const Vector3 &p_point) const {
 	int closest_id = -1;
 	real_t closest_dist = 1e20;
 
-	for (const Map<int, Point *>::Element *E = points.front(); E; E = E->next()) {
+	for (int i = 0; i < point_list.size(); i++) {
 
-		real_t d = p_point.distance_squared_to(E->get()->pos);
-		if (closest_id < 0 || d < closest_dist) {
+		const Point *p = point_list[i];
+		real_t d = p_point.distance_squared_to(p->pos);
+		if (closest_id < 0 || d < closest_dist || (d == closest_dist && p->id < closest_id)) {
 			closest_dist = d;
-			closest_id = E->key();
+			closest_id = p->id;
 		}
 	}
 
@@ -239,96 +388,637 @@ Vector3 AStar::get_closest_position_in_segment(const Vector3 &p_point) const {
 	return closest_point;
 }
 
-bool AStar::_solve(Point *begin_point, Point *end_point) {
+AStar::ClusterKey AStar::_get_cluster_key(const Vector3 &p_pos) const {
 
-	pass++;
+	ClusterKey key;
+	key.x = (int32_t)Math::floor(p_pos.x / cluster_size);
+	key.y = (int32_t)Math::floor(p_pos.y / cluster_size);
+	key.z = (int32_t)Math::floor(p_pos.z / cluster_size);
+	return key;
+}
 
-	if (!end_point->enabled)
-		return false;
+void AStar::_add_to_cluster(Point *p_point) {
 
-	SelfList<Point>::List open_list;
+	ClusterKey key = _get_cluster_key(p_point->pos);
 
-	bool found_route = false;
+	Cluster *cluster;
+	Cluster **C = clusters.getptr(key);
+	if (C) {
+		cluster = *C;
+	} else {
+		cluster = memnew(Cluster);
+		cluster->key = key;
+		cluster->dirty = false;
+		clusters.set(key, cluster);
+	}
 
-	for (Set<Point *>::Element *E = begin_point->neighbours.front(); E; E = E->next()) {
+	cluster->points.push_back(p_point);
+	p_point->cluster = cluster;
+	_make_cluster_dirty(cluster);
+}
 
-		Point *n = E->get();
+void AStar::_remove_from_cluster(Point *p_point) {
 
-		if (!n->enabled)
-			continue;
+	Cluster *cluster = p_point->cluster;
+	if (!cluster)
+		return;
+
+	// Empty clusters are freed on the next hierarchy update.
+	cluster->points.erase(p_point);
+	_make_cluster_dirty(cluster);
 
-		n->prev_point = begin_point;
-		n->distance = _compute_cost(begin_point->id, n->id) * n->weight_scale;
-		n->last_pass = pass;
-		open_list.add(&n->list);
+	p_point->cluster = NULL;
+	p_point->portal = false;
+	p_point->portal_edges.clear();
+}
+
+void AStar::_make_cluster_dirty(Cluster *p_cluster) {
+
+	if (p_cluster->dirty)
+		return;
+
+	p_cluster->dirty = true;
+	dirty_clusters.push_back(p_cluster);
+}
+
+void AStar::_make_point_dirty(Point *p_point, bool p_connections) {
+
+	if (!p_point->cluster)
+		return;
+
+	_make_cluster_dirty(p_point->cluster);
+
+	if (!p_connections)
+		return;
+
+	for (int i = 0; i < p_point->neighbours.size(); i++) {
+		_make_cluster_dirty(p_point->neighbours[i]->cluster);
+	}
+	for (int i = 0; i < p_point->incoming.size(); i++) {
+		_make_cluster_dirty(p_point->incoming[i]->cluster);
+	}
+}
+
+void AStar::_rebuild_clusters() {
+
+	const ClusterKey *K = NULL;
+	while ((K = clusters.next(K))) {
+		memdelete(clusters[*K]);
 	}
+	clusters.clear();
+	dirty_clusters.clear();
 
-	while (true) {
+	for (int i = 0; i < point_list.size(); i++) {
 
-		if (open_list.first() == NULL) {
-			// No path found
-			break;
+		Point *p = point_list[i];
+		p->cluster = NULL;
+		p->portal = false;
+		p->portal_edges.clear();
+
+		if (cluster_size > 0) {
+			_add_to_cluster(p);
 		}
-		// Check open list
+	}
+}
+
+void AStar::_update_cluster(SearchState &r_state, Cluster *p_cluster) {
+
+	r_state.prepare(point_list.size());
 
-		SelfList<Point> *least_cost_point = open_list.first();
-		real_t least_cost = Math_INF;
+	// A portal is any point with a connection from or to another cluster.
+	p_cluster->portals.clear();
+	for (int i = 0; i < p_cluster->points.size(); i++) {
 
-		// TODO: Cache previous results
-		for (SelfList<Point> *E = open_list.first(); E; E = E->next()) {
+		Point *p = p_cluster->points[i];
+		p->portal = false;
+		p->portal_edges.clear();
 
-			Point *p = E->self();
+		for (int j = 0; j < p->neighbours.size() && !p->portal; j++) {
+			p->portal = p->neighbours[j]->cluster != p_cluster;
+		}
+		for (int j = 0; j < p->incoming.size() && !p->portal; j++) {
+			p->portal = p->incoming[j]->cluster != p_cluster;
+		}
 
-			real_t cost = p->distance;
-			cost += _estimate_cost(p->id, end_point->id);
+		if (p->portal) {
+			p_cluster->portals.push_back(p);
+		}
+	}
 
-			if (cost < least_cost) {
-				least_cost_point = E;
-				least_cost = cost;
+	int portal_count = p_cluster->portals.size();
+	for (int i = 0; i < portal_count; i++) {
+		p_cluster->portals[i]->portal_index = i;
+	}
+
+	// Cheapest route between every pair of portals, staying inside the cluster.
+	Vector<real_t> costs;
+	costs.resize(portal_count * portal_count);
+	real_t *c = costs.ptrw();
+	for (int i = 0; i < costs.size(); i++) {
+		c[i] = Math_INF;
+	}
+
+	Vector<PortalEdge> reached;
+	for (int i = 0; i < portal_count; i++) {
+
+		Point *p = p_cluster->portals[i];
+		if (!p->enabled)
+			continue;
+
+		_search_cluster(r_state, p, false, reached);
+
+		for (int j = 0; j < reached.size(); j++) {
+			c[i * portal_count + reached[j].to->portal_index] = reached[j].cost;
+		}
+	}
+
+	// Skip routes that are as cheap when passing through a third portal, the
+	// abstract search still finds them and has far fewer edges to expand.
+	for (int i = 0; i < portal_count; i++) {
+
+		Point *p = p_cluster->portals[i];
+		const real_t *from = &c[i * portal_count];
+
+		for (int j = 0; j < portal_count; j++) {
+
+			if (j == i || from[j] == Math_INF)
+				continue;
+
+			bool redundant = false;
+			for (int k = 0; k < portal_count && !redundant; k++) {
+
+				real_t through = c[k * portal_count + j];
+				redundant = k != i && k != j && from[k] > 0 && through > 0 && from[k] + through <= from[j] * (1.0 + CMP_EPSILON);
+			}
+
+			if (!redundant) {
+				PortalEdge pe;
+				pe.to = p_cluster->portals[j];
+				pe.cost = from[j];
+				p->portal_edges.push_back(pe);
 			}
 		}
+	}
+
+	p_cluster->dirty = false;
+}
 
-		Point *p = least_cost_point->self();
-		if (p == end_point) {
-			found_route = true;
-			break;
+void AStar::_update_clusters_job(uint32_t p_job, ClusterJob *p_data) {
+
+	SearchState &state = p_job == 0 ? main_state : *batch_states[p_job - 1];
+
+	int from = p_data->count * p_job / p_data->job_count;
+	int to = p_data->count * (p_job + 1) / p_data->job_count;
+
+	for (int i = from; i < to; i++) {
+		_update_cluster(state, p_data->clusters[i]);
+	}
+}
+
+void AStar::_update_hierarchy() {
+
+	if (dirty_clusters.empty())
+		return;
+
+	Vector<Cluster *> update;
+	for (int i = 0; i < dirty_clusters.size(); i++) {
+
+		Cluster *c = dirty_clusters[i];
+		if (c->points.empty()) {
+			clusters.erase(c->key);
+			memdelete(c);
+		} else {
+			update.push_back(c);
 		}
+	}
+	dirty_clusters.clear();
 
-		for (Set<Point *>::Element *E = p->neighbours.front(); E; E = E->next()) {
+	// Script costs can only be evaluated on the calling thread. The pool is
+	// shared by all instances, so a batch that finds it busy runs here too.
+	bool pooled = path_pool && !get_script_instance() && path_pool_lock->try_lock() == OK;
+	int job_count = pooled ? CLAMP(update.size(), 1, (int)path_pool->get_thread_count()) : 1;
 
-			Point *e = E->get();
+	while (batch_states.size() < job_count - 1) {
+		batch_states.push_back(memnew(SearchState));
+	}
+
+	ClusterJob job;
+	job.clusters = update.ptr();
+	job.count = update.size();
+	job.job_count = job_count;
+
+	if (job_count > 1) {
+		path_pool->do_work(job_count, this, &AStar::_update_clusters_job, &job);
+	} else {
+		_update_clusters_job(0, &job);
+	}
 
-			if (!e->enabled)
+	if (pooled) {
+		path_pool_lock->unlock();
+	}
+}
+
+void AStar::_graph_changed() {
+
+	path_cache.clear();
+}
+
+void AStar::_search_cluster(SearchState &r_state, Point *p_from, bool p_reverse, Vector<PortalEdge> &r_portals) {
+
+	r_portals.clear();
+
+	uint32_t pass = r_state.next_pass();
+	uint32_t *open_pass = r_state.open_pass.ptrw();
+	uint32_t *closed_pass = r_state.closed_pass.ptrw();
+	real_t *g_score = r_state.g_score.ptrw();
+	Point *const *pl = point_list.ptr();
+	const Cluster *cluster = p_from->cluster;
+
+	open_pass[p_from->index] = pass;
+	g_score[p_from->index] = 0;
+	r_state.push(p_from->index, 0);
+
+	while (r_state.open_size) {
+
+		int pi = r_state.pop();
+		if (closed_pass[pi] == pass)
+			continue; // Stale entry, reached again with a lower cost.
+		closed_pass[pi] = pass;
+
+		Point *p = pl[pi];
+		if (p->portal) {
+			PortalEdge pe;
+			pe.to = p;
+			pe.cost = g_score[pi];
+			r_portals.push_back(pe);
+		}
+
+		const Vector<Point *> &links = p_reverse ? p->incoming : p->neighbours;
+		for (int i = 0; i < links.size(); i++) {
+
+			Point *e = links[i];
+			if (!e->enabled || e->cluster != cluster || closed_pass[e->index] == pass)
 				continue;
 
-			real_t distance = _compute_cost(p->id, e->id) * e->weight_scale + p->distance;
+			real_t g = g_score[pi] + (p_reverse ? _get_cost(e, p) : _get_cost(p, e));
+			if (open_pass[e->index] == pass && g >= g_score[e->index])
+				continue;
 
-			if (e->last_pass == pass) {
-				// Already visited, is this cheaper?
+			open_pass[e->index] = pass;
+			g_score[e->index] = g;
+			r_state.push(e->index, g);
+		}
+	}
+}
 
-				if (e->distance > distance) {
-					e->prev_point = p;
-					e->distance = distance;
-				}
-			} else {
-				// Add to open neighbours
+bool AStar::_solve(SearchState &r_state, Point *begin_point, Point *end_point, const Cluster *p_cluster) {
+
+	if (!end_point->enabled)
+		return false;
+
+	uint32_t pass = r_state.next_pass();
+	uint32_t *open_pass = r_state.open_pass.ptrw();
+	uint32_t *closed_pass = r_state.closed_pass.ptrw();
+	real_t *g_score = r_state.g_score.ptrw();
+	int *prev = r_state.prev.ptrw();
+	Point *const *pl = point_list.ptr();
+
+	open_pass[begin_point->index] = pass;
+	g_score[begin_point->index] = 0;
+	prev[begin_point->index] = -1;
+	r_state.push(begin_point->index, 0);
 
-				e->prev_point = p;
-				e->distance = distance;
-				e->last_pass = pass; // Mark as used
-				open_list.add(&e->list);
+	while (r_state.open_size) {
+
+		int pi = r_state.pop();
+		if (closed_pass[pi] == pass)
+			continue; // Stale entry, reached again with a lower cost.
+		closed_pass[pi] = pass;
+
+		Point *p = pl[pi];
+		if (p == end_point)
+			return true;
+
+		for (int i = 0; i < p->neighbours.size(); i++) {
+
+			Point *e = p->neighbours[i];
+			if (!e->enabled || closed_pass[e->index] == pass)
+				continue;
+			if (p_cluster && e->cluster != p_cluster)
+				continue;
+
+			real_t g = g_score[pi] + _get_cost(p, e);
+			if (open_pass[e->index] == pass && g >= g_score[e->index])
+				continue;
+
+			open_pass[e->index] = pass;
+			g_score[e->index] = g;
+			prev[e->index] = pi;
+			r_state.push(e->index, g + _estimate_cost(e->id, end_point->id));
+		}
+	}
+
+	return false;
+}
+
+void AStar::_append_path(const SearchState &p_state, Point *begin_point, Point *end_point, Vector<Point *> &r_path) const {
+
+	const int *prev = p_state.prev.ptr();
+
+	int count = 0;
+	for (int i = end_point->index; i != begin_point->index; i = prev[i]) {
+		count++;
+	}
+
+	int from = r_path.size();
+	r_path.resize(from + count);
+	Point **w = r_path.ptrw();
+
+	int idx = from + count - 1;
+	for (int i = end_point->index; i != begin_point->index; i = prev[i]) {
+		w[idx--] = point_list[i];
+	}
+}
+
+bool AStar::_solve_hierarchical(SearchState &r_state, Point *begin_point, Point *end_point, Vector<Point *> &r_path) {
+
+	r_path.push_back(begin_point);
+
+	real_t best_cost = Math_INF;
+	int best_portal = -1;
+
+	// Inside a single cluster, the local route bounds the abstract search,
+	// which only needs to look for a cheaper way around through other clusters.
+	bool local = begin_point->cluster == end_point->cluster && _solve(r_state, begin_point, end_point, begin_point->cluster);
+	if (local) {
+		best_cost = r_state.g_score[end_point->index];
+		_append_path(r_state, begin_point, end_point, r_path);
+	}
+
+	// Attach both ends to the portals of their clusters.
+	Vector<PortalEdge> begin_portals;
+	Vector<PortalEdge> end_portals;
+	_search_cluster(r_state, begin_point, false, begin_portals);
+	_search_cluster(r_state, end_point, true, end_portals);
+
+	if (begin_portals.empty() || end_portals.empty())
+		return local;
+
+	uint32_t pass = r_state.next_pass();
+	uint32_t *open_pass = r_state.open_pass.ptrw();
+	uint32_t *closed_pass = r_state.closed_pass.ptrw();
+	real_t *g_score = r_state.g_score.ptrw();
+	int *prev = r_state.prev.ptrw();
+	Point *const *pl = point_list.ptr();
+	const Cluster *end_cluster = end_point->cluster;
+
+	for (int i = 0; i < begin_portals.size(); i++) {
+
+		const PortalEdge &pe = begin_portals[i];
+		open_pass[pe.to->index] = pass;
+		g_score[pe.to->index] = pe.cost;
+		prev[pe.to->index] = -1;
+		r_state.push(pe.to->index, pe.cost + _estimate_cost(pe.to->id, end_point->id));
+	}
+
+	while (r_state.open_size && r_state.open[0].f_score < best_cost) {
+
+		int pi = r_state.pop();
+		if (closed_pass[pi] == pass)
+			continue;
+		closed_pass[pi] = pass;
+
+		Point *p = pl[pi];
+
+		if (p->cluster == end_cluster) {
+			for (int i = 0; i < end_portals.size(); i++) {
+				if (end_portals[i].to == p) {
+					real_t cost = g_score[pi] + end_portals[i].cost;
+					if (cost < best_cost) {
+						best_cost = cost;
+						best_portal = pi;
+					}
+					break;
+				}
 			}
 		}
 
-		open_list.remove(least_cost_point);
+		// Routes across the cluster.
+		for (int i = 0; i < p->portal_edges.size(); i++) {
+
+			const PortalEdge &pe = p->portal_edges[i];
+			Point *e = pe.to;
+			if (!e->enabled || closed_pass[e->index] == pass)
+				continue;
+
+			real_t g = g_score[pi] + pe.cost;
+			if (open_pass[e->index] == pass && g >= g_score[e->index])
+				continue;
+
+			open_pass[e->index] = pass;
+			g_score[e->index] = g;
+			prev[e->index] = pi;
+			r_state.push(e->index, g + _estimate_cost(e->id, end_point->id));
+		}
+
+		// Entrances into the neighbouring clusters.
+		for (int i = 0; i < p->neighbours.size(); i++) {
+
+			Point *e = p->neighbours[i];
+			if (e->cluster == p->cluster || !e->enabled || closed_pass[e->index] == pass)
+				continue;
+
+			real_t g = g_score[pi] + _get_cost(p, e);
+			if (open_pass[e->index] == pass && g >= g_score[e->index])
+				continue;
+
+			open_pass[e->index] = pass;
+			g_score[e->index] = g;
+			prev[e->index] = pi;
+			r_state.push(e->index, g + _estimate_cost(e->id, end_point->id));
+		}
+	}
+
+	if (best_portal < 0)
+		return local;
+
+	r_path.resize(1); // Drop the local route, going around is cheaper.
+
+	Vector<Point *> route;
+	for (int i = best_portal; i != -1; i = prev[i]) {
+		route.push_back(pl[i]);
+	}
+	route.invert();
+	route.push_back(end_point);
+
+	// Refine each step of the abstract route into actual points.
+	Point *from = begin_point;
+	for (int i = 0; i < route.size(); i++) {
+
+		Point *to = route[i];
+		if (to == from)
+			continue;
+
+		if (to->cluster != from->cluster) {
+			r_path.push_back(to); // Direct connection into the next cluster.
+		} else {
+			if (!_solve(r_state, from, to, from->cluster))
+				return false;
+			_append_path(r_state, from, to, r_path);
+		}
+
+		from = to;
+	}
+
+	return true;
+}
+
+bool AStar::_find_path(SearchState &r_state, Point *begin_point, Point *end_point, Vector<Point *> &r_path) {
+
+	r_path.clear();
+
+	if (begin_point == end_point) {
+		r_path.push_back(begin_point);
+		return true;
+	}
+
+	if (!end_point->enabled)
+		return false;
+
+	r_state.prepare(point_list.size());
+
+	if (cluster_size > 0) {
+		if (_solve_hierarchical(r_state, begin_point, end_point, r_path))
+			return true;
+
+		r_path.clear();
+		return false;
+	}
+
+	if (!_solve(r_state, begin_point, end_point, NULL))
+		return false;
+
+	r_path.push_back(begin_point);
+	_append_path(r_state, begin_point, end_point, r_path);
+	return true;
+}
+
+bool AStar::_get_path(int p_from_id, int p_to_id, Vector<Point *> &r_path) {
+
+	uint64_t key = _get_path_key(p_from_id, p_to_id);
+
+	if (path_cache_size > 0) {
+		const Vector<Point *> *cached = path_cache.getptr(key);
+		if (cached) {
+			r_path = *cached;
+			return !r_path.empty();
+		}
+	}
+
+	_update_hierarchy();
+
+	bool found = _find_path(main_state, _get_point(p_from_id), _get_point(p_to_id), r_path);
+	_store_path(key, r_path);
+	return found;
+}
+
+void AStar::_store_path(uint64_t p_key, const Vector<Point *> &p_path) {
+
+	if (path_cache_size <= 0)
+		return;
+
+	if ((int)path_cache.size() >= path_cache_size) {
+		path_cache.clear();
+	}
+	path_cache.set(p_key, p_path);
+}
+
+void AStar::_get_paths(const PoolVector<int> &p_from_ids, const PoolVector<int> &p_to_ids, Vector<Vector<Point *> > &r_paths) {
+
+	int count = p_from_ids.size();
+	ERR_FAIL_COND(p_to_ids.size() != count);
+
+	PoolVector<int>::Read fr = p_from_ids.read();
+	PoolVector<int>::Read tr = p_to_ids.read();
+
+	for (int i = 0; i < count; i++) {
+		ERR_FAIL_COND(!points.has(fr[i]));
+		ERR_FAIL_COND(!points.has(tr[i]));
+	}
+
+	r_paths.resize(count);
+
+	Vector<int> pending;
+	for (int i = 0; i < count; i++) {
+
+		const Vector<Point *> *cached = path_cache_size > 0 ? path_cache.getptr(_get_path_key(fr[i], tr[i])) : NULL;
+		if (cached) {
+			r_paths.write[i] = *cached;
+		} else {
+			pending.push_back(i);
+		}
+	}
+
+	if (pending.empty())
+		return;
+
+	_update_hierarchy();
+
+	Vector<Point *> from;
+	Vector<Point *> to;
+	Vector<Vector<Point *> > results;
+	from.resize(pending.size());
+	to.resize(pending.size());
+	results.resize(pending.size());
+
+	for (int i = 0; i < pending.size(); i++) {
+		from.write[i] = _get_point(fr[pending[i]]);
+		to.write[i] = _get_point(tr[pending[i]]);
+	}
+
+	// Script costs can only be evaluated on the calling thread. The pool is
+	// shared by all instances, so a batch that finds it busy runs here too.
+	bool pooled = path_pool && !get_script_instance() && path_pool_lock->try_lock() == OK;
+	int job_count = pooled ? CLAMP(pending.size(), 1, (int)path_pool->get_thread_count()) : 1;
+
+	while (batch_states.size() < job_count - 1) {
+		batch_states.push_back(memnew(SearchState));
 	}
 
-	// Clear the openf list
-	while (open_list.first()) {
-		open_list.remove(open_list.first());
+	BatchJob job;
+	job.from = from.ptr();
+	job.to = to.ptr();
+	job.paths = results.ptrw();
+	job.count = pending.size();
+	job.job_count = job_count;
+
+	if (job_count > 1) {
+		path_pool->do_work(job_count, this, &AStar::_get_paths_job, &job);
+	} else {
+		_get_paths_job(0, &job);
 	}
 
-	return found_route;
+	if (pooled) {
+		path_pool_lock->unlock();
+	}
+
+	for (int i = 0; i < pending.size(); i++) {
+		int idx = pending[i];
+		r_paths.write[idx] = results[i];
+		_store_path(_get_path_key(fr[idx], tr[idx]), results[i]);
+	}
+}
+
+void AStar::_get_paths_job(uint32_t p_job, BatchJob *p_data) {
+
+	SearchState &state = p_job == 0 ? main_state : *batch_states[p_job - 1];
+
+	int from = p_data->count * p_job / p_data->job_count;
+	int to = p_data->count * (p_job + 1) / p_data->job_count;
+
+	for (int i = from; i < to; i++) {
+		_find_path(state, p_data->from[i], p_data->to[i], p_data->paths[i]);
+	}
 }
 
 float AStar::_estimate_cost(int p_from_id, int p_to_id) {
@@ -336,7 +1026,7 @@ float AStar::_estimate_cost(int p_from_id, int p_to_id) {
 	if (get_script_instance() && get_script_instance()->has_method(SceneStringNames::get_singleton()->_estimate_cost))
 		return get_script_instance()->call(SceneStringNames::get_singleton()->_estimate_cost, p_from_id, p_to_id);
 
-	return points[p_from_id]->pos.distance_to(points[p_to_id]->pos);
+	return _get_point(p_from_id)->pos.distance_to(_get_point(p_to_id)->pos);
 }
 
 float AStar::_compute_cost(int p_from_id, int p_to_id) {
@@ -344,55 +1034,53 @@ float AStar::_compute_cost(int p_from_id, int p_to_id) {
 	if (get_script_instance() && get_script_instance()->has_method(SceneStringNames::get_singleton()->_compute_cost))
 		return get_script_instance()->call(SceneStringNames::get_singleton()->_compute_cost, p_from_id, p_to_id);
 
-	return points[p_from_id]->pos.distance_to(points[p_to_id]->pos);
+	return _get_point(p_from_id)->pos.distance_to(_get_point(p_to_id)->pos);
 }
 
-PoolVector<Vector3> AStar::get_point_path(int p_from_id, int p_to_id) {
+void AStar::set_cluster_size(real_t p_size) {
 
-	ERR_FAIL_COND_V(!points.has(p_from_id), PoolVector<Vector3>());
-	ERR_FAIL_COND_V(!points.has(p_to_id), PoolVector<Vector3>());
+	ERR_FAIL_COND(p_size < 0);
 
-	pass++;
+	cluster_size = p_size;
+	_rebuild_clusters();
+	_graph_changed();
+}
 
-	Point *a = points[p_from_id];
-	Point *b = points[p_to_id];
+real_t AStar::get_cluster_size() const {
 
-	if (a == b) {
-		PoolVector<Vector3> ret;
-		ret.push_back(a->pos);
-		return ret;
-	}
+	return cluster_size;
+}
 
-	Point *begin_point = a;
-	Point *end_point = b;
+void AStar::set_path_cache_size(int p_size) {
 
-	bool found_route = _solve(begin_point, end_point);
+	ERR_FAIL_COND(p_size < 0);
 
-	if (!found_route)
-		return PoolVector<Vector3>();
+	path_cache_size = p_size;
+	path_cache.clear();
+}
 
-	// Midpoints
-	Point *p = end_point;
-	int pc = 1; // Begin point
-	while (p != begin_point) {
-		pc++;
-		p = p->prev_point;
-	}
+int AStar::get_path_cache_size() const {
+
+	return path_cache_size;
+}
+
+PoolVector<Vector3> AStar::get_point_path(int p_from_id, int p_to_id) {
+
+	ERR_FAIL_COND_V(!points.has(p_from_id), PoolVector<Vector3>());
+	ERR_FAIL_COND_V(!points.has(p_to_id), PoolVector<Vector3>());
+
+	Vector<Point *> route;
+	if (!_get_path(p_from_id, p_to_id, route))
+		return PoolVector<Vector3>();
 
 	PoolVector<Vector3> path;
-	path.resize(pc);
+	path.resize(route.size());
 
 	{
 		PoolVector<Vector3>::Write w = path.write();
-
-		Point *p2 = end_point;
-		int idx = pc - 1;
-		while (p2 != begin_point) {
-			w[idx--] = p2->pos;
-			p2 = p2->prev_point;
+		for (int i = 0; i < route.size(); i++) {
+			w[i] = route[i]->pos;
 		}
-
-		w[0] = p2->pos; // Assign first
 	}
 
 	return path;
@@ -403,58 +1091,118 @@ PoolVector<int> AStar::get_id_path(int p_from_id, int p_to_id) {
 	ERR_FAIL_COND_V(!points.has(p_from_id), PoolVector<int>());
 	ERR_FAIL_COND_V(!points.has(p_to_id), PoolVector<int>());
 
-	pass++;
+	Vector<Point *> route;
+	if (!_get_path(p_from_id, p_to_id, route))
+		return PoolVector<int>();
 
-	Point *a = points[p_from_id];
-	Point *b = points[p_to_id];
+	PoolVector<int> path;
+	path.resize(route.size());
 
-	if (a == b) {
-		PoolVector<int> ret;
-		ret.push_back(a->id);
-		return ret;
+	{
+		PoolVector<int>::Write w = path.write();
+		for (int i = 0; i < route.size(); i++) {
+			w[i] = route[i]->id;
+		}
 	}
 
-	Point *begin_point = a;
-	Point *end_point = b;
+	return path;
+}
 
-	bool found_route = _solve(begin_point, end_point);
+Array AStar::get_point_paths(const PoolVector<int> &p_from_ids, const PoolVector<int> &p_to_ids) {
 
-	if (!found_route)
-		return PoolVector<int>();
+	Vector<Vector<Point *> > routes;
+	_get_paths(p_from_ids, p_to_ids, routes);
+
+	Array ret;
+	ret.resize(routes.size());
 
-	// Midpoints
-	Point *p = end_point;
-	int pc = 1; // Begin point
-	while (p != begin_point) {
-		pc++;
-		p = p->prev_point;
+	for (int i = 0; i < routes.size(); i++) {
+
+		const Vector<Point *> &route = routes[i];
+		PoolVector<Vector3> path;
+		path.resize(route.size());
+		{
+			PoolVector<Vector3>::Write w = path.write();
+			for (int j = 0; j < route.size(); j++) {
+				w[j] = route[j]->pos;
+			}
+		}
+		ret[i] = path;
 	}
 
-	PoolVector<int> path;
-	path.resize(pc);
+	return ret;
+}
 
-	{
-		PoolVector<int>::Write w = path.write();
+Array AStar::get_id_paths(const PoolVector<int> &p_from_ids, const PoolVector<int> &p_to_ids) {
 
-		p = end_point;
-		int idx = pc - 1;
-		while (p != begin_point) {
-			w[idx--] = p->id;
-			p = p->prev_point;
-		}
+	Vector<Vector<Point *> > routes;
+	_get_paths(p_from_ids, p_to_ids, routes);
+
+	Array ret;
+	ret.resize(routes.size());
+
+	for (int i = 0; i < routes.size(); i++) {
 
-		w[0] = p->id; // Assign first
+		const Vector<Point *> &route = routes[i];
+		PoolVector<int> path;
+		path.resize(route.size());
+		{
+			PoolVector<int>::Write w = path.write();
+			for (int j = 0; j < route.size(); j++) {
+				w[j] = route[j]->id;
+			}
+		}
+		ret[i] = path;
 	}
 
-	return path;
+	return ret;
 }
 
 void AStar::set_point_disabled(int p_id, bool p_disabled) {
-	points[p_id]->enabled = !p_disabled;
+
+	ERR_FAIL_COND(!points.has(p_id));
+
+	Point *p = _get_point(p_id);
+	if (p->enabled == !p_disabled)
+		return;
+
+	p->enabled = !p_disabled;
+
+	// Only the routes across this point's own cluster can change.
+	_make_point_dirty(p, false);
+	_graph_changed();
 }
 
 bool AStar::is_point_disabled(int p_id) const {
-	return !points[p_id]->enabled;
+
+	ERR_FAIL_COND_V(!points.has(p_id), false);
+
+	return !_get_point(p_id)->enabled;
+}
+
+void AStar::init_path_threads() {
+
+	int threads = GLOBAL_DEF("application/run/astar_threads", 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("application/run/astar_threads", PropertyInfo(Variant::INT, "application/run/astar_threads", PROPERTY_HINT_RANGE, "0,64,1"));
+
+	if (threads == 1)
+		return; //batch queries run on the calling thread
+
+	path_pool = memnew(ThreadWorkPool);
+	path_pool->init(threads > 0 ? threads : -1);
+	path_pool_lock = Mutex::create(false); // not recursive, a nested batch on the same thread must not reenter do_work()
+}
+
+void AStar::finish_path_threads() {
+
+	if (!path_pool)
+		return;
+
+	path_pool->finish();
+	memdelete(path_pool);
+	path_pool = NULL;
+	memdelete(path_pool_lock);
+	path_pool_lock = NULL;
 }
 
 void AStar::_bind_methods() {
@@ -483,20 +1231,37 @@ void AStar::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_closest_point", "to_position"), &AStar::get_closest_point);
 	ClassDB::bind_method(D_METHOD("get_closest_position_in_segment", "to_position"), &AStar::get_closest_position_in_segment);
 
+	ClassDB::bind_method(D_METHOD("set_cluster_size", "size"), &AStar::set_cluster_size);
+	ClassDB::bind_method(D_METHOD("get_cluster_size"), &AStar::get_cluster_size);
+
+	ClassDB::bind_method(D_METHOD("set_path_cache_size", "size"), &AStar::set_path_cache_size);
+	ClassDB::bind_method(D_METHOD("get_path_cache_size"), &AStar::get_path_cache_size);
+
 	ClassDB::bind_method(D_METHOD("get_point_path", "from_id", "to_id"), &AStar::get_point_path);
 	ClassDB::bind_method(D_METHOD("get_id_path", "from_id", "to_id"), &AStar::get_id_path);
 
+	ClassDB::bind_method(D_METHOD("get_point_paths", "from_ids", "to_ids"), &AStar::get_point_paths);
+	ClassDB::bind_method(D_METHOD("get_id_paths", "from_ids", "to_ids"), &AStar::get_id_paths);
+
 	BIND_VMETHOD(MethodInfo(Variant::REAL, "_estimate_cost", PropertyInfo(Variant::INT, "from_id"), PropertyInfo(Variant::INT, "to_id")));
 	BIND_VMETHOD(MethodInfo(Variant::REAL, "_compute_cost", PropertyInfo(Variant::INT, "from_id"), PropertyInfo(Variant::INT, "to_id")));
+
+	ADD_PROPERTY(PropertyInfo(Variant::REAL, "cluster_size", PROPERTY_HINT_RANGE, "0,1024,0.01,or_greater"), "set_cluster_size", "get_cluster_size");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "path_cache_size", PROPERTY_HINT_RANGE, "0,65536,1,or_greater"), "set_path_cache_size", "get_path_cache_size");
 }
 
 AStar::AStar() {
 
-	pass = 1;
+	max_id = -1;
+	cluster_size = 0;
+	path_cache_size = 0;
 }
 
 AStar::~AStar() {
 
-	pass = 1;
 	clear();
+
+	for (int i = 0; i < batch_states.size(); i++) {
+		memdelete(batch_states[i]);
+	}
 }
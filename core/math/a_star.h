@@ -31,12 +31,21 @@
 #ifndef ASTAR_H
 #define ASTAR_H
 
+#include "core/hash_map.h"
+#include "core/oa_hash_map.h"
 #include "core/reference.h"
-#include "core/self_list.h"
+
+class Mutex;
+class ThreadWorkPool;
 
 /**
 	A* pathfinding algorithm
 
+	When a cluster size is set, points are grouped into a grid of clusters and
+	paths are searched on an abstract graph of cluster entrances (portals)
+	first, then refined inside each cluster crossed (HPA*). Portal routes are
+	cached per cluster and only recomputed for clusters touched by edits.
+
 	@author Juan Linietsky <reduzio@gmail.com>
 */
 
@@ -44,29 +53,36 @@ class AStar : public Reference {
 
 	GDCLASS(AStar, Reference)
 
-	uint64_t pass;
+	struct Point;
+	struct Cluster;
 
-	struct Point {
+	struct PortalEdge {
 
-		SelfList<Point> list;
+		Point *to;
+		real_t cost;
+	};
+
+	struct Point {
 
 		int id;
+		int index; // Slot in point_list, addresses the search scratch arrays.
 		Vector3 pos;
 		real_t weight_scale;
-		uint64_t last_pass;
 		bool enabled;
 
-		Set<Point *> neighbours;
+		Vector<Point *> neighbours; // Points this one connects to.
+		Vector<Point *> incoming; // Points connecting to this one.
 
-		// Used for pathfinding
-		Point *prev_point;
-		real_t distance;
-
-		Point() :
-				list(this) {}
+		// Hierarchy
+		Cluster *cluster;
+		bool portal;
+		int portal_index; // Slot in Cluster::portals while the cluster is updated.
+		Vector<PortalEdge> portal_edges; // Cheapest routes to the other portals of the cluster.
 	};
 
-	Map<int, Point *> points;
+	OAHashMap<int, Point *> points;
+	Vector<Point *> point_list;
+	int max_id;
 
 	struct Segment {
 		union {
@@ -94,7 +110,121 @@ class AStar : public Reference {
 
 	Set<Segment> segments;
 
-	bool _solve(Point *begin_point, Point *end_point);
+	struct ClusterKey {
+
+		int32_t x, y, z;
+
+		bool operator==(const ClusterKey &p_key) const { return x == p_key.x && y == p_key.y && z == p_key.z; }
+	};
+
+	struct ClusterKeyHasher {
+
+		static _FORCE_INLINE_ uint32_t hash(const ClusterKey &p_key) {
+			uint32_t h = hash_djb2_one_32(p_key.x);
+			h = hash_djb2_one_32(p_key.y, h);
+			return hash_djb2_one_32(p_key.z, h);
+		}
+	};
+
+	struct Cluster {
+
+		ClusterKey key;
+		Vector<Point *> points;
+		Vector<Point *> portals;
+		bool dirty;
+	};
+
+	real_t cluster_size;
+	HashMap<ClusterKey, Cluster *, ClusterKeyHasher> clusters;
+	Vector<Cluster *> dirty_clusters;
+
+	// Per-thread search scratch data, indexed by Point::index.
+	struct SearchState {
+
+		struct OpenEntry {
+
+			real_t f_score;
+			int index;
+		};
+
+		struct OpenComparator {
+
+			_FORCE_INLINE_ bool operator()(const OpenEntry &A, const OpenEntry &B) const { return A.f_score > B.f_score; }
+		};
+
+		Vector<uint32_t> open_pass;
+		Vector<uint32_t> closed_pass;
+		Vector<real_t> g_score;
+		Vector<int> prev;
+		uint32_t pass;
+
+		Vector<OpenEntry> open;
+		int open_size;
+
+		void prepare(int p_point_count);
+		uint32_t next_pass();
+		void push(int p_index, real_t p_f_score);
+		int pop();
+
+		SearchState() {
+			pass = 0;
+			open_size = 0;
+		}
+	};
+
+	SearchState main_state;
+	Vector<SearchState *> batch_states;
+
+	int path_cache_size;
+	HashMap<uint64_t, Vector<Point *> > path_cache;
+
+	static ThreadWorkPool *path_pool;
+	static Mutex *path_pool_lock; // Held while an instance runs a batch on the pool.
+
+	struct BatchJob {
+
+		Point *const *from;
+		Point *const *to;
+		Vector<Point *> *paths;
+		int count;
+		int job_count;
+	};
+
+	struct ClusterJob {
+
+		Cluster *const *clusters;
+		int count;
+		int job_count;
+	};
+
+	_FORCE_INLINE_ Point *_get_point(int p_id) const {
+		Point *p = NULL;
+		points.lookup(p_id, p);
+		return p;
+	}
+	_FORCE_INLINE_ real_t _get_cost(const Point *p_from, const Point *p_to) { return _compute_cost(p_from->id, p_to->id) * p_to->weight_scale; }
+	static _FORCE_INLINE_ uint64_t _get_path_key(int p_from_id, int p_to_id) { return ((uint64_t)(uint32_t)p_from_id << 32) | (uint32_t)p_to_id; }
+
+	ClusterKey _get_cluster_key(const Vector3 &p_pos) const;
+	void _add_to_cluster(Point *p_point);
+	void _remove_from_cluster(Point *p_point);
+	void _make_cluster_dirty(Cluster *p_cluster);
+	void _make_point_dirty(Point *p_point, bool p_connections);
+	void _rebuild_clusters();
+	void _update_cluster(SearchState &r_state, Cluster *p_cluster);
+	void _update_clusters_job(uint32_t p_job, ClusterJob *p_data);
+	void _update_hierarchy();
+	void _graph_changed();
+
+	void _search_cluster(SearchState &r_state, Point *p_from, bool p_reverse, Vector<PortalEdge> &r_portals);
+	bool _solve(SearchState &r_state, Point *begin_point, Point *end_point, const Cluster *p_cluster);
+	void _append_path(const SearchState &p_state, Point *begin_point, Point *end_point, Vector<Point *> &r_path) const;
+	bool _solve_hierarchical(SearchState &r_state, Point *begin_point, Point *end_point, Vector<Point *> &r_path);
+	bool _find_path(SearchState &r_state, Point *begin_point, Point *end_point, Vector<Point *> &r_path);
+	bool _get_path(int p_from_id, int p_to_id, Vector<Point *> &r_path);
+	void _store_path(uint64_t p_key, const Vector<Point *> &p_path);
+	void _get_paths(const PoolVector<int> &p_from_ids, const PoolVector<int> &p_to_ids, Vector<Vector<Point *> > &r_paths);
+	void _get_paths_job(uint32_t p_job, BatchJob *p_data);
 
 protected:
 	static void _bind_methods();
@@ -127,9 +257,21 @@ public:
 	int get_closest_point(const Vector3 &p_point) const;
 	Vector3 get_closest_position_in_segment(const Vector3 &p_point) const;
 
+	void set_cluster_size(real_t p_size);
+	real_t get_cluster_size() const;
+
+	void set_path_cache_size(int p_size);
+	int get_path_cache_size() const;
+
 	PoolVector<Vector3> get_point_path(int p_from_id, int p_to_id);
 	PoolVector<int> get_id_path(int p_from_id, int p_to_id);
 
+	Array get_point_paths(const PoolVector<int> &p_from_ids, const PoolVector<int> &p_to_ids);
+	Array get_id_paths(const PoolVector<int> &p_from_ids, const PoolVector<int> &p_to_ids);
+
+	static void init_path_threads();
+	static void finish_path_threads();
+
 	AStar();
 	~AStar();
 };
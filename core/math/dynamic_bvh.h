@@ -0,0 +1,1356 @@
+/*************************************************************************/
+/*  dynamic_bvh.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef DYNAMIC_BVH_H
+#define DYNAMIC_BVH_H
+
+#include "core/math/aabb.h"
+#include "core/math/rect2.h"
+#include "core/os/memory.h"
+
+#if !defined(REAL_T_IS_DOUBLE) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define DYNAMIC_BVH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+/**
+ * Dynamic AABB tree with the same interface as Octree, meant for scenes where many elements move every frame.
+ * It works with AABB in 3D and Rect2 in 2D, DynamicBVHBounds has the few operations that depend on the dimension.
+ *
+ * Node bounds and node links are stored in separate flat arrays, so traversals only stream the bounds they test.
+ * Leaves are fattened, elements that stay inside their leaf don't touch the tree. Moves are batched: tree changes
+ * and pair checks are deferred to update(), which refits all the affected nodes once, and only reinserts the
+ * elements that moved too far from their place in the tree. Culls can miss elements that left their leaf until
+ * update() is called.
+ *
+ * Pairable and non pairable elements go in two separate trees, so non pairable elements only look for pairs among
+ * the pairable ones. Culling never modifies the tree and can be done from several threads at the same time.
+ */
+
+typedef uint32_t DynamicBVHElementID;
+
+#define DYNAMIC_BVH_ELEMENT_INVALID_ID 0
+
+template <class B>
+struct DynamicBVHBounds;
+
+template <>
+struct DynamicBVHBounds<AABB> {
+
+	typedef Vector3 Point;
+
+	_FORCE_INLINE_ static Point get_begin(const AABB &p_aabb) { return p_aabb.position; }
+	_FORCE_INLINE_ static Point get_end(const AABB &p_aabb) { return p_aabb.position + p_aabb.size; }
+	_FORCE_INLINE_ static Point splat(real_t p_value) { return Vector3(p_value, p_value, p_value); }
+	_FORCE_INLINE_ static Point min(const Point &p_a, const Point &p_b) { return Vector3(MIN(p_a.x, p_b.x), MIN(p_a.y, p_b.y), MIN(p_a.z, p_b.z)); }
+	_FORCE_INLINE_ static Point max(const Point &p_a, const Point &p_b) { return Vector3(MAX(p_a.x, p_b.x), MAX(p_a.y, p_b.y), MAX(p_a.z, p_b.z)); }
+
+	// Cost of a node for the surface area heuristic.
+	_FORCE_INLINE_ static real_t get_area(const Point &p_min, const Point &p_max) {
+
+		Vector3 d = p_max - p_min;
+		return 2.0 * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	_FORCE_INLINE_ static bool overlaps(const Point &p_min, const Point &p_max, const Point &p_other_min, const Point &p_other_max) {
+
+		return !(p_min.x > p_other_max.x || p_max.x < p_other_min.x || p_min.y > p_other_max.y || p_max.y < p_other_min.y || p_min.z > p_other_max.z || p_max.z < p_other_min.z);
+	}
+
+	_FORCE_INLINE_ static bool encloses(const Point &p_min, const Point &p_max, const Point &p_other_min, const Point &p_other_max) {
+
+		return p_min.x <= p_other_min.x && p_min.y <= p_other_min.y && p_min.z <= p_other_min.z && p_max.x >= p_other_max.x && p_max.y >= p_other_max.y && p_max.z >= p_other_max.z;
+	}
+
+	_FORCE_INLINE_ static bool intersects(const AABB &p_a, const AABB &p_b) { return p_a.intersects_inclusive(p_b); }
+	_FORCE_INLINE_ static bool is_empty(const AABB &p_aabb) { return p_aabb.has_no_surface(); }
+	_FORCE_INLINE_ static bool is_valid(const AABB &p_aabb) { return p_aabb.size.x >= 0.0 && p_aabb.size.y >= 0.0 && p_aabb.size.z >= 0.0; } // also false for NaN
+};
+
+template <>
+struct DynamicBVHBounds<Rect2> {
+
+	typedef Vector2 Point;
+
+	_FORCE_INLINE_ static Point get_begin(const Rect2 &p_rect) { return p_rect.position; }
+	_FORCE_INLINE_ static Point get_end(const Rect2 &p_rect) { return p_rect.position + p_rect.size; }
+	_FORCE_INLINE_ static Point splat(real_t p_value) { return Vector2(p_value, p_value); }
+	_FORCE_INLINE_ static Point min(const Point &p_a, const Point &p_b) { return Vector2(MIN(p_a.x, p_b.x), MIN(p_a.y, p_b.y)); }
+	_FORCE_INLINE_ static Point max(const Point &p_a, const Point &p_b) { return Vector2(MAX(p_a.x, p_b.x), MAX(p_a.y, p_b.y)); }
+
+	// Cost of a node for the surface area heuristic, the perimeter in 2D.
+	_FORCE_INLINE_ static real_t get_area(const Point &p_min, const Point &p_max) {
+
+		Vector2 d = p_max - p_min;
+		return 2.0 * (d.x + d.y);
+	}
+
+	_FORCE_INLINE_ static bool overlaps(const Point &p_min, const Point &p_max, const Point &p_other_min, const Point &p_other_max) {
+
+		return !(p_min.x > p_other_max.x || p_max.x < p_other_min.x || p_min.y > p_other_max.y || p_max.y < p_other_min.y);
+	}
+
+	_FORCE_INLINE_ static bool encloses(const Point &p_min, const Point &p_max, const Point &p_other_min, const Point &p_other_max) {
+
+		return p_min.x <= p_other_min.x && p_min.y <= p_other_min.y && p_max.x >= p_other_max.x && p_max.y >= p_other_max.y;
+	}
+
+	_FORCE_INLINE_ static bool intersects(const Rect2 &p_a, const Rect2 &p_b) { return p_a.intersects(p_b); }
+	_FORCE_INLINE_ static bool is_empty(const Rect2 &p_rect) { return p_rect.size.x <= 0 && p_rect.size.y <= 0; }
+	_FORCE_INLINE_ static bool is_valid(const Rect2 &p_rect) { return p_rect.size.x >= 0.0 && p_rect.size.y >= 0.0; } // also false for NaN
+};
+
+template <class T, bool use_pairs = false, class B = AABB>
+class DynamicBVH {
+public:
+	typedef void *(*PairCallback)(void *, DynamicBVHElementID, T *, int, DynamicBVHElementID, T *, int);
+	typedef void (*UnpairCallback)(void *, DynamicBVHElementID, T *, int, DynamicBVHElementID, T *, int, void *);
+
+private:
+	typedef DynamicBVHBounds<B> Bounds;
+	typedef typename Bounds::Point Point;
+
+	enum {
+		NULL_NODE = -1,
+		STACK_SIZE = 128, // the trees are balanced, so this is way more than the height of any practical tree
+		MAX_PLANE_GROUPS = 8, // planes are tested in groups of four
+		MAX_HEIGHT = 64,
+	};
+
+	// Leaves are also extended along the last motion of their element, so steady movement needs fewer reinsertions.
+	static const int PREDICTION_MULTIPLIER = 2;
+
+	enum {
+		TREE_NON_PAIRABLE,
+		TREE_PAIRABLE,
+		TREE_MAX
+	};
+
+	enum {
+		CULL_OUTSIDE,
+		CULL_INTERSECT,
+		CULL_INSIDE
+	};
+
+	struct NodeBounds {
+
+		Point min;
+		Point max;
+
+		_FORCE_INLINE_ bool overlaps(const Point &p_min, const Point &p_max) const { return Bounds::overlaps(min, max, p_min, p_max); }
+		_FORCE_INLINE_ bool encloses(const Point &p_min, const Point &p_max) const { return Bounds::encloses(min, max, p_min, p_max); }
+	};
+
+	struct NodeLinks {
+
+		int parent; // next free node when not in use
+		int children[2]; // NULL_NODE in leaves
+		int height; // 0 for leaves
+		DynamicBVHElementID element;
+		bool refit_queued;
+		int next_refit;
+
+		_FORCE_INLINE_ bool is_leaf() const { return children[0] == NULL_NODE; }
+	};
+
+	struct PairRef {
+
+		DynamicBVHElementID other;
+		void *ud;
+	};
+
+	struct Element {
+
+		T *userdata;
+		int subindex;
+		B aabb; // exact bounds, the leaves store them fattened
+		Point motion; // from the previous bounds, to extend the leaf when reinserting
+		int leaf; // NULL_NODE when the AABB has no surface (not in the tree)
+		bool pairable;
+		uint32_t pairable_type;
+		uint32_t pairable_mask;
+		bool bounds_dirty; // moved out of its leaf, waiting for update()
+		bool pairs_dirty;
+		uint64_t pass;
+
+		PairRef *pairs;
+		int pair_count;
+		int pair_capacity;
+
+		DynamicBVHElementID next_free; // only valid when not used
+		bool used;
+	};
+
+	// Frustum planes in groups of four, laid out so each group is tested with a few vector operations.
+	struct CullPlanes {
+
+		float normal_x[MAX_PLANE_GROUPS][4];
+		float normal_y[MAX_PLANE_GROUPS][4];
+		float normal_z[MAX_PLANE_GROUPS][4];
+		float abs_normal_x[MAX_PLANE_GROUPS][4];
+		float abs_normal_y[MAX_PLANE_GROUPS][4];
+		float abs_normal_z[MAX_PLANE_GROUPS][4];
+		float d[MAX_PLANE_GROUPS][4];
+		int group_count;
+	};
+
+	NodeBounds *node_bounds;
+	NodeLinks *node_links;
+	int node_capacity;
+	int node_free_list;
+	int roots[TREE_MAX];
+
+	Element *elements;
+	DynamicBVHElementID element_capacity;
+	DynamicBVHElementID element_free_list; // 0 means no free elements
+	int element_count;
+
+	DynamicBVHElementID *dirty_elements;
+	int dirty_count;
+	int dirty_capacity;
+
+	int refit_queues[MAX_HEIGHT]; // nodes waiting for a refit, by height, so children are refitted before their parents
+
+	uint64_t pass;
+	real_t fat_margin;
+
+	PairCallback pair_callback;
+	UnpairCallback unpair_callback;
+	void *pair_callback_userdata;
+	void *unpair_callback_userdata;
+
+	int pair_count;
+
+	_FORCE_INLINE_ Element &_get_element(DynamicBVHElementID p_id) const { return elements[p_id - 1]; }
+	_FORCE_INLINE_ bool _is_valid_id(DynamicBVHElementID p_id) const { return p_id != 0 && p_id <= element_capacity && elements[p_id - 1].used; }
+	_FORCE_INLINE_ int _get_tree(const Element &p_element) const { return use_pairs && p_element.pairable ? TREE_PAIRABLE : TREE_NON_PAIRABLE; }
+
+	_FORCE_INLINE_ void _get_fat_bounds(const Element &p_element, NodeBounds &r_bounds) const {
+
+		Point margin = Bounds::splat(fat_margin);
+		Point prediction = p_element.motion * PREDICTION_MULTIPLIER;
+		r_bounds.min = Bounds::get_begin(p_element.aabb) - margin + Bounds::min(prediction, Point());
+		r_bounds.max = Bounds::get_end(p_element.aabb) + margin + Bounds::max(prediction, Point());
+	}
+
+	_FORCE_INLINE_ void _mark_dirty(DynamicBVHElementID p_id, bool p_bounds);
+	_FORCE_INLINE_ void _queue_refit(int p_node);
+
+	int _allocate_node();
+	void _free_node(int p_node);
+	void _refit(int p_node);
+	int _balance(int p_tree, int p_node);
+	void _insert_leaf(int p_tree, int p_leaf);
+	void _remove_leaf(int p_tree, int p_leaf);
+
+	void _add_leaf(DynamicBVHElementID p_id);
+	void _remove_element_leaf(DynamicBVHElementID p_id);
+
+	_FORCE_INLINE_ bool _can_pair(const Element &p_a, const Element &p_b) const {
+
+		if (p_a.leaf == NULL_NODE || p_b.leaf == NULL_NODE)
+			return false;
+		if (p_a.userdata == p_b.userdata && p_a.userdata)
+			return false;
+		if (!p_a.pairable && !p_b.pairable)
+			return false;
+		if (!(p_a.pairable_type & p_b.pairable_mask) && !(p_b.pairable_type & p_a.pairable_mask))
+			return false; // none can pair with none
+
+		return Bounds::intersects(p_a.aabb, p_b.aabb);
+	}
+
+	void _add_pair_ref(Element &p_element, DynamicBVHElementID p_other, void *p_ud);
+	void _remove_pair_ref(Element &p_element, DynamicBVHElementID p_other);
+	void _unpair_all(DynamicBVHElementID p_id);
+	void _update_pairs(DynamicBVHElementID p_id);
+
+	static void _setup_cull_planes(const Plane *p_planes, int p_plane_count, CullPlanes &r_cull_planes);
+	_FORCE_INLINE_ static int _test_cull_planes(const CullPlanes &p_cull_planes, const Vector3 &p_min, const Vector3 &p_max);
+
+public:
+	DynamicBVHElementID create(T *p_userdata, const B &p_aabb = B(), int p_subindex = 0, bool p_pairable = false, uint32_t p_pairable_type = 0, uint32_t p_pairable_mask = 1);
+	void move(DynamicBVHElementID p_id, const B &p_aabb);
+	void set_pairable(DynamicBVHElementID p_id, bool p_pairable = false, uint32_t p_pairable_type = 0, uint32_t p_pairable_mask = 1);
+	void erase(DynamicBVHElementID p_id);
+
+	// Applies the pending moves to the trees, then updates the pairs of the elements that moved.
+	void update();
+
+	bool is_pairable(DynamicBVHElementID p_id) const;
+	T *get(DynamicBVHElementID p_id) const;
+	int get_subindex(DynamicBVHElementID p_id) const;
+
+	int cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) const; // 3D only
+	int cull_aabb(const B &p_aabb, T **p_result_array, int p_result_max, int *p_subindex_array = NULL, uint32_t p_mask = 0xFFFFFFFF) const;
+	int cull_segment(const Point &p_from, const Point &p_to, T **p_result_array, int p_result_max, int *p_subindex_array = NULL, uint32_t p_mask = 0xFFFFFFFF) const;
+	int cull_point(const Point &p_point, T **p_result_array, int p_result_max, int *p_subindex_array = NULL, uint32_t p_mask = 0xFFFFFFFF) const;
+
+	void set_pair_callback(PairCallback p_callback, void *p_userdata);
+	void set_unpair_callback(UnpairCallback p_callback, void *p_userdata);
+
+	void set_fat_margin(real_t p_margin) { fat_margin = p_margin; }
+	real_t get_fat_margin() const { return fat_margin; }
+
+	int get_element_count() const { return element_count; }
+	int get_pair_count() const { return pair_count; }
+	int get_tree_height() const;
+
+	DynamicBVH(real_t p_fat_margin = 0.1);
+	~DynamicBVH();
+};
+
+/* PRIVATE FUNCTIONS */
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_mark_dirty(DynamicBVHElementID p_id, bool p_bounds) {
+
+	Element &e = _get_element(p_id);
+
+	if (!e.bounds_dirty && !e.pairs_dirty) {
+
+		if (dirty_count == dirty_capacity) {
+			dirty_capacity = dirty_capacity ? dirty_capacity * 2 : 64;
+			dirty_elements = (DynamicBVHElementID *)memrealloc(dirty_elements, sizeof(DynamicBVHElementID) * dirty_capacity);
+		}
+		dirty_elements[dirty_count++] = p_id;
+	}
+
+	if (p_bounds)
+		e.bounds_dirty = true;
+	if (use_pairs)
+		e.pairs_dirty = true;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_queue_refit(int p_node) {
+
+	NodeLinks &n = node_links[p_node];
+	if (n.refit_queued)
+		return;
+
+	ERR_FAIL_INDEX(n.height, MAX_HEIGHT);
+	n.refit_queued = true;
+	n.next_refit = refit_queues[n.height];
+	refit_queues[n.height] = p_node;
+}
+
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::_allocate_node() {
+
+	if (node_free_list == NULL_NODE) {
+
+		int old_capacity = node_capacity;
+		node_capacity = node_capacity ? node_capacity * 2 : 64;
+		node_bounds = (NodeBounds *)memrealloc(node_bounds, sizeof(NodeBounds) * node_capacity);
+		node_links = (NodeLinks *)memrealloc(node_links, sizeof(NodeLinks) * node_capacity);
+
+		for (int i = old_capacity; i < node_capacity; i++) {
+			node_links[i].parent = i + 1 < node_capacity ? i + 1 : NULL_NODE;
+			node_links[i].height = -1;
+		}
+		node_free_list = old_capacity;
+	}
+
+	int index = node_free_list;
+	NodeLinks &n = node_links[index];
+	node_free_list = n.parent;
+	n.parent = NULL_NODE;
+	n.children[0] = NULL_NODE;
+	n.children[1] = NULL_NODE;
+	n.height = 0;
+	n.element = 0;
+	n.refit_queued = false;
+	return index;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_free_node(int p_node) {
+
+	node_links[p_node].parent = node_free_list;
+	node_links[p_node].height = -1;
+	node_free_list = p_node;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_refit(int p_node) {
+
+	NodeLinks &n = node_links[p_node];
+	const NodeBounds &a = node_bounds[n.children[0]];
+	const NodeBounds &b = node_bounds[n.children[1]];
+	node_bounds[p_node].min = Bounds::min(a.min, b.min);
+	node_bounds[p_node].max = Bounds::max(a.max, b.max);
+	n.height = 1 + MAX(node_links[n.children[0]].height, node_links[n.children[1]].height);
+}
+
+// Performs a left or right rotation if the node is imbalanced, returns the new root of the subtree.
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::_balance(int p_tree, int p_node) {
+
+	int ia = p_node;
+	NodeLinks *a = &node_links[ia];
+	if (a->is_leaf() || a->height < 2)
+		return ia;
+
+	int ib = a->children[0];
+	int ic = a->children[1];
+	int balance = node_links[ic].height - node_links[ib].height;
+
+	if (balance > 1 || balance < -1) {
+
+		// Rotate the taller child (C) up, A takes the place of its shorter grandchild.
+		int side = balance > 1 ? 1 : 0;
+		int ic_up = a->children[side];
+		int i_other = a->children[1 - side];
+		NodeLinks *c = &node_links[ic_up];
+
+		int i_f = c->children[0];
+		int i_g = c->children[1];
+
+		c->children[0] = ia;
+		c->parent = a->parent;
+		a->parent = ic_up;
+
+		if (c->parent != NULL_NODE) {
+			NodeLinks &cp = node_links[c->parent];
+			cp.children[cp.children[0] == ia ? 0 : 1] = ic_up;
+		} else {
+			roots[p_tree] = ic_up;
+		}
+
+		int i_keep = node_links[i_f].height > node_links[i_g].height ? i_f : i_g;
+		int i_move = i_keep == i_f ? i_g : i_f;
+
+		c->children[1] = i_keep;
+		a->children[side] = i_move;
+		node_links[i_move].parent = ia;
+
+		NodeBounds &ab = node_bounds[ia];
+		NodeBounds &cb = node_bounds[ic_up];
+		ab.min = Bounds::min(node_bounds[i_other].min, node_bounds[i_move].min);
+		ab.max = Bounds::max(node_bounds[i_other].max, node_bounds[i_move].max);
+		cb.min = Bounds::min(ab.min, node_bounds[i_keep].min);
+		cb.max = Bounds::max(ab.max, node_bounds[i_keep].max);
+		a->height = 1 + MAX(node_links[i_other].height, node_links[i_move].height);
+		c->height = 1 + MAX(a->height, node_links[i_keep].height);
+
+		return ic_up;
+	}
+
+	return ia;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_insert_leaf(int p_tree, int p_leaf) {
+
+	int &root = roots[p_tree];
+
+	if (root == NULL_NODE) {
+		root = p_leaf;
+		node_links[root].parent = NULL_NODE;
+		return;
+	}
+
+	// Find the best sibling using the surface area heuristic.
+	Point leaf_min = node_bounds[p_leaf].min;
+	Point leaf_max = node_bounds[p_leaf].max;
+	int index = root;
+
+	while (!node_links[index].is_leaf()) {
+
+		const NodeBounds &n = node_bounds[index];
+		const NodeLinks &l = node_links[index];
+
+		real_t area = Bounds::get_area(n.min, n.max);
+		real_t combined_area = Bounds::get_area(Bounds::min(n.min, leaf_min), Bounds::max(n.max, leaf_max));
+
+		// Cost of creating a new parent for this node and the new leaf.
+		real_t cost = 2.0 * combined_area;
+		// Minimum cost of pushing the leaf further down the tree.
+		real_t inheritance_cost = 2.0 * (combined_area - area);
+
+		real_t child_cost[2];
+		for (int i = 0; i < 2; i++) {
+			const NodeBounds &c = node_bounds[l.children[i]];
+			real_t merged_area = Bounds::get_area(Bounds::min(c.min, leaf_min), Bounds::max(c.max, leaf_max));
+			if (node_links[l.children[i]].is_leaf()) {
+				child_cost[i] = merged_area + inheritance_cost;
+			} else {
+				child_cost[i] = (merged_area - Bounds::get_area(c.min, c.max)) + inheritance_cost;
+			}
+		}
+
+		if (cost < child_cost[0] && cost < child_cost[1])
+			break;
+
+		index = child_cost[0] < child_cost[1] ? l.children[0] : l.children[1];
+	}
+
+	int sibling = index;
+
+	// Create a new parent, this may reallocate the node arrays.
+	int new_parent = _allocate_node();
+	int old_parent = node_links[sibling].parent;
+
+	NodeLinks &np = node_links[new_parent];
+	np.parent = old_parent;
+	np.height = node_links[sibling].height + 1;
+	np.children[0] = sibling;
+	np.children[1] = p_leaf;
+	node_bounds[new_parent].min = Bounds::min(leaf_min, node_bounds[sibling].min);
+	node_bounds[new_parent].max = Bounds::max(leaf_max, node_bounds[sibling].max);
+	node_links[sibling].parent = new_parent;
+	node_links[p_leaf].parent = new_parent;
+
+	if (old_parent != NULL_NODE) {
+		NodeLinks &op = node_links[old_parent];
+		op.children[op.children[0] == sibling ? 0 : 1] = new_parent;
+	} else {
+		root = new_parent;
+	}
+
+	// Walk back up the tree fixing heights and bounds.
+	index = node_links[p_leaf].parent;
+	while (index != NULL_NODE) {
+		index = _balance(p_tree, index);
+		_refit(index);
+		index = node_links[index].parent;
+	}
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_remove_leaf(int p_tree, int p_leaf) {
+
+	int &root = roots[p_tree];
+
+	if (p_leaf == root) {
+		root = NULL_NODE;
+		return;
+	}
+
+	int parent = node_links[p_leaf].parent;
+	int grand_parent = node_links[parent].parent;
+	int sibling = node_links[parent].children[node_links[parent].children[0] == p_leaf ? 1 : 0];
+
+	if (grand_parent != NULL_NODE) {
+
+		// Destroy the parent and connect the sibling to the grand parent.
+		NodeLinks &gp = node_links[grand_parent];
+		gp.children[gp.children[0] == parent ? 0 : 1] = sibling;
+		node_links[sibling].parent = grand_parent;
+		_free_node(parent);
+
+		int index = grand_parent;
+		while (index != NULL_NODE) {
+			index = _balance(p_tree, index);
+			_refit(index);
+			index = node_links[index].parent;
+		}
+	} else {
+		root = sibling;
+		node_links[sibling].parent = NULL_NODE;
+		_free_node(parent);
+	}
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_add_leaf(DynamicBVHElementID p_id) {
+
+	int leaf = _allocate_node();
+	Element &e = _get_element(p_id);
+	e.leaf = leaf;
+	e.bounds_dirty = false;
+	node_links[leaf].element = p_id;
+	_get_fat_bounds(e, node_bounds[leaf]);
+	_insert_leaf(_get_tree(e), leaf);
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_remove_element_leaf(DynamicBVHElementID p_id) {
+
+	Element &e = _get_element(p_id);
+	_remove_leaf(_get_tree(e), e.leaf);
+	_free_node(e.leaf);
+	e.leaf = NULL_NODE;
+	e.bounds_dirty = false;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_add_pair_ref(Element &p_element, DynamicBVHElementID p_other, void *p_ud) {
+
+	if (p_element.pair_count == p_element.pair_capacity) {
+		p_element.pair_capacity = p_element.pair_capacity ? p_element.pair_capacity * 2 : 4;
+		p_element.pairs = (PairRef *)memrealloc(p_element.pairs, sizeof(PairRef) * p_element.pair_capacity);
+	}
+
+	PairRef &pr = p_element.pairs[p_element.pair_count++];
+	pr.other = p_other;
+	pr.ud = p_ud;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_remove_pair_ref(Element &p_element, DynamicBVHElementID p_other) {
+
+	for (int i = 0; i < p_element.pair_count; i++) {
+		if (p_element.pairs[i].other == p_other) {
+			p_element.pairs[i] = p_element.pairs[p_element.pair_count - 1];
+			p_element.pair_count--;
+			return;
+		}
+	}
+
+	ERR_FAIL();
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_unpair_all(DynamicBVHElementID p_id) {
+
+	Element &e = _get_element(p_id);
+
+	while (e.pair_count) {
+
+		PairRef pr = e.pairs[--e.pair_count];
+		Element &other = _get_element(pr.other);
+		_remove_pair_ref(other, p_id);
+		pair_count--;
+
+		if (unpair_callback) {
+			unpair_callback(unpair_callback_userdata, p_id, e.userdata, e.subindex, pr.other, other.userdata, other.subindex, pr.ud);
+		}
+	}
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_update_pairs(DynamicBVHElementID p_id) {
+
+	Element &e = _get_element(p_id);
+	pass++;
+
+	// Drop the pairs that no longer overlap, and tag the ones that remain.
+	for (int i = 0; i < e.pair_count; i++) {
+
+		PairRef pr = e.pairs[i];
+		Element &other = _get_element(pr.other);
+
+		if (_can_pair(e, other)) {
+			other.pass = pass;
+			continue;
+		}
+
+		e.pairs[i] = e.pairs[e.pair_count - 1];
+		e.pair_count--;
+		i--;
+		_remove_pair_ref(other, p_id);
+		pair_count--;
+
+		if (unpair_callback) {
+			unpair_callback(unpair_callback_userdata, p_id, e.userdata, e.subindex, pr.other, other.userdata, other.subindex, pr.ud);
+		}
+	}
+
+	if (e.leaf == NULL_NODE)
+		return;
+
+	// Find new pairs, non pairable elements only need to look at the pairable tree.
+	Point q_min = Bounds::get_begin(e.aabb);
+	Point q_max = Bounds::get_end(e.aabb);
+
+	for (int t = e.pairable ? TREE_NON_PAIRABLE : TREE_PAIRABLE; t < TREE_MAX; t++) {
+
+		if (roots[t] == NULL_NODE)
+			continue;
+
+		int stack[STACK_SIZE];
+		int stack_size = 0;
+		stack[stack_size++] = roots[t];
+
+		while (stack_size) {
+
+			int index = stack[--stack_size];
+			if (!node_bounds[index].overlaps(q_min, q_max))
+				continue;
+
+			const NodeLinks &n = node_links[index];
+
+			if (!n.is_leaf()) {
+				ERR_FAIL_COND(stack_size + 2 > STACK_SIZE);
+				stack[stack_size++] = n.children[0];
+				stack[stack_size++] = n.children[1];
+				continue;
+			}
+
+			if (n.element == p_id)
+				continue;
+
+			Element &other = _get_element(n.element);
+			if (other.pass == pass || !_can_pair(e, other))
+				continue;
+
+			other.pass = pass;
+
+			// Callbacks must not modify the tree, so references to the elements stay valid.
+			void *ud = NULL;
+			if (pair_callback) {
+				ud = pair_callback(pair_callback_userdata, p_id, e.userdata, e.subindex, n.element, other.userdata, other.subindex);
+			}
+
+			_add_pair_ref(e, n.element, ud);
+			_add_pair_ref(other, p_id, ud);
+			pair_count++;
+		}
+	}
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::_setup_cull_planes(const Plane *p_planes, int p_plane_count, CullPlanes &r_cull_planes) {
+
+	r_cull_planes.group_count = (p_plane_count + 3) / 4;
+
+	for (int i = 0; i < r_cull_planes.group_count * 4; i++) {
+
+		int g = i / 4;
+		int l = i % 4;
+
+		if (i < p_plane_count) {
+			const Plane &p = p_planes[i];
+			r_cull_planes.normal_x[g][l] = p.normal.x;
+			r_cull_planes.normal_y[g][l] = p.normal.y;
+			r_cull_planes.normal_z[g][l] = p.normal.z;
+			r_cull_planes.d[g][l] = p.d;
+		} else {
+			// Padding, every box is inside this one.
+			r_cull_planes.normal_x[g][l] = 0;
+			r_cull_planes.normal_y[g][l] = 0;
+			r_cull_planes.normal_z[g][l] = 0;
+			r_cull_planes.d[g][l] = 1e30;
+		}
+
+		r_cull_planes.abs_normal_x[g][l] = Math::abs(r_cull_planes.normal_x[g][l]);
+		r_cull_planes.abs_normal_y[g][l] = Math::abs(r_cull_planes.normal_y[g][l]);
+		r_cull_planes.abs_normal_z[g][l] = Math::abs(r_cull_planes.normal_z[g][l]);
+	}
+}
+
+// A box is outside when it's fully over any plane, and inside when it's fully under all of them.
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::_test_cull_planes(const CullPlanes &p_cull_planes, const Vector3 &p_min, const Vector3 &p_max) {
+
+	Vector3 center = (p_min + p_max) * 0.5;
+	Vector3 extents = (p_max - p_min) * 0.5;
+	bool inside = true;
+
+#ifdef DYNAMIC_BVH_USE_SSE
+	__m128 cx = _mm_set1_ps(center.x);
+	__m128 cy = _mm_set1_ps(center.y);
+	__m128 cz = _mm_set1_ps(center.z);
+	__m128 ex = _mm_set1_ps(extents.x);
+	__m128 ey = _mm_set1_ps(extents.y);
+	__m128 ez = _mm_set1_ps(extents.z);
+	__m128 zero = _mm_setzero_ps();
+
+	for (int g = 0; g < p_cull_planes.group_count; g++) {
+
+		__m128 dist = _mm_mul_ps(_mm_loadu_ps(p_cull_planes.normal_x[g]), cx);
+		dist = _mm_add_ps(dist, _mm_mul_ps(_mm_loadu_ps(p_cull_planes.normal_y[g]), cy));
+		dist = _mm_add_ps(dist, _mm_mul_ps(_mm_loadu_ps(p_cull_planes.normal_z[g]), cz));
+		dist = _mm_sub_ps(dist, _mm_loadu_ps(p_cull_planes.d[g]));
+
+		__m128 radius = _mm_mul_ps(_mm_loadu_ps(p_cull_planes.abs_normal_x[g]), ex);
+		radius = _mm_add_ps(radius, _mm_mul_ps(_mm_loadu_ps(p_cull_planes.abs_normal_y[g]), ey));
+		radius = _mm_add_ps(radius, _mm_mul_ps(_mm_loadu_ps(p_cull_planes.abs_normal_z[g]), ez));
+
+		if (_mm_movemask_ps(_mm_cmpgt_ps(dist, radius)))
+			return CULL_OUTSIDE;
+		if (_mm_movemask_ps(_mm_cmpgt_ps(dist, _mm_sub_ps(zero, radius))))
+			inside = false;
+	}
+#else
+	for (int g = 0; g < p_cull_planes.group_count; g++) {
+
+		for (int l = 0; l < 4; l++) {
+
+			real_t dist = p_cull_planes.normal_x[g][l] * center.x + p_cull_planes.normal_y[g][l] * center.y + p_cull_planes.normal_z[g][l] * center.z - p_cull_planes.d[g][l];
+			real_t radius = p_cull_planes.abs_normal_x[g][l] * extents.x + p_cull_planes.abs_normal_y[g][l] * extents.y + p_cull_planes.abs_normal_z[g][l] * extents.z;
+
+			if (dist > radius)
+				return CULL_OUTSIDE;
+			if (dist > -radius)
+				inside = false;
+		}
+	}
+#endif
+
+	return inside ? CULL_INSIDE : CULL_INTERSECT;
+}
+
+/* PUBLIC FUNCTIONS */
+
+template <class T, bool use_pairs, class B>
+DynamicBVHElementID DynamicBVH<T, use_pairs, B>::create(T *p_userdata, const B &p_aabb, int p_subindex, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+
+#ifdef DEBUG_ENABLED
+	// check for AABB validity
+	ERR_FAIL_COND_V(!Bounds::is_valid(p_aabb), 0);
+#endif
+
+	if (element_free_list == 0) {
+
+		DynamicBVHElementID old_capacity = element_capacity;
+		element_capacity = element_capacity ? element_capacity * 2 : 64;
+		elements = (Element *)memrealloc(elements, sizeof(Element) * element_capacity);
+
+		for (DynamicBVHElementID i = old_capacity; i < element_capacity; i++) {
+			elements[i].used = false;
+			elements[i].next_free = i + 2 <= element_capacity ? i + 2 : 0;
+		}
+		element_free_list = old_capacity + 1;
+	}
+
+	DynamicBVHElementID id = element_free_list;
+	Element &e = _get_element(id);
+	element_free_list = e.next_free;
+
+	e.userdata = p_userdata;
+	e.subindex = p_subindex;
+	e.aabb = p_aabb;
+	e.motion = Point();
+	e.leaf = NULL_NODE;
+	e.pairable = p_pairable;
+	e.pairable_type = p_pairable_type;
+	e.pairable_mask = p_pairable_mask;
+	e.bounds_dirty = false;
+	e.pairs_dirty = false;
+	e.pass = 0;
+	e.pairs = NULL;
+	e.pair_count = 0;
+	e.pair_capacity = 0;
+	e.next_free = 0;
+	e.used = true;
+	element_count++;
+
+	if (!Bounds::is_empty(p_aabb)) {
+		_add_leaf(id);
+		_mark_dirty(id, false);
+	}
+
+	return id;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::move(DynamicBVHElementID p_id, const B &p_aabb) {
+
+#ifdef DEBUG_ENABLED
+	// check for AABB validity
+	ERR_FAIL_COND(!Bounds::is_valid(p_aabb));
+#endif
+	ERR_FAIL_COND(!_is_valid_id(p_id));
+
+	Element &e = _get_element(p_id);
+
+	bool old_has_surf = e.leaf != NULL_NODE;
+	bool new_has_surf = !Bounds::is_empty(p_aabb);
+
+	if (old_has_surf && new_has_surf && e.aabb == p_aabb)
+		return; // nothing to do, pairs can only change when the other element moves
+
+	e.motion = old_has_surf ? Bounds::get_begin(p_aabb) - Bounds::get_begin(e.aabb) : Point();
+	e.aabb = p_aabb;
+
+	if (!new_has_surf) {
+
+		if (old_has_surf) {
+			_remove_element_leaf(p_id);
+			_unpair_all(p_id);
+		}
+		return;
+	}
+
+	if (!old_has_surf) {
+
+		_add_leaf(p_id);
+		_mark_dirty(p_id, false);
+		return;
+	}
+
+	// Still inside its leaf, only the pairs need checking.
+	_mark_dirty(p_id, !node_bounds[e.leaf].encloses(Bounds::get_begin(p_aabb), Bounds::get_end(p_aabb)));
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::set_pairable(DynamicBVHElementID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+
+	ERR_FAIL_COND(!_is_valid_id(p_id));
+
+	Element &e = _get_element(p_id);
+
+	if (p_pairable == e.pairable && e.pairable_type == p_pairable_type && e.pairable_mask == p_pairable_mask)
+		return; // no changes, return
+
+	bool in_tree = e.leaf != NULL_NODE;
+	bool change_tree = in_tree && p_pairable != e.pairable;
+
+	if (change_tree) {
+		_remove_element_leaf(p_id);
+	}
+
+	e.pairable = p_pairable;
+	e.pairable_type = p_pairable_type;
+	e.pairable_mask = p_pairable_mask;
+
+	if (change_tree) {
+		_add_leaf(p_id);
+	}
+
+	if (use_pairs && in_tree) {
+		_update_pairs(p_id);
+	}
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::erase(DynamicBVHElementID p_id) {
+
+	ERR_FAIL_COND(!_is_valid_id(p_id));
+
+	Element &e = _get_element(p_id);
+
+	if (e.leaf != NULL_NODE) {
+		_remove_element_leaf(p_id);
+	}
+
+	_unpair_all(p_id);
+
+	if (e.pairs) {
+		memfree(e.pairs);
+		e.pairs = NULL;
+	}
+
+	e.bounds_dirty = false;
+	e.pairs_dirty = false;
+	e.used = false;
+	e.next_free = element_free_list;
+	element_free_list = p_id;
+	element_count--;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::update() {
+
+	if (!dirty_count)
+		return;
+
+	// Elements that moved far from their place in the tree are reinserted. This happens before any leaf
+	// is changed in place, so the trees are always valid while inserting.
+	for (int i = 0; i < dirty_count; i++) {
+
+		DynamicBVHElementID id = dirty_elements[i];
+		Element &e = _get_element(id);
+		if (!e.used || !e.bounds_dirty)
+			continue;
+
+		NodeBounds fat;
+		_get_fat_bounds(e, fat);
+
+		int parent = node_links[e.leaf].parent;
+		int grand_parent = parent != NULL_NODE ? node_links[parent].parent : NULL_NODE;
+
+		if (grand_parent == NULL_NODE || !node_bounds[grand_parent].encloses(fat.min, fat.max)) {
+			int tree = _get_tree(e);
+			_remove_leaf(tree, e.leaf);
+			node_bounds[e.leaf] = fat;
+			_insert_leaf(tree, e.leaf);
+			e.bounds_dirty = false;
+		}
+	}
+
+	// The rest are updated in place, then their ancestors are refitted once each, children before parents.
+	// Refits stop going up as soon as a node's bounds don't change.
+	for (int i = 0; i < dirty_count; i++) {
+
+		DynamicBVHElementID id = dirty_elements[i];
+		Element &e = _get_element(id);
+		if (!e.used || !e.bounds_dirty)
+			continue;
+
+		e.bounds_dirty = false;
+		_get_fat_bounds(e, node_bounds[e.leaf]);
+
+		if (node_links[e.leaf].parent != NULL_NODE) {
+			_queue_refit(node_links[e.leaf].parent);
+		}
+	}
+
+	for (int h = 1; h < MAX_HEIGHT; h++) {
+
+		while (refit_queues[h] != NULL_NODE) {
+
+			int index = refit_queues[h];
+			NodeLinks &n = node_links[index];
+			refit_queues[h] = n.next_refit;
+			n.refit_queued = false;
+
+			NodeBounds old_bounds = node_bounds[index];
+			_refit(index);
+
+			if (n.parent != NULL_NODE && (old_bounds.min != node_bounds[index].min || old_bounds.max != node_bounds[index].max)) {
+				_queue_refit(n.parent);
+			}
+		}
+	}
+
+	if (use_pairs) {
+
+		for (int i = 0; i < dirty_count; i++) {
+
+			DynamicBVHElementID id = dirty_elements[i];
+			Element &e = _get_element(id);
+			if (!e.used || !e.pairs_dirty)
+				continue;
+
+			e.pairs_dirty = false;
+			_update_pairs(id);
+		}
+	}
+
+	dirty_count = 0;
+}
+
+template <class T, bool use_pairs, class B>
+bool DynamicBVH<T, use_pairs, B>::is_pairable(DynamicBVHElementID p_id) const {
+
+	ERR_FAIL_COND_V(!_is_valid_id(p_id), false);
+	return _get_element(p_id).pairable;
+}
+
+template <class T, bool use_pairs, class B>
+T *DynamicBVH<T, use_pairs, B>::get(DynamicBVHElementID p_id) const {
+
+	ERR_FAIL_COND_V(!_is_valid_id(p_id), NULL);
+	return _get_element(p_id).userdata;
+}
+
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::get_subindex(DynamicBVHElementID p_id) const {
+
+	ERR_FAIL_COND_V(!_is_valid_id(p_id), -1);
+	return _get_element(p_id).subindex;
+}
+
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask) const {
+
+	if (p_convex.empty())
+		return 0;
+
+	ERR_FAIL_COND_V(p_convex.size() > MAX_PLANE_GROUPS * 4, 0);
+
+	CullPlanes cull_planes;
+	_setup_cull_planes(&p_convex[0], p_convex.size(), cull_planes);
+
+	int count = 0;
+
+	for (int t = 0; t < TREE_MAX; t++) {
+
+		if (roots[t] == NULL_NODE)
+			continue;
+
+		// The lowest bit tells whether the node is known to be fully inside, so there's nothing left to test.
+		int stack[STACK_SIZE];
+		int stack_size = 0;
+		stack[stack_size++] = roots[t] << 1;
+
+		while (stack_size) {
+
+			int entry = stack[--stack_size];
+			int index = entry >> 1;
+			bool inside = entry & 1;
+
+			if (!inside) {
+				int result = _test_cull_planes(cull_planes, node_bounds[index].min, node_bounds[index].max);
+				if (result == CULL_OUTSIDE)
+					continue;
+				inside = result == CULL_INSIDE;
+			}
+
+			const NodeLinks &n = node_links[index];
+
+			if (!n.is_leaf()) {
+				ERR_FAIL_COND_V(stack_size + 2 > STACK_SIZE, count);
+				stack[stack_size++] = (n.children[0] << 1) | int(inside);
+				stack[stack_size++] = (n.children[1] << 1) | int(inside);
+				continue;
+			}
+
+			const Element &e = _get_element(n.element);
+
+			if (use_pairs && !(e.pairable_type & p_mask))
+				continue;
+
+			if (!inside && _test_cull_planes(cull_planes, e.aabb.position, e.aabb.position + e.aabb.size) == CULL_OUTSIDE)
+				continue;
+
+			if (count == p_result_max)
+				return count; // pointless to continue
+
+			p_result_array[count++] = e.userdata;
+		}
+	}
+
+	return count;
+}
+
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::cull_aabb(const B &p_aabb, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const {
+
+	Point q_min = Bounds::get_begin(p_aabb);
+	Point q_max = Bounds::get_end(p_aabb);
+
+	int count = 0;
+
+	for (int t = 0; t < TREE_MAX; t++) {
+
+		if (roots[t] == NULL_NODE)
+			continue;
+
+		int stack[STACK_SIZE];
+		int stack_size = 0;
+		stack[stack_size++] = roots[t];
+
+		while (stack_size) {
+
+			int index = stack[--stack_size];
+			if (!node_bounds[index].overlaps(q_min, q_max))
+				continue;
+
+			const NodeLinks &n = node_links[index];
+
+			if (!n.is_leaf()) {
+				ERR_FAIL_COND_V(stack_size + 2 > STACK_SIZE, count);
+				stack[stack_size++] = n.children[0];
+				stack[stack_size++] = n.children[1];
+				continue;
+			}
+
+			const Element &e = _get_element(n.element);
+
+			if ((use_pairs && !(e.pairable_type & p_mask)) || !Bounds::intersects(p_aabb, e.aabb))
+				continue;
+
+			if (count == p_result_max)
+				return count; // pointless to continue
+
+			p_result_array[count] = e.userdata;
+			if (p_subindex_array)
+				p_subindex_array[count] = e.subindex;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::cull_segment(const Point &p_from, const Point &p_to, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const {
+
+	Point seg_min = Bounds::min(p_from, p_to);
+	Point seg_max = Bounds::max(p_from, p_to);
+
+	int count = 0;
+
+	for (int t = 0; t < TREE_MAX; t++) {
+
+		if (roots[t] == NULL_NODE)
+			continue;
+
+		int stack[STACK_SIZE];
+		int stack_size = 0;
+		stack[stack_size++] = roots[t];
+
+		while (stack_size) {
+
+			int index = stack[--stack_size];
+			const NodeBounds &b = node_bounds[index];
+			if (!b.overlaps(seg_min, seg_max))
+				continue;
+
+			const NodeLinks &n = node_links[index];
+
+			if (!n.is_leaf()) {
+				if (!B(b.min, b.max - b.min).intersects_segment(p_from, p_to))
+					continue;
+				ERR_FAIL_COND_V(stack_size + 2 > STACK_SIZE, count);
+				stack[stack_size++] = n.children[0];
+				stack[stack_size++] = n.children[1];
+				continue;
+			}
+
+			const Element &e = _get_element(n.element);
+
+			if ((use_pairs && !(e.pairable_type & p_mask)) || !e.aabb.intersects_segment(p_from, p_to))
+				continue;
+
+			if (count == p_result_max)
+				return count; // pointless to continue
+
+			p_result_array[count] = e.userdata;
+			if (p_subindex_array)
+				p_subindex_array[count] = e.subindex;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::cull_point(const Point &p_point, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) const {
+
+	int count = 0;
+
+	for (int t = 0; t < TREE_MAX; t++) {
+
+		if (roots[t] == NULL_NODE)
+			continue;
+
+		int stack[STACK_SIZE];
+		int stack_size = 0;
+		stack[stack_size++] = roots[t];
+
+		while (stack_size) {
+
+			int index = stack[--stack_size];
+			if (!node_bounds[index].overlaps(p_point, p_point))
+				continue;
+
+			const NodeLinks &n = node_links[index];
+
+			if (!n.is_leaf()) {
+				ERR_FAIL_COND_V(stack_size + 2 > STACK_SIZE, count);
+				stack[stack_size++] = n.children[0];
+				stack[stack_size++] = n.children[1];
+				continue;
+			}
+
+			const Element &e = _get_element(n.element);
+
+			if ((use_pairs && !(e.pairable_type & p_mask)) || !e.aabb.has_point(p_point))
+				continue;
+
+			if (count == p_result_max)
+				return count; // pointless to continue
+
+			p_result_array[count] = e.userdata;
+			if (p_subindex_array)
+				p_subindex_array[count] = e.subindex;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::set_pair_callback(PairCallback p_callback, void *p_userdata) {
+
+	pair_callback = p_callback;
+	pair_callback_userdata = p_userdata;
+}
+
+template <class T, bool use_pairs, class B>
+void DynamicBVH<T, use_pairs, B>::set_unpair_callback(UnpairCallback p_callback, void *p_userdata) {
+
+	unpair_callback = p_callback;
+	unpair_callback_userdata = p_userdata;
+}
+
+template <class T, bool use_pairs, class B>
+int DynamicBVH<T, use_pairs, B>::get_tree_height() const {
+
+	int height = 0;
+	for (int t = 0; t < TREE_MAX; t++) {
+		if (roots[t] != NULL_NODE)
+			height = MAX(height, node_links[roots[t]].height);
+	}
+	return height;
+}
+
+template <class T, bool use_pairs, class B>
+DynamicBVH<T, use_pairs, B>::DynamicBVH(real_t p_fat_margin) {
+
+	node_bounds = NULL;
+	node_links = NULL;
+	node_capacity = 0;
+	node_free_list = NULL_NODE;
+	for (int t = 0; t < TREE_MAX; t++) {
+		roots[t] = NULL_NODE;
+	}
+
+	elements = NULL;
+	element_capacity = 0;
+	element_free_list = 0;
+	element_count = 0;
+
+	dirty_elements = NULL;
+	dirty_count = 0;
+	dirty_capacity = 0;
+
+	for (int i = 0; i < MAX_HEIGHT; i++) {
+		refit_queues[i] = NULL_NODE;
+	}
+
+	pass = 1;
+	fat_margin = p_fat_margin;
+
+	pair_callback = NULL;
+	unpair_callback = NULL;
+	pair_callback_userdata = NULL;
+	unpair_callback_userdata = NULL;
+	pair_count = 0;
+}
+
+template <class T, bool use_pairs, class B>
+DynamicBVH<T, use_pairs, B>::~DynamicBVH() {
+
+	for (DynamicBVHElementID i = 0; i < element_capacity; i++) {
+		if (elements[i].used && elements[i].pairs) {
+			memfree(elements[i].pairs);
+		}
+	}
+
+	if (elements)
+		memfree(elements);
+	if (node_bounds)
+		memfree(node_bounds);
+	if (node_links)
+		memfree(node_links);
+	if (dirty_elements)
+		memfree(dirty_elements);
+}
+
+#endif // DYNAMIC_BVH_H
@@ -352,6 +352,27 @@ private:
 	};
 
 	void _cull_convex(Octant *p_octant, _CullConvexData *p_cull);
+	void _cull_convex_read_only(const Octant *p_octant, _CullConvexData *p_cull) const;
+
+	_FORCE_INLINE_ bool _is_first_culled_owner(const Element *p_element, const Octant *p_octant, const _CullConvexData *p_cull) const {
+
+		// Elements can be in several octants. Without passes, an element is reported only from the
+		// first of its octants that the cull visits (the root is always visited).
+		if (p_element->octant_owners.size() == 1)
+			return true;
+
+		for (const typename List<typename Element::OctantOwner, AL>::Element *E = p_element->octant_owners.front(); E; E = E->next()) {
+
+			const Octant *o = E->get().octant;
+			if (o == p_octant)
+				return true;
+			if (o == root || o->aabb.intersects_convex_shape(p_cull->planes, p_cull->plane_count))
+				return false;
+		}
+
+		return true;
+	}
+
 	void _cull_aabb(Octant *p_octant, const AABB &p_aabb, T **p_result_array, int *p_result_idx, int p_result_max, int *p_subindex_array, uint32_t p_mask);
 	void _cull_segment(Octant *p_octant, const Vector3 &p_from, const Vector3 &p_to, T **p_result_array, int *p_result_idx, int p_result_max, int *p_subindex_array, uint32_t p_mask);
 	void _cull_point(Octant *p_octant, const Vector3 &p_point, T **p_result_array, int *p_result_idx, int p_result_max, int *p_subindex_array, uint32_t p_mask);
@@ -381,6 +402,8 @@ public:
 	int get_subindex(OctreeElementID p_id) const;
 
 	int cull_convex(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+	// Same as cull_convex(), but doesn't modify the octree, so several culls can run at the same time on different threads.
+	int cull_convex_read_only(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) const;
 	int cull_aabb(const AABB &p_aabb, T **p_result_array, int p_result_max, int *p_subindex_array = NULL, uint32_t p_mask = 0xFFFFFFFF);
 	int cull_segment(const Vector3 &p_from, const Vector3 &p_to, T **p_result_array, int p_result_max, int *p_subindex_array = NULL, uint32_t p_mask = 0xFFFFFFFF);
 
@@ -1072,6 +1095,48 @@ void Octree<T, use_pairs, AL>::_cull_convex(Octant *p_octant, _CullConvexData *p
 	}
 }
 
+template <class T, bool use_pairs, class AL>
+void Octree<T, use_pairs, AL>::_cull_convex_read_only(const Octant *p_octant, _CullConvexData *p_cull) const {
+
+	if (*p_cull->result_idx == p_cull->result_max)
+		return; //pointless
+
+	for (int l = 0; l < 2; l++) {
+
+		const List<Element *, AL> &list = l == 0 ? p_octant->elements : p_octant->pairable_elements;
+		if (!use_pairs && l == 1)
+			break;
+
+		for (const typename List<Element *, AL>::Element *I = list.front(); I; I = I->next()) {
+
+			const Element *e = I->get();
+
+			if (use_pairs && !(e->pairable_type & p_cull->mask))
+				continue;
+
+			if (!e->aabb.intersects_convex_shape(p_cull->planes, p_cull->plane_count))
+				continue;
+
+			if (!_is_first_culled_owner(e, p_octant, p_cull))
+				continue;
+
+			if (*p_cull->result_idx < p_cull->result_max) {
+				p_cull->result_array[*p_cull->result_idx] = e->userdata;
+				(*p_cull->result_idx)++;
+			} else {
+				return; // pointless to continue
+			}
+		}
+	}
+
+	for (int i = 0; i < 8; i++) {
+
+		if (p_octant->children[i] && p_octant->children[i]->aabb.intersects_convex_shape(p_cull->planes, p_cull->plane_count)) {
+			_cull_convex_read_only(p_octant->children[i], p_cull);
+		}
+	}
+}
+
 template <class T, bool use_pairs, class AL>
 void Octree<T, use_pairs, AL>::_cull_aabb(Octant *p_octant, const AABB &p_aabb, T **p_result_array, int *p_result_idx, int p_result_max, int *p_subindex_array, uint32_t p_mask) {
 
@@ -1313,6 +1378,26 @@ int Octree<T, use_pairs, AL>::cull_convex(const Vector<Plane> &p_convex, T **p_r
 	return result_count;
 }
 
+template <class T, bool use_pairs, class AL>
+int Octree<T, use_pairs, AL>::cull_convex_read_only(const Vector<Plane> &p_convex, T **p_result_array, int p_result_max, uint32_t p_mask) const {
+
+	if (!root)
+		return 0;
+
+	int result_count = 0;
+	_CullConvexData cdata;
+	cdata.planes = &p_convex[0];
+	cdata.plane_count = p_convex.size();
+	cdata.result_array = p_result_array;
+	cdata.result_max = p_result_max;
+	cdata.result_idx = &result_count;
+	cdata.mask = p_mask;
+
+	_cull_convex_read_only(root, &cdata);
+
+	return result_count;
+}
+
 template <class T, bool use_pairs, class AL>
 int Octree<T, use_pairs, AL>::cull_aabb(const AABB &p_aabb, T **p_result_array, int p_result_max, int *p_subindex_array, uint32_t p_mask) {
 
@@ -30,33 +30,128 @@
 
 #include "message_queue.h"
 
+#include "core/os/os.h"
 #include "core/project_settings.h"
+#include "core/safe_refcount.h"
 #include "core/script_language.h"
 
+#define MESSAGE_QUEUE_PAGE_HEADER ((sizeof(Page) + 15) & ~size_t(15))
+
 MessageQueue *MessageQueue::singleton = NULL;
 
+static uint32_t message_queue_generation = 0;
+
+// Ties each thread to its buffer, and tells the queue when the thread is gone.
+struct MessageQueueThreadHolder {
+
+	MessageQueue *queue;
+	uint32_t generation;
+	MessageQueue::ThreadBuffer *buffer;
+
+	~MessageQueueThreadHolder() {
+
+		if (queue && queue == MessageQueue::singleton && generation == queue->generation) {
+			queue->lock->lock();
+			buffer->exited = true;
+			queue->lock->unlock();
+		}
+
+		// a push from a later thread_local destructor gets a new buffer, freed with the queue
+		queue = NULL;
+		buffer = NULL;
+	}
+};
+
+static thread_local MessageQueueThreadHolder thread_holder;
+
 MessageQueue *MessageQueue::get_singleton() {
 
 	return singleton;
 }
 
-Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
+MessageQueue::Page *MessageQueue::_alloc_page(uint32_t p_size) {
+
+	Page *page = (Page *)memalloc(MESSAGE_QUEUE_PAGE_HEADER + p_size);
+	ERR_FAIL_COND_V(!page, NULL);
 
-	_THREAD_SAFE_METHOD_
+	page->next = NULL;
+	page->size = p_size;
+	page->write = 0;
+	page->end = 0;
+	page->read = 0;
+	return page;
+}
+
+MessageQueue::ThreadBuffer *MessageQueue::_get_thread_buffer() {
 
-	int room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
+	MessageQueueThreadHolder &holder = thread_holder;
+	if (likely(holder.queue == this && holder.generation == generation)) {
+		return holder.buffer;
+	}
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id))
-			type = ObjectDB::get_instance(p_id)->get_class();
-		print_line("Failed method: " + type + ":" + p_method + " target ID: " + itos(p_id));
-		statistics();
-		ERR_EXPLAIN("Message queue out of memory. Try increasing 'message_queue_size_kb' in project settings.");
-		ERR_FAIL_V(ERR_OUT_OF_MEMORY);
+	ThreadBuffer *buffer = memnew(ThreadBuffer);
+	buffer->next = NULL;
+	buffer->write_page = _alloc_page(PAGE_SIZE);
+	buffer->read_page = buffer->write_page;
+	buffer->exited = false;
+	ERR_FAIL_COND_V(!buffer->write_page, NULL);
+
+	lock->lock();
+	if (last_buffer) {
+		last_buffer->next = buffer;
+	} else {
+		buffers = buffer;
 	}
+	last_buffer = buffer;
+	lock->unlock();
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	holder.queue = this;
+	holder.generation = generation;
+	holder.buffer = buffer;
+	return buffer;
+}
+
+uint8_t *MessageQueue::_reserve(uint32_t p_room, Page *&r_page) {
+
+	ThreadBuffer *buffer = _get_thread_buffer();
+	ERR_FAIL_COND_V(!buffer, NULL);
+
+	Page *page = buffer->write_page;
+
+	if (unlikely(page->write + p_room > page->size)) {
+
+		Page *next = _alloc_page(MAX(uint32_t(PAGE_SIZE), p_room));
+		ERR_FAIL_COND_V(!next, NULL);
+
+		// the flushing thread moves on to the next page once it sees the link
+		lock->lock();
+		page->next = next;
+		lock->unlock();
+
+		buffer->write_page = next;
+		page = next;
+	}
+
+	r_page = page;
+	return (uint8_t *)page + MESSAGE_QUEUE_PAGE_HEADER + page->write;
+}
+
+void MessageQueue::_publish(Page *p_page, uint32_t p_room) {
+
+	p_page->write += p_room;
+	// full barrier, the message is complete before it can be seen
+	atomic_add(&p_page->end, p_room);
+}
+
+Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
+
+	uint32_t room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
+
+	Page *page;
+	uint8_t *mem = _reserve(room_needed, page);
+	ERR_FAIL_COND_V(!mem, ERR_OUT_OF_MEMORY);
+
+	Message *msg = memnew_placement(mem, Message);
 	msg->args = p_argcount;
 	msg->instance_ID = p_id;
 	msg->target = p_method;
@@ -64,15 +159,14 @@ Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, const V
 	if (p_show_error)
 		msg->type |= FLAG_SHOW_ERROR;
 
-	buffer_end += sizeof(Message);
-
+	Variant *args = (Variant *)(msg + 1);
 	for (int i = 0; i < p_argcount; i++) {
 
-		Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-		buffer_end += sizeof(Variant);
-		*v = *p_args[i];
+		memnew_placement(&args[i], Variant(*p_args[i]));
 	}
 
+	_publish(page, room_needed);
+
 	return OK;
 }
 
@@ -93,61 +187,43 @@ Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, VARIANT
 
 Error MessageQueue::push_set(ObjectID p_id, const StringName &p_prop, const Variant &p_value) {
 
-	_THREAD_SAFE_METHOD_
-
-	uint8_t room_needed = sizeof(Message) + sizeof(Variant);
+	uint32_t room_needed = sizeof(Message) + sizeof(Variant);
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id))
-			type = ObjectDB::get_instance(p_id)->get_class();
-		print_line("Failed set: " + type + ":" + p_prop + " target ID: " + itos(p_id));
-		statistics();
-		ERR_EXPLAIN("Message queue out of memory. Try increasing 'message_queue_size_kb' in project settings.");
-		ERR_FAIL_V(ERR_OUT_OF_MEMORY);
-	}
+	Page *page;
+	uint8_t *mem = _reserve(room_needed, page);
+	ERR_FAIL_COND_V(!mem, ERR_OUT_OF_MEMORY);
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Message *msg = memnew_placement(mem, Message);
 	msg->args = 1;
 	msg->instance_ID = p_id;
 	msg->target = p_prop;
 	msg->type = TYPE_SET;
 
-	buffer_end += sizeof(Message);
+	memnew_placement(msg + 1, Variant(p_value));
 
-	Variant *v = memnew_placement(&buffer[buffer_end], Variant);
-	buffer_end += sizeof(Variant);
-	*v = p_value;
+	_publish(page, room_needed);
 
 	return OK;
 }
 
 Error MessageQueue::push_notification(ObjectID p_id, int p_notification) {
 
-	_THREAD_SAFE_METHOD_
-
 	ERR_FAIL_COND_V(p_notification < 0, ERR_INVALID_PARAMETER);
 
-	uint8_t room_needed = sizeof(Message);
+	uint32_t room_needed = sizeof(Message);
 
-	if ((buffer_end + room_needed) >= buffer_size) {
-		String type;
-		if (ObjectDB::get_instance(p_id))
-			type = ObjectDB::get_instance(p_id)->get_class();
-		print_line("Failed notification: " + itos(p_notification) + " target ID: " + itos(p_id));
-		statistics();
-		ERR_EXPLAIN("Message queue out of memory. Try increasing 'message_queue_size_kb' in project settings.");
-		ERR_FAIL_V(ERR_OUT_OF_MEMORY);
-	}
+	Page *page;
+	uint8_t *mem = _reserve(room_needed, page);
+	ERR_FAIL_COND_V(!mem, ERR_OUT_OF_MEMORY);
 
-	Message *msg = memnew_placement(&buffer[buffer_end], Message);
+	Message *msg = memnew_placement(mem, Message);
 
 	msg->type = TYPE_NOTIFICATION;
 	msg->instance_ID = p_id;
 	//msg->target;
 	msg->notification = p_notification;
 
-	buffer_end += sizeof(Message);
+	_publish(page, room_needed);
 
 	return OK;
 }
@@ -172,56 +248,71 @@ void MessageQueue::statistics() {
 	Map<int, int> notify_count;
 	Map<StringName, int> call_count;
 	int null_count = 0;
+	uint64_t total_bytes = 0;
 
-	uint32_t read_pos = 0;
-	while (read_pos < buffer_end) {
-		Message *message = (Message *)&buffer[read_pos];
+	lock->lock();
 
-		Object *target = ObjectDB::get_instance(message->instance_ID);
+	for (ThreadBuffer *b = buffers; b; b = b->next) {
 
-		if (target != NULL) {
+		for (Page *page = b->read_page; page; page = page->next) {
 
-			switch (message->type & FLAG_MASK) {
+			uint8_t *data = (uint8_t *)page + MESSAGE_QUEUE_PAGE_HEADER;
+			uint32_t end = atomic_add(&page->end, 0);
+			uint32_t read_pos = page->read;
+			total_bytes += end - read_pos;
 
-				case TYPE_CALL: {
+			while (read_pos < end) {
+				Message *message = (Message *)&data[read_pos];
 
-					if (!call_count.has(message->target))
-						call_count[message->target] = 0;
+				Object *target = ObjectDB::get_instance(message->instance_ID);
 
-					call_count[message->target]++;
+				if (target != NULL) {
 
-				} break;
-				case TYPE_NOTIFICATION: {
+					switch (message->type & FLAG_MASK) {
 
-					if (!notify_count.has(message->notification))
-						notify_count[message->notification] = 0;
+						case TYPE_CALL: {
 
-					notify_count[message->notification]++;
+							if (!call_count.has(message->target))
+								call_count[message->target] = 0;
 
-				} break;
-				case TYPE_SET: {
+							call_count[message->target]++;
 
-					if (!set_count.has(message->target))
-						set_count[message->target] = 0;
+						} break;
+						case TYPE_NOTIFICATION: {
 
-					set_count[message->target]++;
+							if (!notify_count.has(message->notification))
+								notify_count[message->notification] = 0;
 
-				} break;
-			}
+							notify_count[message->notification]++;
 
-		} else {
-			//object was deleted
-			print_line("Object was deleted while awaiting a callback");
+						} break;
+						case TYPE_SET: {
 
-			null_count++;
-		}
+							if (!set_count.has(message->target))
+								set_count[message->target] = 0;
+
+							set_count[message->target]++;
+
+						} break;
+					}
+
+				} else {
+					//object was deleted
+					print_line("Object was deleted while awaiting a callback");
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION)
-			read_pos += sizeof(Variant) * message->args;
+					null_count++;
+				}
+
+				read_pos += sizeof(Message);
+				if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION)
+					read_pos += sizeof(Variant) * message->args;
+			}
+		}
 	}
 
-	print_line("TOTAL BYTES: " + itos(buffer_end));
+	lock->unlock();
+
+	print_line("TOTAL BYTES: " + itos(total_bytes));
 	print_line("NULL count: " + itos(null_count));
 
 	for (Map<StringName, int>::Element *E = set_count.front(); E; E = E->next()) {
@@ -242,6 +333,24 @@ int MessageQueue::get_max_buffer_usage() const {
 	return buffer_max_used;
 }
 
+void MessageQueue::end_frame() {
+
+	last_frame_flush_usec = frame_flush_usec;
+	last_frame_depth_max = frame_depth_max;
+	frame_flush_usec = 0;
+	frame_depth_max = 0;
+}
+
+uint32_t MessageQueue::get_frame_depth_max() const {
+
+	return last_frame_depth_max;
+}
+
+uint64_t MessageQueue::get_frame_flush_usec() const {
+
+	return last_frame_flush_usec;
+}
+
 void MessageQueue::_call_function(Object *p_target, const StringName &p_func, const Variant *p_args, int p_argcount, bool p_show_error) {
 
 	const Variant **argptrs = NULL;
@@ -260,78 +369,199 @@ void MessageQueue::_call_function(Object *p_target, const StringName &p_func, co
 	}
 }
 
-void MessageQueue::flush() {
+void MessageQueue::_process_message(Message *p_message) {
 
-	if (buffer_end > buffer_max_used) {
-		buffer_max_used = buffer_end;
-	}
+	Object *target = ObjectDB::get_instance(p_message->instance_ID);
 
-	uint32_t read_pos = 0;
+	if (target != NULL) {
 
-	//using reverse locking strategy
-	_THREAD_SAFE_LOCK_
+		switch (p_message->type & FLAG_MASK) {
+			case TYPE_CALL: {
 
-	ERR_FAIL_COND(flushing); //already flushing, you did something odd
-	flushing = true;
+				Variant *args = (Variant *)(p_message + 1);
 
-	while (read_pos < buffer_end) {
+				// messages don't expect a return value
 
-		//lock on each iteration, so a call can re-add itself to the message queue
+				_call_function(target, p_message->target, args, p_message->args, p_message->type & FLAG_SHOW_ERROR);
 
-		Message *message = (Message *)&buffer[read_pos];
+			} break;
+			case TYPE_NOTIFICATION: {
 
-		uint32_t advance = sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION)
-			advance += sizeof(Variant) * message->args;
+				// messages don't expect a return value
+				target->notification(p_message->notification);
 
-		//pre-advance so this function is reentrant
-		read_pos += advance;
+			} break;
+			case TYPE_SET: {
 
-		_THREAD_SAFE_UNLOCK_
+				Variant *arg = (Variant *)(p_message + 1);
+				// messages don't expect a return value
+				target->set(p_message->target, *arg);
 
-		Object *target = ObjectDB::get_instance(message->instance_ID);
+			} break;
+		}
+	}
 
-		if (target != NULL) {
+	_destroy_message(p_message);
+}
 
-			switch (message->type & FLAG_MASK) {
-				case TYPE_CALL: {
+void MessageQueue::_destroy_message(Message *p_message) {
 
-					Variant *args = (Variant *)(message + 1);
+	if ((p_message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+		Variant *args = (Variant *)(p_message + 1);
+		for (int i = 0; i < p_message->args; i++) {
+			args[i].~Variant();
+		}
+	}
 
-					// messages don't expect a return value
+	p_message->~Message();
+}
 
-					_call_function(target, message->target, args, message->args, message->type & FLAG_SHOW_ERROR);
+bool MessageQueue::_flush_buffer(ThreadBuffer *p_buffer, bool p_own, uint32_t p_budget, uint32_t &r_messages, uint32_t &r_bytes) {
 
-					for (int i = 0; i < message->args; i++) {
-						args[i].~Variant();
-					}
+	bool flushed = false;
 
-				} break;
-				case TYPE_NOTIFICATION: {
+	while (r_bytes < p_budget) {
 
-					// messages don't expect a return value
-					target->notification(message->notification);
+		Page *page = p_buffer->read_page;
+		uint8_t *data = (uint8_t *)page + MESSAGE_QUEUE_PAGE_HEADER;
+		uint32_t end = atomic_add(&page->end, 0);
+
+		while (page->read < end && r_bytes < p_budget) {
+
+			Message *message = (Message *)&data[page->read];
+
+			uint32_t advance = sizeof(Message);
+			if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION)
+				advance += sizeof(Variant) * message->args;
+
+			//pre-advance so this function is reentrant
+			page->read += advance;
+			r_bytes += advance;
+			r_messages++;
+			flushed = true;
+
+			_process_message(message);
+
+			if (p_own) {
+				// calls made here may have appended to this page
+				end = page->write;
+			}
+		}
 
-				} break;
-				case TYPE_SET: {
+		if (page->read < end) {
+			break; // Over budget.
+		}
 
-					Variant *arg = (Variant *)(message + 1);
-					// messages don't expect a return value
-					target->set(message->target, *arg);
+		lock->lock();
+		Page *next = page->next;
+		lock->unlock();
 
-					arg->~Variant();
-				} break;
+		if (!next) {
+			if (p_own && page->read == page->write) {
+				// nobody else writes to it, start over
+				page->read = 0;
+				page->write = 0;
+				page->end = 0;
 			}
+			break;
+		}
+
+		// the owner finished this page before linking the next one
+		if (page->read < atomic_add(&page->end, 0)) {
+			continue;
 		}
 
-		message->~Message();
+		p_buffer->read_page = next;
+		memfree(page);
+	}
+
+	return flushed;
+}
+
+bool MessageQueue::_is_drained(ThreadBuffer *p_buffer) {
+
+	Page *page = p_buffer->read_page;
+	return !page->next && page->read == atomic_add(&page->end, 0);
+}
+
+void MessageQueue::_flush(uint32_t p_budget) {
+
+	lock->lock();
+	bool already_flushing = flushing;
+	flushing = true;
+	lock->unlock();
+
+	ERR_FAIL_COND(already_flushing); //already flushing, you did something odd
 
-		_THREAD_SAFE_LOCK_
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	ThreadBuffer *own = _get_thread_buffer();
+	uint32_t messages = 0;
+	uint32_t bytes = 0;
+
+	// keep going over the threads in order until nothing new came in
+	bool pending = true;
+	while (pending && bytes < p_budget) {
+
+		pending = false;
+
+		lock->lock();
+		ThreadBuffer *buffer = buffers;
+		lock->unlock();
+
+		ThreadBuffer *prev = NULL;
+
+		while (buffer) {
+
+			if (_flush_buffer(buffer, buffer == own, p_budget, messages, bytes)) {
+				pending = true;
+			}
+
+			lock->lock();
+			ThreadBuffer *next = buffer->next;
+			if (buffer->exited && buffer != own && _is_drained(buffer)) {
+
+				if (prev) {
+					prev->next = next;
+				} else {
+					buffers = next;
+				}
+				if (last_buffer == buffer) {
+					last_buffer = prev;
+				}
+
+				memfree(buffer->read_page);
+				memdelete(buffer);
+			} else {
+				prev = buffer;
+			}
+			lock->unlock();
+
+			buffer = next;
+		}
 	}
 
-	buffer_end = 0; // reset buffer
+	if (bytes >= p_budget) {
+		WARN_PRINT_ONCE("Message queue grew past 'memory/limits/message_queue/max_size_kb' in a single flush, the remaining messages were left for the next flush.");
+	}
+
+	buffer_max_used = MAX(buffer_max_used, bytes);
+	frame_depth_max = MAX(frame_depth_max, messages);
+	frame_flush_usec += OS::get_singleton()->get_ticks_usec() - begin;
+
+	lock->lock();
 	flushing = false;
-	_THREAD_SAFE_UNLOCK_
+	lock->unlock();
+}
+
+void MessageQueue::flush() {
+
+	_flush(buffer_size);
+}
+
+void MessageQueue::drain() {
+
+	_flush(0xFFFFFFFF);
 }
 
 bool MessageQueue::is_flushing() const {
@@ -345,34 +575,55 @@ MessageQueue::MessageQueue() {
 	singleton = this;
 	flushing = false;
 
-	buffer_end = 0;
+	lock = Mutex::create();
+	buffers = NULL;
+	last_buffer = NULL;
+	generation = ++message_queue_generation;
+
 	buffer_max_used = 0;
 	buffer_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_kb", DEFAULT_QUEUE_SIZE_KB);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/message_queue/max_size_kb", PropertyInfo(Variant::INT, "memory/limits/message_queue/max_size_kb", PROPERTY_HINT_RANGE, "0,2048,1,or_greater"));
 	buffer_size *= 1024;
-	buffer = memnew_arr(uint8_t, buffer_size);
+	buffer_size = MAX(buffer_size, uint32_t(PAGE_SIZE)); // a flush always makes progress
+
+	frame_flush_usec = 0;
+	last_frame_flush_usec = 0;
+	frame_depth_max = 0;
+	last_frame_depth_max = 0;
+
+	// the creating thread is flushed first
+	_get_thread_buffer();
 }
 
 MessageQueue::~MessageQueue() {
 
-	uint32_t read_pos = 0;
+	while (buffers) {
+
+		ThreadBuffer *buffer = buffers;
+		buffers = buffer->next;
+
+		Page *page = buffer->read_page;
+		while (page) {
 
-	while (read_pos < buffer_end) {
+			uint8_t *data = (uint8_t *)page + MESSAGE_QUEUE_PAGE_HEADER;
+			while (page->read < page->end) {
+
+				Message *message = (Message *)&data[page->read];
+				page->read += sizeof(Message);
+				if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION)
+					page->read += sizeof(Variant) * message->args;
+
+				_destroy_message(message);
+			}
 
-		Message *message = (Message *)&buffer[read_pos];
-		Variant *args = (Variant *)(message + 1);
-		int argc = message->args;
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-			for (int i = 0; i < argc; i++)
-				args[i].~Variant();
+			Page *next = page->next;
+			memfree(page);
+			page = next;
 		}
-		message->~Message();
 
-		read_pos += sizeof(Message);
-		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION)
-			read_pos += sizeof(Variant) * message->args;
+		memdelete(buffer);
 	}
 
 	singleton = NULL;
-	memdelete_arr(buffer);
+	memdelete(lock);
 }
@@ -34,13 +34,20 @@
 #include "core/object.h"
 #include "core/os/thread_safe.h"
 
+/**
+ * Every thread appends to its own chain of pages, so pushing a message
+ * takes no lock. flush() runs the threads' messages in the order the
+ * threads first pushed one, each thread's in the order they were pushed.
+ * Pages are added as needed, nothing is dropped. A single flush handles
+ * up to memory/limits/message_queue/max_size_kb, the rest waits for the
+ * next one; drain() runs everything.
+ */
 class MessageQueue {
 
-	_THREAD_SAFE_CLASS_
-
 	enum {
 
-		DEFAULT_QUEUE_SIZE_KB = 1024
+		DEFAULT_QUEUE_SIZE_KB = 1024,
+		PAGE_SIZE = 64 * 1024
 	};
 
 	enum {
@@ -63,11 +70,49 @@ class MessageQueue {
 		};
 	};
 
-	uint8_t *buffer;
-	uint32_t buffer_end;
+	struct Page {
+
+		Page *next; // Set under the lock once the owner moved on.
+		uint32_t size;
+		uint32_t write; // Owning thread only.
+		volatile uint32_t end; // Catches up with write as each message is complete.
+		uint32_t read; // Flushing thread only.
+	};
+
+	struct ThreadBuffer {
+
+		ThreadBuffer *next;
+		Page *write_page; // Owning thread only.
+		Page *read_page; // Flushing thread only.
+		bool exited; // Set under the lock when the thread is gone.
+	};
+
+	friend struct MessageQueueThreadHolder;
+
+	Mutex *lock; // Guards the buffer list, page links and flushing.
+	ThreadBuffer *buffers;
+	ThreadBuffer *last_buffer;
+	uint32_t generation;
+
 	uint32_t buffer_max_used;
 	uint32_t buffer_size;
 
+	uint64_t frame_flush_usec;
+	uint64_t last_frame_flush_usec;
+	uint32_t frame_depth_max;
+	uint32_t last_frame_depth_max;
+
+	Page *_alloc_page(uint32_t p_size);
+	ThreadBuffer *_get_thread_buffer();
+	uint8_t *_reserve(uint32_t p_room, Page *&r_page);
+	void _publish(Page *p_page, uint32_t p_room);
+
+	void _process_message(Message *p_message);
+	void _destroy_message(Message *p_message);
+	bool _flush_buffer(ThreadBuffer *p_buffer, bool p_own, uint32_t p_budget, uint32_t &r_messages, uint32_t &r_bytes);
+	bool _is_drained(ThreadBuffer *p_buffer);
+	void _flush(uint32_t p_budget);
+
 	void _call_function(Object *p_target, const StringName &p_func, const Variant *p_args, int p_argcount, bool p_show_error);
 
 	static MessageQueue *singleton;
@@ -88,11 +133,16 @@ public:
 
 	void statistics();
 	void flush();
+	void drain(); // Runs everything queued, with no budget. Used when shutting down.
 
 	bool is_flushing() const;
 
 	int get_max_buffer_usage() const;
 
+	void end_frame();
+	uint32_t get_frame_depth_max() const; // Most messages handled by one flush during the last frame.
+	uint64_t get_frame_flush_usec() const; // Time spent flushing during the last frame.
+
 	MessageQueue();
 	~MessageQueue();
 };
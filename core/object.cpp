@@ -947,6 +947,23 @@ Variant Object::call(const StringName &p_method, const Variant **p_args, int p_a
 	return ret;
 }
 
+Variant Object::call_method_bind(MethodBind *p_method, const Variant **p_args, int p_argcount, Variant::CallError &r_error) {
+
+	// Same as call(), for callers that resolved the method bind in advance.
+
+	r_error.error = Variant::CallError::CALL_OK;
+
+	OBJ_DEBUG_LOCK
+	if (script_instance) {
+		Variant ret = script_instance->call(p_method->get_name(), p_args, p_argcount, r_error);
+		if (r_error.error != Variant::CallError::CALL_ERROR_INVALID_METHOD && r_error.error != Variant::CallError::CALL_ERROR_INSTANCE_IS_NULL) {
+			return ret;
+		}
+	}
+
+	return p_method->call(this, p_args, p_argcount, r_error);
+}
+
 void Object::notification(int p_notification, bool p_reversed) {
 
 	_notificationv(p_notification, p_reversed);
@@ -1191,13 +1208,20 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 
 	OBJ_DEBUG_LOCK
 
-	Vector<const Variant *> bind_mem;
+	const Variant **bind_mem = NULL;
+	if (s->max_binds) {
+		bind_mem = (const Variant **)alloca(sizeof(Variant *) * (p_argcount + s->max_binds));
+		for (int j = 0; j < p_argcount; j++) {
+			bind_mem[j] = p_args[j];
+		}
+	}
 
 	Error err = OK;
 
 	for (int i = 0; i < ssize; i++) {
 
-		const Connection &c = slot_map.getv(i).conn;
+		const Signal::Slot &slot = slot_map.getv(i);
+		const Connection &c = slot.conn;
 
 		Object *target;
 #ifdef DEBUG_ENABLED
@@ -1211,25 +1235,24 @@ Error Object::emit_signal(const StringName &p_name, const Variant **p_args, int
 		int argc = p_argcount;
 
 		if (c.binds.size()) {
-			//handle binds
-			bind_mem.resize(p_argcount + c.binds.size());
-
-			for (int j = 0; j < p_argcount; j++) {
-				bind_mem.write[j] = p_args[j];
-			}
+			//handle binds, the signal arguments are already in place
 			for (int j = 0; j < c.binds.size(); j++) {
-				bind_mem.write[p_argcount + j] = &c.binds[j];
+				bind_mem[p_argcount + j] = &c.binds[j];
 			}
 
-			args = (const Variant **)bind_mem.ptr();
-			argc = bind_mem.size();
+			args = bind_mem;
+			argc = p_argcount + c.binds.size();
 		}
 
 		if (c.flags & CONNECT_DEFERRED) {
 			MessageQueue::get_singleton()->push_call(target->get_instance_id(), c.method, args, argc, true);
 		} else {
 			Variant::CallError ce;
-			target->call(c.method, args, argc, ce);
+			if (slot.method_bind) {
+				target->call_method_bind(slot.method_bind, args, argc, ce);
+			} else {
+				target->call(c.method, args, argc, ce);
+			}
 
 			if (ce.error != Variant::CallError::CALL_OK) {
 #ifdef DEBUG_ENABLED
@@ -1496,6 +1519,11 @@ Error Object::connect(const StringName &p_signal, Object *p_to_object, const Str
 		slot.reference_count = 1;
 	}
 
+	// The class of an object never changes, so its bind can be looked up once.
+	// Scripts may be swapped or reloaded, call_method_bind() still asks them first.
+	slot.method_bind = ClassDB::get_method(p_to_object->get_class_name(), p_to_method);
+	s->max_binds = MAX(s->max_binds, p_binds.size());
+
 	s->slot_map[target] = slot;
 
 	return OK;
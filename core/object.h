@@ -385,6 +385,7 @@ public:                                                        \
 private:
 
 class ScriptInstance;
+class MethodBind;
 typedef uint64_t ObjectID;
 
 class Object {
@@ -448,13 +449,21 @@ private:
 			int reference_count;
 			Connection conn;
 			List<Connection>::Element *cE;
-			Slot() { reference_count = 0; }
+			MethodBind *method_bind; // Resolved at connect time, NULL if the target class has no such bound method.
+			Slot() {
+				reference_count = 0;
+				method_bind = NULL;
+			}
 		};
 
 		MethodInfo user;
 		VMap<Target, Slot> slot_map;
+		int max_binds; // Sizes the argument array of emit_signal().
 		int lock;
-		Signal() { lock = 0; }
+		Signal() {
+			max_binds = 0;
+			lock = 0;
+		}
 	};
 
 	HashMap<StringName, Signal> signal_map;
@@ -653,6 +662,7 @@ public:
 	void get_method_list(List<MethodInfo> *p_list) const;
 	Variant callv(const StringName &p_method, const Array &p_args);
 	virtual Variant call(const StringName &p_method, const Variant **p_args, int p_argcount, Variant::CallError &r_error);
+	Variant call_method_bind(MethodBind *p_method, const Variant **p_args, int p_argcount, Variant::CallError &r_error); // p_method must be bound to this class or a parent
 	virtual void call_multilevel(const StringName &p_method, const Variant **p_args, int p_argcount);
 	virtual void call_multilevel_reversed(const StringName &p_method, const Variant **p_args, int p_argcount);
 	Variant call(const StringName &p_name, VARIANT_ARG_LIST); // C++ helper
@@ -0,0 +1,303 @@
+/*************************************************************************/
+/*  frame_allocator.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "frame_allocator.h"
+
+#include "core/error_macros.h"
+#include "core/os/memory.h"
+#include "core/safe_refcount.h"
+
+#include <string.h>
+
+// Placed before every block carved from the arena chunk.
+struct FrameArenaBlock {
+
+	uint32_t prev_top; // Offset of the block allocated before this one.
+	uint32_t size;
+	uint32_t freed; // Freed out of order, reclaimed once it reaches the top.
+	uint32_t padding;
+};
+
+// Placed before every block that did not fit in the chunk.
+struct FrameArenaOverflow {
+
+	struct FrameArena *arena;
+	FrameArenaOverflow *prev;
+	FrameArenaOverflow *next;
+	size_t size;
+};
+
+struct FrameArena {
+
+	uint8_t *chunk;
+	uint32_t chunk_size;
+	uint32_t used;
+	uint32_t top;
+
+	FrameArenaOverflow *overflow;
+	size_t overflow_bytes;
+
+	size_t max_usage; // Since the last reset.
+
+	~FrameArena();
+};
+
+enum {
+	FRAME_ARENA_ALIGN = 16,
+	FRAME_ARENA_BLOCK_HEADER = (sizeof(FrameArenaBlock) + FRAME_ARENA_ALIGN - 1) & ~(FRAME_ARENA_ALIGN - 1),
+	FRAME_ARENA_OVERFLOW_HEADER = (sizeof(FrameArenaOverflow) + FRAME_ARENA_ALIGN - 1) & ~(FRAME_ARENA_ALIGN - 1)
+};
+
+static const uint32_t FRAME_ARENA_NO_BLOCK = 0xFFFFFFFF;
+
+static thread_local FrameArena thread_arena;
+
+static uint64_t frame_max_usage = 0;
+static uint64_t max_usage = 0;
+
+static _FORCE_INLINE_ size_t _align(size_t p_bytes) {
+
+	return (p_bytes + FRAME_ARENA_ALIGN - 1) & ~size_t(FRAME_ARENA_ALIGN - 1);
+}
+
+static _FORCE_INLINE_ bool _is_in_chunk(const FrameArena &p_arena, const void *p_memory) {
+
+	return p_memory >= p_arena.chunk && p_memory < p_arena.chunk + p_arena.chunk_size;
+}
+
+static _FORCE_INLINE_ void _update_max_usage(FrameArena &p_arena) {
+
+	size_t usage = p_arena.used + p_arena.overflow_bytes;
+	if (usage > p_arena.max_usage) {
+		p_arena.max_usage = usage;
+	}
+}
+
+static void _set_chunk_size(FrameArena &p_arena, size_t p_size) {
+
+	if (p_arena.chunk) {
+		Memory::free_static(p_arena.chunk);
+	}
+
+	p_arena.chunk = (uint8_t *)Memory::alloc_static(p_size);
+	p_arena.chunk_size = p_arena.chunk ? p_size : 0;
+	p_arena.used = 0;
+	p_arena.top = FRAME_ARENA_NO_BLOCK;
+}
+
+static void _free_overflow(FrameArena &p_arena, FrameArenaOverflow *p_overflow) {
+
+	if (p_overflow->prev) {
+		p_overflow->prev->next = p_overflow->next;
+	} else {
+		p_arena.overflow = p_overflow->next;
+	}
+	if (p_overflow->next) {
+		p_overflow->next->prev = p_overflow->prev;
+	}
+
+	p_arena.overflow_bytes -= p_overflow->size;
+	Memory::free_static(p_overflow);
+}
+
+static size_t _reset(FrameArena &p_arena) {
+
+	while (p_arena.overflow) {
+		_free_overflow(p_arena, p_arena.overflow);
+	}
+
+	size_t peak = p_arena.max_usage;
+	p_arena.max_usage = 0;
+	p_arena.used = 0;
+	p_arena.top = FRAME_ARENA_NO_BLOCK;
+
+	// make room for what this thread needed, so it fits in one chunk next time
+	if (peak > p_arena.chunk_size && p_arena.chunk_size < FrameAllocator::MAX_SIZE) {
+		_set_chunk_size(p_arena, MIN(size_t(next_power_of_2(peak)), size_t(FrameAllocator::MAX_SIZE)));
+	}
+
+	return peak;
+}
+
+FrameArena::~FrameArena() {
+
+	while (overflow) {
+		_free_overflow(*this, overflow);
+	}
+
+	if (chunk) {
+		Memory::free_static(chunk);
+		chunk = NULL;
+		chunk_size = 0;
+	}
+}
+
+void *FrameAllocator::alloc(size_t p_bytes) {
+
+	FrameArena &a = thread_arena;
+	size_t size = _align(p_bytes);
+
+	if (unlikely(!a.chunk_size)) {
+		_set_chunk_size(a, INITIAL_SIZE);
+	}
+
+	if (likely(a.used + FRAME_ARENA_BLOCK_HEADER + size <= a.chunk_size)) {
+
+		FrameArenaBlock *b = (FrameArenaBlock *)(a.chunk + a.used);
+		b->prev_top = a.top;
+		b->size = size;
+		b->freed = 0;
+
+		a.top = a.used;
+		a.used += FRAME_ARENA_BLOCK_HEADER + size;
+		_update_max_usage(a);
+
+		return (uint8_t *)b + FRAME_ARENA_BLOCK_HEADER;
+	}
+
+	FrameArenaOverflow *o = (FrameArenaOverflow *)Memory::alloc_static(FRAME_ARENA_OVERFLOW_HEADER + size);
+	ERR_FAIL_COND_V(!o, NULL);
+
+	o->arena = &a;
+	o->prev = NULL;
+	o->next = a.overflow;
+	o->size = size;
+	if (a.overflow) {
+		a.overflow->prev = o;
+	}
+	a.overflow = o;
+
+	a.overflow_bytes += size;
+	_update_max_usage(a);
+
+	return (uint8_t *)o + FRAME_ARENA_OVERFLOW_HEADER;
+}
+
+void *FrameAllocator::realloc(void *p_memory, size_t p_bytes) {
+
+	if (!p_memory) {
+		return alloc(p_bytes);
+	}
+
+	FrameArena &a = thread_arena;
+	size_t old_size;
+
+	if (_is_in_chunk(a, p_memory)) {
+
+		FrameArenaBlock *b = (FrameArenaBlock *)((uint8_t *)p_memory - FRAME_ARENA_BLOCK_HEADER);
+		uint32_t offset = (uint8_t *)b - a.chunk;
+		size_t size = _align(p_bytes);
+
+		if (offset == a.top && offset + FRAME_ARENA_BLOCK_HEADER + size <= a.chunk_size) {
+
+			// last block, grow or shrink it where it is
+			b->size = size;
+			a.used = offset + FRAME_ARENA_BLOCK_HEADER + size;
+			_update_max_usage(a);
+			return p_memory;
+		}
+
+		old_size = b->size;
+	} else {
+
+		FrameArenaOverflow *o = (FrameArenaOverflow *)((uint8_t *)p_memory - FRAME_ARENA_OVERFLOW_HEADER);
+		ERR_FAIL_COND_V(o->arena != &a, NULL);
+		old_size = o->size;
+	}
+
+	void *mem = alloc(p_bytes);
+	ERR_FAIL_COND_V(!mem, NULL);
+
+	memcpy(mem, p_memory, MIN(old_size, p_bytes));
+	free(p_memory);
+
+	return mem;
+}
+
+void FrameAllocator::free(void *p_memory) {
+
+	if (!p_memory) {
+		return;
+	}
+
+	FrameArena &a = thread_arena;
+
+	if (!_is_in_chunk(a, p_memory)) {
+
+		FrameArenaOverflow *o = (FrameArenaOverflow *)((uint8_t *)p_memory - FRAME_ARENA_OVERFLOW_HEADER);
+		ERR_FAIL_COND(o->arena != &a); // Not frame memory of this thread.
+		_free_overflow(a, o);
+		return;
+	}
+
+	FrameArenaBlock *b = (FrameArenaBlock *)((uint8_t *)p_memory - FRAME_ARENA_BLOCK_HEADER);
+	b->freed = 1;
+
+	// pop every freed block off the top
+	while (a.top != FRAME_ARENA_NO_BLOCK) {
+
+		FrameArenaBlock *t = (FrameArenaBlock *)(a.chunk + a.top);
+		if (!t->freed) {
+			break;
+		}
+
+		a.used = a.top;
+		a.top = t->prev_top;
+	}
+}
+
+void FrameAllocator::reset() {
+
+	size_t peak = _reset(thread_arena);
+	atomic_exchange_if_greater(&max_usage, peak);
+}
+
+void FrameAllocator::end_frame() {
+
+	size_t peak = _reset(thread_arena);
+	frame_max_usage = peak;
+	atomic_exchange_if_greater(&max_usage, peak);
+}
+
+uint64_t FrameAllocator::get_usage() {
+
+	const FrameArena &a = thread_arena;
+	return a.used + a.overflow_bytes;
+}
+
+uint64_t FrameAllocator::get_frame_max_usage() {
+
+	return frame_max_usage;
+}
+
+uint64_t FrameAllocator::get_max_usage() {
+
+	return max_usage;
+}
@@ -0,0 +1,71 @@
+/*************************************************************************/
+/*  frame_allocator.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include "core/typedefs.h"
+
+#include <stddef.h>
+
+/**
+ * Per-thread bump allocator for temporaries that do not outlive the frame.
+ * Main::iteration() calls end_frame() once the frame is done, other threads
+ * that use it call reset() at their own boundaries.
+ *
+ * Freeing the most recent block hands its space back right away, so scoped
+ * use (a FrameVector or a local List<T, FrameAllocator>) is fine on any
+ * thread. Everything else is reclaimed by reset(). Requests that do not fit
+ * in the arena go to Memory::alloc_static until the next reset, which grows
+ * the arena to the size the thread needed.
+ *
+ * Blocks must be freed by the thread that allocated them, and never kept
+ * past the reset.
+ */
+class FrameAllocator {
+public:
+	enum {
+		INITIAL_SIZE = 64 * 1024,
+		MAX_SIZE = 4 * 1024 * 1024
+	};
+
+	static void *alloc(size_t p_bytes);
+	static void *realloc(void *p_memory, size_t p_bytes);
+	static void free(void *p_memory);
+
+	static void reset();
+	static void end_frame(); // As reset(), and records the high-water mark of the frame.
+
+	static uint64_t get_usage(); // Of the calling thread.
+	static uint64_t get_frame_max_usage(); // High-water mark of the last frame.
+	static uint64_t get_max_usage(); // Highest frame so far.
+};
+
+#endif // FRAME_ALLOCATOR_H
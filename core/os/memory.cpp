@@ -32,6 +32,7 @@
 
 #include "core/error_macros.h"
 #include "core/os/copymem.h"
+#include "core/os/small_allocator.h"
 #include "core/safe_refcount.h"
 
 #include <stdio.h>
@@ -67,13 +68,63 @@ void operator delete(void *p_mem, void *p_pointer, size_t check, const char *p_d
 }
 #endif
 
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) && !defined(SMALL_ALLOCATOR_ENABLED)
 uint64_t Memory::mem_usage = 0;
+#endif
+#if defined(DEBUG_ENABLED) || defined(SMALL_ALLOCATOR_ENABLED)
 uint64_t Memory::max_usage = 0;
 #endif
 
 uint64_t Memory::alloc_count = 0;
 
+#ifdef SMALL_ALLOCATOR_ENABLED
+
+// Every block carries a size header here, p_pad_align makes no difference.
+// Usage is counted per thread by the allocator and merged when asked for.
+
+void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
+
+	void *mem = SmallAllocator::alloc(p_bytes);
+	ERR_FAIL_COND_V(!mem, NULL);
+	return mem;
+}
+
+void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
+
+	void *mem = SmallAllocator::realloc(p_memory, p_bytes);
+	ERR_FAIL_COND_V(!mem && p_bytes > 0, NULL);
+	return mem;
+}
+
+void Memory::free_static(void *p_ptr, bool p_pad_align) {
+
+	ERR_FAIL_COND(p_ptr == NULL);
+
+	SmallAllocator::free(p_ptr);
+}
+
+uint64_t Memory::get_mem_available() {
+
+	return -1; // 0xFFFF...
+}
+
+uint64_t Memory::get_mem_usage() {
+
+	SmallAllocator::Stats stats;
+	SmallAllocator::get_stats(stats);
+	atomic_exchange_if_greater(&max_usage, stats.mem_usage);
+	return stats.mem_usage;
+}
+
+uint64_t Memory::get_mem_max_usage() {
+
+	// Sampled whenever usage is queried, peaks in between are not seen.
+	get_mem_usage();
+	return max_usage;
+}
+
+#else
+
 void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
 
 #ifdef DEBUG_ENABLED
@@ -206,6 +257,8 @@ uint64_t Memory::get_mem_max_usage() {
 #endif
 }
 
+#endif // SMALL_ALLOCATOR_ENABLED
+
 _GlobalNil::_GlobalNil() {
 
 	color = 1;
@@ -46,8 +46,10 @@
 class Memory {
 
 	Memory();
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) && !defined(SMALL_ALLOCATOR_ENABLED)
 	static uint64_t mem_usage;
+#endif
+#if defined(DEBUG_ENABLED) || defined(SMALL_ALLOCATOR_ENABLED)
 	static uint64_t max_usage;
 #endif
 
@@ -0,0 +1,464 @@
+/*************************************************************************/
+/*  small_allocator.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "small_allocator.h"
+
+#ifdef SMALL_ALLOCATOR_ENABLED
+
+#include "core/os/memory.h"
+#include "core/safe_refcount.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Memory is needed long before the OS creates mutexes, so the few shared
+// structures are guarded by this spin lock built on the core atomics.
+struct SmallAllocatorLock {
+
+	volatile uint32_t value;
+
+	_FORCE_INLINE_ void lock() {
+
+		while (atomic_increment(&value) != 1) {
+			atomic_decrement(&value);
+			while (value) {
+			}
+		}
+	}
+
+	_FORCE_INLINE_ void unlock() {
+
+		atomic_decrement(&value);
+	}
+};
+
+// Only the first 8 bytes of the PAD_ALIGN header are ours, CowData keeps its
+// refcount and size in the last 8.
+struct SmallAllocatorHeader {
+
+	uint64_t size : 56;
+	uint64_t size_class : 8; // 0 for blocks that come from malloc.
+};
+
+// Layout of a free block, it overwrites the header.
+struct SmallAllocatorBlock {
+
+	SmallAllocatorBlock *next;
+	SmallAllocatorBlock *next_chain; // Only valid on the first block of a chain.
+	uint32_t chain_count;
+};
+
+struct SmallAllocatorCentral {
+
+	SmallAllocatorLock lock;
+	SmallAllocatorBlock *chains;
+	uint8_t *span;
+	size_t span_left;
+	uint64_t free_blocks;
+
+	uint8_t padding[64];
+};
+
+struct SmallAllocatorCache {
+
+	SmallAllocatorBlock *lists[SmallAllocator::SIZE_CLASS_COUNT];
+	uint32_t counts[SmallAllocator::SIZE_CLASS_COUNT];
+
+	// Only written by the owning thread, summed by get_stats().
+	volatile int64_t mem_usage;
+	volatile int64_t alloc_count;
+
+	SmallAllocatorCache *prev;
+	SmallAllocatorCache *next;
+};
+
+struct SmallAllocatorCacheHolder {
+
+	SmallAllocatorCache *cache;
+	bool finished;
+
+	~SmallAllocatorCacheHolder();
+};
+
+static SmallAllocatorCentral central[SmallAllocator::SIZE_CLASS_COUNT];
+
+static SmallAllocatorLock registry_lock;
+static SmallAllocatorCache *registry = NULL;
+static int64_t retired_mem_usage = 0; // Exited threads and frees made without a cache.
+static int64_t retired_alloc_count = 0;
+static uint64_t span_bytes = 0;
+
+static thread_local SmallAllocatorCacheHolder thread_cache;
+
+static _FORCE_INLINE_ int _get_size_class(size_t p_block) {
+
+	// 16 byte steps up to 256, then four steps per power of two
+	if (p_block <= 256) {
+		return p_block <= 32 ? 0 : int((p_block + 15) >> 4) - 2;
+	}
+
+	int group = 0;
+	while (p_block > (size_t(512) << group)) {
+		group++;
+	}
+
+	size_t step = size_t(64) << group;
+	int k = int((p_block - (size_t(256) << group) + step - 1) / step);
+	return 15 + group * 4 + k - 1;
+}
+
+static _FORCE_INLINE_ size_t _get_class_size(int p_class) {
+
+	if (p_class < 15) {
+		return (p_class + 2) * 16;
+	}
+
+	int group = (p_class - 15) / 4;
+	int k = (p_class - 15) % 4 + 1;
+	return (size_t(256) << group) + k * (size_t(64) << group);
+}
+
+static _FORCE_INLINE_ uint32_t _get_cache_limit(int p_class) {
+
+	return CLAMP(SmallAllocator::SPAN_SIZE / 2 / _get_class_size(p_class), 8, 256);
+}
+
+static void _release_chain(int p_class, SmallAllocatorBlock *p_chain, uint32_t p_count) {
+
+	SmallAllocatorCentral &c = central[p_class];
+	p_chain->chain_count = p_count;
+
+	c.lock.lock();
+	p_chain->next_chain = c.chains;
+	c.chains = p_chain;
+	c.free_blocks += p_count;
+	c.lock.unlock();
+}
+
+static bool _fetch_chain(int p_class, uint32_t p_count, SmallAllocatorBlock *&r_chain, uint32_t &r_count) {
+
+	SmallAllocatorCentral &c = central[p_class];
+
+	c.lock.lock();
+
+	if (c.chains) {
+		r_chain = c.chains;
+		r_count = r_chain->chain_count;
+		c.chains = r_chain->next_chain;
+		c.free_blocks -= r_count;
+		c.lock.unlock();
+		return true;
+	}
+
+	// nothing returned by other threads, carve new blocks
+	size_t size = _get_class_size(p_class);
+	r_chain = NULL;
+	r_count = 0;
+
+	while (r_count < p_count) {
+
+		if (c.span_left < size) {
+			uint8_t *span = (uint8_t *)malloc(SmallAllocator::SPAN_SIZE);
+			if (!span) {
+				break;
+			}
+			atomic_add(&span_bytes, SmallAllocator::SPAN_SIZE);
+			c.span = span;
+			c.span_left = SmallAllocator::SPAN_SIZE;
+		}
+
+		SmallAllocatorBlock *b = (SmallAllocatorBlock *)c.span;
+		c.span += size;
+		c.span_left -= size;
+
+		b->next = r_chain;
+		r_chain = b;
+		r_count++;
+	}
+
+	c.lock.unlock();
+	return r_count > 0;
+}
+
+static SmallAllocatorCache *_get_thread_cache() {
+
+	SmallAllocatorCacheHolder &holder = thread_cache;
+	if (likely(holder.cache)) {
+		return holder.cache;
+	}
+
+	if (holder.finished) {
+		return NULL; // Thread is exiting, use the central lists directly.
+	}
+
+	SmallAllocatorCache *cache = (SmallAllocatorCache *)calloc(1, sizeof(SmallAllocatorCache));
+	if (!cache) {
+		return NULL;
+	}
+
+	registry_lock.lock();
+	cache->next = registry;
+	if (registry) {
+		registry->prev = cache;
+	}
+	registry = cache;
+	registry_lock.unlock();
+
+	holder.cache = cache;
+	return cache;
+}
+
+SmallAllocatorCacheHolder::~SmallAllocatorCacheHolder() {
+
+	SmallAllocatorCache *c = cache;
+	cache = NULL;
+	finished = true;
+
+	if (!c) {
+		return;
+	}
+
+	for (int i = 0; i < SmallAllocator::SIZE_CLASS_COUNT; i++) {
+		if (c->lists[i]) {
+			_release_chain(i, c->lists[i], c->counts[i]);
+		}
+	}
+
+	registry_lock.lock();
+	if (c->prev) {
+		c->prev->next = c->next;
+	} else {
+		registry = c->next;
+	}
+	if (c->next) {
+		c->next->prev = c->prev;
+	}
+	retired_mem_usage += c->mem_usage;
+	retired_alloc_count += c->alloc_count;
+	registry_lock.unlock();
+
+	::free(c);
+}
+
+static _FORCE_INLINE_ void _track(SmallAllocatorCache *p_cache, int64_t p_bytes, int64_t p_allocs) {
+
+	if (likely(p_cache)) {
+		p_cache->mem_usage += p_bytes;
+		p_cache->alloc_count += p_allocs;
+	} else {
+		registry_lock.lock();
+		retired_mem_usage += p_bytes;
+		retired_alloc_count += p_allocs;
+		registry_lock.unlock();
+	}
+}
+
+void *SmallAllocator::alloc(size_t p_bytes) {
+
+	size_t block = p_bytes + PAD_ALIGN;
+	SmallAllocatorCache *cache = _get_thread_cache();
+	SmallAllocatorHeader *h;
+
+	if (block <= MAX_SMALL_SIZE) {
+
+		int size_class = _get_size_class(block);
+		SmallAllocatorBlock *b;
+
+		if (likely(cache)) {
+
+			b = cache->lists[size_class];
+			if (unlikely(!b)) {
+				uint32_t count;
+				if (!_fetch_chain(size_class, _get_cache_limit(size_class) / 2, b, count)) {
+					return NULL;
+				}
+				cache->counts[size_class] = count;
+			}
+
+			cache->lists[size_class] = b->next;
+			cache->counts[size_class]--;
+		} else {
+
+			uint32_t count;
+			if (!_fetch_chain(size_class, 1, b, count)) {
+				return NULL;
+			}
+			if (count > 1) {
+				_release_chain(size_class, b->next, count - 1);
+			}
+		}
+
+		h = (SmallAllocatorHeader *)b;
+		h->size_class = size_class + 1;
+	} else {
+
+		h = (SmallAllocatorHeader *)malloc(block);
+		if (!h) {
+			return NULL;
+		}
+		h->size_class = 0;
+	}
+
+	h->size = p_bytes;
+	_track(cache, p_bytes, 1);
+
+	return (uint8_t *)h + PAD_ALIGN;
+}
+
+void SmallAllocator::free(void *p_memory) {
+
+	SmallAllocatorHeader *h = (SmallAllocatorHeader *)((uint8_t *)p_memory - PAD_ALIGN);
+	SmallAllocatorCache *cache = _get_thread_cache();
+
+	_track(cache, -int64_t(h->size), -1);
+
+	if (h->size_class == 0) {
+		::free(h);
+		return;
+	}
+
+	// blocks go to the cache of the thread freeing them, wherever they came from
+	int size_class = h->size_class - 1;
+	SmallAllocatorBlock *b = (SmallAllocatorBlock *)h;
+
+	if (likely(cache)) {
+
+		b->next = cache->lists[size_class];
+		cache->lists[size_class] = b;
+
+		uint32_t limit = _get_cache_limit(size_class);
+		if (unlikely(++cache->counts[size_class] > limit)) {
+
+			// hand half of the cache back so other threads can use it
+			uint32_t count = limit / 2;
+			SmallAllocatorBlock *last = b;
+			for (uint32_t i = 1; i < count; i++) {
+				last = last->next;
+			}
+
+			cache->lists[size_class] = last->next;
+			cache->counts[size_class] -= count;
+			last->next = NULL;
+			_release_chain(size_class, b, count);
+		}
+	} else {
+
+		b->next = NULL;
+		_release_chain(size_class, b, 1);
+	}
+}
+
+void *SmallAllocator::realloc(void *p_memory, size_t p_bytes) {
+
+	if (!p_memory) {
+		return alloc(p_bytes);
+	}
+
+	if (p_bytes == 0) {
+		free(p_memory);
+		return NULL;
+	}
+
+	SmallAllocatorHeader *h = (SmallAllocatorHeader *)((uint8_t *)p_memory - PAD_ALIGN);
+	size_t block = p_bytes + PAD_ALIGN;
+
+	if (h->size_class == 0 && block > MAX_SMALL_SIZE) {
+
+		int64_t delta = int64_t(p_bytes) - int64_t(h->size);
+		h = (SmallAllocatorHeader *)::realloc(h, block);
+		if (!h) {
+			return NULL;
+		}
+
+		h->size = p_bytes;
+		_track(_get_thread_cache(), delta, 0);
+		return (uint8_t *)h + PAD_ALIGN;
+	}
+
+	if (h->size_class != 0 && block <= MAX_SMALL_SIZE && _get_size_class(block) == int(h->size_class - 1)) {
+
+		// still the same class, nothing to move
+		_track(_get_thread_cache(), int64_t(p_bytes) - int64_t(h->size), 0);
+		h->size = p_bytes;
+		return p_memory;
+	}
+
+	void *mem = alloc(p_bytes);
+	if (!mem) {
+		return NULL;
+	}
+
+	// the rest of the PAD_ALIGN header belongs to the caller, move it along
+	const size_t prefix = PAD_ALIGN - sizeof(SmallAllocatorHeader);
+	memcpy((uint8_t *)mem - prefix, (uint8_t *)p_memory - prefix, MIN(size_t(h->size), p_bytes) + prefix);
+	free(p_memory);
+	return mem;
+}
+
+void SmallAllocator::get_stats(Stats &r_stats) {
+
+	int64_t mem_usage = 0;
+	int64_t alloc_count = 0;
+	uint64_t cached_bytes = 0;
+	uint32_t thread_caches = 0;
+
+	registry_lock.lock();
+
+	mem_usage = retired_mem_usage;
+	alloc_count = retired_alloc_count;
+
+	for (SmallAllocatorCache *c = registry; c; c = c->next) {
+
+		mem_usage += c->mem_usage;
+		alloc_count += c->alloc_count;
+		for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+			cached_bytes += uint64_t(c->counts[i]) * _get_class_size(i);
+		}
+		thread_caches++;
+	}
+
+	registry_lock.unlock();
+
+	for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+
+		SmallAllocatorCentral &c = central[i];
+		c.lock.lock();
+		cached_bytes += c.free_blocks * _get_class_size(i);
+		c.lock.unlock();
+	}
+
+	r_stats.mem_usage = MAX(mem_usage, 0);
+	r_stats.alloc_count = MAX(alloc_count, 0);
+	r_stats.cached_bytes = cached_bytes;
+	r_stats.span_bytes = span_bytes;
+	r_stats.thread_caches = thread_caches;
+}
+
+#endif // SMALL_ALLOCATOR_ENABLED
@@ -0,0 +1,77 @@
+/*************************************************************************/
+/*  small_allocator.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef SMALL_ALLOCATOR_H
+#define SMALL_ALLOCATOR_H
+
+#include "core/typedefs.h"
+
+#include <stddef.h>
+
+/**
+ * Size-class allocator backing Memory::alloc_static when the engine is built
+ * with small_allocator=yes (SMALL_ALLOCATOR_ENABLED).
+ *
+ * Blocks up to MAX_SMALL_SIZE are carved from spans and kept in per-thread
+ * free lists, so the common alloc/free pair touches no shared state. Threads
+ * trade whole chains of blocks with a per-class central list when their
+ * cache runs empty or grows too large. Bigger requests go to malloc.
+ *
+ * Every block starts with a PAD_ALIGN header, its size and class are kept
+ * in the first 8 bytes so the rest stays usable by the caller, as it is with
+ * the system allocator.
+ *
+ * Usage counters are kept per thread and only summed when queried.
+ */
+class SmallAllocator {
+public:
+	enum {
+		SPAN_SIZE = 64 * 1024,
+		MAX_SMALL_SIZE = 4096, // Largest block, header included.
+		SIZE_CLASS_COUNT = 31
+	};
+
+	struct Stats {
+
+		uint64_t mem_usage;
+		uint64_t alloc_count;
+		uint64_t cached_bytes; // Free blocks held by thread caches and central lists.
+		uint64_t span_bytes; // Memory taken from the system for spans.
+		uint32_t thread_caches;
+	};
+
+	static void *alloc(size_t p_bytes);
+	static void *realloc(void *p_memory, size_t p_bytes);
+	static void free(void *p_memory);
+
+	static void get_stats(Stats &r_stats);
+};
+
+#endif // SMALL_ALLOCATOR_H
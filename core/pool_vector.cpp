@@ -36,35 +36,76 @@ PoolAllocator *MemoryPool::memory_pool = NULL;
 uint8_t *MemoryPool::pool_memory = NULL;
 size_t *MemoryPool::pool_size = NULL;
 
-MemoryPool::Alloc *MemoryPool::allocs = NULL;
-MemoryPool::Alloc *MemoryPool::free_list = NULL;
-uint32_t MemoryPool::alloc_count = 0;
 uint32_t MemoryPool::allocs_used = 0;
-Mutex *MemoryPool::alloc_mutex = NULL;
 
 size_t MemoryPool::total_memory = 0;
 size_t MemoryPool::max_memory = 0;
 
-void MemoryPool::setup(uint32_t p_max_allocs) {
+struct MemoryPoolFreeList {
 
-	allocs = memnew_arr(Alloc, p_max_allocs);
-	alloc_count = p_max_allocs;
-	allocs_used = 0;
+	MemoryPool::Alloc *first;
+	uint32_t count;
+	bool finished;
 
-	for (uint32_t i = 0; i < alloc_count - 1; i++) {
+	~MemoryPoolFreeList() {
 
-		allocs[i].free_list = &allocs[i + 1];
+		// allocs released after this point go straight back to the heap
+		finished = true;
+		while (first) {
+			MemoryPool::Alloc *alloc = first;
+			first = alloc->free_list;
+			memdelete(alloc);
+		}
+		count = 0;
 	}
+};
+
+static thread_local MemoryPoolFreeList thread_free_list;
+
+MemoryPool::Alloc *MemoryPool::create_alloc() {
 
-	free_list = &allocs[0];
+	MemoryPoolFreeList &list = thread_free_list;
+	Alloc *alloc = list.first;
 
-	alloc_mutex = Mutex::create();
+	if (alloc) {
+		list.first = alloc->free_list;
+		list.count--;
+
+		alloc->lock = 0;
+		alloc->mem = NULL;
+		alloc->pool_id = POOL_ALLOCATOR_INVALID_ID;
+		alloc->size = 0;
+		alloc->free_list = NULL;
+	} else {
+		alloc = memnew(Alloc);
+	}
+
+	alloc->refcount.init();
+	atomic_increment(&allocs_used);
+	return alloc;
 }
 
-void MemoryPool::cleanup() {
+void MemoryPool::free_alloc(Alloc *p_alloc) {
 
-	memdelete_arr(allocs);
-	memdelete(alloc_mutex);
+	atomic_decrement(&allocs_used);
+
+	MemoryPoolFreeList &list = thread_free_list;
+	if (list.finished || list.count >= THREAD_FREE_LIST_MAX) {
+		memdelete(p_alloc);
+		return;
+	}
+
+	p_alloc->free_list = list.first;
+	list.first = p_alloc;
+	list.count++;
+}
+
+void MemoryPool::setup() {
+
+	allocs_used = 0;
+}
+
+void MemoryPool::cleanup() {
 
 	ERR_EXPLAINC("There are still MemoryPool allocs in use at exit!");
 	ERR_FAIL_COND(allocs_used > 0);
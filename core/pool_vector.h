@@ -65,15 +65,30 @@ struct MemoryPool {
 		}
 	};
 
-	static Alloc *allocs;
-	static Alloc *free_list;
-	static uint32_t alloc_count;
+	enum {
+		THREAD_FREE_LIST_MAX = 256
+	};
+
+	// Each thread keeps its own list of released Allocs, and the counters
+	// below are updated atomically, so no path takes a global lock.
 	static uint32_t allocs_used;
-	static Mutex *alloc_mutex;
 	static size_t total_memory;
 	static size_t max_memory;
 
-	static void setup(uint32_t p_max_allocs = (1 << 16));
+	static Alloc *create_alloc();
+	static void free_alloc(Alloc *p_alloc);
+
+	_FORCE_INLINE_ static void track_memory(size_t p_added, size_t p_removed) {
+
+		if (p_removed) {
+			atomic_sub(&total_memory, p_removed);
+		}
+		if (p_added) {
+			atomic_exchange_if_greater(&max_memory, atomic_add(&total_memory, p_added));
+		}
+	}
+
+	static void setup();
 	static void cleanup();
 };
 
@@ -99,36 +114,17 @@ class PoolVector {
 
 		//must allocate something
 
-		MemoryPool::alloc_mutex->lock();
-		if (MemoryPool::allocs_used == MemoryPool::alloc_count) {
-			MemoryPool::alloc_mutex->unlock();
-			ERR_EXPLAINC("All memory pool allocations are in use, can't COW.");
-			ERR_FAIL();
-		}
-
 		MemoryPool::Alloc *old_alloc = alloc;
 
-		//take one from the free list
-		alloc = MemoryPool::free_list;
-		MemoryPool::free_list = alloc->free_list;
-		//increment the used counter
-		MemoryPool::allocs_used++;
+		alloc = MemoryPool::create_alloc();
 
 		//copy the alloc data
 		alloc->size = old_alloc->size;
-		alloc->refcount.init();
-		alloc->pool_id = POOL_ALLOCATOR_INVALID_ID;
-		alloc->lock = 0;
 
 #ifdef DEBUG_ENABLED
-		MemoryPool::total_memory += alloc->size;
-		if (MemoryPool::total_memory > MemoryPool::max_memory) {
-			MemoryPool::max_memory = MemoryPool::total_memory;
-		}
+		MemoryPool::track_memory(alloc->size, 0);
 #endif
 
-		MemoryPool::alloc_mutex->unlock();
-
 		if (MemoryPool::memory_pool) {
 
 		} else {
@@ -153,9 +149,7 @@ class PoolVector {
 			//this should never happen but..
 
 #ifdef DEBUG_ENABLED
-			MemoryPool::alloc_mutex->lock();
-			MemoryPool::total_memory -= old_alloc->size;
-			MemoryPool::alloc_mutex->unlock();
+			MemoryPool::track_memory(0, old_alloc->size);
 #endif
 
 			{
@@ -176,14 +170,7 @@ class PoolVector {
 			} else {
 
 				memfree(old_alloc->mem);
-				old_alloc->mem = NULL;
-				old_alloc->size = 0;
-
-				MemoryPool::alloc_mutex->lock();
-				old_alloc->free_list = MemoryPool::free_list;
-				MemoryPool::free_list = old_alloc;
-				MemoryPool::allocs_used--;
-				MemoryPool::alloc_mutex->unlock();
+				MemoryPool::free_alloc(old_alloc);
 			}
 		}
 	}
@@ -232,9 +219,7 @@ class PoolVector {
 		}
 
 #ifdef DEBUG_ENABLED
-		MemoryPool::alloc_mutex->lock();
-		MemoryPool::total_memory -= alloc->size;
-		MemoryPool::alloc_mutex->unlock();
+		MemoryPool::track_memory(0, alloc->size);
 #endif
 
 		if (MemoryPool::memory_pool) {
@@ -244,14 +229,7 @@ class PoolVector {
 		} else {
 
 			memfree(alloc->mem);
-			alloc->mem = NULL;
-			alloc->size = 0;
-
-			MemoryPool::alloc_mutex->lock();
-			alloc->free_list = MemoryPool::free_list;
-			MemoryPool::free_list = alloc;
-			MemoryPool::allocs_used--;
-			MemoryPool::alloc_mutex->unlock();
+			MemoryPool::free_alloc(alloc);
 		}
 
 		alloc = NULL;
@@ -517,24 +495,7 @@ Error PoolVector<T>::resize(int p_size) {
 			return OK; //nothing to do here
 
 		//must allocate something
-		MemoryPool::alloc_mutex->lock();
-		if (MemoryPool::allocs_used == MemoryPool::alloc_count) {
-			MemoryPool::alloc_mutex->unlock();
-			ERR_EXPLAINC("All memory pool allocations are in use.");
-			ERR_FAIL_V(ERR_OUT_OF_MEMORY);
-		}
-
-		//take one from the free list
-		alloc = MemoryPool::free_list;
-		MemoryPool::free_list = alloc->free_list;
-		//increment the used counter
-		MemoryPool::allocs_used++;
-
-		//cleanup the alloc
-		alloc->size = 0;
-		alloc->refcount.init();
-		alloc->pool_id = POOL_ALLOCATOR_INVALID_ID;
-		MemoryPool::alloc_mutex->unlock();
+		alloc = MemoryPool::create_alloc();
 
 	} else {
 
@@ -554,13 +515,7 @@ Error PoolVector<T>::resize(int p_size) {
 	_copy_on_write(); // make it unique
 
 #ifdef DEBUG_ENABLED
-	MemoryPool::alloc_mutex->lock();
-	MemoryPool::total_memory -= alloc->size;
-	MemoryPool::total_memory += new_size;
-	if (MemoryPool::total_memory > MemoryPool::max_memory) {
-		MemoryPool::max_memory = MemoryPool::total_memory;
-	}
-	MemoryPool::alloc_mutex->unlock();
+	MemoryPool::track_memory(new_size, alloc->size);
 #endif
 
 	int cur_elements = alloc->size / sizeof(T);
@@ -607,14 +562,8 @@ Error PoolVector<T>::resize(int p_size) {
 
 			if (new_size == 0) {
 				memfree(alloc->mem);
-				alloc->mem = NULL;
-				alloc->size = 0;
-
-				MemoryPool::alloc_mutex->lock();
-				alloc->free_list = MemoryPool::free_list;
-				MemoryPool::free_list = alloc;
-				MemoryPool::allocs_used--;
-				MemoryPool::alloc_mutex->unlock();
+				MemoryPool::free_alloc(alloc);
+				alloc = NULL;
 
 			} else {
 				alloc->mem = memrealloc(alloc->mem, new_size);
@@ -206,6 +206,11 @@ void register_core_settings() {
 	//since in register core types, globals may not e present
 	GLOBAL_DEF_RST("network/limits/packet_peer_stream/max_buffer_po2", (16));
 	ProjectSettings::get_singleton()->set_custom_property_info("network/limits/packet_peer_stream/max_buffer_po2", PropertyInfo(Variant::INT, "network/limits/packet_peer_stream/max_buffer_po2", PROPERTY_HINT_RANGE, "0,64,1,or_greater"));
+
+	GLOBAL_DEF_RST("application/run/resource_loader_threads", 2);
+	ProjectSettings::get_singleton()->set_custom_property_info("application/run/resource_loader_threads", PropertyInfo(Variant::INT, "application/run/resource_loader_threads", PROPERTY_HINT_RANGE, "1,32,1"));
+
+	AStar::init_path_threads();
 }
 
 void register_core_singletons() {
@@ -242,6 +247,8 @@ void register_core_singletons() {
 
 void unregister_core_types() {
 
+	AStar::finish_path_threads();
+
 	memdelete(_resource_loader);
 	memdelete(_resource_saver);
 	memdelete(_os);
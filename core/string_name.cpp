@@ -39,7 +39,7 @@ StaticCString StaticCString::create(const char *p_ptr) {
 	return scs;
 }
 
-StringName::_Data *StringName::_table[STRING_TABLE_LEN];
+StringName::_Shard StringName::_shards[STRING_TABLE_SHARDS];
 
 StringName _scs_create(const char *p_chr) {
 
@@ -47,49 +47,219 @@ StringName _scs_create(const char *p_chr) {
 }
 
 bool StringName::configured = false;
-Mutex *StringName::lock = NULL;
 
-void StringName::setup() {
+static _FORCE_INLINE_ bool _name_equals(const char *p_cname, const String &p_name, const char *p_other) {
 
-	lock = Mutex::create();
+	return p_cname ? strcmp(p_cname, p_other) == 0 : p_name == p_other;
+}
 
-	ERR_FAIL_COND(configured);
-	for (int i = 0; i < STRING_TABLE_LEN; i++) {
+static _FORCE_INLINE_ bool _name_equals(const char *p_cname, const String &p_name, const CharType *p_other) {
+
+	return p_cname ? String(p_cname) == p_other : p_name == p_other;
+}
+
+static _FORCE_INLINE_ bool _name_equals(const char *p_cname, const String &p_name, const String &p_other) {
+
+	return p_cname ? p_other == p_cname : p_name == p_other;
+}
+
+StringName::_Table *StringName::_alloc_table(uint32_t p_mask) {
+
+	_Table *table = (_Table *)memalloc(sizeof(_Table) + sizeof(_Data *) * p_mask);
+	table->mask = p_mask;
+	for (uint32_t i = 0; i <= p_mask; i++) {
+		table->buckets[i] = NULL;
+	}
+	return table;
+}
+
+void StringName::_lock_shard(_Shard &p_shard) {
+
+	if (p_shard.lock->try_lock() != OK) {
+		p_shard.lock->lock();
+		p_shard.contended++;
+	}
+}
+
+void StringName::_grow_shard(_Shard &p_shard) {
+
+	if (p_shard.retired_table_count == (int)(sizeof(p_shard.retired_tables) / sizeof(_Table *)))
+		return; // Lookups kept the old arrays alive so far, grow later.
+
+	_Table *old_table = p_shard.table;
+	_Table *table = _alloc_table(old_table->mask * 2 + 1);
+
+	// Entries are moved while lock-free lookups may walk them, they can send
+	// such a lookup into another chain but never into freed memory.
+	for (uint32_t i = 0; i <= old_table->mask; i++) {
+
+		_Data *d = old_table->buckets[i];
+		while (d) {
+
+			_Data *next = d->next;
+			uint32_t idx = d->hash & table->mask;
+			d->prev = NULL;
+			d->next = table->buckets[idx];
+			if (d->next)
+				d->next->prev = d;
+			table->buckets[idx] = d;
+			d = next;
+		}
+	}
+
+	atomic_increment(&p_shard.version); // Full barrier, the new array must be complete when published.
+	p_shard.table = table;
+	p_shard.retired_tables[p_shard.retired_table_count++] = old_table;
+}
+
+void StringName::_free_retired(_Shard &p_shard) {
+
+	if (!p_shard.retired_data && !p_shard.retired_table_count)
+		return;
+
+	if (atomic_add(&p_shard.readers, 0) != 0)
+		return; // A lookup may still be walking them.
+
+	while (p_shard.retired_data) {
+
+		_Data *d = p_shard.retired_data;
+		p_shard.retired_data = d->prev;
+		memdelete(d);
+	}
+
+	for (int i = 0; i < p_shard.retired_table_count; i++) {
+		memfree(p_shard.retired_tables[i]);
+	}
+	p_shard.retired_table_count = 0;
+}
+
+template <class T>
+StringName::_Data *StringName::_find(uint32_t p_hash, const T &p_name, bool p_create, const char *p_cname) {
+
+	_Shard &shard = _get_shard(p_hash);
+
+	// Lock-free lookup first. Racing with a removal or a resize can make it
+	// miss an existing name, the locked search below settles those cases.
+	atomic_increment(&shard.readers);
 
-		_table[i] = NULL;
+	_Table *table = shard.table;
+	for (_Data *d = table->buckets[p_hash & table->mask]; d; d = d->next) {
+
+		// compare hash first
+		if (d->hash == p_hash && _name_equals(d->cname, d->name, p_name) && d->refcount.ref()) {
+			atomic_decrement(&shard.readers);
+			return d;
+		}
+	}
+
+	atomic_decrement(&shard.readers);
+
+	_lock_shard(shard);
+	shard.slow_lookups++;
+
+	table = shard.table;
+	uint32_t idx = p_hash & table->mask;
+
+	for (_Data *d = table->buckets[idx]; d; d = d->next) {
+
+		// entries whose last reference is being dropped can't be revived, skip them
+		if (d->hash == p_hash && _name_equals(d->cname, d->name, p_name) && d->refcount.ref()) {
+			shard.lock->unlock();
+			return d;
+		}
+	}
+
+	if (!p_create) {
+		shard.lock->unlock();
+		return NULL;
+	}
+
+	_Data *d = memnew(_Data);
+	if (p_cname) {
+		d->cname = p_cname;
+	} else {
+		d->name = p_name;
+	}
+	d->refcount.init();
+	d->hash = p_hash;
+	d->prev = NULL;
+	d->next = table->buckets[idx];
+	if (d->next)
+		d->next->prev = d;
+
+	atomic_increment(&shard.version); // Full barrier, the entry must be complete when published.
+	table->buckets[idx] = d;
+
+	shard.count++;
+	if (shard.count > (table->mask + 1) * STRING_TABLE_MAX_LOAD) {
+		_grow_shard(shard);
+	}
+	_free_retired(shard);
+
+	shard.lock->unlock();
+	return d;
+}
+
+void StringName::setup() {
+
+	ERR_FAIL_COND(configured);
+	for (int i = 0; i < STRING_TABLE_SHARDS; i++) {
+
+		_Shard &shard = _shards[i];
+		shard.lock = Mutex::create();
+		shard.table = _alloc_table((1 << STRING_TABLE_MIN_BITS) - 1);
+		shard.count = 0;
+		shard.readers = 0;
+		shard.retired_data = NULL;
+		shard.retired_table_count = 0;
+		shard.contended = 0;
+		shard.slow_lookups = 0;
+		shard.version = 0;
 	}
 	configured = true;
 }
 
 void StringName::cleanup() {
 
-	lock->lock();
-
 	int lost_strings = 0;
-	for (int i = 0; i < STRING_TABLE_LEN; i++) {
+	for (int i = 0; i < STRING_TABLE_SHARDS; i++) {
+
+		_Shard &shard = _shards[i];
+		shard.lock->lock();
+
+		_Table *table = shard.table;
+		for (uint32_t j = 0; j <= table->mask; j++) {
 
-		while (_table[i]) {
+			while (table->buckets[j]) {
 
-			_Data *d = _table[i];
-			lost_strings++;
-			if (OS::get_singleton()->is_stdout_verbose()) {
-				if (d->cname) {
-					print_line("Orphan StringName: " + String(d->cname));
-				} else {
-					print_line("Orphan StringName: " + String(d->name));
+				_Data *d = table->buckets[j];
+				lost_strings++;
+				if (OS::get_singleton()->is_stdout_verbose()) {
+					if (d->cname) {
+						print_line("Orphan StringName: " + String(d->cname));
+					} else {
+						print_line("Orphan StringName: " + String(d->name));
+					}
 				}
-			}
 
-			_table[i] = _table[i]->next;
-			memdelete(d);
+				table->buckets[j] = d->next;
+				memdelete(d);
+			}
 		}
+
+		_free_retired(shard);
+		memfree(table);
+		shard.table = NULL;
+		shard.count = 0;
+
+		shard.lock->unlock();
+		memdelete(shard.lock);
+		shard.lock = NULL;
 	}
+
 	if (lost_strings) {
 		print_verbose("StringName: " + itos(lost_strings) + " unclaimed string names at exit.");
 	}
-	lock->unlock();
-
-	memdelete(lock);
 }
 
 void StringName::unref() {
@@ -98,27 +268,69 @@ void StringName::unref() {
 
 	if (_data && _data->refcount.unref()) {
 
-		lock->lock();
+		_Shard &shard = _get_shard(_data->hash);
+		_lock_shard(shard);
 
 		if (_data->prev) {
 			_data->prev->next = _data->next;
 		} else {
-			if (_table[_data->idx] != _data) {
+			_Table *table = shard.table;
+			if (table->buckets[_data->hash & table->mask] != _data) {
 				ERR_PRINT("BUG!");
 			}
-			_table[_data->idx] = _data->next;
+			table->buckets[_data->hash & table->mask] = _data->next;
 		}
 
 		if (_data->next) {
 			_data->next->prev = _data->prev;
 		}
-		memdelete(_data);
-		lock->unlock();
+		shard.count--;
+
+		// keep next intact, a lock-free lookup may be standing on this entry
+		_data->prev = shard.retired_data;
+		shard.retired_data = _data;
+		_free_retired(shard);
+
+		shard.lock->unlock();
 	}
 
 	_data = NULL;
 }
 
+void StringName::get_table_stats(TableStats &r_stats) {
+
+	r_stats.names = 0;
+	r_stats.buckets = 0;
+	r_stats.longest_chain = 0;
+	r_stats.slow_lookups = 0;
+	r_stats.contended = 0;
+
+	ERR_FAIL_COND(!configured);
+
+	for (int i = 0; i < STRING_TABLE_SHARDS; i++) {
+
+		_Shard &shard = _shards[i];
+		shard.lock->lock();
+
+		_Table *table = shard.table;
+		for (uint32_t j = 0; j <= table->mask; j++) {
+
+			uint32_t chain = 0;
+			for (_Data *d = table->buckets[j]; d; d = d->next) {
+				chain++;
+			}
+			r_stats.longest_chain = MAX(r_stats.longest_chain, chain);
+		}
+
+		r_stats.names += shard.count;
+		r_stats.buckets += table->mask + 1;
+		r_stats.slow_lookups += shard.slow_lookups;
+		r_stats.contended += shard.contended;
+
+		shard.lock->unlock();
+	}
+}
+
 bool StringName::operator==(const String &p_name) const {
 
 	if (!_data) {
@@ -184,44 +396,7 @@ StringName::StringName(const char *p_name) {
 	if (!p_name || p_name[0] == 0)
 		return; //empty, ignore
 
-	lock->lock();
-
-	uint32_t hash = String::hash(p_name);
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
-
-	while (_data) {
-
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name)
-			break;
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			lock->unlock();
-			return;
-		} else {
-		}
-	}
-
-	_data = memnew(_Data);
-	_data->name = p_name;
-	_data->refcount.init();
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = NULL;
-	_data->next = _table[idx];
-	_data->prev = NULL;
-	if (_table[idx])
-		_table[idx]->prev = _data;
-	_table[idx] = _data;
-
-	lock->unlock();
+	_data = _find(String::hash(p_name), p_name, true, NULL);
 }
 
 StringName::StringName(const StaticCString &p_static_string) {
@@ -232,44 +407,7 @@ StringName::StringName(const StaticCString &p_static_string) {
 
 	ERR_FAIL_COND(!p_static_string.ptr || !p_static_string.ptr[0]);
 
-	lock->lock();
-
-	uint32_t hash = String::hash(p_static_string.ptr);
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
-
-	while (_data) {
-
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_static_string.ptr)
-			break;
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			lock->unlock();
-			return;
-		} else {
-		}
-	}
-
-	_data = memnew(_Data);
-
-	_data->refcount.init();
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = p_static_string.ptr;
-	_data->next = _table[idx];
-	_data->prev = NULL;
-	if (_table[idx])
-		_table[idx]->prev = _data;
-	_table[idx] = _data;
-
-	lock->unlock();
+	_data = _find(String::hash(p_static_string.ptr), p_static_string.ptr, true, p_static_string.ptr);
 }
 
 StringName::StringName(const String &p_name) {
@@ -281,43 +419,7 @@ StringName::StringName(const String &p_name) {
 	if (p_name == String())
 		return;
 
-	lock->lock();
-
-	uint32_t hash = p_name.hash();
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_data = _table[idx];
-
-	while (_data) {
-
-		if (_data->hash == hash && _data->get_name() == p_name)
-			break;
-		_data = _data->next;
-	}
-
-	if (_data) {
-		if (_data->refcount.ref()) {
-			// exists
-			lock->unlock();
-			return;
-		} else {
-		}
-	}
-
-	_data = memnew(_Data);
-	_data->name = p_name;
-	_data->refcount.init();
-	_data->hash = hash;
-	_data->idx = idx;
-	_data->cname = NULL;
-	_data->next = _table[idx];
-	_data->prev = NULL;
-	if (_table[idx])
-		_table[idx]->prev = _data;
-	_table[idx] = _data;
-
-	lock->unlock();
+	_data = _find(p_name.hash(), p_name, true, NULL);
 }
 
 StringName StringName::search(const char *p_name) {
@@ -328,29 +430,11 @@ StringName StringName::search(const char *p_name) {
 	if (!p_name[0])
 		return StringName();
 
-	lock->lock();
-
-	uint32_t hash = String::hash(p_name);
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
-
-	while (_data) {
-
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name)
-			break;
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		lock->unlock();
-
+	_Data *_data = _find(String::hash(p_name), p_name, false, NULL);
+	if (_data) {
 		return StringName(_data);
 	}
 
-	lock->unlock();
 	return StringName(); //does not exist
 }
 
@@ -362,56 +446,23 @@ StringName StringName::search(const CharType *p_name) {
 	if (!p_name[0])
 		return StringName();
 
-	lock->lock();
-
-	uint32_t hash = String::hash(p_name);
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
-
-	while (_data) {
-
-		// compare hash first
-		if (_data->hash == hash && _data->get_name() == p_name)
-			break;
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		lock->unlock();
+	_Data *_data = _find(String::hash(p_name), p_name, false, NULL);
+	if (_data) {
 		return StringName(_data);
 	}
 
-	lock->unlock();
 	return StringName(); //does not exist
 }
+
 StringName StringName::search(const String &p_name) {
 
 	ERR_FAIL_COND_V(p_name == "", StringName());
 
-	lock->lock();
-
-	uint32_t hash = p_name.hash();
-
-	uint32_t idx = hash & STRING_TABLE_MASK;
-
-	_Data *_data = _table[idx];
-
-	while (_data) {
-
-		// compare hash first
-		if (_data->hash == hash && p_name == _data->get_name())
-			break;
-		_data = _data->next;
-	}
-
-	if (_data && _data->refcount.ref()) {
-		lock->unlock();
+	_Data *_data = _find(p_name.hash(), p_name, false, NULL);
+	if (_data) {
 		return StringName(_data);
 	}
 
-	lock->unlock();
 	return StringName(); //does not exist
 }
 
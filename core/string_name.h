@@ -48,9 +48,12 @@ class StringName {
 
 	enum {
 
-		STRING_TABLE_BITS = 12,
-		STRING_TABLE_LEN = 1 << STRING_TABLE_BITS,
-		STRING_TABLE_MASK = STRING_TABLE_LEN - 1
+		// The table is split in shards by the top hash bits, each shard has
+		// its own lock and a bucket array that doubles as it fills up.
+		STRING_TABLE_SHARD_BITS = 6,
+		STRING_TABLE_SHARDS = 1 << STRING_TABLE_SHARD_BITS,
+		STRING_TABLE_MIN_BITS = 6,
+		STRING_TABLE_MAX_LOAD = 2
 	};
 
 	struct _Data {
@@ -59,19 +62,43 @@ class StringName {
 		String name;
 
 		String get_name() const { return cname ? String(cname) : name; }
-		int idx;
 		uint32_t hash;
-		_Data *prev;
-		_Data *next;
+		_Data *prev; // Also links retired entries.
+		_Data *volatile next;
 		_Data() {
 			cname = NULL;
 			next = prev = NULL;
-			idx = 0;
 			hash = 0;
 		}
 	};
 
-	static _Data *_table[STRING_TABLE_LEN];
+	struct _Table {
+
+		uint32_t mask;
+		_Data *volatile buckets[1]; // Allocated with mask + 1 entries.
+	};
+
+	struct _Shard {
+
+		Mutex *lock;
+		_Table *volatile table;
+		uint32_t count;
+
+		// Lookups walk the buckets without the lock. Unlinked entries and old
+		// bucket arrays are only freed once no such lookup is running.
+		volatile uint32_t readers;
+		_Data *retired_data;
+		_Table *retired_tables[32];
+		int retired_table_count;
+
+		uint32_t contended;
+		uint32_t slow_lookups;
+		uint32_t version;
+
+		uint8_t padding[64];
+	};
+
+	static _Shard _shards[STRING_TABLE_SHARDS];
 
 	_Data *_data;
 
@@ -85,11 +112,24 @@ class StringName {
 	friend void register_core_types();
 	friend void unregister_core_types();
 
-	static Mutex *lock;
 	static void setup();
 	static void cleanup();
 	static bool configured;
 
+	_FORCE_INLINE_ static _Shard &_get_shard(uint32_t p_hash) {
+
+		// Short names only fill the low hash bits, spread them before picking.
+		return _shards[(p_hash * 2654435761U) >> (32 - STRING_TABLE_SHARD_BITS)];
+	}
+
+	static _Table *_alloc_table(uint32_t p_mask);
+	static void _lock_shard(_Shard &p_shard);
+	static void _grow_shard(_Shard &p_shard);
+	static void _free_retired(_Shard &p_shard);
+
+	template <class T>
+	static _Data *_find(uint32_t p_hash, const T &p_name, bool p_create, const char *p_cname);
+
 	StringName(_Data *p_data) { _data = p_data; }
 
 public:
@@ -135,6 +175,17 @@ public:
 	static StringName search(const CharType *p_name);
 	static StringName search(const String &p_name);
 
+	struct TableStats {
+
+		uint32_t names;
+		uint32_t buckets;
+		uint32_t longest_chain;
+		uint32_t slow_lookups; // Lookups that had to take a shard lock.
+		uint32_t contended; // Times a shard lock was already taken.
+	};
+
+	static void get_table_stats(TableStats &r_stats);
+
 	struct AlphCompare {
 
 		_FORCE_INLINE_ bool operator()(const StringName &l, const StringName &r) const {
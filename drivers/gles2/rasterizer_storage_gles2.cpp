@@ -3615,6 +3615,22 @@ Transform2D RasterizerStorageGLES2::skeleton_bone_get_transform_2d(RID p_skeleto
 	return ret;
 }
 
+void RasterizerStorageGLES2::skeleton_set_as_bulk_array(RID p_skeleton, const PoolVector<float> &p_array) {
+	Skeleton *skeleton = skeleton_owner.getornull(p_skeleton);
+	ERR_FAIL_COND(!skeleton);
+
+	ERR_FAIL_COND(skeleton->use_2d);
+	ERR_FAIL_COND(p_array.size() != skeleton->size * 4 * 3);
+
+	// bulk layout matches bone_data, one row per basis axis with the origin in w
+	PoolVector<float>::Read r = p_array.read();
+	copymem(skeleton->bone_data.ptrw(), r.ptr(), p_array.size() * sizeof(float));
+
+	if (!skeleton->update_list.in_list()) {
+		skeleton_update_list.add(&skeleton->update_list);
+	}
+}
+
 void RasterizerStorageGLES2::skeleton_set_base_transform_2d(RID p_skeleton, const Transform2D &p_base_transform) {
 
 	Skeleton *skeleton = skeleton_owner.getornull(p_skeleton);
@@ -5141,6 +5141,35 @@ Transform2D RasterizerStorageGLES3::skeleton_bone_get_transform_2d(RID p_skeleto
 	return ret;
 }
 
+void RasterizerStorageGLES3::skeleton_set_as_bulk_array(RID p_skeleton, const PoolVector<float> &p_array) {
+
+	Skeleton *skeleton = skeleton_owner.getornull(p_skeleton);
+
+	ERR_FAIL_COND(!skeleton);
+	ERR_FAIL_COND(skeleton->use_2d);
+	ERR_FAIL_COND(p_array.size() != skeleton->size * 4 * 3);
+
+	PoolVector<float>::Read r = p_array.read();
+	const float *src = r.ptr();
+	float *texture = skeleton->skel_texture.ptrw();
+
+	// bulk layout is 3 rows of 4 floats per bone, the texture stores each row of a 256 bone block on its own line
+	for (int i = 0; i < skeleton->size; i++) {
+
+		int base_ofs = ((i / 256) * 256) * 3 * 4 + (i % 256) * 4;
+
+		copymem(&texture[base_ofs], &src[i * 12 + 0], sizeof(float) * 4);
+		base_ofs += 256 * 4;
+		copymem(&texture[base_ofs], &src[i * 12 + 4], sizeof(float) * 4);
+		base_ofs += 256 * 4;
+		copymem(&texture[base_ofs], &src[i * 12 + 8], sizeof(float) * 4);
+	}
+
+	if (!skeleton->update_list.in_list()) {
+		skeleton_update_list.add(&skeleton->update_list);
+	}
+}
+
 void RasterizerStorageGLES3::skeleton_set_base_transform_2d(RID p_skeleton, const Transform2D &p_base_transform) {
 
 	Skeleton *skeleton = skeleton_owner.getornull(p_skeleton);
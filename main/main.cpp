@@ -41,6 +41,7 @@
 #include "core/io/stream_peer_tcp.h"
 #include "core/message_queue.h"
 #include "core/os/dir_access.h"
+#include "core/os/frame_allocator.h"
 #include "core/os/os.h"
 #include "core/project_settings.h"
 #include "core/register_core_types.h"
@@ -1920,6 +1921,12 @@ bool Main::iteration() {
 		script_debugger->idle_poll();
 	}
 
+	if (iterating == 1) {
+		// a nested iteration (e.g. a progress dialog) runs inside a frame
+		FrameAllocator::end_frame();
+		message_queue->end_frame();
+	}
+
 	frames++;
 	Engine::get_singleton()->_idle_frames++;
 
@@ -1992,10 +1999,11 @@ void Main::cleanup() {
 
 	ERR_FAIL_COND(!_start_success);
 
+	ResourceLoader::clear_thread_load_tasks();
 	ResourceLoader::remove_custom_loaders();
 	ResourceSaver::remove_custom_savers();
 
-	message_queue->flush();
+	message_queue->drain();
 	memdelete(message_queue);
 
 	if (script_debugger) {
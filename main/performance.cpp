@@ -31,6 +31,7 @@
 #include "performance.h"
 
 #include "core/message_queue.h"
+#include "core/os/frame_allocator.h"
 #include "core/os/os.h"
 #include "scene/main/node.h"
 #include "scene/main/scene_tree.h"
@@ -74,6 +75,11 @@ void Performance::_bind_methods() {
 	BIND_ENUM_CONSTANT(PHYSICS_3D_COLLISION_PAIRS);
 	BIND_ENUM_CONSTANT(PHYSICS_3D_ISLAND_COUNT);
 	BIND_ENUM_CONSTANT(AUDIO_OUTPUT_LATENCY);
+	BIND_ENUM_CONSTANT(AUDIO_REAL_VOICES);
+	BIND_ENUM_CONSTANT(AUDIO_VIRTUAL_VOICES);
+	BIND_ENUM_CONSTANT(MEMORY_FRAME_ARENA_MAX);
+	BIND_ENUM_CONSTANT(MESSAGE_QUEUE_DEPTH);
+	BIND_ENUM_CONSTANT(MESSAGE_QUEUE_FLUSH_TIME);
 
 	BIND_ENUM_CONSTANT(MONITOR_MAX);
 }
@@ -120,6 +126,11 @@ String Performance::get_monitor_name(Monitor p_monitor) const {
 		"physics_3d/collision_pairs",
 		"physics_3d/islands",
 		"audio/output_latency",
+		"audio/real_voices",
+		"audio/virtual_voices",
+		"memory/frame_arena_max",
+		"message_queue/depth",
+		"message_queue/flush_time",
 
 	};
 
@@ -158,6 +169,11 @@ float Performance::get_monitor(Monitor p_monitor) const {
 		case PHYSICS_3D_COLLISION_PAIRS: return PhysicsServer::get_singleton()->get_process_info(PhysicsServer::INFO_COLLISION_PAIRS);
 		case PHYSICS_3D_ISLAND_COUNT: return PhysicsServer::get_singleton()->get_process_info(PhysicsServer::INFO_ISLAND_COUNT);
 		case AUDIO_OUTPUT_LATENCY: return AudioServer::get_singleton()->get_output_latency();
+		case AUDIO_REAL_VOICES: return AudioServer::get_singleton()->get_real_voice_count();
+		case AUDIO_VIRTUAL_VOICES: return AudioServer::get_singleton()->get_virtual_voice_count();
+		case MEMORY_FRAME_ARENA_MAX: return FrameAllocator::get_frame_max_usage();
+		case MESSAGE_QUEUE_DEPTH: return MessageQueue::get_singleton()->get_frame_depth_max();
+		case MESSAGE_QUEUE_FLUSH_TIME: return MessageQueue::get_singleton()->get_frame_flush_usec() / 1000000.0;
 
 		default: {
 		}
@@ -200,6 +216,11 @@ Performance::MonitorType Performance::get_monitor_type(Monitor p_monitor) const
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_TIME,
+		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_MEMORY,
+		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_TIME,
 
 	};
 
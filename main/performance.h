@@ -81,6 +81,11 @@ public:
 		PHYSICS_3D_ISLAND_COUNT,
 		//physics
 		AUDIO_OUTPUT_LATENCY,
+		AUDIO_REAL_VOICES,
+		AUDIO_VIRTUAL_VOICES,
+		MEMORY_FRAME_ARENA_MAX,
+		MESSAGE_QUEUE_DEPTH,
+		MESSAGE_QUEUE_FLUSH_TIME,
 		MONITOR_MAX
 	};
 
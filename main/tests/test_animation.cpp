@@ -0,0 +1,340 @@
+/*************************************************************************/
+/*  test_animation.cpp                                                   */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_animation.h"
+
+#include "core/math/math_funcs.h"
+#include "core/os/os.h"
+#include "core/project_settings.h"
+#include "scene/2d/node_2d.h"
+#include "scene/animation/animation_blend_tree.h"
+#include "scene/animation/animation_player.h"
+#include "scene/animation/animation_tree.h"
+#include "scene/main/scene_tree.h"
+#include "scene/main/viewport.h"
+#include "scene/resources/animation.h"
+
+namespace TestAnimation {
+
+// A walk-cycle shaped clip: a root bone that moves and turns, and a body of
+// rotation-only bones swinging at different rates, keyed at 30 fps the way
+// imported clips usually are.
+static Ref<Animation> _make_humanoid_clip(int p_bones, float p_length) {
+
+	Ref<Animation> anim;
+	anim.instance();
+	anim->set_length(p_length);
+	anim->set_loop(true);
+
+	const float key_fps = 30;
+	int keys = int(p_length * key_fps) + 1;
+
+	for (int i = 0; i < p_bones; i++) {
+
+		int track = anim->add_track(Animation::TYPE_TRANSFORM);
+		anim->track_set_path(track, "Skeleton:bone_" + itos(i));
+
+		for (int k = 0; k < keys; k++) {
+
+			float t = k / key_fps;
+			Vector3 loc;
+			if (i == 0) {
+				loc = Vector3(Math::sin(t * 0.5) * 0.3, 0.9 + Math::sin(t * 6.0) * 0.05, t * 1.4);
+			} else {
+				loc = Vector3(0, 0.1 + (i % 7) * 0.02, 0); //bones keep their offset to the parent
+			}
+
+			float swing = Math::sin(t * (2.0 + (i % 5)) + i) * (0.2 + (i % 3) * 0.3);
+			Quat rot = Quat(Vector3(Math::cos(float(i)), Math::sin(float(i)), 0.5).normalized(), swing);
+
+			anim->transform_track_insert_key(track, t, loc, rot, Vector3(1, 1, 1));
+		}
+	}
+
+	return anim;
+}
+
+static int _serialized_size(const Ref<Animation> &p_anim) {
+
+	int size = 0;
+	for (int i = 0; i < p_anim->get_track_count(); i++) {
+		if (p_anim->transform_track_is_compressed(i)) {
+			PoolVector<uint8_t> data = p_anim->get("tracks/" + itos(i) + "/compressed");
+			size += data.size();
+		} else {
+			PoolVector<float> data = p_anim->get("tracks/" + itos(i) + "/keys");
+			size += data.size() * sizeof(float);
+		}
+	}
+	return size;
+}
+
+static uint64_t _sample_all(const Ref<Animation> &p_anim, int p_samples, Vector3 *r_checksum) {
+
+	Vector3 sum;
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	for (int s = 0; s < p_samples; s++) {
+
+		float time = Math::fposmod(s * 0.0167f, p_anim->get_length());
+		for (int i = 0; i < p_anim->get_track_count(); i++) {
+			Vector3 loc;
+			Quat rot;
+			Vector3 scale;
+			p_anim->transform_track_interpolate(i, time, &loc, &rot, &scale);
+			sum += loc + Vector3(rot.x, rot.y, rot.z);
+		}
+	}
+
+	*r_checksum = sum;
+	return OS::get_singleton()->get_ticks_usec() - begin;
+}
+
+static bool _test_clip(int p_bones, float p_length, float p_fps, float p_allowed_loc_err, float p_allowed_rot_err) {
+
+	Ref<Animation> source = _make_humanoid_clip(p_bones, p_length);
+	Ref<Animation> compressed = _make_humanoid_clip(p_bones, p_length);
+	compressed->compress(p_fps);
+
+	bool ok = true;
+	for (int i = 0; i < compressed->get_track_count(); i++) {
+		if (!compressed->transform_track_is_compressed(i)) {
+			OS::get_singleton()->print("\ttrack %d was not compressed\n", i);
+			ok = false;
+		}
+	}
+
+	// error against the source clip, between frames too
+	float max_loc_err = 0;
+	float max_rot_err = 0;
+	for (float time = 0; time < p_length; time += 0.0071) {
+		for (int i = 0; i < p_bones; i++) {
+			Vector3 loc_a, loc_b, scale_a, scale_b;
+			Quat rot_a, rot_b;
+			source->transform_track_interpolate(i, time, &loc_a, &rot_a, &scale_a);
+			compressed->transform_track_interpolate(i, time, &loc_b, &rot_b, &scale_b);
+			max_loc_err = MAX(max_loc_err, loc_a.distance_to(loc_b));
+			if (rot_a.dot(rot_b) < 0)
+				rot_b = -rot_b;
+			max_rot_err = MAX(max_rot_err, 2.0f * (rot_a - rot_b).length()); //acos() is too coarse near 1
+
+		}
+	}
+
+	// saving goes through the track properties, reload into a fresh resource
+	Ref<Animation> loaded;
+	loaded.instance();
+	List<PropertyInfo> props;
+	compressed->get_property_list(&props);
+	for (List<PropertyInfo>::Element *E = props.front(); E; E = E->next()) {
+		if (E->get().usage & PROPERTY_USAGE_STORAGE)
+			loaded->set(E->get().name, compressed->get(E->get().name));
+	}
+
+	for (int i = 0; i < p_bones && ok; i++) {
+		if (!loaded->transform_track_is_compressed(i) || loaded->track_get_key_count(i) != compressed->track_get_key_count(i)) {
+			OS::get_singleton()->print("\ttrack %d did not survive saving\n", i);
+			ok = false;
+			break;
+		}
+		for (float time = 0; time < p_length; time += 0.1) {
+			Vector3 loc_a, loc_b;
+			compressed->transform_track_interpolate(i, time, &loc_a, NULL, NULL);
+			loaded->transform_track_interpolate(i, time, &loc_b, NULL, NULL);
+			if (loc_a != loc_b) {
+				OS::get_singleton()->print("\ttrack %d samples differently after loading\n", i);
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	const int samples = 2000;
+	Vector3 sum_a, sum_b;
+	uint64_t time_source = _sample_all(source, samples, &sum_a);
+	uint64_t time_compressed = _sample_all(compressed, samples, &sum_b);
+
+	int size_source = _serialized_size(source);
+	int size_compressed = _serialized_size(compressed);
+
+	OS::get_singleton()->print("%d bones, %.1f s, %.0f fps: %d -> %d bytes (%.1fx), max error %.5f m / %.5f rad\n", p_bones, p_length, p_fps, size_source, size_compressed, float(size_source) / size_compressed, max_loc_err, max_rot_err);
+	OS::get_singleton()->print("\tsampling %d poses: %.3f ms keyed, %.3f ms compressed (%.1f ns per track)\n", samples, time_source / 1000.0, time_compressed / 1000.0, time_compressed * 1000.0 / (samples * p_bones));
+
+	if (max_loc_err > p_allowed_loc_err || max_rot_err > p_allowed_rot_err) {
+		print_line("\terror is too large");
+		ok = false;
+	}
+
+	return ok;
+}
+
+MainLoop *test() {
+
+	bool ok = true;
+	// at the key rate only quantization adds error, at half of it the curves get smoothed too
+	ok = _test_clip(60, 10, 30, 0.001, 0.001) && ok;
+	ok = _test_clip(120, 30, 30, 0.001, 0.001) && ok;
+	ok = _test_clip(60, 10, 15, 0.002, 0.03) && ok;
+
+	print_line(ok ? "Compressed tracks: OK" : "Compressed tracks: FAIL");
+	return NULL;
+}
+
+// Animated nodes freed while their trees wait for the deferred blend. The
+// delete queue is flushed before the blends are, so the trees must not write
+// to them anymore, but must still animate the other nodes.
+class TreeFreeMainLoop : public SceneTree {
+
+	enum {
+		TREE_COUNT = 8,
+		FREE_FRAME = 3,
+		LAST_FRAME = 6
+	};
+
+	int frame;
+	int old_blending_threads;
+	bool ok;
+	Node2D *targets[TREE_COUNT];
+	Node2D *others[TREE_COUNT];
+
+public:
+	virtual void init() {
+
+		SceneTree::init();
+
+		// blend on worker threads, as projects with animation/blending_threads set do
+		old_blending_threads = GLOBAL_GET("animation/blending_threads");
+		AnimationTree::finish_blend_threads();
+		ProjectSettings::get_singleton()->set("animation/blending_threads", 4);
+		AnimationTree::init_blend_threads();
+
+		frame = 0;
+		ok = true;
+
+		Ref<Animation> anim;
+		anim.instance();
+		anim->set_length(1);
+		anim->set_loop(true);
+		int track = anim->add_track(Animation::TYPE_VALUE);
+		anim->track_set_path(track, NodePath("target:position"));
+		anim->track_insert_key(track, 0, Vector2());
+		anim->track_insert_key(track, 1, Vector2(100, 0));
+		track = anim->add_track(Animation::TYPE_VALUE);
+		anim->track_set_path(track, NodePath("other:position"));
+		anim->track_insert_key(track, 0, Vector2());
+		anim->track_insert_key(track, 1, Vector2(0, 100));
+
+		for (int i = 0; i < TREE_COUNT; i++) {
+
+			Node *root = memnew(Node);
+			get_root()->add_child(root);
+
+			targets[i] = memnew(Node2D);
+			targets[i]->set_name("target");
+			root->add_child(targets[i]);
+
+			others[i] = memnew(Node2D);
+			others[i]->set_name("other");
+			root->add_child(others[i]);
+
+			AnimationPlayer *player = memnew(AnimationPlayer);
+			player->set_name("player");
+			root->add_child(player);
+			player->add_animation("move", anim);
+
+			Ref<AnimationNodeAnimation> node;
+			node.instance();
+			node->set_animation("move");
+
+			AnimationTree *tree = memnew(AnimationTree);
+			root->add_child(tree);
+			tree->set_tree_root(node);
+			tree->set_animation_player(NodePath("../player"));
+			tree->set_active(true);
+		}
+	}
+
+	virtual bool idle(float p_time) {
+
+		frame++;
+
+		Vector2 before[TREE_COUNT];
+		for (int i = 0; i < TREE_COUNT; i++) {
+			before[i] = others[i]->get_position();
+		}
+
+		if (frame == FREE_FRAME) {
+			for (int i = 0; i < TREE_COUNT; i++) {
+				if (targets[i]->get_position() == Vector2()) {
+					print_line("FAIL: target " + itos(i) + " was not animated.");
+					ok = false;
+				}
+				// half of them, the other trees keep animating theirs
+				if (i % 2 == 0) {
+					targets[i]->queue_delete();
+					targets[i] = NULL;
+				}
+			}
+		}
+
+		bool quit = SceneTree::idle(p_time);
+
+		if (frame == FREE_FRAME) {
+			for (int i = 0; i < TREE_COUNT; i++) {
+				if (others[i]->get_position() == before[i]) {
+					print_line("FAIL: other " + itos(i) + " was not animated in the frame a target was freed.");
+					ok = false;
+				}
+			}
+		}
+
+		if (frame == LAST_FRAME) {
+			print_line(ok ? "AnimationTree free: OK" : "AnimationTree free: FAIL");
+			return true;
+		}
+
+		return quit;
+	}
+
+	virtual void finish() {
+
+		SceneTree::finish();
+
+		AnimationTree::finish_blend_threads();
+		ProjectSettings::get_singleton()->set("animation/blending_threads", old_blending_threads);
+		AnimationTree::init_blend_threads();
+	}
+};
+
+MainLoop *test_tree_free() {
+
+	return memnew(TreeFreeMainLoop);
+}
+} // namespace TestAnimation
@@ -29,8 +29,10 @@
 /*************************************************************************/
 
 #include "test_astar.h"
+#include "test_utils.h"
 
 #include "core/math/a_star.h"
+#include "core/math/math_funcs.h"
 #include "core/os/os.h"
 
 #include <stdio.h>
@@ -87,11 +89,244 @@ bool test_abcx() {
 	return ok;
 }
 
+// Grid with scattered walls and heavier cells, ids are y * width + x.
+static void _make_grid(AStar &r_astar, int p_width, int p_height, uint64_t p_seed) {
+
+	uint64_t seed = p_seed;
+	for (int y = 0; y < p_height; y++) {
+		for (int x = 0; x < p_width; x++) {
+			real_t weight = Math::rand_from_seed(&seed) % 8 == 0 ? 3 : 1;
+			r_astar.add_point(y * p_width + x, Vector3(x, y, 0), weight);
+		}
+	}
+
+	for (int y = 0; y < p_height; y++) {
+		for (int x = 0; x < p_width; x++) {
+			int id = y * p_width + x;
+			if (x + 1 < p_width && Math::rand_from_seed(&seed) % 6) {
+				r_astar.connect_points(id, id + 1);
+			}
+			if (y + 1 < p_height && Math::rand_from_seed(&seed) % 6) {
+				r_astar.connect_points(id, id + p_width);
+			}
+		}
+	}
+}
+
+static real_t _path_cost(AStar &p_astar, const PoolVector<int> &p_path) {
+
+	real_t cost = 0;
+	for (int i = 1; i < p_path.size(); i++) {
+		if (!p_astar.are_points_connected(p_path[i - 1], p_path[i]) || p_astar.is_point_disabled(p_path[i])) {
+			return -1;
+		}
+		cost += p_astar.get_point_position(p_path[i - 1]).distance_to(p_astar.get_point_position(p_path[i])) * p_astar.get_point_weight_scale(p_path[i]);
+	}
+	return cost;
+}
+
+bool test_hierarchical() {
+
+	AStar flat;
+	AStar clustered;
+	_make_grid(flat, 64, 64, 1);
+	_make_grid(clustered, 64, 64, 1);
+	clustered.set_cluster_size(8);
+
+	uint64_t seed = 2;
+	for (int i = 0; i < 600; i++) {
+
+		if (i % 20 == 0) {
+			// Toggle points to exercise incremental cluster updates.
+			int id = Math::rand_from_seed(&seed) % (64 * 64);
+			bool disabled = !flat.is_point_disabled(id);
+			flat.set_point_disabled(id, disabled);
+			clustered.set_point_disabled(id, disabled);
+		}
+
+		int from = Math::rand_from_seed(&seed) % (64 * 64);
+		int to = Math::rand_from_seed(&seed) % (64 * 64);
+		PoolVector<int> a = flat.get_id_path(from, to);
+		PoolVector<int> b = clustered.get_id_path(from, to);
+
+		if (a.size() == 0 || b.size() == 0) {
+			if (a.size() != b.size()) {
+				OS::get_singleton()->print("	reachability differs from %d to %d\n", from, to);
+				return false;
+			}
+			continue;
+		}
+
+		real_t cost_a = _path_cost(flat, a);
+		real_t cost_b = _path_cost(clustered, b);
+		if (cost_b < 0 || b[0] != from || b[b.size() - 1] != to || Math::abs(cost_a - cost_b) > 0.001) {
+			OS::get_singleton()->print("	path from %d to %d costs %f flat, %f clustered\n", from, to, cost_a, cost_b);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool test_batch() {
+
+	AStar astar;
+	_make_grid(astar, 48, 48, 3);
+	astar.set_cluster_size(6);
+
+	PoolVector<int> from_ids;
+	PoolVector<int> to_ids;
+	uint64_t seed = 4;
+	for (int i = 0; i < 200; i++) {
+		from_ids.push_back(Math::rand_from_seed(&seed) % (48 * 48));
+		to_ids.push_back(Math::rand_from_seed(&seed) % (48 * 48));
+	}
+
+	Array paths = astar.get_id_paths(from_ids, to_ids);
+	if (paths.size() != from_ids.size())
+		return false;
+
+	for (int i = 0; i < paths.size(); i++) {
+		PoolVector<int> batch = paths[i];
+		PoolVector<int> single = astar.get_id_path(from_ids[i], to_ids[i]);
+		if (batch.size() != single.size())
+			return false;
+		for (int j = 0; j < batch.size(); j++) {
+			if (batch[j] != single[j])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+struct ConcurrentBatch {
+
+	uint64_t seed;
+	bool ok;
+};
+
+static void _concurrent_batch(void *p_data) {
+
+	ConcurrentBatch *cb = (ConcurrentBatch *)p_data;
+	cb->ok = true;
+
+	AStar astar;
+	_make_grid(astar, 48, 48, cb->seed);
+	astar.set_cluster_size(6);
+
+	for (int round = 0; round < 10; round++) {
+
+		PoolVector<int> from_ids;
+		PoolVector<int> to_ids;
+		for (int i = 0; i < 50; i++) {
+			from_ids.push_back(Math::rand_from_seed(&cb->seed) % (48 * 48));
+			to_ids.push_back(Math::rand_from_seed(&cb->seed) % (48 * 48));
+		}
+
+		// toggling points rebuilds clusters, which runs on the pool as well
+		astar.set_point_disabled(from_ids[0], round % 2);
+
+		Array paths = astar.get_id_paths(from_ids, to_ids);
+		if (paths.size() != from_ids.size()) {
+			cb->ok = false;
+			return;
+		}
+
+		for (int i = 0; i < paths.size(); i++) {
+			PoolVector<int> batch = paths[i];
+			PoolVector<int> single = astar.get_id_path(from_ids[i], to_ids[i]);
+			if (batch.size() != single.size()) {
+				cb->ok = false;
+				return;
+			}
+			for (int j = 0; j < batch.size(); j++) {
+				if (batch[j] != single[j]) {
+					cb->ok = false;
+					return;
+				}
+			}
+		}
+	}
+}
+
+// Batches of different instances on different threads, the thread pool is
+// shared by all of them.
+bool test_batch_concurrent() {
+
+	ConcurrentBatch batches[4];
+	for (int i = 0; i < 4; i++) {
+		batches[i].seed = 10 + i;
+	}
+
+	TestUtils::wait_threads(TestUtils::start_threads(_concurrent_batch, batches, 4));
+
+	bool ok = true;
+	for (int i = 0; i < 4; i++) {
+		ok = TestUtils::check(batches[i].ok, "thread " + itos(i) + ": batched paths match single queries") && ok;
+	}
+	return ok;
+}
+
+bool test_throughput() {
+
+	const int size = 320;
+	const int queries = 200;
+
+	AStar astar;
+	_make_grid(astar, size, size, 5);
+
+	PoolVector<int> from_ids;
+	PoolVector<int> to_ids;
+	uint64_t seed = 6;
+	for (int i = 0; i < queries; i++) {
+		from_ids.push_back(Math::rand_from_seed(&seed) % (size * size));
+		to_ids.push_back(Math::rand_from_seed(&seed) % (size * size));
+	}
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < queries; i++) {
+		astar.get_id_path(from_ids[i], to_ids[i]);
+	}
+	uint64_t time_flat = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	astar.set_cluster_size(16);
+	astar.get_id_path(from_ids[0], from_ids[0] + 1); // Builds the cluster graph.
+	uint64_t time_build = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < queries; i++) {
+		astar.get_id_path(from_ids[i], to_ids[i]);
+	}
+	uint64_t time_clustered = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	astar.get_id_paths(from_ids, to_ids);
+	uint64_t time_batch = OS::get_singleton()->get_ticks_usec() - begin;
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < 20; i++) {
+		astar.set_point_disabled(from_ids[i], i % 2);
+	}
+	astar.get_id_path(from_ids[0], to_ids[0]);
+	uint64_t time_update = OS::get_singleton()->get_ticks_usec() - begin;
+
+	OS::get_singleton()->print("	%d points, %d queries: flat %.1f q/s, clustered %.1f q/s, batched %.1f q/s\n", size * size, queries, queries * 1000000.0 / time_flat, queries * 1000000.0 / time_clustered, queries * 1000000.0 / time_batch);
+	OS::get_singleton()->print("	cluster graph built in %.3f ms, 20 point toggles updated in %.3f ms\n", time_build / 1000.0, time_update / 1000.0);
+
+	return true;
+}
+
 typedef bool (*TestFunc)(void);
 
 TestFunc test_funcs[] = {
 	test_abc,
 	test_abcx,
+	test_hierarchical,
+	test_batch,
+	test_batch_concurrent,
+	test_throughput,
 	NULL
 };
 
@@ -0,0 +1,337 @@
+/*************************************************************************/
+/*  test_audio.cpp                                                       */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_audio.h"
+
+#include "core/math/math_funcs.h"
+#include "core/os/os.h"
+#include "core/project_settings.h"
+#include "scene/resources/audio_stream_sample.h"
+#include "servers/audio/audio_driver_dummy.h"
+#include "servers/audio/audio_mix_kernels.h"
+#include "servers/audio/effects/audio_effect_eq.h"
+#include "servers/audio/effects/audio_effect_reverb.h"
+#include "servers/audio_server.h"
+#include "test_utils.h"
+
+namespace TestAudio {
+
+/* KERNELS */
+
+static bool _frames_match(const AudioFrame *p_a, const AudioFrame *p_b, int p_frames) {
+
+	for (int i = 0; i < p_frames; i++) {
+		if (Math::abs(p_a[i].l - p_b[i].l) > 0.0001 || Math::abs(p_a[i].r - p_b[i].r) > 0.0001) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool _test_kernels() {
+
+	const int frames = 1023; //odd, so the scalar tail runs too
+
+	Vector<AudioFrame> src, dst, expected;
+	src.resize(frames);
+	dst.resize(frames);
+	expected.resize(frames);
+
+	for (int i = 0; i < frames; i++) {
+		src.write[i] = AudioFrame(Math::sin(i * 0.1), Math::cos(i * 0.07) * 0.5);
+		dst.write[i] = AudioFrame(i * 0.001, -i * 0.001);
+	}
+
+	bool ok = true;
+
+	// accumulate
+	for (int i = 0; i < frames; i++) {
+		expected.write[i] = dst[i] + src[i];
+	}
+	Vector<AudioFrame> res = dst;
+	AudioMixKernels::accumulate(res.ptrw(), src.ptr(), frames);
+	if (!_frames_match(res.ptr(), expected.ptr(), frames)) {
+		print_line("AudioMixKernels::accumulate() mismatch.");
+		ok = false;
+	}
+
+	// apply_volume_ramp
+	float vol = 0.8;
+	float inc = -0.5 / frames;
+	for (int i = 0; i < frames; i++) {
+		expected.write[i] = src[i] * (vol + inc * i);
+	}
+	res = src;
+	AudioMixKernels::apply_volume_ramp(res.ptrw(), frames, vol, inc);
+	if (!_frames_match(res.ptr(), expected.ptr(), frames)) {
+		print_line("AudioMixKernels::apply_volume_ramp() mismatch.");
+		ok = false;
+	}
+
+	// mix_volume_ramp
+	AudioFrame fvol(0.3, 0.9);
+	AudioFrame finc(0.4 / frames, -0.6 / frames);
+	for (int i = 0; i < frames; i++) {
+		expected.write[i] = dst[i] + src[i] * (fvol + finc * float(i));
+	}
+	res = dst;
+	AudioMixKernels::mix_volume_ramp(res.ptrw(), src.ptr(), frames, fvol, finc);
+	if (!_frames_match(res.ptr(), expected.ptr(), frames)) {
+		print_line("AudioMixKernels::mix_volume_ramp() mismatch.");
+		ok = false;
+	}
+
+	// apply_volume_get_peak
+	AudioFrame expected_peak(0, 0);
+	for (int i = 0; i < frames; i++) {
+		expected.write[i] = src[i] * 0.5;
+		expected_peak.l = MAX(expected_peak.l, Math::abs(expected[i].l));
+		expected_peak.r = MAX(expected_peak.r, Math::abs(expected[i].r));
+	}
+	res = src;
+	AudioFrame peak = AudioMixKernels::apply_volume_get_peak(res.ptrw(), frames, 0.5);
+	if (!_frames_match(res.ptr(), expected.ptr(), frames) || !_frames_match(&peak, &expected_peak, 1)) {
+		print_line("AudioMixKernels::apply_volume_get_peak() mismatch.");
+		ok = false;
+	}
+
+	// clear
+	res = src;
+	AudioMixKernels::clear(res.ptrw(), frames);
+	for (int i = 0; i < frames; i++) {
+		if (res[i].l != 0 || res[i].r != 0) {
+			print_line("AudioMixKernels::clear() left data.");
+			ok = false;
+			break;
+		}
+	}
+
+	return ok;
+}
+
+// A one second tone, looping if p_loop so the voices never stop.
+static Ref<AudioStreamSample> _make_tone(bool p_loop) {
+
+	const int sample_frames = 22050;
+	PoolVector<uint8_t> data;
+	data.resize(sample_frames * 2);
+	{
+		PoolVector<uint8_t>::Write w = data.write();
+		int16_t *samples = (int16_t *)w.ptr();
+		for (int i = 0; i < sample_frames; i++) {
+			samples[i] = int16_t(Math::sin(i * Math_PI * 2.0 * 440.0 / 22050.0) * 16000);
+		}
+	}
+
+	Ref<AudioStreamSample> sample;
+	sample.instance();
+	sample->set_format(AudioStreamSample::FORMAT_16_BITS);
+	sample->set_mix_rate(22050);
+	sample->set_loop_mode(p_loop ? AudioStreamSample::LOOP_FORWARD : AudioStreamSample::LOOP_DISABLED);
+	sample->set_loop_begin(0);
+	sample->set_loop_end(sample_frames);
+	sample->set_data(data);
+
+	return sample;
+}
+
+/* VOICES */
+
+static bool _test_voice_seek() {
+
+	AudioServer *as = AudioServer::get_singleton();
+	bool ok = true;
+
+	Ref<AudioStreamSample> sample = _make_tone(false);
+	Ref<AudioStreamPlayback> playback = sample->instance_playback();
+	float length = sample->get_length();
+	int frames = as->thread_get_mix_buffer_size();
+	float step = frames / as->get_mix_rate();
+
+	as->lock();
+
+	AudioServer::Voice *voice = as->voice_create();
+	playback->start(0.1);
+	voice->virtualized = true;
+	for (int i = 0; i < 4; i++) {
+		as->thread_voice_advance(voice, playback.ptr(), length, 1.0, frames);
+	}
+
+	// Seeking while virtual, the way the players do it from their mix callback.
+	playback->start(0.5);
+	as->voice_reset(voice);
+	for (int i = 0; i < 2; i++) {
+		as->thread_voice_advance(voice, playback.ptr(), length, 1.0, frames);
+	}
+
+	voice->virtualized = false;
+	as->thread_voice_advance(voice, playback.ptr(), length, 1.0, frames);
+	ok &= TestUtils::check(Math::abs(playback->get_playback_position() - (0.5 + step * 2)) < 0.001, "a virtual voice resumes from its seek position, at " + rtos(playback->get_playback_position()));
+
+	// Stopping and starting again while virtual.
+	voice->virtualized = true;
+	as->thread_voice_advance(voice, playback.ptr(), length, 1.0, frames);
+	playback->stop();
+	as->voice_reset(voice);
+	playback->start(0.0);
+	as->voice_reset(voice);
+	as->thread_voice_advance(voice, playback.ptr(), length, 1.0, frames);
+	voice->virtualized = false;
+	as->thread_voice_advance(voice, playback.ptr(), length, 1.0, frames);
+	ok &= TestUtils::check(Math::abs(playback->get_playback_position() - step) < 0.001, "a restarted virtual voice resumes from its start, at " + rtos(playback->get_playback_position()));
+
+	as->voice_free(voice);
+	as->unlock();
+
+	return ok;
+}
+
+/* BENCHMARK */
+
+// Exposes the driver side entry point, so the server can be driven without a sound card.
+class BenchmarkAudioDriver : public AudioDriverDummy {
+public:
+	void process(int p_frames, int32_t *p_buffer) {
+		audio_server_process(p_frames, p_buffer, false);
+	}
+};
+
+// Mixes like an AudioStreamPlayer2D does: resample the stream, then ramp it into its bus.
+struct Voice {
+	Ref<AudioStreamPlayback> playback;
+	int bus;
+	float pitch_scale;
+	AudioFrame volume;
+	Vector<AudioFrame> buffer;
+};
+
+static void _voice_mix(void *p_userdata) {
+
+	Voice *voice = (Voice *)p_userdata;
+	int buffer_size = voice->buffer.size();
+
+	voice->playback->mix(voice->buffer.ptrw(), voice->pitch_scale, buffer_size);
+
+	AudioFrame *target = AudioServer::get_singleton()->thread_get_channel_mix_buffer(voice->bus, 0);
+	AudioMixKernels::mix_volume_ramp(target, voice->buffer.ptr(), buffer_size, voice->volume, AudioFrame(0, 0));
+}
+
+static MainLoop *_benchmark(int p_voices, int p_buses, int p_steps) {
+
+	AudioServer *as = AudioServer::get_singleton();
+
+	Ref<AudioStreamSample> sample = _make_tone(true);
+
+	as->lock();
+
+	// Every bus has a reverb and an EQ, half of them go through a shared submix.
+	int first_bus = as->get_bus_count();
+	as->set_bus_count(first_bus + p_buses + 1);
+	int submix = first_bus + p_buses;
+	as->set_bus_name(submix, "Benchmark Submix");
+	as->set_bus_send(submix, "Master");
+
+	for (int i = 0; i < p_buses; i++) {
+		int bus = first_bus + i;
+		as->set_bus_name(bus, "Benchmark " + itos(i));
+		as->set_bus_send(bus, (i % 2) ? StringName("Master") : StringName("Benchmark Submix"));
+
+		Ref<AudioEffectReverb> reverb;
+		reverb.instance();
+		as->add_bus_effect(bus, reverb);
+
+		Ref<AudioEffectEQ10> eq;
+		eq.instance();
+		as->add_bus_effect(bus, eq);
+	}
+
+	Vector<Voice *> voices;
+	for (int i = 0; i < p_voices; i++) {
+		Voice *voice = memnew(Voice);
+		voice->playback = sample->instance_playback();
+		voice->playback->start(i * 0.01);
+		voice->bus = first_bus + i % p_buses;
+		voice->pitch_scale = 0.5 + (i % 16) / 10.0; //different resampling ratios
+		voice->volume = AudioFrame(0.01, 0.01);
+		voice->buffer.resize(as->thread_get_mix_buffer_size());
+		as->add_callback(_voice_mix, voice);
+		voices.push_back(voice);
+	}
+
+	as->unlock();
+
+	BenchmarkAudioDriver driver;
+	int frames = as->thread_get_mix_buffer_size();
+	Vector<int32_t> output;
+	output.resize(frames * as->get_channel_count() * 2);
+
+	// The real driver thread would mix too, keep it out while measuring.
+	as->lock();
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_steps; i++) {
+		driver.process(frames, output.ptrw());
+	}
+	uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+
+	for (int i = 0; i < voices.size(); i++) {
+		as->remove_callback(_voice_mix, voices[i]);
+		memdelete(voices[i]);
+	}
+	as->set_bus_count(first_bus);
+
+	as->unlock();
+
+	double step_msec = time / 1000.0 / p_steps;
+	double budget_msec = frames * 1000.0 / as->get_mix_rate();
+	OS::get_singleton()->print("%d voices, %d buses, %d mixing threads: %.3f ms per %d frames (%.1f%% of real time)\n", p_voices, p_buses, int(GLOBAL_GET("audio/mixing_threads")), step_msec, frames, step_msec * 100.0 / budget_msec);
+
+	return NULL;
+}
+
+MainLoop *test() {
+
+	if (_test_kernels()) {
+		print_line("Mix kernels: OK");
+	}
+
+	if (!AudioServer::get_singleton()) {
+		print_line("No AudioServer, skipping mixing benchmark.");
+		return NULL;
+	}
+
+	print_line(_test_voice_seek() ? "Voice seek: OK" : "Voice seek: FAIL");
+
+	_benchmark(64, 4, 200);
+	_benchmark(256, 16, 200);
+
+	return NULL;
+}
+} // namespace TestAudio
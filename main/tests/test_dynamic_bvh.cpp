@@ -0,0 +1,313 @@
+/*************************************************************************/
+/*  test_dynamic_bvh.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_dynamic_bvh.h"
+#include "test_utils.h"
+
+#include "core/math/camera_matrix.h"
+#include "core/math/dynamic_bvh.h"
+#include "core/math/octree.h"
+#include "core/math/random_pcg.h"
+#include "core/set.h"
+
+namespace TestDynamicBVH {
+
+enum {
+	ELEMENT_COUNT = 600,
+	STEP_COUNT = 40,
+	QUERY_COUNT = 20,
+};
+
+struct Element {
+
+	int index;
+};
+
+// Pairs reported by the callbacks, the two element indices packed in one key.
+typedef Set<uint64_t> PairSet;
+
+static uint64_t _pair_key(const Element *p_a, const Element *p_b) {
+
+	uint64_t a = MIN(p_a->index, p_b->index);
+	uint64_t b = MAX(p_a->index, p_b->index);
+	return (a << 32) | b;
+}
+
+static void *_pair_callback(void *p_self, uint32_t, Element *p_a, int, uint32_t, Element *p_b, int) {
+
+	PairSet *pairs = (PairSet *)p_self;
+	TestUtils::check(!pairs->has(_pair_key(p_a, p_b)), "pair reported twice");
+	pairs->insert(_pair_key(p_a, p_b));
+	return NULL;
+}
+
+static void _unpair_callback(void *p_self, uint32_t, Element *p_a, int, uint32_t, Element *p_b, int, void *) {
+
+	PairSet *pairs = (PairSet *)p_self;
+	TestUtils::check(pairs->has(_pair_key(p_a, p_b)), "unpaired a missing pair");
+	pairs->erase(_pair_key(p_a, p_b));
+}
+
+static bool _same_pairs(const PairSet &p_a, const PairSet &p_b) {
+
+	if (p_a.size() != p_b.size())
+		return false;
+
+	for (const PairSet::Element *E = p_a.front(); E; E = E->next()) {
+		if (!p_b.has(E->get()))
+			return false;
+	}
+	return true;
+}
+
+static Vector<Element *> _sorted(Element **p_results, int p_count) {
+
+	Vector<Element *> sorted;
+	sorted.resize(p_count);
+	for (int i = 0; i < p_count; i++) {
+		sorted.write[i] = p_results[i];
+	}
+	sorted.sort();
+	return sorted;
+}
+
+static bool _same_results(Element **p_a, int p_a_count, Element **p_b, int p_b_count) {
+
+	if (p_a_count != p_b_count)
+		return false;
+
+	Vector<Element *> a = _sorted(p_a, p_a_count);
+	Vector<Element *> b = _sorted(p_b, p_b_count);
+	for (int i = 0; i < a.size(); i++) {
+		if (a[i] != b[i])
+			return false;
+	}
+	return true;
+}
+
+static bool _test_3d() {
+
+	bool ok = true;
+	RandomPCG rng(1);
+
+	Octree<Element, true> octree;
+	DynamicBVH<Element, true> bvh;
+	PairSet octree_pairs;
+	PairSet bvh_pairs;
+	octree.set_pair_callback(_pair_callback, &octree_pairs);
+	octree.set_unpair_callback(_unpair_callback, &octree_pairs);
+	bvh.set_pair_callback(_pair_callback, &bvh_pairs);
+	bvh.set_unpair_callback(_unpair_callback, &bvh_pairs);
+
+	Element elements[ELEMENT_COUNT];
+	AABB aabbs[ELEMENT_COUNT];
+	OctreeElementID octree_ids[ELEMENT_COUNT];
+	DynamicBVHElementID bvh_ids[ELEMENT_COUNT];
+
+	for (int i = 0; i < ELEMENT_COUNT; i++) {
+
+		real_t size = rng.random(0.1f, 8.0f);
+		elements[i].index = i;
+		aabbs[i] = AABB(Vector3(rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f)), Vector3(size, size * 0.5, size));
+		bool pairable = i % 3 == 0;
+		uint32_t type = 1 << (i % 4);
+		uint32_t mask = rng.rand() % 16;
+		octree_ids[i] = octree.create(&elements[i], aabbs[i], 0, pairable, type, mask);
+		bvh_ids[i] = bvh.create(&elements[i], aabbs[i], 0, pairable, type, mask);
+	}
+
+	Element *octree_results[ELEMENT_COUNT];
+	Element *bvh_results[ELEMENT_COUNT];
+
+	for (int step = 0; step < STEP_COUNT; step++) {
+
+		// Most elements move a little, so they stay in their leaf, some jump and some leave or join the trees.
+		for (int i = 0; i < ELEMENT_COUNT; i++) {
+
+			uint32_t r = rng.rand() % 100;
+			if (r < 50) {
+				continue;
+			} else if (r < 85) {
+				if (aabbs[i].has_no_surface())
+					continue;
+				aabbs[i].position += Vector3(rng.random(-0.5f, 0.5f), rng.random(-0.5f, 0.5f), rng.random(-0.5f, 0.5f));
+			} else if (r < 95) {
+				real_t size = rng.random(0.1f, 20.0f);
+				aabbs[i] = AABB(Vector3(rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f)), Vector3(size, size, size * 0.5));
+			} else if (r < 98) {
+				aabbs[i] = AABB();
+			} else {
+				bool pairable = rng.rand() % 2;
+				uint32_t type = 1 << (rng.rand() % 4);
+				uint32_t mask = rng.rand() % 16;
+				octree.set_pairable(octree_ids[i], pairable, type, mask);
+				bvh.set_pairable(bvh_ids[i], pairable, type, mask);
+				continue;
+			}
+
+			octree.move(octree_ids[i], aabbs[i]);
+			bvh.move(bvh_ids[i], aabbs[i]);
+		}
+
+		bvh.update();
+		ok &= TestUtils::check(_same_pairs(octree_pairs, bvh_pairs), "pairs match the octree at step " + itos(step));
+
+		for (int q = 0; q < QUERY_COUNT; q++) {
+
+			uint32_t mask = rng.rand() % 2 ? 0xFFFFFFFF : (1 << (rng.rand() % 4));
+
+			AABB box(Vector3(rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f)), Vector3(rng.random(0.0f, 60.0f), rng.random(0.0f, 60.0f), rng.random(0.0f, 60.0f)));
+			int octree_count = octree.cull_aabb(box, octree_results, ELEMENT_COUNT, NULL, mask);
+			int bvh_count = bvh.cull_aabb(box, bvh_results, ELEMENT_COUNT, NULL, mask);
+			ok &= TestUtils::check(_same_results(octree_results, octree_count, bvh_results, bvh_count), "cull_aabb matches the octree at step " + itos(step));
+
+			Vector3 from(rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f));
+			Vector3 to(rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f));
+			octree_count = octree.cull_segment(from, to, octree_results, ELEMENT_COUNT, NULL, mask);
+			bvh_count = bvh.cull_segment(from, to, bvh_results, ELEMENT_COUNT, NULL, mask);
+			ok &= TestUtils::check(_same_results(octree_results, octree_count, bvh_results, bvh_count), "cull_segment matches the octree at step " + itos(step));
+
+			CameraMatrix projection;
+			projection.set_perspective(rng.random(30.0f, 100.0f), rng.random(0.5f, 2.0f), 0.1, rng.random(10.0f, 200.0f));
+			Transform camera;
+			camera.origin = Vector3(rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f), rng.random(-100.0f, 100.0f));
+			camera.basis.rotate(Vector3(rng.random(-1.0f, 1.0f), rng.random(-1.0f, 1.0f), 1.0).normalized(), rng.random(0.0f, 6.0f));
+			Vector<Plane> planes = projection.get_projection_planes(camera);
+
+			octree_count = octree.cull_convex(planes, octree_results, ELEMENT_COUNT, mask);
+			bvh_count = bvh.cull_convex(planes, bvh_results, ELEMENT_COUNT, mask);
+
+			// The octree can reject elements that only overlap the frustum near a corner, the BVH keeps every
+			// element whose AABB is not fully outside one of the planes.
+			Vector<Element *> octree_sorted = _sorted(octree_results, octree_count);
+			Vector<Element *> bvh_sorted = _sorted(bvh_results, bvh_count);
+			bool convex_ok = true;
+			for (int i = 0; i < octree_sorted.size(); i++) {
+				convex_ok &= bvh_sorted.find(octree_sorted[i]) != -1;
+			}
+			for (int i = 0; i < bvh_sorted.size(); i++) {
+				if (octree_sorted.find(bvh_sorted[i]) == -1) {
+					convex_ok &= aabbs[bvh_sorted[i]->index].intersects_convex_shape(planes.ptr(), planes.size());
+				}
+			}
+			ok &= TestUtils::check(convex_ok, "cull_convex matches the octree at step " + itos(step));
+		}
+	}
+
+	for (int i = 0; i < ELEMENT_COUNT; i++) {
+		octree.erase(octree_ids[i]);
+		bvh.erase(bvh_ids[i]);
+	}
+	ok &= TestUtils::check(octree_pairs.empty() && bvh_pairs.empty(), "erasing removes every pair");
+
+	return ok;
+}
+
+// There is no 2D octree, so the Rect2 tree is checked against brute force.
+static bool _test_2d() {
+
+	bool ok = true;
+	RandomPCG rng(2);
+
+	DynamicBVH<Element, true, Rect2> bvh(4.0);
+	PairSet bvh_pairs;
+	bvh.set_pair_callback(_pair_callback, &bvh_pairs);
+	bvh.set_unpair_callback(_unpair_callback, &bvh_pairs);
+
+	Element elements[ELEMENT_COUNT];
+	Rect2 rects[ELEMENT_COUNT];
+	bool pairable[ELEMENT_COUNT];
+	DynamicBVHElementID bvh_ids[ELEMENT_COUNT];
+
+	for (int i = 0; i < ELEMENT_COUNT; i++) {
+
+		elements[i].index = i;
+		rects[i] = Rect2(rng.random(-500.0f, 500.0f), rng.random(-500.0f, 500.0f), rng.random(1.0f, 40.0f), rng.random(1.0f, 40.0f));
+		pairable[i] = i % 2 == 0;
+		bvh_ids[i] = bvh.create(&elements[i], rects[i], 0, pairable[i], 1, 1);
+	}
+
+	Element *bvh_results[ELEMENT_COUNT];
+	Element *expected[ELEMENT_COUNT];
+
+	for (int step = 0; step < STEP_COUNT; step++) {
+
+		for (int i = 0; i < ELEMENT_COUNT; i++) {
+
+			uint32_t r = rng.rand() % 100;
+			if (r < 50) {
+				continue;
+			} else if (r < 90) {
+				rects[i].position += Vector2(rng.random(-3.0f, 3.0f), rng.random(-3.0f, 3.0f));
+			} else {
+				rects[i].position = Vector2(rng.random(-500.0f, 500.0f), rng.random(-500.0f, 500.0f));
+			}
+			bvh.move(bvh_ids[i], rects[i]);
+		}
+
+		bvh.update();
+
+		PairSet expected_pairs;
+		for (int i = 0; i < ELEMENT_COUNT; i++) {
+			for (int j = i + 1; j < ELEMENT_COUNT; j++) {
+				if ((pairable[i] || pairable[j]) && rects[i].intersects(rects[j])) {
+					expected_pairs.insert(_pair_key(&elements[i], &elements[j]));
+				}
+			}
+		}
+		ok &= TestUtils::check(_same_pairs(expected_pairs, bvh_pairs), "2D pairs match brute force at step " + itos(step));
+
+		for (int q = 0; q < QUERY_COUNT; q++) {
+
+			Rect2 box(rng.random(-500.0f, 500.0f), rng.random(-500.0f, 500.0f), rng.random(0.0f, 200.0f), rng.random(0.0f, 200.0f));
+			int expected_count = 0;
+			for (int i = 0; i < ELEMENT_COUNT; i++) {
+				if (box.intersects(rects[i])) {
+					expected[expected_count++] = &elements[i];
+				}
+			}
+			int bvh_count = bvh.cull_aabb(box, bvh_results, ELEMENT_COUNT);
+			ok &= TestUtils::check(_same_results(expected, expected_count, bvh_results, bvh_count), "2D cull_aabb matches brute force at step " + itos(step));
+		}
+	}
+
+	return ok;
+}
+
+MainLoop *test() {
+
+	bool ok = true;
+	ok &= _test_3d();
+	ok &= _test_2d();
+
+	print_line(ok ? "DynamicBVH: OK" : "DynamicBVH: FAIL");
+	return NULL;
+}
+} // namespace TestDynamicBVH
@@ -0,0 +1,125 @@
+/*************************************************************************/
+/*  test_frame_allocator.cpp                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_frame_allocator.h"
+#include "test_utils.h"
+
+#include "core/frame_vector.h"
+#include "core/list.h"
+#include "core/os/frame_allocator.h"
+#include "core/os/os.h"
+
+namespace TestFrameAllocator {
+
+// A frame's worth of the temporaries the engine builds on hot paths: a path
+// of points and a list of hits, dropped before the next one.
+template <class A>
+static uint64_t _run_frames(int p_frames, int p_items) {
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	for (int f = 0; f < p_frames; f++) {
+
+		List<Vector3, A> hits;
+		for (int i = 0; i < p_items; i++) {
+			hits.push_back(Vector3(i, f, 0));
+		}
+
+		if (hits.size() != p_items) {
+			return 0;
+		}
+	}
+
+	return OS::get_singleton()->get_ticks_usec() - begin;
+}
+
+MainLoop *test() {
+
+	bool ok = true;
+
+	FrameAllocator::reset();
+
+	{
+		// scoped use hands the space back, even for blocks freed out of order
+		FrameVector<Vector3> path;
+		for (int i = 0; i < 1000; i++) {
+			path.push_back(Vector3(i, 0, 0));
+		}
+		void *a = FrameAllocator::alloc(100);
+		void *b = FrameAllocator::alloc(200);
+		FrameAllocator::free(a);
+		ok &= TestUtils::check(FrameAllocator::get_usage() > 0, "usage while allocated");
+		FrameAllocator::free(b);
+
+		path.invert();
+		ok &= TestUtils::check(path.size() == 1000 && path[0].x == 999 && path[999].x == 0, "FrameVector contents");
+	}
+	ok &= TestUtils::check(FrameAllocator::get_usage() == 0, "scoped blocks reclaimed");
+
+	{
+		// blocks bigger than the arena go to the heap until the reset
+		uint8_t *big = (uint8_t *)FrameAllocator::alloc(FrameAllocator::INITIAL_SIZE * 2);
+		big[FrameAllocator::INITIAL_SIZE * 2 - 1] = 1;
+		List<int, FrameAllocator> list;
+		for (int i = 0; i < 1000; i++) {
+			list.push_back(i);
+		}
+		ok &= TestUtils::check(list.size() == 1000 && list.back()->get() == 999, "List in frame memory");
+		FrameAllocator::free(big);
+	}
+
+	ok &= TestUtils::check(FrameAllocator::get_usage() == 0, "list nodes reclaimed");
+
+	FrameAllocator::alloc(64); // never freed
+	ok &= TestUtils::check(FrameAllocator::get_usage() > 0, "blocks stay until the frame ends");
+
+	FrameAllocator::end_frame();
+	ok &= TestUtils::check(FrameAllocator::get_usage() == 0, "frame reset");
+	ok &= TestUtils::check(FrameAllocator::get_frame_max_usage() >= uint64_t(FrameAllocator::INITIAL_SIZE * 2), "frame high-water mark");
+
+	// the arena grew to what the last frame needed, it fits now
+	void *big = FrameAllocator::alloc(FrameAllocator::INITIAL_SIZE * 2);
+	FrameAllocator::free(big);
+	FrameAllocator::end_frame();
+
+	const int frames = 2000;
+	const int items = 256;
+	uint64_t time_default = _run_frames<DefaultAllocator>(frames, items);
+	uint64_t time_frame = _run_frames<FrameAllocator>(frames, items);
+	FrameAllocator::end_frame();
+
+	OS::get_singleton()->print("%d frames of %d list nodes: %.3f ms default allocator, %.3f ms frame allocator, %d bytes peak\n", frames, items, time_default / 1000.0, time_frame / 1000.0, int(FrameAllocator::get_frame_max_usage()));
+
+	ok &= TestUtils::check(time_default && time_frame, "list sizes");
+
+	print_line(ok ? "FrameAllocator: OK" : "FrameAllocator: FAIL");
+	return NULL;
+}
+} // namespace TestFrameAllocator
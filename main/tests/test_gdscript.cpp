@@ -38,6 +38,7 @@
 
 #include "modules/gdscript/gdscript.h"
 #include "modules/gdscript/gdscript_compiler.h"
+#include "modules/gdscript/gdscript_optimizer.h"
 #include "modules/gdscript/gdscript_parser.h"
 #include "modules/gdscript/gdscript_tokenizer.h"
 
@@ -567,10 +568,17 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 
 			switch (code[ip]) {
 
-				case GDScriptFunction::OPCODE_OPERATOR: {
+				case GDScriptFunction::OPCODE_OPERATOR:
+				case GDScriptFunction::OPCODE_OPERATOR_INT:
+				case GDScriptFunction::OPCODE_OPERATOR_REAL: {
 
 					int op = code[ip + 1];
-					txt += " op ";
+					if (code[ip] == GDScriptFunction::OPCODE_OPERATOR_INT)
+						txt += " op-int ";
+					else if (code[ip] == GDScriptFunction::OPCODE_OPERATOR_REAL)
+						txt += " op-real ";
+					else
+						txt += " op ";
 
 					String opname = Variant::get_operator_name(Variant::Operator(op));
 
@@ -605,27 +613,29 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					incr += 4;
 
 				} break;
-				case GDScriptFunction::OPCODE_SET_NAMED: {
+				case GDScriptFunction::OPCODE_SET_NAMED:
+				case GDScriptFunction::OPCODE_SET_NAMED_VECTOR: {
 
-					txt += " set_named ";
+					txt += code[ip] == GDScriptFunction::OPCODE_SET_NAMED_VECTOR ? " set_named-vector " : " set_named ";
 					txt += DADDR(1);
 					txt += "[\"";
 					txt += func.get_global_name(code[ip + 2]);
 					txt += "\"]=";
 					txt += DADDR(3);
-					incr += 4;
+					incr += code[ip] == GDScriptFunction::OPCODE_SET_NAMED_VECTOR ? 5 : 4;
 
 				} break;
-				case GDScriptFunction::OPCODE_GET_NAMED: {
+				case GDScriptFunction::OPCODE_GET_NAMED:
+				case GDScriptFunction::OPCODE_GET_NAMED_VECTOR: {
 
-					txt += " get_named ";
+					txt += code[ip] == GDScriptFunction::OPCODE_GET_NAMED_VECTOR ? " get_named-vector " : " get_named ";
 					txt += DADDR(3);
 					txt += "=";
 					txt += DADDR(1);
 					txt += "[\"";
 					txt += func.get_global_name(code[ip + 2]);
 					txt += "\"]";
-					incr += 4;
+					incr += code[ip] == GDScriptFunction::OPCODE_GET_NAMED_VECTOR ? 5 : 4;
 
 				} break;
 				case GDScriptFunction::OPCODE_SET_MEMBER: {
@@ -746,14 +756,17 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 				} break;
 
 				case GDScriptFunction::OPCODE_CALL:
-				case GDScriptFunction::OPCODE_CALL_RETURN: {
+				case GDScriptFunction::OPCODE_CALL_RETURN:
+				case GDScriptFunction::OPCODE_CALL_METHOD_BIND:
+				case GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN: {
 
-					bool ret = code[ip] == GDScriptFunction::OPCODE_CALL_RETURN;
+					bool ret = code[ip] == GDScriptFunction::OPCODE_CALL_RETURN || code[ip] == GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN;
+					bool native = code[ip] == GDScriptFunction::OPCODE_CALL_METHOD_BIND || code[ip] == GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN;
 
 					if (ret)
-						txt += " call-ret ";
+						txt += native ? " call-bind-ret " : " call-ret ";
 					else
-						txt += " call ";
+						txt += native ? " call-bind " : " call ";
 
 					int argc = code[ip + 1];
 					if (ret) {
@@ -761,7 +774,7 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 					}
 
 					txt += DADDR(2) + ".";
-					txt += String(func.get_global_name(code[ip + 3]));
+					txt += String(native ? func.get_native_method_name(code[ip + 3]) : func.get_global_name(code[ip + 3]));
 					txt += "(";
 
 					for (int i = 0; i < argc; i++) {
@@ -921,8 +934,375 @@ static void _disassemble_class(const Ref<GDScript> &p_class, const Vector<String
 	}
 }
 
+/* BENCHMARK */
+
+static const char *benchmark_code =
+	"extends Reference\n"
+	"\n"
+	"signal ticked(value)\n"
+	"\n"
+	"var received = 0\n"
+	"\n"
+	"func fib(n):\n"
+	"\tif n < 2:\n"
+	"\t\treturn n\n"
+	"\treturn fib(n - 1) + fib(n - 2)\n"
+	"\n"
+	"func fib_typed(n: int) -> int:\n"
+	"\tif n < 2:\n"
+	"\t\treturn n\n"
+	"\treturn fib_typed(n - 1) + fib_typed(n - 2)\n"
+	"\n"
+	"func loop(count):\n"
+	"\tvar total = 0\n"
+	"\tfor i in range(count):\n"
+	"\t\ttotal += i % 7\n"
+	"\treturn total\n"
+	"\n"
+	"func loop_typed(count: int) -> int:\n"
+	"\tvar total := 0\n"
+	"\tvar i := 0\n"
+	"\twhile i < count:\n"
+	"\t\ttotal += i % 7\n"
+	"\t\ti += 1\n"
+	"\treturn total\n"
+	"\n"
+	"func vector_math(count: int) -> float:\n"
+	"\tvar pos := Vector3()\n"
+	"\tvar vel := Vector3(1.5, -0.5, 0.25)\n"
+	"\tfor i in range(count):\n"
+	"\t\tpos += vel * 0.016\n"
+	"\t\tif pos.x > 10.0:\n"
+	"\t\t\tpos.x -= 20.0\n"
+	"\t\tvel.y = vel.y * 0.999 + 0.001\n"
+	"\treturn pos.length()\n"
+	"\n"
+	"func _on_ticked(value):\n"
+	"\treceived += value\n"
+	"\n"
+	"func signals(count: int) -> int:\n"
+	"\treceived = 0\n"
+	"\tconnect(\"ticked\", self, \"_on_ticked\")\n"
+	"\tfor i in range(count):\n"
+	"\t\temit_signal(\"ticked\", 1)\n"
+	"\tdisconnect(\"ticked\", self, \"_on_ticked\")\n"
+	"\treturn received\n";
+
+static void _benchmark_call(Object *p_obj, const StringName &p_method, int p_arg, int p_repeat) {
+
+	Variant arg = p_arg;
+	const Variant *args[1] = { &arg };
+	Variant::CallError ce;
+	Variant ret;
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < p_repeat; i++) {
+		ret = p_obj->call(p_method, args, 1, ce);
+	}
+	uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+
+	if (ce.error != Variant::CallError::CALL_OK) {
+		print_line("Error calling " + String(p_method) + "().");
+		return;
+	}
+
+	OS::get_singleton()->print("%-12s (%8d) x %3d: %9.3f ms/call, result %s\n", String(p_method).utf8().get_data(), p_arg, p_repeat, time / 1000.0 / p_repeat, String(ret).utf8().get_data());
+}
+
+static MainLoop *_benchmark() {
+
+	Ref<GDScript> gds;
+	gds.instance();
+	gds->set_source_code(benchmark_code);
+	Error err = gds->reload();
+	if (err != OK) {
+		print_line("Benchmark script failed to compile.");
+		return NULL;
+	}
+
+	Ref<Reference> obj;
+	obj.instance();
+	obj->set_script(gds.get_ref_ptr());
+
+	_benchmark_call(obj.ptr(), "fib", 25, 5);
+	_benchmark_call(obj.ptr(), "fib_typed", 25, 5);
+	_benchmark_call(obj.ptr(), "loop", 1000000, 5);
+	_benchmark_call(obj.ptr(), "loop_typed", 1000000, 5);
+	_benchmark_call(obj.ptr(), "vector_math", 1000000, 5);
+	_benchmark_call(obj.ptr(), "signals", 100000, 5);
+
+	return NULL;
+}
+
+/* OPTIMIZER */
+
+// Control flow the optimizer has to keep intact, each function returns a
+// known value.
+static const char *optimizer_code =
+	"extends Reference\n"
+	"\n"
+	"func for_range():\n"
+	"\tvar total = 0\n"
+	"\tfor i in range(10):\n"
+	"\t\ttotal += i\n"
+	"\treturn total\n"
+	"\n"
+	"func for_empty():\n"
+	"\tvar total = 1\n"
+	"\tfor i in []:\n"
+	"\t\ttotal += 100\n"
+	"\treturn total\n"
+	"\n"
+	"func for_nested_break_continue():\n"
+	"\tvar total = 0\n"
+	"\tfor i in [1, 2, 3, 4]:\n"
+	"\t\tif i == 2:\n"
+	"\t\t\tcontinue\n"
+	"\t\tfor j in range(i):\n"
+	"\t\t\tif j == 2:\n"
+	"\t\t\t\tbreak\n"
+	"\t\t\ttotal += i * 10 + j\n"
+	"\treturn total\n"
+	"\n"
+	"func for_typed(count: int) -> int:\n"
+	"\tvar total := 0\n"
+	"\tfor i in range(count):\n"
+	"\t\tif true:\n"
+	"\t\t\ttotal += 2\n"
+	"\t\telse:\n"
+	"\t\t\ttotal -= 1000\n"
+	"\treturn total\n"
+	"\n"
+	"func while_const():\n"
+	"\tvar n = 0\n"
+	"\twhile true:\n"
+	"\t\tn += 1\n"
+	"\t\tif n >= 3 * 2:\n"
+	"\t\t\tbreak\n"
+	"\treturn n\n"
+	"\n"
+	"func default_args(a = 1 + 2, b = [1, 2]):\n"
+	"\tvar total = a\n"
+	"\tfor x in b:\n"
+	"\t\ttotal += x\n"
+	"\treturn total\n"
+	"\n"
+	"func vector2_untyped(count):\n"
+	"\tvar v = Vector2(1, 2)\n"
+	"\tfor i in range(count):\n"
+	"\t\tv.x += v.y * 0.5\n"
+	"\t\tv.y = v.x - i\n"
+	"\treturn v\n"
+	"\n"
+	"func vector2_typed(count: int) -> Vector2:\n"
+	"\tvar v := Vector2(1, 2)\n"
+	"\tfor i in range(count):\n"
+	"\t\tv.x += v.y * 0.5\n"
+	"\t\tv.y = v.x - i\n"
+	"\treturn v\n"
+	"\n"
+	"func vector3_untyped(count):\n"
+	"\tvar v = Vector3(1, 2, 3)\n"
+	"\tfor i in range(count):\n"
+	"\t\tv.z -= v.x * 0.25\n"
+	"\t\tv.x = v.y + v.z\n"
+	"\t\tv.y = -v.y\n"
+	"\treturn v\n"
+	"\n"
+	"func vector3_typed(count: int) -> Vector3:\n"
+	"\tvar v := Vector3(1, 2, 3)\n"
+	"\tfor i in range(count):\n"
+	"\t\tv.z -= v.x * 0.25\n"
+	"\t\tv.x = v.y + v.z\n"
+	"\t\tv.y = -v.y\n"
+	"\treturn v\n"
+	"\n"
+	"func method_bind_untyped(count):\n"
+	"\tvar rng = RandomNumberGenerator.new()\n"
+	"\tvar total = 0\n"
+	"\tfor i in range(count):\n"
+	"\t\trng.set_seed(i * 3)\n"
+	"\t\ttotal += rng.randi_range(0, 1000) + rng.get_seed()\n"
+	"\treturn [total, rng.randf(), rng.is_class(\"Reference\")]\n"
+	"\n"
+	"func method_bind_typed(count: int) -> Array:\n"
+	"\tvar rng := RandomNumberGenerator.new()\n"
+	"\tvar total := 0\n"
+	"\tfor i in range(count):\n"
+	"\t\trng.set_seed(i * 3)\n"
+	"\t\ttotal += rng.randi_range(0, 1000) + rng.get_seed()\n"
+	"\treturn [total, rng.randf(), rng.is_class(\"Reference\")]\n";
+
+static void _optimizer_error_handler(void *p_self, const char *p_func, const char *p_file, int p_line, const char *p_error, const char *p_errorexp, ErrorHandlerType p_type) {
+
+	(*(int *)p_self)++;
+}
+
+static bool _optimizer_check(Object *p_obj, const StringName &p_method, const Variant &p_expected, const Variant &p_arg = Variant()) {
+
+	const Variant *args[1] = { &p_arg };
+	Variant::CallError ce;
+	Variant ret = p_obj->call(p_method, args, p_arg.get_type() == Variant::NIL ? 0 : 1, ce);
+
+	if (ce.error != Variant::CallError::CALL_OK || ret != p_expected) {
+		print_line("FAIL: " + String(p_method) + "() returned " + String(ret) + ", expected " + String(p_expected));
+		return false;
+	}
+	return true;
+}
+
+// The typed variant of a function has to use p_opcode and return the same as
+// the untyped one, which goes through the generic opcodes.
+static bool _optimizer_compare(const Ref<GDScript> &p_script, Object *p_obj, const String &p_method, GDScriptFunction::Opcode p_opcode, int p_arg) {
+
+	StringName typed = p_method + "_typed";
+	StringName untyped = p_method + "_untyped";
+
+	const Map<StringName, GDScriptFunction *> &mf = p_script->debug_get_member_functions();
+	if (!mf.has(typed)) {
+		print_line("FAIL: " + String(typed) + "() not found.");
+		return false;
+	}
+
+	const GDScriptFunction *func = mf[typed];
+	const int *code = func->get_code();
+	bool found = false;
+	for (int ip = 0; ip < func->get_code_size() && !found; ip += GDScriptFunction::get_opcode_size(code, ip)) {
+		found = code[ip] == p_opcode;
+	}
+	if (!found) {
+		print_line("FAIL: " + String(typed) + "() doesn't use the typed opcode.");
+		return false;
+	}
+
+	Variant arg = p_arg;
+	const Variant *args[1] = { &arg };
+	Variant::CallError ce;
+	Variant expected = p_obj->call(untyped, args, 1, ce);
+	if (ce.error != Variant::CallError::CALL_OK) {
+		print_line("FAIL: " + String(untyped) + "() failed.");
+		return false;
+	}
+
+	return _optimizer_check(p_obj, typed, expected, arg);
+}
+
+// Folding must not merge -0.0 into an existing 0.0 constant, they behave differently (1 / x, atan2()).
+static bool _optimizer_signed_zero() {
+
+	const int stack = GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS;
+	const int constant = GDScriptFunction::ADDR_TYPE_LOCAL_CONSTANT << GDScriptFunction::ADDR_BITS;
+
+	Vector<Variant> constants;
+	constants.push_back(0.0);
+	constants.push_back(-1.0);
+	constants.push_back(Vector2());
+
+	Vector<int> code;
+	const int ops[][2] = { { 0, 1 }, { 2, 1 } }; // 0.0 * -1.0, Vector2() * -1.0
+	for (int i = 0; i < 2; i++) {
+		code.push_back(GDScriptFunction::OPCODE_OPERATOR);
+		code.push_back(Variant::OP_MULTIPLY);
+		code.push_back(constant | ops[i][0]);
+		code.push_back(constant | ops[i][1]);
+		code.push_back(stack | i);
+	}
+	code.push_back(GDScriptFunction::OPCODE_END);
+
+	Vector<int> default_args;
+	GDScriptOptimizer optimizer;
+	if (!optimizer.optimize(code, default_args, constants)) {
+		print_line("FAIL: signed zero code was not optimized.");
+		return false;
+	}
+
+	bool ok = true;
+	int ip = 0;
+	for (int i = 0; i < 2; i++) {
+
+		if (code[ip] != GDScriptFunction::OPCODE_ASSIGN) {
+			print_line("FAIL: signed zero operator " + itos(i) + " was not folded.");
+			return false;
+		}
+
+		Variant folded = constants[code[ip + 2] & GDScriptFunction::ADDR_MASK];
+		Vector2 v = folded.get_type() == Variant::VECTOR2 ? Vector2(folded) : Vector2(folded, folded);
+		if (!(v.x == 0 && 1 / v.x < 0) || !(v.y == 0 && 1 / v.y < 0)) {
+			print_line("FAIL: signed zero operator " + itos(i) + " folded to " + String(folded) + ", not to negative zeros.");
+			ok = false;
+		}
+
+		ip += GDScriptFunction::get_opcode_size(code.ptr(), ip);
+	}
+
+	return ok;
+}
+
+static MainLoop *_optimizer() {
+
+	// the optimizer reports code it can't handle as an error and leaves it as is
+	int errors = 0;
+	ErrorHandlerList handler;
+	handler.errfunc = _optimizer_error_handler;
+	handler.userdata = &errors;
+	add_error_handler(&handler);
+
+	Ref<GDScript> gds;
+	gds.instance();
+	gds->set_source_code(optimizer_code);
+	Error err = gds->reload();
+
+	Ref<GDScript> benchmark;
+	benchmark.instance();
+	benchmark->set_source_code(benchmark_code);
+	Error benchmark_err = benchmark->reload();
+
+	remove_error_handler(&handler);
+
+	bool ok = true;
+	if (err != OK || benchmark_err != OK) {
+		print_line("FAIL: scripts failed to compile.");
+		ok = false;
+	}
+	if (errors) {
+		print_line("FAIL: " + itos(errors) + " errors while compiling.");
+		ok = false;
+	}
+
+	if (err == OK) {
+		Ref<Reference> obj;
+		obj.instance();
+		obj->set_script(gds.get_ref_ptr());
+
+		ok = _optimizer_check(obj.ptr(), "for_range", 45) && ok;
+		ok = _optimizer_check(obj.ptr(), "for_empty", 1) && ok;
+		ok = _optimizer_check(obj.ptr(), "for_nested_break_continue", 10 + 30 + 31 + 40 + 41) && ok;
+		ok = _optimizer_check(obj.ptr(), "for_typed", 14, 7) && ok;
+		ok = _optimizer_check(obj.ptr(), "while_const", 6) && ok;
+		ok = _optimizer_check(obj.ptr(), "default_args", 6) && ok;
+		ok = _optimizer_check(obj.ptr(), "default_args", 13, 10) && ok;
+
+		ok = _optimizer_compare(gds, obj.ptr(), "vector2", GDScriptFunction::OPCODE_SET_NAMED_VECTOR, 20) && ok;
+		ok = _optimizer_compare(gds, obj.ptr(), "vector3", GDScriptFunction::OPCODE_GET_NAMED_VECTOR, 20) && ok;
+		ok = _optimizer_compare(gds, obj.ptr(), "method_bind", GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN, 20) && ok;
+	}
+
+	ok = _optimizer_signed_zero() && ok;
+
+	print_line(ok ? "Optimizer: OK" : "Optimizer: FAIL");
+	return NULL;
+}
+
 MainLoop *test(TestType p_type) {
 
+	if (p_type == TEST_BENCHMARK) {
+		return _benchmark();
+	}
+
+	if (p_type == TEST_OPTIMIZER) {
+		return _optimizer();
+	}
+
 	List<String> cmdlargs = OS::get_singleton()->get_cmdline_args();
 
 	if (cmdlargs.empty()) {
@@ -33,17 +33,29 @@
 
 #ifdef DEBUG_ENABLED
 
+#include "test_animation.h"
 #include "test_astar.h"
+#include "test_audio.h"
+#include "test_dynamic_bvh.h"
+#include "test_frame_allocator.h"
 #include "test_gdscript.h"
 #include "test_gui.h"
 #include "test_math.h"
+#include "test_memory.h"
+#include "test_message_queue.h"
+#include "test_navigation.h"
 #include "test_oa_hash_map.h"
 #include "test_ordered_hash_map.h"
 #include "test_physics.h"
 #include "test_physics_2d.h"
+#include "test_pool_vector.h"
 #include "test_render.h"
+#include "test_resource_loader.h"
 #include "test_shader_lang.h"
+#include "test_signal.h"
 #include "test_string.h"
+#include "test_string_name.h"
+#include "test_tile_map.h"
 
 const char **tests_get_names() {
 
@@ -51,8 +63,13 @@ const char **tests_get_names() {
 		"string",
 		"math",
 		"physics",
+		"physics_broadphase",
+		"physics_batch",
 		"physics_2d",
+		"physics_2d_batch",
+		"dynamic_bvh",
 		"render",
+		"render_culling",
 		"oa_hash_map",
 		"gui",
 		"shaderlang",
@@ -60,8 +77,22 @@ const char **tests_get_names() {
 		"gd_parser",
 		"gd_compiler",
 		"gd_bytecode",
+		"gd_benchmark",
+		"gd_optimizer",
 		"ordered_hash_map",
 		"astar",
+		"navigation",
+		"tile_map",
+		"audio",
+		"animation",
+		"animation_tree_free",
+		"string_name",
+		"memory",
+		"pool_vector",
+		"frame_allocator",
+		"signal",
+		"message_queue",
+		"resource_loader",
 		NULL
 	};
 
@@ -85,16 +116,41 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestPhysics::test();
 	}
 
+	if (p_test == "physics_broadphase") {
+
+		return TestPhysics::test_broadphase();
+	}
+
+	if (p_test == "physics_batch") {
+
+		return TestPhysics::test_batch_queries();
+	}
+
 	if (p_test == "physics_2d") {
 
 		return TestPhysics2D::test();
 	}
 
+	if (p_test == "physics_2d_batch") {
+
+		return TestPhysics2D::test_batch_queries();
+	}
+
+	if (p_test == "dynamic_bvh") {
+
+		return TestDynamicBVH::test();
+	}
+
 	if (p_test == "render") {
 
 		return TestRender::test();
 	}
 
+	if (p_test == "render_culling") {
+
+		return TestRender::test_culling();
+	}
+
 	if (p_test == "oa_hash_map") {
 
 		return TestOAHashMap::test();
@@ -132,6 +188,16 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestGDScript::test(TestGDScript::TEST_BYTECODE);
 	}
 
+	if (p_test == "gd_benchmark") {
+
+		return TestGDScript::test(TestGDScript::TEST_BENCHMARK);
+	}
+
+	if (p_test == "gd_optimizer") {
+
+		return TestGDScript::test(TestGDScript::TEST_OPTIMIZER);
+	}
+
 	if (p_test == "ordered_hash_map") {
 
 		return TestOrderedHashMap::test();
@@ -142,6 +208,66 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestAStar::test();
 	}
 
+	if (p_test == "navigation") {
+
+		return TestNavigation::test();
+	}
+
+	if (p_test == "tile_map") {
+
+		return TestTileMap::test();
+	}
+
+	if (p_test == "audio") {
+
+		return TestAudio::test();
+	}
+
+	if (p_test == "animation") {
+
+		return TestAnimation::test();
+	}
+
+	if (p_test == "animation_tree_free") {
+
+		return TestAnimation::test_tree_free();
+	}
+
+	if (p_test == "string_name") {
+
+		return TestStringName::test();
+	}
+
+	if (p_test == "memory") {
+
+		return TestMemory::test();
+	}
+
+	if (p_test == "pool_vector") {
+
+		return TestPoolVector::test();
+	}
+
+	if (p_test == "frame_allocator") {
+
+		return TestFrameAllocator::test();
+	}
+
+	if (p_test == "signal") {
+
+		return TestSignal::test();
+	}
+
+	if (p_test == "message_queue") {
+
+		return TestMessageQueue::test();
+	}
+
+	if (p_test == "resource_loader") {
+
+		return TestResourceLoader::test();
+	}
+
 	print_line("Unknown test: " + p_test);
 	return NULL;
 }
@@ -0,0 +1,142 @@
+/*************************************************************************/
+/*  test_memory.cpp                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_memory.h"
+#include "test_utils.h"
+
+#include "core/list.h"
+#include "core/map.h"
+#include "core/os/os.h"
+#include "core/variant.h"
+
+namespace TestMemory {
+
+struct WorkerData {
+
+	int iterations;
+	int seed;
+	bool ok;
+};
+
+// The engine's typical churn: short-lived Variant arrays, list and map
+// nodes, plus raw buffers of assorted sizes, some of them handed over to be
+// freed later, out of allocation order.
+static void _worker(void *p_data) {
+
+	WorkerData *wd = (WorkerData *)p_data;
+	uint32_t seed = wd->seed;
+
+	const int keep = 256;
+	void *kept[keep] = {};
+
+	for (int i = 0; i < wd->iterations; i++) {
+
+		Array args;
+		args.push_back(i);
+		args.push_back(Vector3(i, 0, 0));
+
+		List<int> list;
+		Map<int, int> map;
+		for (int j = 0; j < 8; j++) {
+			list.push_back(j);
+			map[j] = i;
+		}
+
+		seed = seed * 1664525 + 1013904223;
+		int slot = (seed >> 8) % keep;
+		size_t size = 8 + ((seed >> 16) % 1024);
+		if ((seed >> 28) == 0) {
+			size *= 64; // every now and then a large one
+		}
+
+		if (kept[slot]) {
+			if (*(int *)kept[slot] != slot) {
+				wd->ok = false;
+			}
+			memfree(kept[slot]);
+		}
+		kept[slot] = memalloc(size);
+		*(int *)kept[slot] = slot;
+
+		if ((int)args[0] != i || map.size() != 8) {
+			wd->ok = false;
+		}
+	}
+
+	for (int i = 0; i < keep; i++) {
+		if (kept[i]) {
+			memfree(kept[i]);
+		}
+	}
+}
+
+MainLoop *test() {
+
+	bool ok = true;
+	const int iterations = 100000;
+	int max_threads = MAX(OS::get_singleton()->get_processor_count(), 4);
+
+#ifdef SMALL_ALLOCATOR_ENABLED
+	print_line("Allocator: small_allocator");
+#else
+	print_line("Allocator: system");
+#endif
+
+	uint64_t usage_before = Memory::get_mem_usage();
+
+	for (int threads = 1; threads <= max_threads; threads *= 2) {
+
+		Vector<WorkerData> data;
+		data.resize(threads);
+		for (int i = 0; i < threads; i++) {
+			data.write[i].iterations = iterations;
+			data.write[i].seed = i + 1;
+			data.write[i].ok = true;
+		}
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		TestUtils::wait_threads(TestUtils::start_threads(_worker, data.ptrw(), threads));
+
+		for (int i = 0; i < threads; i++) {
+			ok = ok && data[i].ok;
+		}
+
+		uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+		OS::get_singleton()->print("%d threads: %.3f ms, %.2f M iterations/s\n", threads, time / 1000.0, double(threads) * iterations / MAX(time, 1));
+	}
+
+	// usage is only tracked by debug builds or the small allocator
+	uint64_t usage_after = Memory::get_mem_usage();
+	OS::get_singleton()->print("static memory: %d bytes before, %d after, %d peak\n", int(usage_before), int(usage_after), int(Memory::get_mem_max_usage()));
+
+	print_line(ok ? "Memory: OK" : "Memory: FAIL");
+	return NULL;
+}
+} // namespace TestMemory
@@ -0,0 +1,229 @@
+/*************************************************************************/
+/*  test_message_queue.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_message_queue.h"
+#include "test_utils.h"
+
+#include "core/message_queue.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+
+namespace TestMessageQueue {
+
+enum {
+	MAX_THREADS = 16,
+	NOTIFICATION_RECORD = 9000
+};
+
+static int total_calls = 0;
+static int errors = 0;
+
+static void _error_handler(void *p_self, const char *p_func, const char *p_file, int p_line, const char *p_error, const char *p_message, ErrorHandlerType p_type) {
+
+	errors++;
+}
+
+class MessageRecorder : public Object {
+
+	GDCLASS(MessageRecorder, Object);
+
+protected:
+	static void _bind_methods() {
+
+		ClassDB::bind_method(D_METHOD("record", "thread", "value"), &MessageRecorder::record);
+	}
+
+	void _notification(int p_what) {
+
+		if (p_what == NOTIFICATION_RECORD) {
+			notifications++;
+		}
+	}
+
+public:
+	int last[MAX_THREADS];
+	int calls;
+	int notifications;
+	bool in_order;
+
+	void record(int p_thread, int p_value) {
+
+		ERR_FAIL_INDEX(p_thread, MAX_THREADS);
+		if (p_value != last[p_thread] + 1) {
+			in_order = false;
+		}
+		last[p_thread] = p_value;
+		calls++;
+		total_calls++;
+	}
+
+	MessageRecorder() {
+
+		for (int i = 0; i < MAX_THREADS; i++) {
+			last[i] = -1;
+		}
+		calls = 0;
+		notifications = 0;
+		in_order = true;
+	}
+};
+
+struct WorkerData {
+
+	ObjectID target;
+	int thread;
+	int count;
+};
+
+static void _worker(void *p_data) {
+
+	WorkerData *wd = (WorkerData *)p_data;
+
+	for (int i = 0; i < wd->count; i++) {
+		MessageQueue::get_singleton()->push_call(wd->target, "record", wd->thread, i);
+		if ((i & 15) == 0) {
+			MessageQueue::get_singleton()->push_notification(wd->target, NOTIFICATION_RECORD);
+		}
+	}
+}
+
+MainLoop *test() {
+
+	bool ok = true;
+	MessageQueue *mq = MessageQueue::get_singleton();
+
+	ClassDB::register_class<MessageRecorder>();
+
+	// a single thread, far more than one page and one flush can hold
+	{
+		const int count = 100000;
+		MessageRecorder *recorder = memnew(MessageRecorder);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < count; i++) {
+			mq->push_call(recorder, "record", 0, i);
+		}
+		uint64_t pushed = OS::get_singleton()->get_ticks_usec();
+
+		int flushes = 0;
+		while (recorder->calls < count && flushes < 1000) {
+			mq->flush();
+			flushes++;
+		}
+		uint64_t flushed = OS::get_singleton()->get_ticks_usec();
+
+		ok = TestUtils::check(recorder->calls == count, "all calls ran") && ok;
+		ok = TestUtils::check(recorder->in_order, "calls ran in order") && ok;
+		ok = TestUtils::check(flushes > 1, "over-budget messages were left for the next flush") && ok;
+		OS::get_singleton()->print("1 thread: push %.2f M/s, flush %.2f M/s, %d flushes\n", count / double(MAX(pushed - begin, 1)), count / double(MAX(flushed - pushed, 1)), flushes);
+
+		memdelete(recorder);
+	}
+
+	// several threads pushing while the main thread keeps flushing
+	for (int threads = 2; threads <= MAX_THREADS; threads *= 2) {
+
+		const int count = 20000;
+		MessageRecorder *recorder = memnew(MessageRecorder);
+
+		WorkerData data[MAX_THREADS];
+		for (int i = 0; i < threads; i++) {
+			data[i].target = recorder->get_instance_id();
+			data[i].thread = i;
+			data[i].count = count;
+		}
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		Vector<Thread *> workers = TestUtils::start_threads(_worker, data, threads);
+
+		for (int i = 0; i < threads; i++) {
+			while (recorder->last[i] < count - 1 && recorder->in_order) {
+				mq->flush();
+			}
+		}
+
+		TestUtils::wait_threads(workers);
+		mq->flush();
+
+		uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+
+		ok = TestUtils::check(recorder->calls == threads * count, itos(threads) + " threads: all calls ran") && ok;
+		ok = TestUtils::check(recorder->in_order, itos(threads) + " threads: each thread's calls ran in order") && ok;
+		ok = TestUtils::check(recorder->notifications == threads * ((count + 15) / 16), itos(threads) + " threads: all notifications ran") && ok;
+		OS::get_singleton()->print("%d threads: %.3f ms, %.2f M messages/s\n", threads, time / 1000.0, threads * count / double(MAX(time, 1)));
+
+		memdelete(recorder);
+	}
+
+	// drain() runs everything, past the per-flush budget
+	{
+		const int count = 100000;
+		MessageRecorder *recorder = memnew(MessageRecorder);
+
+		for (int i = 0; i < count; i++) {
+			mq->push_call(recorder, "record", 0, i);
+		}
+		mq->drain();
+
+		ok = TestUtils::check(recorder->calls == count, "drain ran all calls") && ok;
+		ok = TestUtils::check(recorder->in_order, "drain ran the calls in order") && ok;
+
+		memdelete(recorder);
+	}
+
+	// messages to a deleted object are dropped quietly
+	{
+		ErrorHandlerList handler;
+		handler.errfunc = _error_handler;
+		add_error_handler(&handler);
+
+		MessageRecorder *recorder = memnew(MessageRecorder);
+		mq->push_call(recorder, "record", 0, 0);
+		mq->push_notification(recorder, NOTIFICATION_RECORD);
+		memdelete(recorder);
+
+		int calls_before = total_calls;
+		errors = 0;
+		mq->flush();
+
+		remove_error_handler(&handler);
+
+		ok = TestUtils::check(total_calls == calls_before, "deleted object: no call ran") && ok;
+		ok = TestUtils::check(errors == 0, "deleted object: no error was printed") && ok;
+	}
+
+	mq->end_frame();
+	OS::get_singleton()->print("max used: %d bytes, last frame: %d messages in one flush, %.3f ms flushing\n", mq->get_max_buffer_usage(), int(mq->get_frame_depth_max()), mq->get_frame_flush_usec() / 1000.0);
+	ok = TestUtils::check(mq->get_frame_depth_max() > 0, "depth is reported") && ok;
+
+	print_line(ok ? "MessageQueue: OK" : "MessageQueue: FAIL");
+	return NULL;
+}
+} // namespace TestMessageQueue
@@ -0,0 +1,325 @@
+/*************************************************************************/
+/*  test_navigation.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_navigation.h"
+#include "test_utils.h"
+
+#include "core/math/math_funcs.h"
+#include "core/os/os.h"
+#include "scene/2d/navigation_2d.h"
+#include "scene/3d/navigation.h"
+
+namespace TestNavigation {
+
+// A floor of unit cells, p_width along x and p_depth along z, with the cells
+// of column p_wall_x up to p_wall_depth left out so paths have to go around.
+static Ref<NavigationMesh> _make_floor(int p_width, int p_depth, int p_wall_x, int p_wall_depth) {
+
+	PoolVector<Vector3> vertices;
+	for (int z = 0; z <= p_depth; z++) {
+		for (int x = 0; x <= p_width; x++) {
+			vertices.push_back(Vector3(x, 0, z));
+		}
+	}
+
+	Ref<NavigationMesh> navmesh;
+	navmesh.instance();
+	navmesh->set_vertices(vertices);
+
+	for (int z = 0; z < p_depth; z++) {
+		for (int x = 0; x < p_width; x++) {
+			if (x == p_wall_x && z < p_wall_depth)
+				continue;
+
+			Vector<int> polygon;
+			polygon.push_back(z * (p_width + 1) + x);
+			polygon.push_back(z * (p_width + 1) + x + 1);
+			polygon.push_back((z + 1) * (p_width + 1) + x + 1);
+			polygon.push_back((z + 1) * (p_width + 1) + x);
+			navmesh->add_polygon(polygon);
+		}
+	}
+
+	return navmesh;
+}
+
+static Ref<NavigationPolygon> _make_floor_2d(int p_width, int p_height, int p_wall_x, int p_wall_height, float p_cell) {
+
+	PoolVector<Vector2> vertices;
+	for (int y = 0; y <= p_height; y++) {
+		for (int x = 0; x <= p_width; x++) {
+			vertices.push_back(Vector2(x, y) * p_cell);
+		}
+	}
+
+	Ref<NavigationPolygon> navpoly;
+	navpoly.instance();
+	navpoly->set_vertices(vertices);
+
+	for (int y = 0; y < p_height; y++) {
+		for (int x = 0; x < p_width; x++) {
+			if (x == p_wall_x && y < p_wall_height)
+				continue;
+
+			Vector<int> polygon;
+			polygon.push_back(y * (p_width + 1) + x);
+			polygon.push_back(y * (p_width + 1) + x + 1);
+			polygon.push_back((y + 1) * (p_width + 1) + x + 1);
+			polygon.push_back((y + 1) * (p_width + 1) + x);
+			navpoly->add_polygon(polygon);
+		}
+	}
+
+	return navpoly;
+}
+
+// Paths as positions on the floor, in cells.
+static Vector<Vector2> _floor_path(const Vector<Vector3> &p_path) {
+
+	Vector<Vector2> path;
+	for (int i = 0; i < p_path.size(); i++) {
+		path.push_back(Vector2(p_path[i].x, p_path[i].z));
+	}
+	return path;
+}
+
+static Vector<Vector2> _floor_path(const Vector<Vector2> &p_path, float p_cell) {
+
+	Vector<Vector2> path;
+	for (int i = 0; i < p_path.size(); i++) {
+		path.push_back(p_path[i] / p_cell);
+	}
+	return path;
+}
+
+// Checks that a path goes from p_from to p_to without crossing the wall of
+// the first floor. Equal quads give the search several corridors of the same
+// cost, so only paths along a straight line have an exact length.
+static bool _check_path(const Vector<Vector2> &p_path, const Vector2 &p_from, const Vector2 &p_to, float p_min_length, float p_max_length, const String &p_what) {
+
+	if (!TestUtils::check(p_path.size() >= 2, p_what + ": path found")) {
+		return false;
+	}
+
+	bool ok = true;
+	ok = TestUtils::check(p_path[0].distance_to(p_from) < 0.01, p_what + ": path starts at the start point") && ok;
+	ok = TestUtils::check(p_path[p_path.size() - 1].distance_to(p_to) < 0.01, p_what + ": path ends at the end point") && ok;
+
+	float length = 0;
+	bool crosses_wall = false;
+	for (int i = 1; i < p_path.size(); i++) {
+		length += p_path[i].distance_to(p_path[i - 1]);
+		for (int j = 0; j <= 16; j++) {
+			Vector2 point = p_path[i - 1].linear_interpolate(p_path[i], j / 16.0);
+			if (point.x > 2.01 && point.x < 2.99 && point.y < 2.99) {
+				crosses_wall = true;
+			}
+		}
+	}
+
+	ok = TestUtils::check(length > p_min_length - 0.01 && length < p_max_length + 0.01, p_what + ": path length " + rtos(length) + ", expected " + rtos(p_min_length) + " to " + rtos(p_max_length)) && ok;
+	ok = TestUtils::check(!crosses_wall, p_what + ": path goes around the wall") && ok;
+	return ok;
+}
+
+struct ConcurrentQueries {
+	Navigation *navigation;
+	const Vector3 *from;
+	const Vector3 *to;
+	const Vector<Vector3> *paths;
+	int count;
+	bool ok;
+};
+
+static void _concurrent_queries(void *p_userdata) {
+
+	ConcurrentQueries *cq = (ConcurrentQueries *)p_userdata;
+	cq->ok = true;
+
+	for (int i = 0; i < cq->count; i++) {
+		Vector<Vector3> path = cq->navigation->get_simple_path(cq->from[i], cq->to[i]);
+		if (path.size() != cq->paths[i].size()) {
+			cq->ok = false;
+			return;
+		}
+		for (int j = 0; j < path.size(); j++) {
+			if (path[j] != cq->paths[i][j]) {
+				cq->ok = false;
+				return;
+			}
+		}
+	}
+}
+
+static bool test_navigation_3d() {
+
+	// Two 4x4 floors side by side, the first one with a wall at x = 2 that
+	// ends at z = 3.
+	Navigation *navigation = memnew(Navigation);
+	Object *owner_a = memnew(Object);
+	Object *owner_b = memnew(Object);
+
+	int id_a = navigation->navmesh_add(_make_floor(4, 4, 2, 3), Transform(), owner_a);
+	int id_b = navigation->navmesh_add(_make_floor(4, 4, -1, 0), Transform(Basis(), Vector3(4, 0, 0)), owner_b);
+
+	bool ok = true;
+
+	ok = TestUtils::check(navigation->get_closest_point(Vector3(1.5, 2, 1.25)).distance_to(Vector3(1.5, 0, 1.25)) < CMP_EPSILON, "closest point above the floor") && ok;
+	ok = TestUtils::check(navigation->get_closest_point(Vector3(2.3, 0, 1)).distance_to(Vector3(2, 0, 1)) < CMP_EPSILON, "closest point inside the wall") && ok;
+	ok = TestUtils::check(navigation->get_closest_point(Vector3(10, 0, 2)).distance_to(Vector3(8, 0, 2)) < CMP_EPSILON, "closest point past the second floor") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_normal(Vector3(1.5, 2, 1.25)).distance_to(Vector3(0, 1, 0)) < CMP_EPSILON, "closest point normal") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector3(1, 0, 1)) == owner_a, "owner of the first floor") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector3(6, 0, 2)) == owner_b, "owner of the second floor") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_to_segment(Vector3(6, 1, 2), Vector3(6, -1, 2)).distance_to(Vector3(6, 0, 2)) < CMP_EPSILON, "segment through the floor") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_to_segment(Vector3(5, 1, 5), Vector3(7, 1, 6)).distance_to(Vector3(5, 0, 4)) < CMP_EPSILON, "segment beside the floor") && ok;
+
+	// At best around the end of the wall: (0.5, 0.25) -> (2, 3) -> (3, 3) -> (3.5, 0.25).
+	float around = Math::sqrt(1.5 * 1.5 + 2.75 * 2.75) + 1 + Math::sqrt(0.5 * 0.5 + 2.75 * 2.75);
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector3(0.5, 0, 0.25), Vector3(3.5, 0, 0.25))), Vector2(0.5, 0.25), Vector2(3.5, 0.25), around, around * 1.25, "around the wall") && ok;
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector3(0.5, 0, 3.25), Vector3(7.5, 0, 3.25))), Vector2(0.5, 3.25), Vector2(7.5, 3.25), 7, 7, "across both floors") && ok;
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector3(0.5, 1, 3.25), Vector3(12, 0, 3.25))), Vector2(0.5, 3.25), Vector2(8, 3.25), 7.5, 7.5, "to a point off the floor") && ok;
+
+	// Queries only read the navigation data, so they can run on several
+	// threads at once and must give the same paths as serial ones.
+	const int query_count = 200;
+	Vector3 from[query_count];
+	Vector3 to[query_count];
+	Vector<Vector3> paths[query_count];
+	uint64_t seed = 7;
+	for (int i = 0; i < query_count; i++) {
+		from[i] = Vector3(Math::rand_from_seed(&seed) % 800, 0, Math::rand_from_seed(&seed) % 400) * 0.01;
+		to[i] = Vector3(Math::rand_from_seed(&seed) % 800, 0, Math::rand_from_seed(&seed) % 400) * 0.01;
+		paths[i] = navigation->get_simple_path(from[i], to[i]);
+	}
+
+	ConcurrentQueries queries[4];
+	for (int i = 0; i < 4; i++) {
+		queries[i].navigation = navigation;
+		queries[i].from = from;
+		queries[i].to = to;
+		queries[i].paths = paths;
+		queries[i].count = query_count;
+	}
+	TestUtils::wait_threads(TestUtils::start_threads(_concurrent_queries, queries, 4));
+	for (int i = 0; i < 4; i++) {
+		ok = TestUtils::check(queries[i].ok, "thread " + itos(i) + ": paths match serial queries") && ok;
+	}
+
+	// Move the second floor away, the floors are no longer connected.
+	navigation->navmesh_set_transform(id_b, Transform(Basis(), Vector3(0, 0, 10)));
+
+	ok = TestUtils::check(navigation->get_closest_point(Vector3(6, 0, 2)).distance_to(Vector3(4, 0, 2)) < CMP_EPSILON, "moved: closest point where the second floor was") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector3(6, 0, 2)) == owner_a, "moved: owner where the second floor was") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector3(1, 0, 12)) == owner_b, "moved: owner of the second floor") && ok;
+	ok = TestUtils::check(navigation->get_simple_path(Vector3(0.5, 0, 3.25), Vector3(1, 0, 12)).empty(), "moved: no path between the floors") && ok;
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector3(0.5, 0, 10.25), Vector3(3.5, 0, 10.25))), Vector2(0.5, 10.25), Vector2(3.5, 10.25), 3, 3, "moved: path on the second floor") && ok;
+
+	// Put it back right behind the first floor, they link up again.
+	navigation->navmesh_set_transform(id_b, Transform(Basis(), Vector3(0, 0, 4)));
+
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector3(0.25, 0, 0.5), Vector3(0.25, 0, 7.5))), Vector2(0.25, 0.5), Vector2(0.25, 7.5), 7, 7, "moved back: path across both floors") && ok;
+
+	navigation->navmesh_remove(id_b);
+
+	ok = TestUtils::check(navigation->get_closest_point(Vector3(1, 0, 6)).distance_to(Vector3(1, 0, 4)) < CMP_EPSILON, "removed: closest point where the second floor was") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector3(1, 0, 6)) == owner_a, "removed: owner where the second floor was") && ok;
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector3(0.5, 0, 3.25), Vector3(1, 0, 6))), Vector2(0.5, 3.25), Vector2(1, 4), Math::sqrt(0.5 * 0.5 + 0.75 * 0.75), Math::sqrt(0.5 * 0.5 + 0.75 * 0.75), "removed: path to where the second floor was") && ok;
+
+	navigation->navmesh_remove(id_a);
+
+	ok = TestUtils::check(navigation->get_simple_path(Vector3(0.5, 0, 0.25), Vector3(1, 0, 1.5)).empty(), "empty: no path") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector3(1, 0, 1)) == NULL, "empty: no owner") && ok;
+
+	memdelete(owner_a);
+	memdelete(owner_b);
+	memdelete(navigation);
+
+	return ok;
+}
+
+static bool test_navigation_2d() {
+
+	// The same floors as the 3D test, in cells of 32 pixels.
+	const float cell = 32;
+	Navigation2D *navigation = memnew(Navigation2D);
+	Object *owner_a = memnew(Object);
+	Object *owner_b = memnew(Object);
+
+	int id_a = navigation->navpoly_add(_make_floor_2d(4, 4, 2, 3, cell), Transform2D(), owner_a);
+	int id_b = navigation->navpoly_add(_make_floor_2d(4, 4, -1, 0, cell), Transform2D(0, Vector2(4, 0) * cell), owner_b);
+
+	bool ok = true;
+
+	ok = TestUtils::check(navigation->get_closest_point(Vector2(1.5, 1.25) * cell).distance_to(Vector2(1.5, 1.25) * cell) < CMP_EPSILON, "2D: closest point on the floor") && ok;
+	ok = TestUtils::check(navigation->get_closest_point(Vector2(2.25, 1) * cell).distance_to(Vector2(2, 1) * cell) < CMP_EPSILON, "2D: closest point inside the wall") && ok;
+	ok = TestUtils::check(navigation->get_closest_point(Vector2(10, 2) * cell).distance_to(Vector2(8, 2) * cell) < CMP_EPSILON, "2D: closest point past the second floor") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector2(1, 1) * cell) == owner_a, "2D: owner of the first floor") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector2(6, 2) * cell) == owner_b, "2D: owner of the second floor") && ok;
+
+	float around = Math::sqrt(1.5 * 1.5 + 2.75 * 2.75) + 1 + Math::sqrt(0.5 * 0.5 + 2.75 * 2.75);
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector2(0.5, 0.25) * cell, Vector2(3.5, 0.25) * cell), cell), Vector2(0.5, 0.25), Vector2(3.5, 0.25), around, around * 1.25, "2D: around the wall") && ok;
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector2(0.5, 3.25) * cell, Vector2(7.5, 3.25) * cell), cell), Vector2(0.5, 3.25), Vector2(7.5, 3.25), 7, 7, "2D: across both floors") && ok;
+
+	navigation->navpoly_set_transform(id_b, Transform2D(0, Vector2(0, 10) * cell));
+
+	ok = TestUtils::check(navigation->get_closest_point(Vector2(6, 2) * cell).distance_to(Vector2(4, 2) * cell) < CMP_EPSILON, "2D moved: closest point where the second floor was") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector2(1, 12) * cell) == owner_b, "2D moved: owner of the second floor") && ok;
+	ok = TestUtils::check(navigation->get_simple_path(Vector2(0.5, 3.25) * cell, Vector2(1, 12) * cell).empty(), "2D moved: no path between the floors") && ok;
+
+	navigation->navpoly_set_transform(id_b, Transform2D(0, Vector2(0, 4) * cell));
+
+	ok = _check_path(_floor_path(navigation->get_simple_path(Vector2(0.25, 0.5) * cell, Vector2(0.25, 7.5) * cell), cell), Vector2(0.25, 0.5), Vector2(0.25, 7.5), 7, 7, "2D moved back: path across both floors") && ok;
+
+	navigation->navpoly_remove(id_b);
+
+	ok = TestUtils::check(navigation->get_closest_point(Vector2(1, 6) * cell).distance_to(Vector2(1, 4) * cell) < CMP_EPSILON, "2D removed: closest point where the second floor was") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector2(1, 6) * cell) == owner_a, "2D removed: owner where the second floor was") && ok;
+
+	navigation->navpoly_remove(id_a);
+
+	ok = TestUtils::check(navigation->get_simple_path(Vector2(0.5, 0.25) * cell, Vector2(1, 1.5) * cell).empty(), "2D empty: no path") && ok;
+	ok = TestUtils::check(navigation->get_closest_point_owner(Vector2(1, 1) * cell) == NULL, "2D empty: no owner") && ok;
+
+	memdelete(owner_a);
+	memdelete(owner_b);
+	memdelete(navigation);
+
+	return ok;
+}
+
+MainLoop *test() {
+
+	bool ok = test_navigation_3d();
+	ok = test_navigation_2d() && ok;
+
+	print_line(ok ? "Navigation: OK" : "Navigation: FAIL");
+	return NULL;
+}
+} // namespace TestNavigation
@@ -29,6 +29,7 @@
 /*************************************************************************/
 
 #include "test_physics.h"
+#include "test_utils.h"
 
 #include "core/map.h"
 #include "core/math/math_funcs.h"
@@ -36,6 +37,10 @@
 #include "core/os/main_loop.h"
 #include "core/os/os.h"
 #include "core/print_string.h"
+#include "servers/physics/broad_phase_bvh.h"
+#include "servers/physics/broad_phase_octree.h"
+#include "servers/physics/broad_phase_sw.h"
+#include "servers/physics/collision_object_sw.h"
 #include "servers/physics_server.h"
 #include "servers/visual_server.h"
 
@@ -436,4 +441,251 @@ MainLoop *test() {
 
 	return memnew(TestPhysicsMainLoop);
 }
+
+/* BROADPHASE BENCHMARK */
+
+class BenchmarkCollisionObject : public CollisionObjectSW {
+
+protected:
+	virtual void _shapes_changed() {}
+
+public:
+	virtual void set_space(SpaceSW *p_space) {}
+
+	BenchmarkCollisionObject() :
+			CollisionObjectSW(TYPE_BODY) {}
+};
+
+static int benchmark_pair_count = 0;
+
+static void *_benchmark_pair(CollisionObjectSW *A, int p_subindex_A, CollisionObjectSW *B, int p_subindex_B, void *p_userdata) {
+
+	benchmark_pair_count++;
+	return NULL;
+}
+
+static void _benchmark_unpair(CollisionObjectSW *A, int p_subindex_A, CollisionObjectSW *B, int p_subindex_B, void *p_data, void *p_userdata) {
+
+	benchmark_pair_count--;
+}
+
+static void _benchmark_broadphase(const String &p_name, BroadPhaseSW::CreateFunction p_create, int p_count) {
+
+	const int frames = 60;
+	const int queries = 1000;
+	const real_t frame_time = 1.0 / 60.0;
+	// Keep density constant, so only the amount of objects changes.
+	const real_t extent = Math::pow((real_t)p_count, (real_t)(1.0 / 3.0)) * 2.0;
+
+	Math::seed(1234);
+	benchmark_pair_count = 0;
+
+	BroadPhaseSW *bp = p_create();
+	bp->set_pair_callback(_benchmark_pair, NULL);
+	bp->set_unpair_callback(_benchmark_unpair, NULL);
+
+	Vector<BenchmarkCollisionObject *> objects;
+	Vector<BroadPhaseSW::ID> ids;
+	Vector<AABB> aabbs;
+	Vector<Vector3> velocities;
+	objects.resize(p_count);
+	ids.resize(p_count);
+	aabbs.resize(p_count);
+	velocities.resize(p_count);
+
+	for (int i = 0; i < p_count; i++) {
+		objects.write[i] = memnew(BenchmarkCollisionObject);
+		Vector3 size = Vector3(Math::random(0.5, 1.5), Math::random(0.5, 1.5), Math::random(0.5, 1.5));
+		Vector3 pos = Vector3(Math::random(-extent, extent), Math::random(-extent, extent), Math::random(-extent, extent));
+		aabbs.write[i] = AABB(pos, size);
+		velocities.write[i] = Vector3(Math::random(-1.0, 1.0), Math::random(-1.0, 1.0), Math::random(-1.0, 1.0)) * 4.0;
+	}
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	for (int i = 0; i < p_count; i++) {
+		ids.write[i] = bp->create(objects[i]);
+		bp->set_static(ids[i], false);
+		bp->move(ids[i], aabbs[i]);
+	}
+
+	uint64_t insert_time = OS::get_singleton()->get_ticks_usec() - begin;
+	begin = OS::get_singleton()->get_ticks_usec();
+
+	for (int f = 0; f < frames; f++) {
+		for (int i = 0; i < p_count; i++) {
+			AABB &aabb = aabbs.write[i];
+			Vector3 &vel = velocities.write[i];
+			aabb.position += vel * frame_time;
+			for (int j = 0; j < 3; j++) {
+				if (aabb.position[j] < -extent || aabb.position[j] > extent) {
+					vel[j] = -vel[j];
+				}
+			}
+			bp->move(ids[i], aabb);
+		}
+		bp->update();
+	}
+
+	uint64_t move_time = OS::get_singleton()->get_ticks_usec() - begin;
+
+	CollisionObjectSW *results[256];
+	int found = 0;
+	begin = OS::get_singleton()->get_ticks_usec();
+
+	for (int i = 0; i < queries; i++) {
+		Vector3 pos = Vector3(Math::random(-extent, extent), Math::random(-extent, extent), Math::random(-extent, extent));
+		found += bp->cull_aabb(AABB(pos, Vector3(4, 4, 4)), results, 256);
+		found += bp->cull_segment(pos, pos + Vector3(10, 0, 0), results, 256);
+	}
+
+	uint64_t query_time = OS::get_singleton()->get_ticks_usec() - begin;
+
+	OS::get_singleton()->print("%-8s %6d bodies: insert %8.2f ms, move %8.3f ms/frame, %d queries %7.2f ms, %d pairs, %d hits\n", p_name.utf8().get_data(), p_count, insert_time / 1000.0, move_time / 1000.0 / frames, queries * 2, query_time / 1000.0, benchmark_pair_count, found);
+
+	for (int i = 0; i < p_count; i++) {
+		bp->remove(ids[i]);
+		memdelete(objects[i]);
+	}
+
+	memdelete(bp);
+}
+
+MainLoop *test_broadphase() {
+
+	static const int counts[] = { 1000, 10000, 50000 };
+
+	for (int i = 0; i < 3; i++) {
+		_benchmark_broadphase("Octree", BroadPhaseOctree::_create, counts[i]);
+		_benchmark_broadphase("BVH", BroadPhaseBVH::_create, counts[i]);
+	}
+
+	return NULL;
+}
+
+/* BATCH QUERIES */
+
+// Batches must give the same results as the same queries run one by one,
+// serially and on the work pool.
+MainLoop *test_batch_queries() {
+
+	const int body_count = 300;
+	const int query_count = 2000;
+	const real_t extent = 40;
+
+	bool ok = true;
+	PhysicsServer *ps = PhysicsServer::get_singleton();
+
+	// only the BVH allows concurrent culls, the threaded batches run serially otherwise
+	BroadPhaseSW::CreateFunction old_create = BroadPhaseSW::create_func;
+	BroadPhaseSW::create_func = BroadPhaseBVH::_create;
+	RID space = ps->space_create();
+	BroadPhaseSW::create_func = old_create;
+	ps->space_set_active(space, true);
+
+	RID box = ps->shape_create(PhysicsServer::SHAPE_BOX);
+	ps->shape_set_data(box, Vector3(1, 1, 1));
+	RID sphere = ps->shape_create(PhysicsServer::SHAPE_SPHERE);
+	ps->shape_set_data(sphere, 0.5);
+
+	Math::seed(4321);
+
+	Vector<RID> bodies;
+	for (int i = 0; i < body_count; i++) {
+		RID body = ps->body_create(PhysicsServer::BODY_MODE_STATIC);
+		ps->body_add_shape(body, i % 2 ? box : sphere);
+		ps->body_set_space(body, space);
+		ps->body_set_state(body, PhysicsServer::BODY_STATE_TRANSFORM, Transform(Basis(), Vector3(Math::random(-extent, extent), Math::random(-extent, extent), Math::random(-extent, extent))));
+		bodies.push_back(body);
+	}
+
+	Vector<Vector3> from;
+	Vector<Vector3> to;
+	Vector<Transform> xforms;
+	Vector<Vector3> motions;
+	for (int i = 0; i < query_count; i++) {
+		Vector3 origin(Math::random(-extent, extent), Math::random(-extent, extent), Math::random(-extent, extent));
+		Vector3 motion(Math::random(-20.0, 20.0), Math::random(-20.0, 20.0), Math::random(-20.0, 20.0));
+		from.push_back(origin);
+		to.push_back(origin + motion);
+		xforms.push_back(Transform(Basis(), origin));
+		motions.push_back(motion);
+	}
+
+	PhysicsDirectSpaceState *state = ps->space_get_direct_state(space);
+
+	Vector<PhysicsDirectSpaceState::RayResult> expected_rays;
+	Vector<bool> expected_hits;
+	Vector<real_t> expected_safe;
+	Vector<real_t> expected_unsafe;
+	expected_rays.resize(query_count);
+	expected_hits.resize(query_count);
+	expected_safe.resize(query_count);
+	expected_unsafe.resize(query_count);
+
+	int expected_hit_count = 0;
+	int expected_blocked_count = 0;
+	for (int i = 0; i < query_count; i++) {
+		expected_hits.write[i] = state->intersect_ray(from[i], to[i], expected_rays.write[i]);
+		if (!state->cast_motion(sphere, xforms[i], motions[i], 0, expected_safe.write[i], expected_unsafe.write[i])) {
+			expected_safe.write[i] = 0; // what the batch reports when stuck from the start
+			expected_unsafe.write[i] = 0;
+		}
+		expected_hit_count += expected_hits[i];
+		expected_blocked_count += expected_safe[i] < 1;
+	}
+
+	ok = TestUtils::check(expected_hit_count > 0 && expected_hit_count < query_count, "some rays hit, some miss") && ok;
+	ok = TestUtils::check(expected_blocked_count > 0 && expected_blocked_count < query_count, "some motions are blocked, some are free") && ok;
+
+	for (int threaded = 0; threaded < 2; threaded++) {
+
+		String mode = threaded ? "threaded" : "serial";
+
+		Vector<PhysicsDirectSpaceState::RayResult> rays;
+		Vector<bool> hits;
+		rays.resize(query_count);
+		hits.resize(query_count);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		int hit_count = state->intersect_ray_batch(from.ptr(), to.ptr(), query_count, rays.ptrw(), hits.ptrw(), Set<RID>(), 0xFFFFFFFF, true, false, threaded);
+		uint64_t ray_time = OS::get_singleton()->get_ticks_usec() - begin;
+
+		bool same = hit_count == expected_hit_count;
+		for (int i = 0; i < query_count && same; i++) {
+			same = hits[i] == expected_hits[i];
+			if (same && expected_hits[i]) {
+				same = rays[i].rid == expected_rays[i].rid && rays[i].shape == expected_rays[i].shape && rays[i].position == expected_rays[i].position && rays[i].normal == expected_rays[i].normal;
+			}
+		}
+		ok = TestUtils::check(same, mode + " intersect_ray_batch matches intersect_ray") && ok;
+
+		Vector<real_t> safe;
+		Vector<real_t> unsafe;
+		safe.resize(query_count);
+		unsafe.resize(query_count);
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		int blocked_count = state->cast_motion_batch(sphere, xforms.ptr(), motions.ptr(), query_count, 0, safe.ptrw(), unsafe.ptrw(), Set<RID>(), 0xFFFFFFFF, true, false, threaded);
+		uint64_t motion_time = OS::get_singleton()->get_ticks_usec() - begin;
+
+		same = blocked_count == expected_blocked_count;
+		for (int i = 0; i < query_count && same; i++) {
+			same = safe[i] == expected_safe[i] && unsafe[i] == expected_unsafe[i];
+		}
+		ok = TestUtils::check(same, mode + " cast_motion_batch matches cast_motion") && ok;
+
+		OS::get_singleton()->print("%s: %d rays %.3f ms, %d motions %.3f ms\n", mode.utf8().get_data(), query_count, ray_time / 1000.0, query_count, motion_time / 1000.0);
+	}
+
+	for (int i = 0; i < bodies.size(); i++) {
+		ps->free(bodies[i]);
+	}
+	ps->free(box);
+	ps->free(sphere);
+	ps->free(space);
+
+	print_line(ok ? "Physics batch queries: OK" : "Physics batch queries: FAIL");
+	return NULL;
+}
 } // namespace TestPhysics
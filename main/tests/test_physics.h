@@ -40,6 +40,8 @@
 namespace TestPhysics {
 
 MainLoop *test();
+MainLoop *test_broadphase();
+MainLoop *test_batch_queries();
 }
 
 #endif
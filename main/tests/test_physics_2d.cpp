@@ -29,12 +29,16 @@
 /*************************************************************************/
 
 #include "test_physics_2d.h"
+#include "test_utils.h"
 
 #include "core/map.h"
+#include "core/math/math_funcs.h"
 #include "core/os/main_loop.h"
 #include "core/os/os.h"
 #include "core/print_string.h"
 #include "scene/resources/texture.h"
+#include "servers/physics_2d/broad_phase_2d_bvh.h"
+#include "servers/physics_2d/broad_phase_2d_sw.h"
 #include "servers/physics_2d_server.h"
 #include "servers/visual_server.h"
 
@@ -432,4 +436,131 @@ MainLoop *test() {
 
 	return memnew(TestPhysics2DMainLoop);
 }
+
+/* BATCH QUERIES */
+
+// Batches must give the same results as the same queries run one by one,
+// serially and on the work pool.
+MainLoop *test_batch_queries() {
+
+	const int body_count = 100;
+	const int query_count = 2000;
+	const real_t extent = 40;
+
+	bool ok = true;
+	Physics2DServer *ps = Physics2DServer::get_singleton();
+
+	// only the BVH allows concurrent culls, the threaded batches run serially otherwise
+	BroadPhase2DSW::CreateFunction old_create = BroadPhase2DSW::create_func;
+	BroadPhase2DSW::create_func = BroadPhase2DBVH::_create;
+	RID space = ps->space_create();
+	BroadPhase2DSW::create_func = old_create;
+	ps->space_set_active(space, true);
+
+	RID rectangle = ps->rectangle_shape_create();
+	ps->shape_set_data(rectangle, Vector2(1, 1));
+	RID circle = ps->circle_shape_create();
+	ps->shape_set_data(circle, 0.5);
+
+	Math::seed(4321);
+
+	Vector<RID> bodies;
+	for (int i = 0; i < body_count; i++) {
+		RID body = ps->body_create();
+		ps->body_set_mode(body, Physics2DServer::BODY_MODE_STATIC);
+		ps->body_add_shape(body, i % 2 ? rectangle : circle);
+		ps->body_set_space(body, space);
+		ps->body_set_state(body, Physics2DServer::BODY_STATE_TRANSFORM, Transform2D(0, Vector2(Math::random(-extent, extent), Math::random(-extent, extent))));
+		bodies.push_back(body);
+	}
+
+	Vector<Vector2> from;
+	Vector<Vector2> to;
+	Vector<Transform2D> xforms;
+	Vector<Vector2> motions;
+	for (int i = 0; i < query_count; i++) {
+		Vector2 origin(Math::random(-extent, extent), Math::random(-extent, extent));
+		Vector2 motion(Math::random(-20.0, 20.0), Math::random(-20.0, 20.0));
+		from.push_back(origin);
+		to.push_back(origin + motion);
+		xforms.push_back(Transform2D(0, origin));
+		motions.push_back(motion);
+	}
+
+	Physics2DDirectSpaceState *state = ps->space_get_direct_state(space);
+
+	Vector<Physics2DDirectSpaceState::RayResult> expected_rays;
+	Vector<bool> expected_hits;
+	Vector<real_t> expected_safe;
+	Vector<real_t> expected_unsafe;
+	expected_rays.resize(query_count);
+	expected_hits.resize(query_count);
+	expected_safe.resize(query_count);
+	expected_unsafe.resize(query_count);
+
+	int expected_hit_count = 0;
+	int expected_blocked_count = 0;
+	for (int i = 0; i < query_count; i++) {
+		expected_hits.write[i] = state->intersect_ray(from[i], to[i], expected_rays.write[i]);
+		if (!state->cast_motion(circle, xforms[i], motions[i], 0, expected_safe.write[i], expected_unsafe.write[i])) {
+			expected_safe.write[i] = 0; // what the batch reports when stuck from the start
+			expected_unsafe.write[i] = 0;
+		}
+		expected_hit_count += expected_hits[i];
+		expected_blocked_count += expected_safe[i] < 1;
+	}
+
+	ok = TestUtils::check(expected_hit_count > 0 && expected_hit_count < query_count, "some rays hit, some miss") && ok;
+	ok = TestUtils::check(expected_blocked_count > 0 && expected_blocked_count < query_count, "some motions are blocked, some are free") && ok;
+
+	for (int threaded = 0; threaded < 2; threaded++) {
+
+		String mode = threaded ? "threaded" : "serial";
+
+		Vector<Physics2DDirectSpaceState::RayResult> rays;
+		Vector<bool> hits;
+		rays.resize(query_count);
+		hits.resize(query_count);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		int hit_count = state->intersect_ray_batch(from.ptr(), to.ptr(), query_count, rays.ptrw(), hits.ptrw(), Set<RID>(), 0xFFFFFFFF, true, false, threaded);
+		uint64_t ray_time = OS::get_singleton()->get_ticks_usec() - begin;
+
+		bool same = hit_count == expected_hit_count;
+		for (int i = 0; i < query_count && same; i++) {
+			same = hits[i] == expected_hits[i];
+			if (same && expected_hits[i]) {
+				same = rays[i].rid == expected_rays[i].rid && rays[i].shape == expected_rays[i].shape && rays[i].position == expected_rays[i].position && rays[i].normal == expected_rays[i].normal;
+			}
+		}
+		ok = TestUtils::check(same, mode + " intersect_ray_batch matches intersect_ray") && ok;
+
+		Vector<real_t> safe;
+		Vector<real_t> unsafe;
+		safe.resize(query_count);
+		unsafe.resize(query_count);
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		int blocked_count = state->cast_motion_batch(circle, xforms.ptr(), motions.ptr(), query_count, 0, safe.ptrw(), unsafe.ptrw(), Set<RID>(), 0xFFFFFFFF, true, false, threaded);
+		uint64_t motion_time = OS::get_singleton()->get_ticks_usec() - begin;
+
+		same = blocked_count == expected_blocked_count;
+		for (int i = 0; i < query_count && same; i++) {
+			same = safe[i] == expected_safe[i] && unsafe[i] == expected_unsafe[i];
+		}
+		ok = TestUtils::check(same, mode + " cast_motion_batch matches cast_motion") && ok;
+
+		OS::get_singleton()->print("%s: %d rays %.3f ms, %d motions %.3f ms\n", mode.utf8().get_data(), query_count, ray_time / 1000.0, query_count, motion_time / 1000.0);
+	}
+
+	for (int i = 0; i < bodies.size(); i++) {
+		ps->free(bodies[i]);
+	}
+	ps->free(rectangle);
+	ps->free(circle);
+	ps->free(space);
+
+	print_line(ok ? "Physics 2D batch queries: OK" : "Physics 2D batch queries: FAIL");
+	return NULL;
+}
 } // namespace TestPhysics2D
@@ -0,0 +1,189 @@
+/*************************************************************************/
+/*  test_pool_vector.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_pool_vector.h"
+#include "test_utils.h"
+
+#include "core/os/mutex.h"
+#include "core/os/os.h"
+#include "core/pool_vector.h"
+
+namespace TestPoolVector {
+
+enum {
+	KEEP = 64,
+	EXCHANGE = 16
+};
+
+struct WorkerData {
+
+	int iterations;
+	int seed;
+	bool ok;
+};
+
+// Read by every thread, each one makes its own copy on write.
+static PoolVector<String> shared_strings;
+
+// Vectors handed from thread to thread, so they are released by a
+// different thread than the one that allocated them.
+static PoolVector<int> exchange[EXCHANGE];
+static Mutex *exchange_lock = NULL;
+
+static PoolVector<int> _make_vector(int p_size) {
+
+	PoolVector<int> v;
+	v.resize(p_size);
+	PoolVector<int>::Write w = v.write();
+	for (int i = 0; i < p_size; i++) {
+		w[i] = p_size;
+	}
+	return v;
+}
+
+static bool _check_vector(const PoolVector<int> &p_vector) {
+
+	int size = p_vector.size();
+	return size == 0 || (p_vector[0] == size && p_vector[size - 1] == size);
+}
+
+// What scripts and resources do with pool arrays: copy shared ones and
+// change the copy, build short-lived buffers, keep some around for a while
+// and pass others on to be dropped elsewhere.
+static void _worker(void *p_data) {
+
+	WorkerData *wd = (WorkerData *)p_data;
+	uint32_t seed = wd->seed;
+
+	PoolVector<int> kept[KEEP];
+
+	for (int i = 0; i < wd->iterations; i++) {
+
+		seed = seed * 1664525 + 1013904223;
+
+		// resize() fails with ERR_LOCKED while other threads read the shared
+		// data, so the copy is made with set() before it grows.
+		PoolVector<String> strings = shared_strings;
+		strings.set(0, itos(i));
+		strings.push_back(itos(i));
+		if (strings.size() != shared_strings.size() + 1 || shared_strings[0] != "0" || strings[0] != itos(i) || strings[strings.size() - 1] != itos(i)) {
+			wd->ok = false;
+		}
+
+		PoolVector<uint8_t> bytes;
+		bytes.resize(1 + (seed >> 8) % 300);
+		{
+			PoolVector<uint8_t>::Write w = bytes.write();
+			w[0] = wd->seed;
+			w[bytes.size() - 1] = wd->seed;
+		}
+		PoolVector<uint8_t> bytes_copy = bytes;
+		bytes_copy.set(0, wd->seed + 1);
+		if (bytes[0] != uint8_t(wd->seed) || bytes[bytes.size() - 1] != uint8_t(wd->seed) || bytes_copy[0] != uint8_t(wd->seed + 1)) {
+			wd->ok = false;
+		}
+
+		int slot = (seed >> 16) % KEEP;
+		if (!_check_vector(kept[slot])) {
+			wd->ok = false;
+		}
+		kept[slot] = _make_vector((seed >> 24) % 64);
+
+		if ((i & 7) == 0) {
+			PoolVector<int> mine = _make_vector(1 + (seed >> 20) % 32);
+			PoolVector<int> theirs;
+
+			exchange_lock->lock();
+			int e = (seed >> 12) % EXCHANGE;
+			theirs = exchange[e];
+			exchange[e] = mine;
+			exchange_lock->unlock();
+
+			if (!_check_vector(theirs)) {
+				wd->ok = false;
+			}
+		}
+	}
+}
+
+MainLoop *test() {
+
+	bool ok = true;
+	const int iterations = 50000;
+	int max_threads = MAX(OS::get_singleton()->get_processor_count(), 4);
+
+	exchange_lock = Mutex::create();
+	for (int i = 0; i < 10; i++) {
+		shared_strings.push_back(itos(i));
+	}
+
+	uint32_t allocs_before = MemoryPool::allocs_used;
+	size_t memory_before = MemoryPool::total_memory;
+
+	for (int threads = 1; threads <= max_threads; threads *= 2) {
+
+		Vector<WorkerData> data;
+		data.resize(threads);
+		for (int i = 0; i < threads; i++) {
+			data.write[i].iterations = iterations;
+			data.write[i].seed = i + 1;
+			data.write[i].ok = true;
+		}
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		TestUtils::wait_threads(TestUtils::start_threads(_worker, data.ptrw(), threads));
+		uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+
+		for (int i = 0; i < threads; i++) {
+			ok = TestUtils::check(data[i].ok, itos(threads) + " threads: thread " + itos(i) + " saw the vectors it expected") && ok;
+		}
+
+		OS::get_singleton()->print("%d threads: %.3f ms, %.2f M iterations/s\n", threads, time / 1000.0, double(threads) * iterations / MAX(time, 1));
+	}
+
+	for (int i = 0; i < EXCHANGE; i++) {
+		if (!_check_vector(exchange[i])) {
+			ok = TestUtils::check(false, "vector " + itos(i) + " left in the exchange") && ok;
+		}
+		exchange[i] = PoolVector<int>();
+	}
+
+	// total_memory is only tracked by debug builds
+	ok = TestUtils::check(MemoryPool::allocs_used == allocs_before, "allocs in use: " + itos(allocs_before) + " before, " + itos(MemoryPool::allocs_used) + " after") && ok;
+	ok = TestUtils::check(MemoryPool::total_memory == memory_before, "pool memory: " + itos(memory_before) + " bytes before, " + itos(MemoryPool::total_memory) + " after") && ok;
+
+	shared_strings = PoolVector<String>();
+	memdelete(exchange_lock);
+	exchange_lock = NULL;
+
+	print_line(ok ? "PoolVector: OK" : "PoolVector: FAIL");
+	return NULL;
+}
+} // namespace TestPoolVector
@@ -32,11 +32,16 @@
 
 #include "core/math/math_funcs.h"
 #include "core/math/quick_hull.h"
+#include "core/math/random_pcg.h"
 #include "core/os/keyboard.h"
 #include "core/os/main_loop.h"
 #include "core/os/os.h"
 #include "core/print_string.h"
+#include "core/project_settings.h"
+#include "servers/visual/visual_server_globals.h"
+#include "servers/visual/visual_server_scene.h"
 #include "servers/visual_server.h"
+#include "test_utils.h"
 
 #define OBJECT_COUNT 50
 
@@ -242,4 +247,130 @@ MainLoop *test() {
 
 	return memnew(TestMainLoop);
 }
+
+/* CAMERA CULLING */
+
+// Meant for the headless (dummy rasterizer) build, which does not draw but
+// still goes through the whole camera cull. Reads the scene server directly,
+// so it needs the single threaded render model.
+
+struct CullResult {
+
+	Vector<VisualServerScene::Instance *> instances;
+	Vector<int> depth_layers;
+};
+
+static CullResult _cull_with_threads(int p_threads, const Transform &p_cam_transform, const CameraMatrix &p_cam_projection, uint32_t p_visible_layers, RID p_scenario) {
+
+	VisualServerScene *scene = VSG::scene;
+
+	scene->cull_work_pool.finish();
+	scene->cull_work_pool.init(p_threads);
+
+	scene->update_dirty_instances();
+	scene->_prepare_scene(p_cam_transform, p_cam_projection, false, RID(), p_visible_layers, p_scenario, RID(), RID());
+
+	CullResult result;
+	result.instances.resize(scene->instance_cull_count);
+	result.depth_layers.resize(scene->instance_cull_count);
+	for (int i = 0; i < scene->instance_cull_count; i++) {
+		result.instances.write[i] = scene->instance_cull_result[i];
+		result.depth_layers.write[i] = scene->instance_cull_result[i]->depth_layer;
+	}
+	return result;
+}
+
+MainLoop *test_culling() {
+
+	VisualServer *vs = VisualServer::get_singleton();
+	VisualServerScene *scene = VSG::scene;
+	bool ok = true;
+
+	RID scenario = vs->scenario_create();
+	RID mesh = vs->mesh_create();
+
+	RandomPCG rng(3);
+	Vector<RID> instances;
+
+	for (int i = 0; i < 20000; i++) {
+
+		RID instance = vs->instance_create2(mesh, scenario);
+		vs->instance_set_custom_aabb(instance, AABB(Vector3(-1, -1, -1), Vector3(2, 2, 2)));
+		vs->instance_set_transform(instance, Transform(Basis(), Vector3(rng.random(-150.0f, 150.0f), rng.random(-150.0f, 150.0f), rng.random(-150.0f, 150.0f))));
+		vs->instance_set_layer_mask(instance, 1 << (rng.rand() % 2));
+		if (i % 7 == 0) {
+			vs->instance_set_visible(instance, false);
+		}
+		if (i % 11 == 0) {
+			vs->instance_geometry_set_cast_shadows_setting(instance, VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY);
+		}
+		instances.push_back(instance);
+	}
+
+	vs->sync();
+
+	Transform cam_transform;
+	cam_transform.set_look_at(Vector3(0, 0, 20), Vector3(10, 5, -100), Vector3(0, 1, 0));
+	CameraMatrix cam_projection;
+	cam_projection.set_perspective(70, 1.0, 0.05, 120);
+	Vector<Plane> planes = cam_projection.get_projection_planes(cam_transform);
+	Plane near_plane(cam_transform.origin, -cam_transform.basis.get_axis(2).normalized());
+
+	CullResult serial = _cull_with_threads(1, cam_transform, cam_projection, 1, scenario);
+
+	// Every kept instance passes the per instance checks, and nothing that
+	// is inside the frustum and should be drawn is missing.
+	Set<VisualServerScene::Instance *> kept;
+	for (int i = 0; i < serial.instances.size(); i++) {
+		kept.insert(serial.instances[i]);
+	}
+
+	int expected_count = 0;
+	for (int i = 0; i < instances.size(); i++) {
+
+		VisualServerScene::Instance *ins = scene->instance_owner.get(instances[i]);
+		bool drawn = ins->visible && (ins->layer_mask & 1) && ins->cast_shadows != VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY;
+		bool in_frustum = ins->transformed_aabb.intersects_convex_shape(planes.ptr(), planes.size());
+
+		if (kept.has(ins)) {
+			ok &= TestUtils::check(drawn, "instance " + itos(i) + " is hidden, shadow only or on another layer, but was kept");
+			ok &= TestUtils::check(Math::is_equal_approx(ins->depth, near_plane.distance_to(ins->transform.origin)), "instance " + itos(i) + " has the wrong depth");
+		} else {
+			ok &= TestUtils::check(!drawn || !in_frustum, "instance " + itos(i) + " is in the frustum, but was culled");
+		}
+
+		if (drawn && in_frustum) {
+			expected_count++;
+		}
+	}
+
+	ok &= TestUtils::check(expected_count > 0, "the camera sees some instances");
+
+	// The parallel classification must give the serial result, in the same order.
+	static const int thread_counts[] = { 2, 4, 8 };
+
+	for (int i = 0; i < 3; i++) {
+
+		CullResult threaded = _cull_with_threads(thread_counts[i], cam_transform, cam_projection, 1, scenario);
+
+		bool same = threaded.instances.size() == serial.instances.size();
+		for (int j = 0; same && j < serial.instances.size(); j++) {
+			same = threaded.instances[j] == serial.instances[j] && threaded.depth_layers[j] == serial.depth_layers[j];
+		}
+		ok &= TestUtils::check(same, itos(thread_counts[i]) + " culling threads match the serial cull");
+	}
+
+	for (int i = 0; i < instances.size(); i++) {
+		vs->free(instances[i]);
+	}
+	vs->free(mesh);
+	vs->free(scenario);
+
+	int threads = GLOBAL_GET("rendering/threads/culling_threads");
+	scene->cull_work_pool.finish();
+	scene->cull_work_pool.init(threads > 0 ? threads : -1);
+
+	print_line(ok ? "RenderCulling: OK" : "RenderCulling: FAIL");
+	return NULL;
+}
 } // namespace TestRender
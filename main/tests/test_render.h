@@ -40,6 +40,7 @@
 namespace TestRender {
 
 MainLoop *test();
+MainLoop *test_culling();
 }
 
 #endif
@@ -0,0 +1,132 @@
+/*************************************************************************/
+/*  test_resource_loader.cpp                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_resource_loader.h"
+#include "test_utils.h"
+
+#include "core/io/resource_loader.h"
+#include "core/io/resource_saver.h"
+#include "core/os/dir_access.h"
+#include "core/os/os.h"
+
+namespace TestResourceLoader {
+
+struct LoadData {
+
+	String path;
+	int delay_usec;
+	RES resource;
+};
+
+static void _load(void *p_data) {
+
+	LoadData *ld = (LoadData *)p_data;
+
+	OS::get_singleton()->delay_usec(ld->delay_usec);
+	ld->resource = ResourceLoader::load(ld->path);
+}
+
+// A background request and several plain load() calls race on one path.
+// The calls are spread over the time one load takes, so they land before,
+// while and right after the loader thread finishes. Every one must get the
+// same instance.
+static bool _test_shared_load(const String &p_path, int p_iterations) {
+
+	const int threads = 8;
+	bool ok = true;
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	ResourceLoader::load(p_path);
+	int load_usec = MAX(int(OS::get_singleton()->get_ticks_usec() - begin), 1);
+
+	for (int i = 0; i < p_iterations; i++) {
+
+		Vector<LoadData> data;
+		data.resize(threads);
+		for (int j = 0; j < threads; j++) {
+			data.write[j].path = p_path;
+			data.write[j].delay_usec = (load_usec * (j * p_iterations + i)) / (threads * p_iterations / 2);
+		}
+
+		ok &= TestUtils::check(ResourceLoader::load_threaded_request(p_path) == OK, "threaded request accepted");
+		TestUtils::wait_threads(TestUtils::start_threads(_load, data.ptrw(), threads));
+		RES requested = ResourceLoader::load_threaded_get(p_path);
+
+		ok &= TestUtils::check(requested.is_valid(), "threaded request loaded the resource");
+		for (int j = 0; j < threads; j++) {
+			ok &= TestUtils::check(data[j].resource == requested, "load() " + itos(j) + " shares the background result, iteration " + itos(i));
+		}
+
+		// Drop every reference, so the next iteration loads from disk again.
+		// The loader thread may still be letting go of its own.
+		data.clear();
+		requested.unref();
+		for (int j = 0; j < 1000 && ResourceCache::has(p_path); j++) {
+			OS::get_singleton()->delay_usec(1000);
+		}
+		ok &= TestUtils::check(!ResourceCache::has(p_path), "the resource left the cache");
+	}
+
+	return ok;
+}
+
+MainLoop *test() {
+
+	String path = "user://test_resource_loader.res";
+
+	// Big enough that loading it takes a moment.
+	PoolVector<uint8_t> payload;
+	payload.resize(256 * 1024);
+	{
+		PoolVector<uint8_t>::Write w = payload.write();
+		for (int i = 0; i < payload.size(); i++) {
+			w[i] = uint8_t(i * 31);
+		}
+	}
+
+	Ref<Resource> resource;
+	resource.instance();
+	resource->set_meta("payload", payload);
+
+	bool ok = TestUtils::check(ResourceSaver::save(path, resource) == OK, "test resource saved");
+	resource.unref();
+
+	if (ok) {
+		ok &= _test_shared_load(path, 200);
+	}
+
+	DirAccess *da = DirAccess::create(DirAccess::ACCESS_USERDATA);
+	da->remove(path);
+	memdelete(da);
+
+	print_line(ok ? "ResourceLoader: OK" : "ResourceLoader: FAIL");
+	return NULL;
+}
+} // namespace TestResourceLoader
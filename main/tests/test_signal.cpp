@@ -0,0 +1,125 @@
+/*************************************************************************/
+/*  test_signal.cpp                                                      */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_signal.h"
+#include "test_utils.h"
+
+#include "core/os/os.h"
+#include "core/resource.h"
+
+namespace TestSignal {
+
+static void _print_rate(const char *p_what, int p_calls, uint64_t p_usec) {
+
+	OS::get_singleton()->print("%s: %.3f ms, %.2f M calls/s\n", p_what, p_usec / 1000.0, p_calls / double(MAX(p_usec, 1)));
+}
+
+MainLoop *test() {
+
+	bool ok = true;
+
+	const int target_count = 8;
+	const int emits = 200000;
+
+	Object *source = memnew(Object);
+	source->add_user_signal(MethodInfo("changed", PropertyInfo(Variant::STRING, "name"), PropertyInfo(Variant::INT, "value")));
+	source->add_user_signal(MethodInfo("touched"));
+	source->add_user_signal(MethodInfo("pinged"));
+
+	// a few levels of inheritance, like most targets have
+	Object *targets[target_count];
+	for (int i = 0; i < target_count; i++) {
+		targets[i] = memnew(Resource);
+		source->connect("pinged", targets[i], "get_instance_id");
+		source->connect("changed", targets[i], "set_meta");
+		// the signal has no arguments, binds supply all of them
+		Vector<Variant> binds;
+		binds.push_back("touched");
+		binds.push_back(i);
+		source->connect("touched", targets[i], "set_meta", binds);
+	}
+
+	// baseline: the same calls by name, as emit_signal() used to make them
+	StringName method = "get_instance_id";
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < emits; i++) {
+		for (int j = 0; j < target_count; j++) {
+			targets[j]->call(method);
+		}
+	}
+	_print_rate("call by name, no arguments", emits * target_count, OS::get_singleton()->get_ticks_usec() - begin);
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < emits; i++) {
+		source->emit_signal("pinged");
+	}
+	_print_rate("emit_signal, no arguments", emits * target_count, OS::get_singleton()->get_ticks_usec() - begin);
+
+	String name = "value";
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < emits; i++) {
+		source->emit_signal("changed", name, i);
+	}
+	_print_rate("emit_signal, 2 arguments", emits * target_count, OS::get_singleton()->get_ticks_usec() - begin);
+
+	begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < emits; i++) {
+		source->emit_signal("touched");
+	}
+	_print_rate("emit_signal, 2 binds", emits * target_count, OS::get_singleton()->get_ticks_usec() - begin);
+
+	for (int i = 0; i < target_count; i++) {
+		ok &= TestUtils::check(int(targets[i]->get_meta("value")) == emits - 1, "signal arguments delivered");
+		ok &= TestUtils::check(int(targets[i]->get_meta("touched")) == i, "binds delivered");
+	}
+
+	// one-shot connections are gone after the first emission
+	Object *oneshot = memnew(Object);
+	source->connect("changed", oneshot, "set_meta", Vector<Variant>(), Object::CONNECT_ONESHOT);
+	source->emit_signal("changed", name, 1);
+	source->emit_signal("changed", name, 2);
+	ok &= TestUtils::check(int(oneshot->get_meta("value")) == 1 && !source->is_connected("changed", oneshot, "set_meta"), "one-shot connection");
+
+	// methods the class doesn't bind still go through call()
+	ok &= TestUtils::check(source->connect("touched", targets[0], "_no_such_method") == OK, "connect to unbound method");
+	ok &= TestUtils::check(source->emit_signal("touched") == ERR_METHOD_NOT_FOUND, "unbound method reported");
+	source->disconnect("touched", targets[0], "_no_such_method");
+
+	memdelete(oneshot);
+	for (int i = 0; i < target_count; i++) {
+		memdelete(targets[i]);
+	}
+	memdelete(source);
+
+	print_line(ok ? "Signal: OK" : "Signal: FAIL");
+	return NULL;
+}
+} // namespace TestSignal
@@ -0,0 +1,166 @@
+/*************************************************************************/
+/*  test_string_name.cpp                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_string_name.h"
+#include "test_utils.h"
+
+#include "core/os/os.h"
+#include "core/string_name.h"
+
+namespace TestStringName {
+
+struct WorkerData {
+
+	const Vector<String> *names;
+	int first;
+	int iterations;
+	int thread_index;
+	bool ok;
+};
+
+// Every worker keeps resolving the shared names (the common case: property
+// and method names looked up by scripts) and interns a few short-lived ones
+// of its own, so both the lookup path and the insert/remove path race.
+static void _worker(void *p_data) {
+
+	WorkerData *wd = (WorkerData *)p_data;
+	const Vector<String> &names = *wd->names;
+	int count = names.size();
+
+	StringName first(names[wd->first]);
+
+	for (int i = 0; i < wd->iterations; i++) {
+
+		int idx = (wd->first + i * 7919) % count;
+		StringName a(names[idx]);
+		StringName b = StringName::search(names[idx]);
+		if (a != b || String(a) != names[idx]) {
+			wd->ok = false;
+		}
+
+		if ((i & 15) == 0) {
+			String transient = "transient_" + itos(wd->thread_index) + "_" + itos(i);
+			StringName t(transient);
+			if (StringName(transient) != t) {
+				wd->ok = false;
+			}
+		}
+	}
+
+	if (first != StringName(names[wd->first])) {
+		wd->ok = false;
+	}
+}
+
+static uint64_t _run(const Vector<String> &p_names, int p_threads, int p_iterations, bool *r_ok) {
+
+	Vector<WorkerData> data;
+	data.resize(p_threads);
+	for (int i = 0; i < p_threads; i++) {
+		WorkerData &wd = data.write[i];
+		wd.names = &p_names;
+		wd.first = (i * 104729) % p_names.size();
+		wd.iterations = p_iterations;
+		wd.thread_index = i;
+		wd.ok = true;
+	}
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	TestUtils::wait_threads(TestUtils::start_threads(_worker, data.ptrw(), p_threads));
+	uint64_t time = OS::get_singleton()->get_ticks_usec() - begin;
+
+	for (int i = 0; i < p_threads; i++) {
+		*r_ok = *r_ok && data[i].ok;
+	}
+
+	return time;
+}
+
+MainLoop *test() {
+
+	bool ok = true;
+
+	const int name_count = 100000;
+	Vector<String> names;
+	names.resize(name_count);
+	for (int i = 0; i < name_count; i++) {
+		names.write[i] = "name_" + itos(i * 2654435761U);
+	}
+
+	// Keep every shared name interned while the workers run.
+	Vector<StringName> interned;
+	interned.resize(name_count);
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < name_count; i++) {
+		interned.write[i] = names[i];
+	}
+	uint64_t time_intern = OS::get_singleton()->get_ticks_usec() - begin;
+
+	for (int i = 0; i < name_count; i++) {
+		if (String(interned[i]) != names[i] || interned[i] != StringName(names[i])) {
+			ok = false;
+		}
+	}
+
+	StringName::TableStats stats;
+	StringName::get_table_stats(stats);
+	OS::get_singleton()->print("interned %d names in %.3f ms: %d entries, %d buckets, longest chain %d\n", name_count, time_intern / 1000.0, stats.names, stats.buckets, stats.longest_chain);
+
+	const int iterations = 200000;
+	int max_threads = MAX(OS::get_singleton()->get_processor_count(), 4);
+
+	for (int threads = 1; threads <= max_threads; threads *= 2) {
+
+		StringName::TableStats before;
+		StringName::get_table_stats(before);
+
+		uint64_t time = _run(names, threads, iterations, &ok);
+
+		StringName::get_table_stats(stats);
+		uint64_t ops = uint64_t(threads) * iterations * 2;
+		OS::get_singleton()->print("%d threads: %.3f ms, %.1f M lookups/s, %d locked lookups, %d contended\n", threads, time / 1000.0, ops / double(MAX(time, 1)), stats.slow_lookups - before.slow_lookups, stats.contended - before.contended);
+	}
+
+	interned.clear();
+
+	// The transient names must be gone again, along with the shared ones.
+	for (int i = 0; i < name_count; i += 997) {
+		if (StringName::search(names[i]) != StringName()) {
+			ok = false;
+		}
+	}
+	if (StringName::search("transient_0_0") != StringName()) {
+		ok = false;
+	}
+
+	print_line(ok ? "StringName table: OK" : "StringName table: FAIL");
+	return NULL;
+}
+} // namespace TestStringName
@@ -0,0 +1,232 @@
+/*************************************************************************/
+/*  test_tile_map.cpp                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_tile_map.h"
+#include "test_utils.h"
+
+#include "core/math/math_funcs.h"
+#include "scene/2d/tile_map.h"
+
+namespace TestTileMap {
+
+// Cells are checked against a plain grid over this window, which spans
+// several chunks and quadrants on both sides of zero.
+enum {
+	WINDOW_FROM = -40,
+	WINDOW_SIZE = 80
+};
+
+struct Reference {
+	int cells[WINDOW_SIZE * WINDOW_SIZE];
+
+	int &at(int p_x, int p_y) { return cells[(p_y - WINDOW_FROM) * WINDOW_SIZE + p_x - WINDOW_FROM]; }
+
+	Reference() {
+		for (int i = 0; i < WINDOW_SIZE * WINDOW_SIZE; i++) {
+			cells[i] = TileMap::INVALID_CELL;
+		}
+	}
+};
+
+// Array::operator== only tells if both share the same data.
+static bool _same_cells(const Array &p_a, const Array &p_b) {
+
+	if (p_a.size() != p_b.size())
+		return false;
+
+	for (int i = 0; i < p_a.size(); i++) {
+		if (Vector2(p_a[i]) != Vector2(p_b[i]))
+			return false;
+	}
+	return true;
+}
+
+// Compares every cell, the used cells in (y, x) order and the used rect.
+static bool _compare(TileMap *p_map, Reference &p_ref, const String &p_what) {
+
+	bool cells_ok = true;
+	Array expected;
+	Array expected_by_id;
+	Rect2 expected_rect;
+
+	// Row by row, so expected is in the order get_used_cells() must keep.
+	for (int y = WINDOW_FROM; y < WINDOW_FROM + WINDOW_SIZE; y++) {
+		for (int x = WINDOW_FROM; x < WINDOW_FROM + WINDOW_SIZE; x++) {
+
+			int id = p_ref.at(x, y);
+			if (p_map->get_cell(x, y) != id) {
+				cells_ok = false;
+			}
+			if (id == TileMap::INVALID_CELL)
+				continue;
+
+			if (expected.empty()) {
+				expected_rect = Rect2(x, y, 0, 0);
+			} else {
+				expected_rect.expand_to(Vector2(x, y));
+			}
+			expected.push_back(Vector2(x, y));
+			if (id == 2) {
+				expected_by_id.push_back(Vector2(x, y));
+			}
+		}
+	}
+	if (!expected.empty()) {
+		expected_rect.size += Vector2(1, 1);
+	}
+
+	bool ok = TestUtils::check(cells_ok, p_what + ": get_cell() matches");
+	ok = TestUtils::check(_same_cells(p_map->get_used_cells(), expected), p_what + ": get_used_cells() has every used cell, by row then column") && ok;
+	ok = TestUtils::check(_same_cells(p_map->get_used_cells_by_id(2), expected_by_id), p_what + ": get_used_cells_by_id()") && ok;
+	ok = TestUtils::check(p_map->get_used_rect() == expected_rect, p_what + ": get_used_rect() is " + String(p_map->get_used_rect()) + ", expected " + String(expected_rect)) && ok;
+	return ok;
+}
+
+static bool test_order() {
+
+	TileMap *map = memnew(TileMap);
+
+	// Chunks and quadrants are 16 cells wide, so these are all in different
+	// ones, and rows with negative y come first.
+	map->set_cell(16, -1, 3);
+	map->set_cell(-1, 0, 1);
+	map->set_cell(0, -1, 2);
+	map->set_cell(-17, -1, 0);
+	map->set_cell(-16, -16, 4);
+
+	Array expected;
+	expected.push_back(Vector2(-16, -16));
+	expected.push_back(Vector2(-17, -1));
+	expected.push_back(Vector2(0, -1));
+	expected.push_back(Vector2(16, -1));
+	expected.push_back(Vector2(-1, 0));
+
+	bool ok = TestUtils::check(_same_cells(map->get_used_cells(), expected), "used cells by row then column");
+	ok = TestUtils::check(map->get_used_rect() == Rect2(-17, -16, 34, 17), "used rect across chunks") && ok;
+	ok = TestUtils::check(map->get_cell(-16, -16) == 4 && map->get_cell(-17, -1) == 0 && map->get_cell(-1, -1) == TileMap::INVALID_CELL, "cells with negative coordinates") && ok;
+
+	map->set_cell(-16, -16, TileMap::INVALID_CELL);
+	map->set_cell(16, -1, TileMap::INVALID_CELL);
+	expected.remove(3);
+	expected.remove(0);
+
+	ok = TestUtils::check(_same_cells(map->get_used_cells(), expected), "used cells after clearing") && ok;
+	ok = TestUtils::check(map->get_used_rect() == Rect2(-17, -1, 18, 2), "used rect after clearing") && ok;
+
+	map->clear();
+
+	ok = TestUtils::check(map->get_used_cells().empty(), "no used cells after clear()") && ok;
+	ok = TestUtils::check(map->get_used_rect() == Rect2(), "empty used rect after clear()") && ok;
+
+	memdelete(map);
+	return ok;
+}
+
+static bool test_random_edits() {
+
+	TileMap *map = memnew(TileMap);
+	Reference *ref = memnew(Reference);
+	bool ok = true;
+	uint64_t seed = 17;
+
+	for (int round = 0; round < 20; round++) {
+
+		// Single cells, about a third of them cleared.
+		for (int i = 0; i < 300; i++) {
+			int x = WINDOW_FROM + Math::rand_from_seed(&seed) % WINDOW_SIZE;
+			int y = WINDOW_FROM + Math::rand_from_seed(&seed) % WINDOW_SIZE;
+			int id = int(Math::rand_from_seed(&seed) % 6) - 2;
+			id = MAX(id, int(TileMap::INVALID_CELL));
+			map->set_cell(x, y, id);
+			ref->at(x, y) = id;
+		}
+		ok = _compare(map, *ref, "round " + itos(round) + " set_cell()") && ok;
+
+		// A batch of scattered cells, all set to one tile or each to its own.
+		PoolVector2Array positions;
+		PoolIntArray tiles;
+		bool single = round % 2;
+		for (int i = 0; i < 100; i++) {
+			int x = WINDOW_FROM + Math::rand_from_seed(&seed) % WINDOW_SIZE;
+			int y = WINDOW_FROM + Math::rand_from_seed(&seed) % WINDOW_SIZE;
+			int id = single ? (round % 4 == 1 ? int(TileMap::INVALID_CELL) : 2) : int(Math::rand_from_seed(&seed) % 4);
+			positions.push_back(Vector2(x, y));
+			if (!single || i == 0) {
+				tiles.push_back(id);
+			}
+			ref->at(x, y) = single ? tiles[0] : id;
+		}
+		map->set_cells(positions, tiles);
+		ok = _compare(map, *ref, "round " + itos(round) + " set_cells()") && ok;
+
+		// A rect, filled or cleared as a whole or with a tile per cell.
+		int w = 1 + Math::rand_from_seed(&seed) % 30;
+		int h = 1 + Math::rand_from_seed(&seed) % 30;
+		int rx = WINDOW_FROM + Math::rand_from_seed(&seed) % (WINDOW_SIZE - w);
+		int ry = WINDOW_FROM + Math::rand_from_seed(&seed) % (WINDOW_SIZE - h);
+		PoolIntArray rect_tiles;
+		if (round % 3 == 0) {
+			rect_tiles.push_back(round % 2 ? int(TileMap::INVALID_CELL) : 1);
+		} else {
+			for (int i = 0; i < w * h; i++) {
+				rect_tiles.push_back(int(Math::rand_from_seed(&seed) % 5) - 1);
+			}
+		}
+		map->set_cells_rect(Rect2(rx, ry, w, h), rect_tiles);
+		for (int y = 0; y < h; y++) {
+			for (int x = 0; x < w; x++) {
+				ref->at(rx + x, ry + y) = rect_tiles.size() == 1 ? rect_tiles[0] : rect_tiles[y * w + x];
+			}
+		}
+		ok = _compare(map, *ref, "round " + itos(round) + " set_cells_rect()") && ok;
+	}
+
+	// Clearing the whole window empties the map.
+	PoolIntArray clear_tile;
+	clear_tile.push_back(TileMap::INVALID_CELL);
+	map->set_cells_rect(Rect2(WINDOW_FROM, WINDOW_FROM, WINDOW_SIZE, WINDOW_SIZE), clear_tile);
+	memdelete(ref);
+	ref = memnew(Reference);
+	ok = _compare(map, *ref, "cleared window") && ok;
+
+	memdelete(ref);
+	memdelete(map);
+	return ok;
+}
+
+MainLoop *test() {
+
+	bool ok = test_order();
+	ok = test_random_edits() && ok;
+
+	print_line(ok ? "TileMap: OK" : "TileMap: FAIL");
+	return NULL;
+}
+} // namespace TestTileMap
@@ -0,0 +1,72 @@
+/*************************************************************************/
+/*  test_utils.h                                                         */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include "core/os/thread.h"
+#include "core/print_string.h"
+#include "core/vector.h"
+
+namespace TestUtils {
+
+// Reports a failed check and passes the result on, so a test can go on and
+// report every failure.
+inline bool check(bool p_ok, const String &p_what) {
+
+	if (!p_ok) {
+		print_line("FAIL: " + p_what);
+	}
+	return p_ok;
+}
+
+// Runs p_func on a thread of its own for each of the p_count elements of
+// p_data, which it gets as its argument.
+template <class T>
+Vector<Thread *> start_threads(ThreadCreateCallback p_func, T *p_data, int p_count) {
+
+	Vector<Thread *> threads;
+	threads.resize(p_count);
+	for (int i = 0; i < p_count; i++) {
+		threads.write[i] = Thread::create(p_func, &p_data[i]);
+	}
+	return threads;
+}
+
+inline void wait_threads(const Vector<Thread *> &p_threads) {
+
+	for (int i = 0; i < p_threads.size(); i++) {
+		Thread::wait_to_finish(p_threads[i]);
+		memdelete(p_threads[i]);
+	}
+}
+} // namespace TestUtils
+
+#endif
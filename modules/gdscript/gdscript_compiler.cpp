@@ -31,6 +31,7 @@
 #include "gdscript_compiler.h"
 
 #include "gdscript.h"
+#include "gdscript_optimizer.h"
 
 bool GDScriptCompiler::_is_class_member_property(CodeGen &codegen, const StringName &p_name) {
 
@@ -82,7 +83,8 @@ bool GDScriptCompiler::_create_unary_operator(CodeGen &codegen, const GDScriptPa
 	if (src_address_a < 0)
 		return false;
 
-	codegen.opcodes.push_back(GDScriptFunction::OPCODE_OPERATOR); // perform operator
+	const GDScriptParser::DataType type_a = on->arguments[0]->get_datatype();
+	codegen.opcodes.push_back(_get_operator_opcode(op, type_a, type_a)); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_a); // argument 2 (repeated)
@@ -104,7 +106,7 @@ bool GDScriptCompiler::_create_binary_operator(CodeGen &codegen, const GDScriptP
 	if (src_address_b < 0)
 		return false;
 
-	codegen.opcodes.push_back(GDScriptFunction::OPCODE_OPERATOR); // perform operator
+	codegen.opcodes.push_back(_get_operator_opcode(op, on->arguments[0]->get_datatype(), on->arguments[1]->get_datatype())); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_b); // argument 2 (unary only takes one parameter)
@@ -171,6 +173,127 @@ GDScriptDataType GDScriptCompiler::_gdtype_from_datatype(const GDScriptParser::D
 	return result;
 }
 
+static bool _is_builtin_datatype(const GDScriptParser::DataType &p_datatype, Variant::Type p_type) {
+
+	return p_datatype.has_type && !p_datatype.is_meta_type && p_datatype.kind == GDScriptParser::DataType::BUILTIN && p_datatype.builtin_type == p_type;
+}
+
+GDScriptFunction::Opcode GDScriptCompiler::_get_operator_opcode(Variant::Operator p_op, const GDScriptParser::DataType &p_a, const GDScriptParser::DataType &p_b) const {
+
+	// The typed opcodes still check the operand types at runtime, the static
+	// types are only a hint (they are not enforced in release builds).
+	bool int_a = _is_builtin_datatype(p_a, Variant::INT);
+	bool int_b = _is_builtin_datatype(p_b, Variant::INT);
+
+	if (int_a && int_b) {
+		switch (p_op) {
+			case Variant::OP_ADD:
+			case Variant::OP_SUBTRACT:
+			case Variant::OP_MULTIPLY:
+			case Variant::OP_DIVIDE:
+			case Variant::OP_MODULE:
+			case Variant::OP_NEGATE:
+			case Variant::OP_POSITIVE:
+			case Variant::OP_SHIFT_LEFT:
+			case Variant::OP_SHIFT_RIGHT:
+			case Variant::OP_BIT_AND:
+			case Variant::OP_BIT_OR:
+			case Variant::OP_BIT_XOR:
+			case Variant::OP_BIT_NEGATE:
+			case Variant::OP_EQUAL:
+			case Variant::OP_NOT_EQUAL:
+			case Variant::OP_LESS:
+			case Variant::OP_LESS_EQUAL:
+			case Variant::OP_GREATER:
+			case Variant::OP_GREATER_EQUAL:
+				return GDScriptFunction::OPCODE_OPERATOR_INT;
+			default:
+				return GDScriptFunction::OPCODE_OPERATOR;
+		}
+	}
+
+	bool num_a = int_a || _is_builtin_datatype(p_a, Variant::REAL);
+	bool num_b = int_b || _is_builtin_datatype(p_b, Variant::REAL);
+
+	if (num_a && num_b) {
+		switch (p_op) {
+			case Variant::OP_ADD:
+			case Variant::OP_SUBTRACT:
+			case Variant::OP_MULTIPLY:
+			case Variant::OP_DIVIDE:
+			case Variant::OP_NEGATE:
+			case Variant::OP_POSITIVE:
+			case Variant::OP_EQUAL:
+			case Variant::OP_NOT_EQUAL:
+			case Variant::OP_LESS:
+			case Variant::OP_LESS_EQUAL:
+			case Variant::OP_GREATER:
+			case Variant::OP_GREATER_EQUAL:
+				return GDScriptFunction::OPCODE_OPERATOR_REAL;
+			default:
+				break;
+		}
+	}
+
+	return GDScriptFunction::OPCODE_OPERATOR;
+}
+
+int GDScriptCompiler::_get_vector_axis(const GDScriptParser::Node *p_base, const StringName &p_name) const {
+
+	int axes;
+	const GDScriptParser::DataType base_type = p_base->get_datatype();
+	if (_is_builtin_datatype(base_type, Variant::VECTOR2)) {
+		axes = 2;
+	} else if (_is_builtin_datatype(base_type, Variant::VECTOR3)) {
+		axes = 3;
+	} else {
+		return -1;
+	}
+
+	static const char *axis_names[3] = { "x", "y", "z" };
+	for (int i = 0; i < axes; i++) {
+		if (p_name == axis_names[i]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+MethodBind *GDScriptCompiler::_get_native_method(CodeGen &codegen, const GDScriptParser::Node *p_base, const StringName &p_method, void **r_class_ptr) const {
+
+	StringName native_type;
+	if (p_base->type == GDScriptParser::Node::TYPE_SELF) {
+		if (!codegen.script || !codegen.function_node || codegen.function_node->_static) {
+			return NULL;
+		}
+		native_type = codegen.script->get_instance_base_type();
+	} else {
+		const GDScriptParser::DataType base_type = p_base->get_datatype();
+		if (!base_type.has_type || base_type.is_meta_type || base_type.kind == GDScriptParser::DataType::BUILTIN) {
+			return NULL;
+		}
+		native_type = _gdtype_from_datatype(base_type).native_type;
+	}
+
+	if (native_type == StringName() || !ClassDB::class_exists(native_type)) {
+		return NULL;
+	}
+
+	// Scripts and a few platform classes override Object::call() to expose
+	// their own methods, those calls must keep going through the method name.
+	if (ClassDB::is_parent_class(native_type, "Script") || ClassDB::is_parent_class("Script", native_type) || ClassDB::is_parent_class(native_type, "JavaClass") || ClassDB::is_parent_class(native_type, "JavaObject")) {
+		return NULL;
+	}
+
+	MethodBind *method = ClassDB::get_method(native_type, p_method);
+	if (!method) {
+		return NULL;
+	}
+
+	*r_class_ptr = ClassDB::get_class_ptr(method->get_instance_class());
+	return *r_class_ptr ? method : NULL;
+}
+
 int GDScriptCompiler::_parse_assign_right_expression(CodeGen &codegen, const GDScriptParser::OperatorNode *p_expression, int p_stack_level) {
 
 	Variant::Operator var_op = Variant::OP_MAX;
@@ -620,10 +743,6 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 
 						const GDScriptParser::Node *instance = on->arguments[0];
 
-						if (instance->type == GDScriptParser::Node::TYPE_SELF) {
-							//room for optimization
-						}
-
 						Vector<int> arguments;
 						int slevel = p_stack_level;
 
@@ -656,7 +775,15 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 							arguments.push_back(ret);
 						}
 
-						codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL : GDScriptFunction::OPCODE_CALL_RETURN); // perform operator
+						void *class_ptr = NULL;
+						MethodBind *native_method = _get_native_method(codegen, instance, static_cast<GDScriptParser::IdentifierNode *>(on->arguments[1])->name, &class_ptr);
+						if (native_method) {
+							// Method known from the static type of the base, call the bind directly.
+							arguments.write[1] = codegen.get_native_method_pos(native_method, class_ptr);
+							codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL_METHOD_BIND : GDScriptFunction::OPCODE_CALL_METHOD_BIND_RETURN);
+						} else {
+							codegen.opcodes.push_back(p_root ? GDScriptFunction::OPCODE_CALL : GDScriptFunction::OPCODE_CALL_RETURN); // perform operator
+						}
 						codegen.opcodes.push_back(on->arguments.size() - 2);
 						codegen.alloc_call(on->arguments.size() - 2);
 						for (int i = 0; i < arguments.size(); i++)
@@ -747,6 +874,19 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						}
 					}
 
+					int axis = on->op == GDScriptParser::OperatorNode::OP_INDEX_NAMED ? _get_vector_axis(on->arguments[0], static_cast<GDScriptParser::IdentifierNode *>(on->arguments[1])->name) : -1;
+					if (axis >= 0) {
+						// x/y/z of a Vector2 or Vector3, the axis goes after the destination.
+						int dst_addr = (p_stack_level) | (GDScriptFunction::ADDR_TYPE_STACK << GDScriptFunction::ADDR_BITS);
+						codegen.opcodes.push_back(GDScriptFunction::OPCODE_GET_NAMED_VECTOR);
+						codegen.opcodes.push_back(from);
+						codegen.opcodes.push_back(index);
+						codegen.opcodes.push_back(dst_addr);
+						codegen.opcodes.push_back(axis);
+						codegen.alloc_stack(p_stack_level);
+						return dst_addr;
+					}
+
 					codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_GET_NAMED : GDScriptFunction::OPCODE_GET); // perform operator
 					codegen.opcodes.push_back(from); // argument 1
 					codegen.opcodes.push_back(index); // argument 2 (unary only takes one parameter)
@@ -1072,11 +1212,13 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 
 						int set_index;
 						bool named = false;
+						int set_axis = -1;
 
 						if (static_cast<const GDScriptParser::OperatorNode *>(op)->op == GDScriptParser::OperatorNode::OP_INDEX_NAMED) {
 
 							set_index = codegen.get_name_map_pos(static_cast<const GDScriptParser::IdentifierNode *>(op->arguments[1])->name);
 							named = true;
+							set_axis = _get_vector_axis(op->arguments[0], static_cast<const GDScriptParser::IdentifierNode *>(op->arguments[1])->name);
 						} else {
 
 							set_index = _parse_expression(codegen, op->arguments[1], slevel + 1);
@@ -1095,10 +1237,18 @@ int GDScriptCompiler::_parse_expression(CodeGen &codegen, const GDScriptParser::
 						if (set_value < 0) //error
 							return set_value;
 
-						codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_SET_NAMED : GDScriptFunction::OPCODE_SET);
-						codegen.opcodes.push_back(prev_pos);
-						codegen.opcodes.push_back(set_index);
-						codegen.opcodes.push_back(set_value);
+						if (set_axis >= 0) {
+							codegen.opcodes.push_back(GDScriptFunction::OPCODE_SET_NAMED_VECTOR);
+							codegen.opcodes.push_back(prev_pos);
+							codegen.opcodes.push_back(set_index);
+							codegen.opcodes.push_back(set_value);
+							codegen.opcodes.push_back(set_axis);
+						} else {
+							codegen.opcodes.push_back(named ? GDScriptFunction::OPCODE_SET_NAMED : GDScriptFunction::OPCODE_SET);
+							codegen.opcodes.push_back(prev_pos);
+							codegen.opcodes.push_back(set_index);
+							codegen.opcodes.push_back(set_value);
+						}
 
 						for (int i = 0; i < setchain.size(); i++) {
 
@@ -1660,6 +1810,17 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 
 	codegen.opcodes.push_back(GDScriptFunction::OPCODE_END);
 
+	//constants
+	Vector<Variant> constants;
+	constants.resize(codegen.constant_map.size());
+	const Variant *K = NULL;
+	while ((K = codegen.constant_map.next(K))) {
+		constants.write[codegen.constant_map[*K]] = *K;
+	}
+
+	GDScriptOptimizer optimizer;
+	optimizer.optimize(codegen.opcodes, defarg_addr, constants);
+
 	/*
 	if (String(p_func->name)=="") { //initializer func
 		gdfunc = &p_script->initializer;
@@ -1690,15 +1851,10 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 	gdfunc->arg_names = argnames;
 #endif
 	//constants
-	if (codegen.constant_map.size()) {
-		gdfunc->_constant_count = codegen.constant_map.size();
-		gdfunc->constants.resize(codegen.constant_map.size());
+	if (constants.size()) {
+		gdfunc->constants = constants;
+		gdfunc->_constant_count = constants.size();
 		gdfunc->_constants_ptr = gdfunc->constants.ptrw();
-		const Variant *K = NULL;
-		while ((K = codegen.constant_map.next(K))) {
-			int idx = codegen.constant_map[*K];
-			gdfunc->constants.write[idx] = *K;
-		}
 	} else {
 
 		gdfunc->_constants_ptr = NULL;
@@ -1720,6 +1876,17 @@ Error GDScriptCompiler::_parse_function(GDScript *p_script, const GDScriptParser
 		gdfunc->_global_names_count = 0;
 	}
 
+	//native methods
+	if (codegen.native_methods.size()) {
+
+		gdfunc->native_methods = codegen.native_methods;
+		gdfunc->_native_methods_ptr = gdfunc->native_methods.ptr();
+		gdfunc->_native_methods_count = gdfunc->native_methods.size();
+	} else {
+		gdfunc->_native_methods_ptr = NULL;
+		gdfunc->_native_methods_count = 0;
+	}
+
 #ifdef TOOLS_ENABLED
 	// Named globals
 	if (codegen.named_globals.size()) {
@@ -121,6 +121,22 @@ class GDScriptCompiler {
 			return pos;
 		}
 
+		Vector<GDScriptFunction::NativeMethod> native_methods;
+		Map<MethodBind *, int> native_method_map;
+
+		int get_native_method_pos(MethodBind *p_method, void *p_class_ptr) {
+			if (native_method_map.has(p_method))
+				return native_method_map[p_method];
+			GDScriptFunction::NativeMethod nm;
+			nm.method = p_method;
+			nm.class_ptr = p_class_ptr;
+			nm.name = p_method->get_name();
+			int pos = native_methods.size();
+			native_methods.push_back(nm);
+			native_method_map[p_method] = pos;
+			return pos;
+		}
+
 		Vector<int> opcodes;
 		void alloc_stack(int p_level) {
 			if (p_level >= stack_max) stack_max = p_level + 1;
@@ -143,6 +159,9 @@ class GDScriptCompiler {
 	bool _create_binary_operator(CodeGen &codegen, const GDScriptParser::OperatorNode *on, Variant::Operator op, int p_stack_level, bool p_initializer = false);
 
 	GDScriptDataType _gdtype_from_datatype(const GDScriptParser::DataType &p_datatype) const;
+	GDScriptFunction::Opcode _get_operator_opcode(Variant::Operator p_op, const GDScriptParser::DataType &p_a, const GDScriptParser::DataType &p_b) const;
+	int _get_vector_axis(const GDScriptParser::Node *p_base, const StringName &p_name) const;
+	MethodBind *_get_native_method(CodeGen &codegen, const GDScriptParser::Node *p_base, const StringName &p_method, void **r_class_ptr) const;
 
 	int _parse_assign_right_expression(CodeGen &codegen, const GDScriptParser::OperatorNode *p_expression, int p_stack_level);
 	int _parse_expression(CodeGen &codegen, const GDScriptParser::Node *p_expression, int p_stack_level, bool p_root = false, bool p_initializer = false);
@@ -31,6 +31,7 @@
 #include "gdscript_function.h"
 
 #include "core/os/os.h"
+#include "core/variant_internal.h"
 #include "gdscript.h"
 #include "gdscript_functions.h"
 
@@ -187,12 +188,16 @@ static String _get_var_type(const Variant *p_type) {
 #define OPCODES_TABLE                         \
 	static const void *switch_table_ops[] = { \
 		&&OPCODE_OPERATOR,                    \
+		&&OPCODE_OPERATOR_INT,                \
+		&&OPCODE_OPERATOR_REAL,               \
 		&&OPCODE_EXTENDS_TEST,                \
 		&&OPCODE_IS_BUILTIN,                  \
 		&&OPCODE_SET,                         \
 		&&OPCODE_GET,                         \
 		&&OPCODE_SET_NAMED,                   \
 		&&OPCODE_GET_NAMED,                   \
+		&&OPCODE_SET_NAMED_VECTOR,            \
+		&&OPCODE_GET_NAMED_VECTOR,            \
 		&&OPCODE_SET_MEMBER,                  \
 		&&OPCODE_GET_MEMBER,                  \
 		&&OPCODE_ASSIGN,                      \
@@ -209,6 +214,8 @@ static String _get_var_type(const Variant *p_type) {
 		&&OPCODE_CONSTRUCT_DICTIONARY,        \
 		&&OPCODE_CALL,                        \
 		&&OPCODE_CALL_RETURN,                 \
+		&&OPCODE_CALL_METHOD_BIND,            \
+		&&OPCODE_CALL_METHOD_BIND_RETURN,     \
 		&&OPCODE_CALL_BUILT_IN,               \
 		&&OPCODE_CALL_SELF,                   \
 		&&OPCODE_CALL_SELF_BASE,              \
@@ -251,6 +258,89 @@ static String _get_var_type(const Variant *p_type) {
 #define OPCODE_OUT break
 #endif
 
+// Fast paths for OPCODE_OPERATOR_INT and OPCODE_OPERATOR_REAL. They return false
+// when the operation must go through Variant::evaluate() instead (unsupported
+// operator, division by zero), so errors are still reported the usual way.
+
+static _FORCE_INLINE_ bool _evaluate_int(Variant::Operator p_op, int64_t a, int64_t b, Variant *r_dst) {
+
+	switch (p_op) {
+		case Variant::OP_ADD: VariantInternal::set_int(r_dst, a + b); return true;
+		case Variant::OP_SUBTRACT: VariantInternal::set_int(r_dst, a - b); return true;
+		case Variant::OP_MULTIPLY: VariantInternal::set_int(r_dst, a * b); return true;
+		case Variant::OP_DIVIDE: {
+			if (b == 0)
+				return false;
+			VariantInternal::set_int(r_dst, a / b);
+			return true;
+		}
+		case Variant::OP_MODULE: {
+			if (b == 0)
+				return false;
+			VariantInternal::set_int(r_dst, a % b);
+			return true;
+		}
+		case Variant::OP_NEGATE: VariantInternal::set_int(r_dst, -a); return true;
+		case Variant::OP_POSITIVE: VariantInternal::set_int(r_dst, a); return true;
+		case Variant::OP_SHIFT_LEFT: VariantInternal::set_int(r_dst, a << b); return true;
+		case Variant::OP_SHIFT_RIGHT: VariantInternal::set_int(r_dst, a >> b); return true;
+		case Variant::OP_BIT_AND: VariantInternal::set_int(r_dst, a & b); return true;
+		case Variant::OP_BIT_OR: VariantInternal::set_int(r_dst, a | b); return true;
+		case Variant::OP_BIT_XOR: VariantInternal::set_int(r_dst, a ^ b); return true;
+		case Variant::OP_BIT_NEGATE: VariantInternal::set_int(r_dst, ~a); return true;
+		case Variant::OP_EQUAL: VariantInternal::set_bool(r_dst, a == b); return true;
+		case Variant::OP_NOT_EQUAL: VariantInternal::set_bool(r_dst, a != b); return true;
+		case Variant::OP_LESS: VariantInternal::set_bool(r_dst, a < b); return true;
+		case Variant::OP_LESS_EQUAL: VariantInternal::set_bool(r_dst, a <= b); return true;
+		case Variant::OP_GREATER: VariantInternal::set_bool(r_dst, a > b); return true;
+		case Variant::OP_GREATER_EQUAL: VariantInternal::set_bool(r_dst, a >= b); return true;
+		default: return false;
+	}
+}
+
+static _FORCE_INLINE_ bool _evaluate_real(Variant::Operator p_op, double a, double b, Variant *r_dst) {
+
+	switch (p_op) {
+		case Variant::OP_ADD: VariantInternal::set_real(r_dst, a + b); return true;
+		case Variant::OP_SUBTRACT: VariantInternal::set_real(r_dst, a - b); return true;
+		case Variant::OP_MULTIPLY: VariantInternal::set_real(r_dst, a * b); return true;
+		case Variant::OP_DIVIDE: {
+			if (b == 0)
+				return false;
+			VariantInternal::set_real(r_dst, a / b);
+			return true;
+		}
+		case Variant::OP_NEGATE: VariantInternal::set_real(r_dst, -a); return true;
+		case Variant::OP_POSITIVE: VariantInternal::set_real(r_dst, a); return true;
+		case Variant::OP_EQUAL: VariantInternal::set_bool(r_dst, a == b); return true;
+		case Variant::OP_NOT_EQUAL: VariantInternal::set_bool(r_dst, a != b); return true;
+		case Variant::OP_LESS: VariantInternal::set_bool(r_dst, a < b); return true;
+		case Variant::OP_LESS_EQUAL: VariantInternal::set_bool(r_dst, a <= b); return true;
+		case Variant::OP_GREATER: VariantInternal::set_bool(r_dst, a > b); return true;
+		case Variant::OP_GREATER_EQUAL: VariantInternal::set_bool(r_dst, a >= b); return true;
+		default: return false;
+	}
+}
+
+// Returns the object OPCODE_CALL_METHOD_BIND can call directly, or NULL if the
+// call has to be dispatched by name (not an object of the expected class, null
+// or freed instance).
+
+static _FORCE_INLINE_ Object *_get_method_bind_target(const Variant *p_base, const GDScriptFunction::NativeMethod *p_method) {
+
+	if (p_base->get_type() != Variant::OBJECT)
+		return NULL;
+
+	Object *obj = VariantInternal::get_object(p_base);
+	if (!obj)
+		return NULL;
+#ifdef DEBUG_ENABLED
+	if (ScriptDebugger::get_singleton() && !VariantInternal::is_object_reference(p_base) && !ObjectDB::instance_validate(obj))
+		return NULL;
+#endif
+	return obj->is_class_ptr(p_method->class_ptr) ? obj : NULL;
+}
+
 Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_args, int p_argcount, Variant::CallError &r_err, CallState *p_state) {
 
 	OPCODES_TABLE;
@@ -339,9 +429,9 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 							return Variant();
 						}
 					}
-					if (argument_types[i].kind == GDScriptDataType::BUILTIN) {
-						Variant arg = Variant::construct(argument_types[i].builtin_type, &p_args[i], 1, r_err);
-						memnew_placement(&stack[i], Variant(arg));
+					if (argument_types[i].kind == GDScriptDataType::BUILTIN && p_args[i]->get_type() != argument_types[i].builtin_type) {
+						// Only implicit conversions need a construct, exact types are copied.
+						memnew_placement(&stack[i], Variant(Variant::construct(argument_types[i].builtin_type, &p_args[i], 1, r_err)));
 					} else {
 						memnew_placement(&stack[i], Variant(*p_args[i]));
 					}
@@ -381,9 +471,14 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 	String err_text;
 
+	// Read once, so the exit bookkeeping always matches what was done on entry.
+	const bool debugging = ScriptDebugger::get_singleton() != NULL;
+
 #ifdef DEBUG_ENABLED
 
-	if (ScriptDebugger::get_singleton())
+	const bool profiling = GDScriptLanguage::get_singleton()->profiling;
+
+	if (debugging)
 		GDScriptLanguage::get_singleton()->enter_function(p_instance, this, stack, &ip, &line);
 
 #define GD_ERR_BREAK(m_cond)                                                                                           \
@@ -418,7 +513,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 	uint64_t function_start_time = 0;
 	uint64_t function_call_time = 0;
 
-	if (GDScriptLanguage::get_singleton()->profiling) {
+	if (profiling) {
 		function_start_time = OS::get_singleton()->get_ticks_usec();
 		function_call_time = 0;
 		profile.call_count++;
@@ -436,6 +531,8 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 		OPCODE_SWITCH(_code_ptr[ip]) {
 
+			OPCODE(OPCODE_OPERATOR_INT)
+			OPCODE(OPCODE_OPERATOR_REAL)
 			OPCODE(OPCODE_OPERATOR) {
 
 				CHECK_SPACE(5);
@@ -448,6 +545,21 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_VARIANT_PTR(b, 3);
 				GET_VARIANT_PTR(dst, 4);
 
+				// Typed variants are emitted when the parser knows both operands
+				// are numbers. The types are still checked here, anything
+				// unexpected falls back to Variant::evaluate().
+				if (_code_ptr[ip] == OPCODE_OPERATOR_INT) {
+					if (likely(a->get_type() == Variant::INT && b->get_type() == Variant::INT) && _evaluate_int(op, VariantInternal::get_int(a), VariantInternal::get_int(b), dst)) {
+						ip += 5;
+						DISPATCH_OPCODE;
+					}
+				} else if (_code_ptr[ip] == OPCODE_OPERATOR_REAL) {
+					if (likely(a->is_num() && b->is_num() && (a->get_type() == Variant::REAL || b->get_type() == Variant::REAL)) && _evaluate_real(op, VariantInternal::get_number(a), VariantInternal::get_number(b), dst)) {
+						ip += 5;
+						DISPATCH_OPCODE;
+					}
+				}
+
 #ifdef DEBUG_ENABLED
 
 				Variant ret;
@@ -611,6 +723,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_SET_NAMED_VECTOR)
 			OPCODE(OPCODE_SET_NAMED) {
 
 				CHECK_SPACE(3);
@@ -618,6 +731,23 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_VARIANT_PTR(dst, 1);
 				GET_VARIANT_PTR(value, 3);
 
+				int ip_ofs = 4;
+				if (_code_ptr[ip] == OPCODE_SET_NAMED_VECTOR) {
+					// x/y/z of a base typed as Vector2 or Vector3, the axis follows the regular operands.
+					CHECK_SPACE(4);
+					int axis = _code_ptr[ip + 4];
+					if (dst->get_type() == Variant::VECTOR2 && axis < 2 && value->is_num()) {
+						(*VariantInternal::get_vector2(dst))[axis] = VariantInternal::get_number(value);
+						ip += 5;
+						DISPATCH_OPCODE;
+					} else if (dst->get_type() == Variant::VECTOR3 && axis < 3 && value->is_num()) {
+						(*VariantInternal::get_vector3(dst))[axis] = VariantInternal::get_number(value);
+						ip += 5;
+						DISPATCH_OPCODE;
+					}
+					ip_ofs = 5;
+				}
+
 				int indexname = _code_ptr[ip + 2];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
@@ -633,10 +763,11 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					OPCODE_BREAK;
 				}
 #endif
-				ip += 4;
+				ip += ip_ofs;
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_GET_NAMED_VECTOR)
 			OPCODE(OPCODE_GET_NAMED) {
 
 				CHECK_SPACE(4);
@@ -644,6 +775,23 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				GET_VARIANT_PTR(src, 1);
 				GET_VARIANT_PTR(dst, 3);
 
+				int ip_ofs = 4;
+				if (_code_ptr[ip] == OPCODE_GET_NAMED_VECTOR) {
+					// x/y/z of a base typed as Vector2 or Vector3, the axis follows the regular operands.
+					CHECK_SPACE(5);
+					int axis = _code_ptr[ip + 4];
+					if (src->get_type() == Variant::VECTOR2 && axis < 2) {
+						VariantInternal::set_real(dst, (*VariantInternal::get_vector2(src))[axis]);
+						ip += 5;
+						DISPATCH_OPCODE;
+					} else if (src->get_type() == Variant::VECTOR3 && axis < 3) {
+						VariantInternal::set_real(dst, (*VariantInternal::get_vector3(src))[axis]);
+						ip += 5;
+						DISPATCH_OPCODE;
+					}
+					ip_ofs = 5;
+				}
+
 				int indexname = _code_ptr[ip + 2];
 
 				GD_ERR_BREAK(indexname < 0 || indexname >= _global_names_count);
@@ -668,7 +816,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				}
 				*dst = ret;
 #endif
-				ip += 4;
+				ip += ip_ofs;
 			}
 			DISPATCH_OPCODE;
 
@@ -1034,18 +1182,30 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 			}
 			DISPATCH_OPCODE;
 
+			OPCODE(OPCODE_CALL_METHOD_BIND_RETURN)
+			OPCODE(OPCODE_CALL_METHOD_BIND)
 			OPCODE(OPCODE_CALL_RETURN)
 			OPCODE(OPCODE_CALL) {
 
 				CHECK_SPACE(4);
-				bool call_ret = _code_ptr[ip] == OPCODE_CALL_RETURN;
+				bool call_ret = _code_ptr[ip] == OPCODE_CALL_RETURN || _code_ptr[ip] == OPCODE_CALL_METHOD_BIND_RETURN;
 
 				int argc = _code_ptr[ip + 1];
 				GET_VARIANT_PTR(base, 2);
-				int nameg = _code_ptr[ip + 3];
 
-				GD_ERR_BREAK(nameg < 0 || nameg >= _global_names_count);
-				const StringName *methodname = &_global_names_ptr[nameg];
+				const StringName *methodname;
+				const NativeMethod *native_method = NULL;
+				if (_code_ptr[ip] == OPCODE_CALL_METHOD_BIND || _code_ptr[ip] == OPCODE_CALL_METHOD_BIND_RETURN) {
+					// Method bind resolved by the compiler from the static type of the base.
+					int nativeg = _code_ptr[ip + 3];
+					GD_ERR_BREAK(nativeg < 0 || nativeg >= _native_methods_count);
+					native_method = &_native_methods_ptr[nativeg];
+					methodname = &native_method->name;
+				} else {
+					int nameg = _code_ptr[ip + 3];
+					GD_ERR_BREAK(nameg < 0 || nameg >= _global_names_count);
+					methodname = &_global_names_ptr[nameg];
+				}
 
 				GD_ERR_BREAK(argc < 0);
 				ip += 4;
@@ -1060,13 +1220,21 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 #ifdef DEBUG_ENABLED
 				uint64_t call_time = 0;
 
-				if (GDScriptLanguage::get_singleton()->profiling) {
+				if (profiling) {
 					call_time = OS::get_singleton()->get_ticks_usec();
 				}
 
 #endif
 				Variant::CallError err;
-				if (call_ret) {
+				Object *native_obj = native_method ? _get_method_bind_target(base, native_method) : NULL;
+				if (native_obj) {
+
+					Variant native_ret = native_obj->call_method_bind(native_method->method, (const Variant **)argptrs, argc, err);
+					if (call_ret && err.error == Variant::CallError::CALL_OK) {
+						GET_VARIANT_PTR(ret, argc);
+						*ret = native_ret;
+					}
+				} else if (call_ret) {
 
 					GET_VARIANT_PTR(ret, argc);
 					base->call_ptr(*methodname, (const Variant **)argptrs, argc, ret, err);
@@ -1075,7 +1243,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 					base->call_ptr(*methodname, (const Variant **)argptrs, argc, NULL, err);
 				}
 #ifdef DEBUG_ENABLED
-				if (GDScriptLanguage::get_singleton()->profiling) {
+				if (profiling) {
 					function_call_time += OS::get_singleton()->get_ticks_usec() - call_time;
 				}
 
@@ -1428,7 +1596,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 						OPCODE_BREAK;
 					}
 #endif
-					ip += 5; //skip regular iterate which is always next
+					ip += 5; //go on with the next instruction, which jumps to the loop body
 				}
 			}
 			DISPATCH_OPCODE;
@@ -1500,7 +1668,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 				line = _code_ptr[ip + 1];
 				ip += 2;
 
-				if (ScriptDebugger::get_singleton()) {
+				if (unlikely(debugging)) {
 					// line
 					bool do_break = false;
 
@@ -1574,7 +1742,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 
 	OPCODES_OUT
 #ifdef DEBUG_ENABLED
-	if (GDScriptLanguage::get_singleton()->profiling) {
+	if (profiling) {
 		uint64_t time_taken = OS::get_singleton()->get_ticks_usec() - function_start_time;
 		profile.total_time += time_taken;
 		profile.self_time += time_taken - function_call_time;
@@ -1583,7 +1751,7 @@ Variant GDScriptFunction::call(GDScriptInstance *p_instance, const Variant **p_a
 		GDScriptLanguage::get_singleton()->script_frame_time += time_taken - function_call_time;
 	}
 
-	if (ScriptDebugger::get_singleton())
+	if (debugging)
 		GDScriptLanguage::get_singleton()->exit_function();
 #endif
 
@@ -1617,6 +1785,12 @@ StringName GDScriptFunction::get_global_name(int p_idx) const {
 	return global_names[p_idx];
 }
 
+StringName GDScriptFunction::get_native_method_name(int p_idx) const {
+
+	ERR_FAIL_INDEX_V(p_idx, native_methods.size(), "<errnmethod>");
+	return native_methods[p_idx].name;
+}
+
 int GDScriptFunction::get_default_argument_count() const {
 
 	return _default_arg_count;
@@ -1646,6 +1820,70 @@ int GDScriptFunction::get_max_stack_size() const {
 	return _stack_size;
 }
 
+int GDScriptFunction::get_opcode_size(const int *p_code, int p_ip) {
+
+	switch (p_code[p_ip]) {
+		case OPCODE_OPERATOR:
+		case OPCODE_OPERATOR_INT:
+		case OPCODE_OPERATOR_REAL:
+		case OPCODE_SET_NAMED_VECTOR:
+		case OPCODE_GET_NAMED_VECTOR:
+		case OPCODE_ITERATE_BEGIN:
+		case OPCODE_ITERATE:
+			return 5;
+		case OPCODE_EXTENDS_TEST:
+		case OPCODE_IS_BUILTIN:
+		case OPCODE_SET:
+		case OPCODE_GET:
+		case OPCODE_SET_NAMED:
+		case OPCODE_GET_NAMED:
+		case OPCODE_ASSIGN_TYPED_BUILTIN:
+		case OPCODE_ASSIGN_TYPED_NATIVE:
+		case OPCODE_ASSIGN_TYPED_SCRIPT:
+		case OPCODE_CAST_TO_BUILTIN:
+		case OPCODE_CAST_TO_NATIVE:
+		case OPCODE_CAST_TO_SCRIPT:
+			return 4;
+		case OPCODE_SET_MEMBER:
+		case OPCODE_GET_MEMBER:
+		case OPCODE_ASSIGN:
+		case OPCODE_JUMP_IF:
+		case OPCODE_JUMP_IF_NOT:
+		case OPCODE_YIELD_SIGNAL:
+			return 3;
+		case OPCODE_ASSIGN_TRUE:
+		case OPCODE_ASSIGN_FALSE:
+		case OPCODE_YIELD_RESUME:
+		case OPCODE_JUMP:
+		case OPCODE_RETURN:
+		case OPCODE_ASSERT:
+		case OPCODE_LINE:
+			return 2;
+		case OPCODE_CALL_SELF:
+		case OPCODE_YIELD:
+		case OPCODE_JUMP_TO_DEF_ARGUMENT:
+		case OPCODE_BREAKPOINT:
+		case OPCODE_END:
+			return 1;
+		case OPCODE_CONSTRUCT:
+			return 4 + p_code[p_ip + 2];
+		case OPCODE_CONSTRUCT_ARRAY:
+			return 3 + p_code[p_ip + 1];
+		case OPCODE_CONSTRUCT_DICTIONARY:
+			return 3 + p_code[p_ip + 1] * 2;
+		case OPCODE_CALL:
+		case OPCODE_CALL_RETURN:
+		case OPCODE_CALL_METHOD_BIND:
+		case OPCODE_CALL_METHOD_BIND_RETURN:
+			return 5 + p_code[p_ip + 1];
+		case OPCODE_CALL_BUILT_IN:
+		case OPCODE_CALL_SELF_BASE:
+			return 4 + p_code[p_ip + 2];
+		default:
+			ERR_FAIL_V(-1);
+	}
+}
+
 struct _GDFKC {
 
 	int order;
@@ -1721,6 +1959,8 @@ GDScriptFunction::GDScriptFunction() :
 
 	_stack_size = 0;
 	_call_size = 0;
+	_native_methods_ptr = NULL;
+	_native_methods_count = 0;
 	rpc_mode = MultiplayerAPI::RPC_MODE_DISABLED;
 	name = "<anonymous>";
 #ifdef DEBUG_ENABLED
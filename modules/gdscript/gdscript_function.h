@@ -148,12 +148,16 @@ class GDScriptFunction {
 public:
 	enum Opcode {
 		OPCODE_OPERATOR,
+		OPCODE_OPERATOR_INT,
+		OPCODE_OPERATOR_REAL,
 		OPCODE_EXTENDS_TEST,
 		OPCODE_IS_BUILTIN,
 		OPCODE_SET,
 		OPCODE_GET,
 		OPCODE_SET_NAMED,
 		OPCODE_GET_NAMED,
+		OPCODE_SET_NAMED_VECTOR,
+		OPCODE_GET_NAMED_VECTOR,
 		OPCODE_SET_MEMBER,
 		OPCODE_GET_MEMBER,
 		OPCODE_ASSIGN,
@@ -170,6 +174,8 @@ public:
 		OPCODE_CONSTRUCT_DICTIONARY,
 		OPCODE_CALL,
 		OPCODE_CALL_RETURN,
+		OPCODE_CALL_METHOD_BIND,
+		OPCODE_CALL_METHOD_BIND_RETURN,
 		OPCODE_CALL_BUILT_IN,
 		OPCODE_CALL_SELF,
 		OPCODE_CALL_SELF_BASE,
@@ -213,6 +219,16 @@ public:
 		StringName identifier;
 	};
 
+	// Native method resolved by the compiler for OPCODE_CALL_METHOD_BIND.
+	struct NativeMethod {
+
+		MethodBind *method;
+		void *class_ptr; // class the method is bound to, tested with Object::is_class_ptr()
+		StringName name;
+	};
+
+	static int get_opcode_size(const int *p_code, int p_ip);
+
 private:
 	friend class GDScriptCompiler;
 
@@ -227,6 +243,8 @@ private:
 	const StringName *_named_globals_ptr;
 	int _named_globals_count;
 #endif
+	const NativeMethod *_native_methods_ptr;
+	int _native_methods_count;
 	const int *_default_arg_ptr;
 	int _default_arg_count;
 	const int *_code_ptr;
@@ -246,6 +264,7 @@ private:
 #ifdef TOOLS_ENABLED
 	Vector<StringName> named_globals;
 #endif
+	Vector<NativeMethod> native_methods;
 	Vector<int> default_arguments;
 	Vector<int> code;
 	Vector<GDScriptDataType> argument_types;
@@ -304,6 +323,7 @@ public:
 	int get_code_size() const;
 	Variant get_constant(int p_idx) const;
 	StringName get_global_name(int p_idx) const;
+	StringName get_native_method_name(int p_idx) const;
 	StringName get_name() const;
 	int get_max_stack_size() const;
 	int get_default_argument_count() const;
@@ -0,0 +1,376 @@
+/*************************************************************************/
+/*  gdscript_optimizer.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "gdscript_optimizer.h"
+
+int GDScriptOptimizer::_get_jump_offset(int p_opcode) {
+
+	switch (p_opcode) {
+		case GDScriptFunction::OPCODE_JUMP:
+			return 1;
+		case GDScriptFunction::OPCODE_JUMP_IF:
+		case GDScriptFunction::OPCODE_JUMP_IF_NOT:
+			return 2;
+		case GDScriptFunction::OPCODE_ITERATE_BEGIN:
+		case GDScriptFunction::OPCODE_ITERATE:
+			return 3;
+		default:
+			return -1;
+	}
+}
+
+bool GDScriptOptimizer::_is_constant_address(int p_address) {
+
+	return ((p_address & GDScriptFunction::ADDR_TYPE_MASK) >> GDScriptFunction::ADDR_BITS) == GDScriptFunction::ADDR_TYPE_LOCAL_CONSTANT;
+}
+
+int GDScriptOptimizer::_next_instruction(int p_index) const {
+
+	// Removed instructions behave as no-ops, the last one (OPCODE_END) is never removed.
+	while (p_index < instructions.size() - 1 && instructions[p_index].removed) {
+		p_index++;
+	}
+	return p_index;
+}
+
+bool GDScriptOptimizer::_is_same_constant(const Variant &p_a, const Variant &p_b) {
+
+	if (p_a.get_type() != p_b.get_type()) {
+		return false;
+	}
+
+	switch (p_a.get_type()) {
+
+		case Variant::REAL: {
+
+			// hash_compare() treats -0.0 and 0.0 (and all NaNs) as equal, the bits tell them apart.
+			double a = p_a;
+			double b = p_b;
+			return memcmp(&a, &b, sizeof(double)) == 0;
+		}
+		case Variant::VECTOR2:
+		case Variant::RECT2:
+		case Variant::VECTOR3:
+		case Variant::TRANSFORM2D:
+		case Variant::PLANE:
+		case Variant::QUAT:
+		case Variant::AABB:
+		case Variant::BASIS:
+		case Variant::TRANSFORM:
+		case Variant::COLOR: {
+
+			return false; // Same issue for each component, rare enough to not be worth sharing.
+		}
+		default: {
+
+			return p_a.hash_compare(p_b);
+		}
+	}
+}
+
+int GDScriptOptimizer::_add_constant(Vector<Variant> &r_constants, const Variant &p_value) const {
+
+	for (int i = 0; i < r_constants.size(); i++) {
+		if (_is_same_constant(r_constants[i], p_value)) {
+			return i;
+		}
+	}
+	r_constants.push_back(p_value);
+	return r_constants.size() - 1;
+}
+
+bool GDScriptOptimizer::_fold_constants(Vector<Variant> &r_constants) {
+
+	bool changed = false;
+
+	for (int i = 0; i < instructions.size(); i++) {
+
+		Instruction &inst = instructions.write[i];
+		int opcode = inst.words[0];
+
+		if (opcode == GDScriptFunction::OPCODE_OPERATOR || opcode == GDScriptFunction::OPCODE_OPERATOR_INT || opcode == GDScriptFunction::OPCODE_OPERATOR_REAL) {
+
+			if (!_is_constant_address(inst.words[2]) || !_is_constant_address(inst.words[3])) {
+				continue;
+			}
+
+			const Variant &a = r_constants[inst.words[2] & GDScriptFunction::ADDR_MASK];
+			const Variant &b = r_constants[inst.words[3] & GDScriptFunction::ADDR_MASK];
+			// Arrays and dictionaries are shared, folding would make every call reuse the same instance.
+			if (a.get_type() == Variant::OBJECT || a.get_type() == Variant::ARRAY || a.get_type() == Variant::DICTIONARY || b.get_type() == Variant::OBJECT || b.get_type() == Variant::ARRAY || b.get_type() == Variant::DICTIONARY) {
+				continue;
+			}
+
+			Variant result;
+			bool valid;
+			Variant::evaluate((Variant::Operator)inst.words[1], a, b, result, valid);
+			if (!valid || result.get_type() == Variant::OBJECT || result.get_type() == Variant::ARRAY || result.get_type() == Variant::DICTIONARY) {
+				continue; // Leave it to fail at runtime, with the usual error.
+			}
+
+			int dst = inst.words[4];
+			inst.words.resize(3);
+			inst.words.write[0] = GDScriptFunction::OPCODE_ASSIGN;
+			inst.words.write[1] = dst;
+			inst.words.write[2] = _add_constant(r_constants, result) | (GDScriptFunction::ADDR_TYPE_LOCAL_CONSTANT << GDScriptFunction::ADDR_BITS);
+			changed = true;
+
+		} else if (opcode == GDScriptFunction::OPCODE_JUMP_IF || opcode == GDScriptFunction::OPCODE_JUMP_IF_NOT) {
+
+			if (!_is_constant_address(inst.words[1])) {
+				continue;
+			}
+
+			bool jump = r_constants[inst.words[1] & GDScriptFunction::ADDR_MASK].booleanize() == (opcode == GDScriptFunction::OPCODE_JUMP_IF);
+			if (jump) {
+				int target = inst.words[2];
+				inst.words.resize(2);
+				inst.words.write[0] = GDScriptFunction::OPCODE_JUMP;
+				inst.words.write[1] = target;
+			} else {
+				inst.removed = true;
+			}
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::_thread_jumps() {
+
+	bool changed = false;
+
+	for (int i = 0; i < instructions.size(); i++) {
+
+		if (instructions[i].removed) {
+			continue;
+		}
+
+		int ofs = _get_jump_offset(instructions[i].words[0]);
+		if (ofs < 0) {
+			continue;
+		}
+
+		int target = _next_instruction(instructions[i].words[ofs]);
+		// Bounded, in case of an endless loop made of jumps only.
+		for (int steps = 0; steps < instructions.size() && target != i && instructions[target].words[0] == GDScriptFunction::OPCODE_JUMP; steps++) {
+			target = _next_instruction(instructions[target].words[1]);
+		}
+
+		Instruction &inst = instructions.write[i];
+		if (inst.words[ofs] != target) {
+			inst.words.write[ofs] = target;
+			changed = true;
+		}
+
+		int target_opcode = instructions[target].words[0];
+		if (inst.words[0] == GDScriptFunction::OPCODE_JUMP && (target_opcode == GDScriptFunction::OPCODE_RETURN || target_opcode == GDScriptFunction::OPCODE_END)) {
+			inst.words = instructions[target].words;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::_remove_unreachable() {
+
+	Vector<bool> reached;
+	reached.resize(instructions.size());
+	for (int i = 0; i < reached.size(); i++) {
+		reached.write[i] = false;
+	}
+
+	Vector<int> pending;
+	pending.push_back(_next_instruction(0));
+	for (int i = 0; i < default_args.size(); i++) {
+		pending.push_back(_next_instruction(default_args[i]));
+	}
+
+	while (pending.size()) {
+
+		int idx = pending[pending.size() - 1];
+		pending.resize(pending.size() - 1);
+
+		if (reached[idx]) {
+			continue;
+		}
+		reached.write[idx] = true;
+
+		const Vector<int> &words = instructions[idx].words;
+		int ofs = _get_jump_offset(words[0]);
+		if (ofs >= 0) {
+			pending.push_back(_next_instruction(words[ofs]));
+		}
+
+		switch (words[0]) {
+			case GDScriptFunction::OPCODE_JUMP:
+			case GDScriptFunction::OPCODE_RETURN:
+			case GDScriptFunction::OPCODE_END:
+			case GDScriptFunction::OPCODE_CALL_SELF: {
+			} break;
+			case GDScriptFunction::OPCODE_JUMP_TO_DEF_ARGUMENT: {
+				// Successors are already in the roots.
+			} break;
+			default: {
+				// Also covers OPCODE_ITERATE_BEGIN and OPCODE_ITERATE, which go on
+				// with the next instruction when there is something to iterate.
+				if (idx + 1 < instructions.size()) {
+					pending.push_back(_next_instruction(idx + 1));
+				}
+			} break;
+		}
+	}
+
+	bool changed = false;
+	for (int i = 0; i < instructions.size() - 1; i++) {
+		if (!instructions[i].removed && !reached[i]) {
+			instructions.write[i].removed = true;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::_remove_jumps_to_next() {
+
+	bool changed = false;
+
+	for (int i = 0; i < instructions.size() - 1; i++) {
+
+		const Instruction &inst = instructions[i];
+		if (!inst.removed && inst.words[0] == GDScriptFunction::OPCODE_JUMP && _next_instruction(inst.words[1]) == _next_instruction(i + 1)) {
+			instructions.write[i].removed = true;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+bool GDScriptOptimizer::optimize(Vector<int> &r_code, Vector<int> &r_default_args, Vector<Variant> &r_constants) {
+
+	instructions.clear();
+	default_args.clear();
+
+	// Decode into instructions, jump targets become instruction indices.
+
+	Vector<int> index_at;
+	index_at.resize(r_code.size() + 1);
+	for (int i = 0; i < index_at.size(); i++) {
+		index_at.write[i] = -1;
+	}
+
+	int ip = 0;
+	while (ip < r_code.size()) {
+
+		int size = GDScriptFunction::get_opcode_size(r_code.ptr(), ip);
+		ERR_FAIL_COND_V(size <= 0 || ip + size > r_code.size(), false);
+
+		Instruction inst;
+		inst.words.resize(size);
+		for (int i = 0; i < size; i++) {
+			inst.words.write[i] = r_code[ip + i];
+		}
+		index_at.write[ip] = instructions.size();
+		instructions.push_back(inst);
+		ip += size;
+	}
+
+	ERR_FAIL_COND_V(instructions.empty() || instructions[instructions.size() - 1].words[0] != GDScriptFunction::OPCODE_END, false);
+
+	for (int i = 0; i < instructions.size(); i++) {
+
+		Instruction &inst = instructions.write[i];
+		int ofs = _get_jump_offset(inst.words[0]);
+		if (ofs < 0) {
+			continue;
+		}
+		int target = inst.words[ofs];
+		ERR_FAIL_INDEX_V(target, r_code.size(), false);
+		ERR_FAIL_COND_V(index_at[target] < 0, false);
+		inst.words.write[ofs] = index_at[target];
+	}
+
+	for (int i = 0; i < r_default_args.size(); i++) {
+		ERR_FAIL_INDEX_V(r_default_args[i], r_code.size(), false);
+		ERR_FAIL_COND_V(index_at[r_default_args[i]] < 0, false);
+		default_args.push_back(index_at[r_default_args[i]]);
+	}
+
+	// Optimize.
+
+	_fold_constants(r_constants);
+
+	bool changed = true;
+	for (int pass = 0; changed && pass < MAX_PASSES; pass++) {
+		changed = _thread_jumps();
+		changed = _remove_unreachable() || changed;
+		changed = _remove_jumps_to_next() || changed;
+	}
+
+	// Encode, removed instructions map to the address of the next kept one.
+
+	Vector<int> new_address;
+	new_address.resize(instructions.size());
+	int code_size = 0;
+	for (int i = 0; i < instructions.size(); i++) {
+		new_address.write[i] = code_size;
+		if (!instructions[i].removed) {
+			code_size += instructions[i].words.size();
+		}
+	}
+
+	r_code.resize(code_size);
+	int *w = r_code.ptrw();
+	for (int i = 0; i < instructions.size(); i++) {
+
+		const Instruction &inst = instructions[i];
+		if (inst.removed) {
+			continue;
+		}
+
+		int ofs = _get_jump_offset(inst.words[0]);
+		for (int j = 0; j < inst.words.size(); j++) {
+			*w++ = j == ofs ? new_address[inst.words[j]] : inst.words[j];
+		}
+	}
+
+	for (int i = 0; i < r_default_args.size(); i++) {
+		r_default_args.write[i] = new_address[default_args[i]];
+	}
+
+	instructions.clear();
+	default_args.clear();
+
+	return true;
+}
@@ -0,0 +1,76 @@
+/*************************************************************************/
+/*  gdscript_optimizer.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_OPTIMIZER_H
+#define GDSCRIPT_OPTIMIZER_H
+
+#include "gdscript_function.h"
+
+// Peephole pass run by the compiler on the bytecode of each function: folds
+// operators and conditional jumps on constants, threads jump chains and drops
+// unreachable code and jumps to the next instruction. Jump targets and default
+// argument addresses are remapped, the constant table may grow.
+
+class GDScriptOptimizer {
+
+	enum {
+		MAX_PASSES = 16 // Each pass leaves valid code, this only bounds compile time.
+	};
+
+	struct Instruction {
+
+		Vector<int> words;
+		bool removed;
+
+		Instruction() :
+				removed(false) {}
+	};
+
+	Vector<Instruction> instructions;
+	Vector<int> default_args; // instruction indices
+
+	static int _get_jump_offset(int p_opcode);
+	static bool _is_constant_address(int p_address);
+	static bool _is_same_constant(const Variant &p_a, const Variant &p_b);
+
+	int _next_instruction(int p_index) const;
+	int _add_constant(Vector<Variant> &r_constants, const Variant &p_value) const;
+
+	bool _fold_constants(Vector<Variant> &r_constants);
+	bool _thread_jumps();
+	bool _remove_unreachable();
+	bool _remove_jumps_to_next();
+
+public:
+	// Returns false (leaving everything untouched) if the code can't be decoded.
+	bool optimize(Vector<int> &r_code, Vector<int> &r_default_args, Vector<Variant> &r_constants);
+};
+
+#endif // GDSCRIPT_OPTIMIZER_H
@@ -101,6 +101,16 @@ int AudioStreamPlaybackOGGVorbis::get_loop_count() const {
 	return loops;
 }
 
+bool AudioStreamPlaybackOGGVorbis::is_looping() const {
+
+	return vorbis_stream->loop;
+}
+
+float AudioStreamPlaybackOGGVorbis::get_loop_begin() const {
+
+	return vorbis_stream->loop_offset;
+}
+
 float AudioStreamPlaybackOGGVorbis::get_playback_position() const {
 
 	return float(frames_mixed) / vorbis_stream->sample_rate;
@@ -33,6 +33,7 @@
 #include "core/engine.h"
 #include "scene/2d/area_2d.h"
 #include "scene/main/viewport.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 void AudioStreamPlayer2D::_mix_audio() {
 
@@ -43,6 +44,7 @@ void AudioStreamPlayer2D::_mix_audio() {
 
 	if (setseek >= 0.0) {
 		stream_playback->start(setseek);
+		AudioServer::get_singleton()->voice_reset(voice);
 		setseek = -1.0; //reset seek
 	}
 
@@ -55,6 +57,17 @@ void AudioStreamPlayer2D::_mix_audio() {
 		buffer_size = MIN(buffer_size, 128);
 	}
 
+	if (AudioServer::get_singleton()->thread_voice_advance(voice, stream_playback.ptr(), stream->get_length(), pitch_scale, buffer_size)) {
+		//virtual voice, its time is tracked but nothing is mixed
+		if (!stream_playback->is_playing()) {
+			active = false;
+		}
+		output_ready = false;
+		stream_paused_fade_in = false;
+		stream_paused_fade_out = false;
+		return;
+	}
+
 	stream_playback->mix(buffer, pitch_scale, buffer_size);
 
 	//write all outputs
@@ -97,11 +110,7 @@ void AudioStreamPlayer2D::_mix_audio() {
 
 			AudioFrame *target = AudioServer::get_singleton()->thread_get_channel_mix_buffer(current.bus_index, 0);
 
-			for (int j = 0; j < buffer_size; j++) {
-
-				target[j] += buffer[j] * vol;
-				vol += vol_inc;
-			}
+			AudioMixKernels::mix_volume_ramp(target, buffer, buffer_size, vol, vol_inc);
 
 		} else {
 			AudioFrame *targets[4];
@@ -148,6 +157,8 @@ void AudioStreamPlayer2D::_notification(int p_what) {
 
 	if (p_what == NOTIFICATION_ENTER_TREE) {
 
+		voice = AudioServer::get_singleton()->voice_create();
+		AudioServer::get_singleton()->voice_set_priority(voice, voice_priority);
 		AudioServer::get_singleton()->add_callback(_mix_audios, this);
 		if (autoplay && !Engine::get_singleton()->is_editor_hint()) {
 			play();
@@ -157,6 +168,8 @@ void AudioStreamPlayer2D::_notification(int p_what) {
 	if (p_what == NOTIFICATION_EXIT_TREE) {
 
 		AudioServer::get_singleton()->remove_callback(_mix_audios, this);
+		AudioServer::get_singleton()->voice_free(voice);
+		voice = NULL;
 	}
 
 	if (p_what == NOTIFICATION_PAUSED) {
@@ -245,6 +258,12 @@ void AudioStreamPlayer2D::_notification(int p_what) {
 				}
 			}
 
+			float audibility = 0;
+			for (int i = 0; i < new_output_count; i++) {
+				audibility = MAX(audibility, MAX(outputs[i].vol.l, outputs[i].vol.r));
+			}
+			AudioServer::get_singleton()->voice_set_audibility(voice, audibility);
+
 			output_count = new_output_count;
 			output_ready = true;
 		}
@@ -344,6 +363,12 @@ void AudioStreamPlayer2D::stop() {
 		set_physics_process_internal(false);
 		setplay = -1;
 	}
+
+	if (voice) {
+		AudioServer::get_singleton()->lock();
+		AudioServer::get_singleton()->voice_reset(voice);
+		AudioServer::get_singleton()->unlock();
+	}
 }
 
 bool AudioStreamPlayer2D::is_playing() const {
@@ -467,6 +492,19 @@ bool AudioStreamPlayer2D::get_stream_paused() const {
 	return stream_paused;
 }
 
+void AudioStreamPlayer2D::set_voice_priority(int p_priority) {
+
+	voice_priority = p_priority;
+	if (voice) {
+		AudioServer::get_singleton()->voice_set_priority(voice, voice_priority);
+	}
+}
+
+int AudioStreamPlayer2D::get_voice_priority() const {
+
+	return voice_priority;
+}
+
 Ref<AudioStreamPlayback> AudioStreamPlayer2D::get_stream_playback() {
 	return stream_playback;
 }
@@ -510,6 +548,9 @@ void AudioStreamPlayer2D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_stream_paused", "pause"), &AudioStreamPlayer2D::set_stream_paused);
 	ClassDB::bind_method(D_METHOD("get_stream_paused"), &AudioStreamPlayer2D::get_stream_paused);
 
+	ClassDB::bind_method(D_METHOD("set_voice_priority", "priority"), &AudioStreamPlayer2D::set_voice_priority);
+	ClassDB::bind_method(D_METHOD("get_voice_priority"), &AudioStreamPlayer2D::get_voice_priority);
+
 	ClassDB::bind_method(D_METHOD("get_stream_playback"), &AudioStreamPlayer2D::get_stream_playback);
 
 	ClassDB::bind_method(D_METHOD("_bus_layout_changed"), &AudioStreamPlayer2D::_bus_layout_changed);
@@ -524,6 +565,7 @@ void AudioStreamPlayer2D::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "attenuation", PROPERTY_HINT_EXP_EASING, "attenuation"), "set_attenuation", "get_attenuation");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "bus", PROPERTY_HINT_ENUM, ""), "set_bus", "get_bus");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "area_mask", PROPERTY_HINT_LAYERS_2D_PHYSICS), "set_area_mask", "get_area_mask");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "voice_priority", PROPERTY_HINT_RANGE, "-128,127,1"), "set_voice_priority", "get_voice_priority");
 
 	ADD_SIGNAL(MethodInfo("finished"));
 }
@@ -545,6 +587,8 @@ AudioStreamPlayer2D::AudioStreamPlayer2D() {
 	stream_paused = false;
 	stream_paused_fade_in = false;
 	stream_paused_fade_out = false;
+	voice = NULL;
+	voice_priority = 0;
 	AudioServer::get_singleton()->connect("bus_layout_changed", this, "_bus_layout_changed");
 }
 
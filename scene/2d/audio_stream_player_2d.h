@@ -90,6 +90,9 @@ private:
 	float max_distance;
 	float attenuation;
 
+	AudioServer::Voice *voice;
+	int voice_priority;
+
 protected:
 	void _validate_property(PropertyInfo &property) const;
 	void _notification(int p_what);
@@ -129,6 +132,9 @@ public:
 	void set_stream_paused(bool p_pause);
 	bool get_stream_paused() const;
 
+	void set_voice_priority(int p_priority);
+	int get_voice_priority() const;
+
 	Ref<AudioStreamPlayback> get_stream_playback();
 
 	AudioStreamPlayer2D();
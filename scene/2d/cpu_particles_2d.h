@@ -35,6 +35,8 @@
 #include "scene/2d/node_2d.h"
 #include "scene/resources/texture.h"
 
+class ThreadWorkPool;
+
 /**
 	@author Juan Linietsky <reduzio@gmail.com>
 */
@@ -171,8 +173,42 @@ private:
 
 	Vector2 gravity;
 
+	enum {
+		PROCESS_CHUNK_SIZE = 256 // particles per work item when processing in parallel
+	};
+
+	enum ProcessStep {
+		STEP_SKIP,
+		STEP_EMITTED,
+		STEP_UPDATE
+	};
+
+	struct DataBufferJob {
+		float *data;
+		const int *order;
+		const Particle *particles;
+		Transform2D un_transform;
+		int count;
+	};
+
+	// filled serially each step, read by the processing jobs
+	Vector<uint8_t> particle_steps;
+	Vector<float> particle_deltas;
+	int process_count;
+	Vector2 process_emission_origin;
+	Curve *process_curves[PARAM_MAX];
+	Gradient *process_color_ramp;
+	bool process_hue_rot_constant;
+	Basis process_hue_rot;
+
+	static ThreadWorkPool *process_pool;
+
+	static Basis _get_hue_rot_matrix(float p_angle);
+
 	void _particles_process(float p_delta);
+	void _particles_process_chunk(uint32_t p_chunk, Particle *p_particles);
 	void _update_particle_data_buffer();
+	void _update_particle_data_chunk(uint32_t p_chunk, const DataBufferJob *p_job);
 
 	Mutex *update_mutex;
 
@@ -279,6 +315,9 @@ public:
 
 	void convert_from_particles(Node *p_particles);
 
+	static void init_process_threads();
+	static void finish_process_threads();
+
 	CPUParticles2D();
 	~CPUParticles2D();
 };
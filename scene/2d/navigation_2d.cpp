@@ -30,6 +30,9 @@
 
 #include "navigation_2d.h"
 
+#include "core/frame_vector.h"
+#include "core/sort_array.h"
+
 #define USE_ENTRY_POINT
 
 void Navigation2D::_navpoly_link(int p_id) {
@@ -205,6 +208,9 @@ void Navigation2D::_navpoly_unlink(int p_id) {
 
 int Navigation2D::navpoly_add(const Ref<NavigationPolygon> &p_mesh, const Transform2D &p_xform, Object *p_owner) {
 
+	RWLockWrite w(query_lock);
+	query_dirty = true;
+
 	int id = last_id++;
 	NavMesh nm;
 	nm.linked = false;
@@ -224,6 +230,10 @@ void Navigation2D::navpoly_set_transform(int p_id, const Transform2D &p_xform) {
 	NavMesh &nm = navpoly_map[p_id];
 	if (nm.xform == p_xform)
 		return; //bleh
+
+	RWLockWrite w(query_lock);
+	query_dirty = true;
+
 	_navpoly_unlink(p_id);
 	nm.xform = p_xform;
 	_navpoly_link(p_id);
@@ -231,493 +241,594 @@ void Navigation2D::navpoly_set_transform(int p_id, const Transform2D &p_xform) {
 void Navigation2D::navpoly_remove(int p_id) {
 
 	ERR_FAIL_COND(!navpoly_map.has(p_id));
+
+	RWLockWrite w(query_lock);
+	query_dirty = true;
+
 	_navpoly_unlink(p_id);
 	navpoly_map.erase(p_id);
 }
 
-Vector<Vector2> Navigation2D::get_simple_path(const Vector2 &p_start, const Vector2 &p_end, bool p_optimize) {
+static _FORCE_INLINE_ float _get_rect_distance_squared(const Rect2 &p_rect, const Vector2 &p_point) {
 
-	Polygon *begin_poly = NULL;
-	Polygon *end_poly = NULL;
-	Vector2 begin_point;
-	Vector2 end_point;
-	float begin_d = 1e20;
-	float end_d = 1e20;
+	Vector2 from = p_rect.position;
+	Vector2 to = p_rect.position + p_rect.size;
+	Vector2 closest(CLAMP(p_point.x, from.x, to.x), CLAMP(p_point.y, from.y, to.y));
+	return closest.distance_squared_to(p_point);
+}
 
-	//look for point inside triangle
+uint32_t Navigation2D::QueryState::begin(int p_polygon_count) {
 
-	for (Map<int, NavMesh>::Element *E = navpoly_map.front(); E; E = E->next()) {
+	int from = polygons.size();
+	if (from < p_polygon_count) {
+		polygons.resize(p_polygon_count);
+		PolygonState *w = polygons.ptrw();
+		for (int i = from; i < p_polygon_count; i++) {
+			w[i].pass = 0;
+			w[i].closed_pass = 0;
+		}
+	}
 
-		if (!E->get().linked)
-			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
+	pass++;
+	if (pass == 0) {
+		// Wrapped around, forget every mark left by old searches.
+		PolygonState *w = polygons.ptrw();
+		for (int i = 0; i < polygons.size(); i++) {
+			w[i].pass = 0;
+			w[i].closed_pass = 0;
+		}
+		pass = 1;
+	}
 
-			Polygon &p = F->get();
-			if (begin_d || end_d) {
-				for (int i = 2; i < p.edges.size(); i++) {
+	open_size = 0;
+	return pass;
+}
 
-					if (begin_d > 0) {
+void Navigation2D::QueryState::push(int p_polygon, float p_cost) {
 
-						if (Geometry::is_point_in_triangle(p_start, _get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point))) {
+	if (open_size == open.size()) {
+		open.resize(MAX(open_size * 2, 64));
+	}
 
-							begin_poly = &p;
-							begin_point = p_start;
-							begin_d = 0;
-							if (end_d == 0)
-								break;
-						}
-					}
+	OpenEntry e;
+	e.cost = p_cost;
+	e.polygon = p_polygon;
 
-					if (end_d > 0) {
+	SortArray<OpenEntry, OpenComparator> sorter;
+	sorter.push_heap(0, open_size, 0, e, open.ptrw());
+	open_size++;
+}
 
-						if (Geometry::is_point_in_triangle(p_end, _get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point))) {
+int Navigation2D::QueryState::pop() {
 
-							end_poly = &p;
-							end_point = p_end;
-							end_d = 0;
-							if (begin_d == 0)
-								break;
-						}
-					}
-				}
-			}
+	OpenEntry *o = open.ptrw();
+	int polygon = o[0].polygon;
 
-			p.prev_edge = -1;
-		}
-	}
+	SortArray<OpenEntry, OpenComparator> sorter;
+	sorter.pop_heap(0, open_size, o);
+	open_size--;
 
-	//start or end not inside triangle.. look for closest segment :|
-	if (begin_d || end_d) {
-		for (Map<int, NavMesh>::Element *E = navpoly_map.front(); E; E = E->next()) {
+	return polygon;
+}
 
-			if (!E->get().linked)
-				continue;
-			for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
-
-				Polygon &p = F->get();
-				int es = p.edges.size();
-				for (int i = 0; i < es; i++) {
-
-					Vector2 edge[2] = {
-						_get_vertex(p.edges[i].point),
-						_get_vertex(p.edges[(i + 1) % es].point)
-					};
-
-					if (begin_d > 0) {
-						Vector2 spoint = Geometry::get_closest_point_to_segment_2d(p_start, edge);
-						float d = spoint.distance_to(p_start);
-						if (d < begin_d) {
-							begin_poly = &p;
-							begin_point = spoint;
-							begin_d = d;
-						}
-					}
+int Navigation2D::_create_bvh(BVH *p_bvh, BVH **p_bb, int p_from, int p_size, int p_depth, int &r_max_depth, int &r_max_alloc) {
 
-					if (end_d > 0) {
-						Vector2 spoint = Geometry::get_closest_point_to_segment_2d(p_end, edge);
-						float d = spoint.distance_to(p_end);
-						if (d < end_d) {
-							end_poly = &p;
-							end_point = spoint;
-							end_d = d;
-						}
-					}
-				}
-			}
-		}
+	if (p_depth > r_max_depth) {
+		r_max_depth = p_depth;
 	}
 
-	if (!begin_poly || !end_poly) {
+	if (p_size == 1) {
 
-		return Vector<Vector2>(); //no path
+		return p_bb[p_from] - p_bvh;
+	} else if (p_size == 0) {
+
+		return -1;
 	}
 
-	if (begin_poly == end_poly) {
+	Rect2 aabb;
+	aabb = p_bb[p_from]->aabb;
+	for (int i = 1; i < p_size; i++) {
 
-		Vector<Vector2> path;
-		path.resize(2);
-		path.write[0] = begin_point;
-		path.write[1] = end_point;
-		return path;
+		aabb = aabb.merge(p_bb[p_from + i]->aabb);
 	}
 
-	bool found_route = false;
+	if (aabb.size.x >= aabb.size.y) {
+		SortArray<BVH *, BVHCmpX> sort_x;
+		sort_x.nth_element(0, p_size, p_size / 2, &p_bb[p_from]);
+	} else {
+		SortArray<BVH *, BVHCmpY> sort_y;
+		sort_y.nth_element(0, p_size, p_size / 2, &p_bb[p_from]);
+	}
 
-	List<Polygon *> open_list;
+	int left = _create_bvh(p_bvh, p_bb, p_from, p_size / 2, p_depth + 1, r_max_depth, r_max_alloc);
+	int right = _create_bvh(p_bvh, p_bb, p_from + p_size / 2, p_size - p_size / 2, p_depth + 1, r_max_depth, r_max_alloc);
 
-	begin_poly->entry = p_start;
+	int index = r_max_alloc++;
+	BVH *_new = &p_bvh[index];
+	_new->aabb = aabb;
+	_new->center = aabb.position + aabb.size * 0.5;
+	_new->polygon_index = -1;
+	_new->left = left;
+	_new->right = right;
 
-	for (int i = 0; i < begin_poly->edges.size(); i++) {
+	return index;
+}
 
-		if (begin_poly->edges[i].C) {
+void Navigation2D::_update_query_data() {
 
-			begin_poly->edges[i].C->prev_edge = begin_poly->edges[i].C_edge;
-#ifdef USE_ENTRY_POINT
-			Vector2 edge[2] = {
-				_get_vertex(begin_poly->edges[i].point),
-				_get_vertex(begin_poly->edges[(i + 1) % begin_poly->edges.size()].point)
-			};
+	if (!query_dirty)
+		return;
 
-			Vector2 entry = Geometry::get_closest_point_to_segment_2d(begin_poly->entry, edge);
-			begin_poly->edges[i].C->distance = begin_poly->entry.distance_to(entry);
-			begin_poly->edges[i].C->entry = entry;
-#else
-			begin_poly->edges[i].C->distance = begin_poly->center.distance_to(begin_poly->edges[i].C->center);
-#endif
-			open_list.push_back(begin_poly->edges[i].C);
+	RWLockWrite w(query_lock);
 
-			if (begin_poly->edges[i].C == end_poly) {
-				found_route = true;
-			}
-		}
-	}
+	if (!query_dirty)
+		return; // Rebuilt by another query meanwhile.
+
+	int polygon_count = 0;
+	int edge_count = 0;
+
+	for (Map<int, NavMesh>::Element *E = navpoly_map.front(); E; E = E->next()) {
 
-	while (!found_route) {
+		if (!E->get().linked)
+			continue;
+		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
 
-		if (open_list.size() == 0) {
-			break;
+			F->get().index = polygon_count++;
+			edge_count += F->get().edges.size();
 		}
-		//check open list
+	}
 
-		List<Polygon *>::Element *least_cost_poly = NULL;
-		float least_cost = 1e30;
+	query_polygons.resize(polygon_count);
+	query_edges.resize(edge_count);
+	query_bvh.resize(polygon_count * 2);
 
-		//this could be faster (cache previous results)
-		for (List<Polygon *>::Element *E = open_list.front(); E; E = E->next()) {
+	QueryPolygon *qp = query_polygons.ptrw();
+	QueryEdge *qe = query_edges.ptrw();
+	BVH *bvh = query_bvh.ptrw();
+	Vector<BVH *> bb;
+	bb.resize(polygon_count);
 
-			Polygon *p = E->get();
+	int pi = 0;
+	int ei = 0;
 
-			float cost = p->distance;
+	for (Map<int, NavMesh>::Element *E = navpoly_map.front(); E; E = E->next()) {
 
-#ifdef USE_ENTRY_POINT
-			int es = p->edges.size();
+		if (!E->get().linked)
+			continue;
+		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
 
-			float shortest_distance = 1e30;
+			const Polygon &p = F->get();
+			int es = p.edges.size();
 
-			for (int i = 0; i < es; i++) {
-				Polygon::Edge &e = p->edges.write[i];
+			qp[pi].first_edge = ei;
+			qp[pi].edge_count = es;
+			qp[pi].center = p.center;
+			qp[pi].clockwise = p.clockwise;
+			qp[pi].owner = E->get().owner;
 
-				if (!e.C)
-					continue;
+			Rect2 aabb;
+			for (int i = 0; i < es; i++) {
 
-				Vector2 edge[2] = {
-					_get_vertex(p->edges[i].point),
-					_get_vertex(p->edges[(i + 1) % es].point)
-				};
+				const Polygon::Edge &e = p.edges[i];
+				qe[ei + i].point = _get_vertex(e.point);
+				qe[ei + i].link = e.C ? e.C->index : -1;
+				qe[ei + i].link_edge = e.C_edge;
 
-				Vector2 edge_point = Geometry::get_closest_point_to_segment_2d(p->entry, edge);
-				float dist = p->entry.distance_to(edge_point);
-				if (dist < shortest_distance)
-					shortest_distance = dist;
+				if (i == 0) {
+					aabb.position = qe[ei].point;
+				} else {
+					aabb.expand_to(qe[ei + i].point);
+				}
 			}
 
-			cost += shortest_distance;
-#else
-			cost += p->center.distance_to(end_point);
-#endif
-			if (cost < least_cost) {
-				least_cost_poly = E;
-				least_cost = cost;
-			}
+			bvh[pi].aabb = aabb;
+			bvh[pi].center = aabb.position + aabb.size * 0.5;
+			bvh[pi].left = -1;
+			bvh[pi].right = -1;
+			bvh[pi].polygon_index = pi;
+			bb.write[pi] = &bvh[pi];
+
+			ei += es;
+			pi++;
 		}
+	}
 
-		Polygon *p = least_cost_poly->get();
-		//open the neighbours for search
-		int es = p->edges.size();
+	int max_alloc = polygon_count;
+	query_bvh_depth = 0;
+	_create_bvh(bvh, bb.ptrw(), 0, polygon_count, 1, query_bvh_depth, max_alloc);
+	query_bvh.resize(max_alloc); // The root is the last node.
 
-		for (int i = 0; i < es; i++) {
+	query_dirty = false;
+}
 
-			Polygon::Edge &e = p->edges.write[i];
+int Navigation2D::_find_closest_polygon(const Vector2 &p_point, Vector2 &r_closest) const {
 
-			if (!e.C)
-				continue;
+	if (query_bvh.empty())
+		return -1;
 
-#ifdef USE_ENTRY_POINT
-			Vector2 edge[2] = {
-				_get_vertex(p->edges[i].point),
-				_get_vertex(p->edges[(i + 1) % es].point)
-			};
+	const BVH *bvh = query_bvh.ptr();
+	const QueryPolygon *polygons = query_polygons.ptr();
+	const QueryEdge *edges = query_edges.ptr();
 
-			Vector2 edge_entry = Geometry::get_closest_point_to_segment_2d(p->entry, edge);
-			float distance = p->entry.distance_to(edge_entry) + p->distance;
+	int *stack = (int *)alloca(sizeof(int) * (query_bvh_depth + 1));
+	int stack_size = 1;
+	stack[0] = query_bvh.size() - 1;
 
-#else
+	int closest = -1;
+	float closest_d = 1e20;
 
-			float distance = p->center.distance_to(e.C->center) + p->distance;
+	while (stack_size) {
 
-#endif
+		const BVH &b = bvh[stack[--stack_size]];
+		if (_get_rect_distance_squared(b.aabb, p_point) > closest_d)
+			continue;
 
-			if (e.C->prev_edge != -1) {
-				//oh this was visited already, can we win the cost?
+		if (b.polygon_index >= 0) {
 
-				if (e.C->distance > distance) {
+			const QueryPolygon &p = polygons[b.polygon_index];
+			const QueryEdge *pe = &edges[p.first_edge];
 
-					e.C->prev_edge = e.C_edge;
-					e.C->distance = distance;
-#ifdef USE_ENTRY_POINT
-					e.C->entry = edge_entry;
-#endif
+			for (int i = 2; i < p.edge_count; i++) {
+
+				if (Geometry::is_point_in_triangle(p_point, pe[0].point, pe[i - 1].point, pe[i].point)) {
+
+					r_closest = p_point; //inside triangle, nothing else to discuss
+					return b.polygon_index;
 				}
-			} else {
-				//add to open neighbours
+			}
 
-				e.C->prev_edge = e.C_edge;
-				e.C->distance = distance;
-#ifdef USE_ENTRY_POINT
-				e.C->entry = edge_entry;
-#endif
+			for (int i = 0; i < p.edge_count; i++) {
 
-				open_list.push_back(e.C);
+				Vector2 edge[2] = {
+					pe[i].point,
+					pe[(i + 1) % p.edge_count].point
+				};
 
-				if (e.C == end_poly) {
-					//oh my reached end! stop algorithm
-					found_route = true;
-					break;
+				Vector2 spoint = Geometry::get_closest_point_to_segment_2d(p_point, edge);
+				float d = spoint.distance_squared_to(p_point);
+				if (d < closest_d) {
+					closest_d = d;
+					closest = b.polygon_index;
+					r_closest = spoint;
 				}
 			}
+		} else {
+
+			// Visit the nearest child first.
+			if (_get_rect_distance_squared(bvh[b.left].aabb, p_point) < _get_rect_distance_squared(bvh[b.right].aabb, p_point)) {
+				stack[stack_size++] = b.right;
+				stack[stack_size++] = b.left;
+			} else {
+				stack[stack_size++] = b.left;
+				stack[stack_size++] = b.right;
+			}
 		}
+	}
 
-		if (found_route)
-			break;
+	return closest;
+}
 
-		open_list.erase(least_cost_poly);
-	}
+float Navigation2D::_get_entry_cost(int p_polygon, const Vector2 &p_entry, const Vector2 &p_end_point) const {
 
-	if (found_route) {
+	const QueryPolygon &p = query_polygons[p_polygon];
 
-		Vector<Vector2> path;
+#ifdef USE_ENTRY_POINT
+	const QueryEdge *pe = &query_edges[p.first_edge];
+	float shortest_distance = 1e30;
 
-		if (p_optimize) {
-			//string pulling
+	for (int i = 0; i < p.edge_count; i++) {
 
-			Vector2 apex_point = end_point;
-			Vector2 portal_left = apex_point;
-			Vector2 portal_right = apex_point;
-			Polygon *left_poly = end_poly;
-			Polygon *right_poly = end_poly;
-			Polygon *p = end_poly;
+		if (pe[i].link < 0)
+			continue;
 
-			while (p) {
+		Vector2 edge[2] = {
+			pe[i].point,
+			pe[(i + 1) % p.edge_count].point
+		};
 
-				Vector2 left;
-				Vector2 right;
+		Vector2 edge_point = Geometry::get_closest_point_to_segment_2d(p_entry, edge);
+		float dist = p_entry.distance_to(edge_point);
+		if (dist < shortest_distance)
+			shortest_distance = dist;
+	}
 
-//#define CLOCK_TANGENT(m_a,m_b,m_c) ( ((m_a)-(m_c)).cross((m_a)-(m_b)) )
-#define CLOCK_TANGENT(m_a, m_b, m_c) ((((m_a).x - (m_c).x) * ((m_b).y - (m_c).y) - ((m_b).x - (m_c).x) * ((m_a).y - (m_c).y)))
+	return shortest_distance;
+#else
+	return p.center.distance_to(p_end_point);
+#endif
+}
 
-				if (p == begin_poly) {
-					left = begin_point;
-					right = begin_point;
-				} else {
-					int prev = p->prev_edge;
-					int prev_n = (p->prev_edge + 1) % p->edges.size();
-					left = _get_vertex(p->edges[prev].point);
-					right = _get_vertex(p->edges[prev_n].point);
+Navigation2D::QueryState *Navigation2D::_alloc_query_state() {
 
-					if (p->clockwise) {
-						SWAP(left, right);
-					}
-					/*if (CLOCK_TANGENT(apex_point,left,(left+right)*0.5) < 0){
-						SWAP(left,right);
-					}*/
-				}
+	MutexLock lock(state_mutex);
 
-				bool skip = false;
-
-				/*
-				print_line("-----\nAPEX: "+(apex_point-end_point));
-				print_line("LEFT:");
-				print_line("\tPortal: "+(portal_left-end_point));
-				print_line("\tPoint: "+(left-end_point));
-				print_line("\tLeft Tangent: "+rtos(CLOCK_TANGENT(apex_point,portal_left,left)));
-				print_line("\tLeft Distance: "+rtos(portal_left.distance_squared_to(apex_point)));
-				print_line("\tLeft Test: "+rtos(CLOCK_TANGENT(apex_point,left,portal_right)));
-				print_line("RIGHT:");
-				print_line("\tPortal: "+(portal_right-end_point));
-				print_line("\tPoint: "+(right-end_point));
-				print_line("\tRight Tangent: "+rtos(CLOCK_TANGENT(apex_point,portal_right,right)));
-				print_line("\tRight Distance: "+rtos(portal_right.distance_squared_to(apex_point)));
-				print_line("\tRight Test: "+rtos(CLOCK_TANGENT(apex_point,right,portal_left)));
-				*/
-
-				if (CLOCK_TANGENT(apex_point, portal_left, left) >= 0) {
-					//process
-					if (Math::is_zero_approx(portal_left.distance_squared_to(apex_point)) || CLOCK_TANGENT(apex_point, left, portal_right) > 0) {
-						left_poly = p;
-						portal_left = left;
-					} else {
-
-						apex_point = portal_right;
-						p = right_poly;
-						left_poly = p;
-						portal_left = apex_point;
-						portal_right = apex_point;
-						if (!path.size() || !Math::is_zero_approx(path[path.size() - 1].distance_to(apex_point)))
-							path.push_back(apex_point);
-						skip = true;
-					}
-				}
+	if (free_states.empty()) {
+		return memnew(QueryState);
+	}
 
-				if (!skip && CLOCK_TANGENT(apex_point, portal_right, right) <= 0) {
-					//process
-					if (Math::is_zero_approx(portal_right.distance_squared_to(apex_point)) || CLOCK_TANGENT(apex_point, right, portal_left) < 0) {
-						right_poly = p;
-						portal_right = right;
-					} else {
-
-						apex_point = portal_left;
-						p = left_poly;
-						right_poly = p;
-						portal_right = apex_point;
-						portal_left = apex_point;
-						if (!path.size() || !Math::is_zero_approx(path[path.size() - 1].distance_to(apex_point)))
-							path.push_back(apex_point);
-					}
-				}
+	QueryState *state = free_states[free_states.size() - 1];
+	free_states.resize(free_states.size() - 1);
+	return state;
+}
 
-				if (p != begin_poly)
-					p = p->edges[p->prev_edge].C;
-				else
-					p = NULL;
-			}
+void Navigation2D::_free_query_state(QueryState *p_state) {
 
-		} else {
-			//midpoints
-			Polygon *p = end_poly;
-
-			while (true) {
-				int prev = p->prev_edge;
-				int prev_n = (p->prev_edge + 1) % p->edges.size();
-				Vector2 point = (_get_vertex(p->edges[prev].point) + _get_vertex(p->edges[prev_n].point)) * 0.5;
-				path.push_back(point);
-				p = p->edges[prev].C;
-				if (p == begin_poly)
-					break;
-			}
-		}
+	MutexLock lock(state_mutex);
+	free_states.push_back(p_state);
+}
 
-		if (!path.size() || !Math::is_zero_approx(path[path.size() - 1].distance_squared_to(begin_point))) {
-			path.push_back(begin_point); // Add the begin point
-		} else {
-			path.write[path.size() - 1] = begin_point; // Replace first midpoint by the exact begin point
-		}
+Vector<Vector2> Navigation2D::get_simple_path(const Vector2 &p_start, const Vector2 &p_end, bool p_optimize) {
 
-		path.invert();
+	_update_query_data();
+	RWLockRead r(query_lock);
 
-		if (path.size() <= 1 || !Math::is_zero_approx(path[path.size() - 1].distance_squared_to(end_point))) {
-			path.push_back(end_point); // Add the end point
-		} else {
-			path.write[path.size() - 1] = end_point; // Replace last midpoint by the exact end point
-		}
+	Vector2 begin_point;
+	Vector2 end_point;
+	int begin_poly = _find_closest_polygon(p_start, begin_point);
+	int end_poly = _find_closest_polygon(p_end, end_point);
+
+	if (begin_poly < 0 || end_poly < 0) {
 
+		return Vector<Vector2>(); //no path
+	}
+
+	if (begin_poly == end_poly) {
+
+		Vector<Vector2> path;
+		path.resize(2);
+		path.write[0] = begin_point;
+		path.write[1] = end_point;
 		return path;
 	}
 
-	return Vector<Vector2>();
-}
+	const QueryPolygon *polygons = query_polygons.ptr();
+	const QueryEdge *edges = query_edges.ptr();
 
-Vector2 Navigation2D::get_closest_point(const Vector2 &p_point) {
+	QueryState *state = _alloc_query_state();
+	uint32_t pass = state->begin(query_polygons.size());
+	QueryState::PolygonState *ps = state->polygons.ptrw();
+
+	bool found_route = false;
 
-	Vector2 closest_point = Vector2();
-	float closest_point_d = 1e20;
+	ps[begin_poly].pass = pass;
+	ps[begin_poly].closed_pass = pass;
+	ps[begin_poly].prev_edge = -1;
+	ps[begin_poly].distance = 0;
+	ps[begin_poly].entry = p_start;
 
-	for (Map<int, NavMesh>::Element *E = navpoly_map.front(); E; E = E->next()) {
+	const QueryPolygon &bp = polygons[begin_poly];
+	for (int i = 0; i < bp.edge_count; i++) {
 
-		if (!E->get().linked)
+		const QueryEdge &e = edges[bp.first_edge + i];
+		if (e.link < 0)
 			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
 
-			Polygon &p = F->get();
-			for (int i = 2; i < p.edges.size(); i++) {
+		QueryState::PolygonState &c = ps[e.link];
+#ifdef USE_ENTRY_POINT
+		Vector2 edge[2] = {
+			e.point,
+			edges[bp.first_edge + (i + 1) % bp.edge_count].point
+		};
 
-				if (Geometry::is_point_in_triangle(p_point, _get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point))) {
+		c.entry = Geometry::get_closest_point_to_segment_2d(p_start, edge);
+		c.distance = p_start.distance_to(c.entry);
+#else
+		c.entry = polygons[e.link].center;
+		c.distance = bp.center.distance_to(polygons[e.link].center);
+#endif
+		c.prev_edge = e.link_edge;
+		c.pass = pass;
+		state->push(e.link, c.distance + _get_entry_cost(e.link, c.entry, end_point));
 
-					return p_point; //inside triangle, nothing else to discuss
-				}
-			}
+		if (e.link == end_poly) {
+			found_route = true;
 		}
 	}
 
-	for (Map<int, NavMesh>::Element *E = navpoly_map.front(); E; E = E->next()) {
+	while (!found_route && state->open_size) {
 
-		if (!E->get().linked)
-			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
+		int pi = state->pop();
+		if (ps[pi].closed_pass == pass)
+			continue; // Stale entry, reached again with a lower cost.
+		ps[pi].closed_pass = pass;
 
-			Polygon &p = F->get();
-			int es = p.edges.size();
-			for (int i = 0; i < es; i++) {
+		const QueryPolygon &p = polygons[pi];
 
-				Vector2 edge[2] = {
-					_get_vertex(p.edges[i].point),
-					_get_vertex(p.edges[(i + 1) % es].point)
-				};
+		//open the neighbours for search
+		for (int i = 0; i < p.edge_count; i++) {
 
-				Vector2 spoint = Geometry::get_closest_point_to_segment_2d(p_point, edge);
-				float d = spoint.distance_squared_to(p_point);
-				if (d < closest_point_d) {
+			const QueryEdge &e = edges[p.first_edge + i];
+			if (e.link < 0)
+				continue;
+
+#ifdef USE_ENTRY_POINT
+			Vector2 edge[2] = {
+				e.point,
+				edges[p.first_edge + (i + 1) % p.edge_count].point
+			};
+
+			Vector2 edge_entry = Geometry::get_closest_point_to_segment_2d(ps[pi].entry, edge);
+			float distance = ps[pi].entry.distance_to(edge_entry) + ps[pi].distance;
+#else
+			Vector2 edge_entry = polygons[e.link].center;
+			float distance = p.center.distance_to(polygons[e.link].center) + ps[pi].distance;
+#endif
 
-					closest_point = spoint;
-					closest_point_d = d;
+			QueryState::PolygonState &c = ps[e.link];
+
+			if (c.pass == pass) {
+				//oh this was visited already, can we win the cost?
+
+				if (c.distance > distance) {
+
+					c.prev_edge = e.link_edge;
+					c.distance = distance;
+					c.entry = edge_entry;
+					if (c.closed_pass != pass) {
+						state->push(e.link, distance + _get_entry_cost(e.link, edge_entry, end_point));
+					}
+				}
+			} else {
+				//add to open neighbours
+
+				c.prev_edge = e.link_edge;
+				c.distance = distance;
+				c.entry = edge_entry;
+				c.pass = pass;
+				state->push(e.link, distance + _get_entry_cost(e.link, edge_entry, end_point));
+
+				if (e.link == end_poly) {
+					//oh my reached end! stop algorithm
+					found_route = true;
+					break;
 				}
 			}
 		}
 	}
 
-	return closest_point;
-}
+	if (!found_route) {
 
-Object *Navigation2D::get_closest_point_owner(const Vector2 &p_point) {
+		_free_query_state(state);
+		return Vector<Vector2>();
+	}
 
-	Object *owner = NULL;
-	Vector2 closest_point = Vector2();
-	float closest_point_d = 1e20;
+	// built backwards in frame memory, then copied out in order
+	FrameVector<Vector2> path;
 
-	for (Map<int, NavMesh>::Element *E = navpoly_map.front(); E; E = E->next()) {
+	if (p_optimize) {
+		//string pulling
 
-		if (!E->get().linked)
-			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
+		Vector2 apex_point = end_point;
+		Vector2 portal_left = apex_point;
+		Vector2 portal_right = apex_point;
+		int left_poly = end_poly;
+		int right_poly = end_poly;
+		int p = end_poly;
+
+		while (p != -1) {
 
-			Polygon &p = F->get();
-			for (int i = 2; i < p.edges.size(); i++) {
+			Vector2 left;
+			Vector2 right;
 
-				if (Geometry::is_point_in_triangle(p_point, _get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point))) {
+//#define CLOCK_TANGENT(m_a,m_b,m_c) ( ((m_a)-(m_c)).cross((m_a)-(m_b)) )
+#define CLOCK_TANGENT(m_a, m_b, m_c) ((((m_a).x - (m_c).x) * ((m_b).y - (m_c).y) - ((m_b).x - (m_c).x) * ((m_a).y - (m_c).y)))
 
-					return E->get().owner;
+			if (p == begin_poly) {
+				left = begin_point;
+				right = begin_point;
+			} else {
+				const QueryPolygon &qp = polygons[p];
+				int prev = ps[p].prev_edge;
+				int prev_n = (prev + 1) % qp.edge_count;
+				left = edges[qp.first_edge + prev].point;
+				right = edges[qp.first_edge + prev_n].point;
+
+				if (qp.clockwise) {
+					SWAP(left, right);
 				}
 			}
-		}
-	}
-
-	for (Map<int, NavMesh>::Element *E = navpoly_map.front(); E; E = E->next()) {
 
-		if (!E->get().linked)
-			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
+			bool skip = false;
 
-			Polygon &p = F->get();
-			int es = p.edges.size();
-			for (int i = 0; i < es; i++) {
+			if (CLOCK_TANGENT(apex_point, portal_left, left) >= 0) {
+				//process
+				if (Math::is_zero_approx(portal_left.distance_squared_to(apex_point)) || CLOCK_TANGENT(apex_point, left, portal_right) > 0) {
+					left_poly = p;
+					portal_left = left;
+				} else {
 
-				Vector2 edge[2] = {
-					_get_vertex(p.edges[i].point),
-					_get_vertex(p.edges[(i + 1) % es].point)
-				};
+					apex_point = portal_right;
+					p = right_poly;
+					left_poly = p;
+					portal_left = apex_point;
+					portal_right = apex_point;
+					if (!path.size() || !Math::is_zero_approx(path[path.size() - 1].distance_to(apex_point)))
+						path.push_back(apex_point);
+					skip = true;
+				}
+			}
 
-				Vector2 spoint = Geometry::get_closest_point_to_segment_2d(p_point, edge);
-				float d = spoint.distance_squared_to(p_point);
-				if (d < closest_point_d) {
+			if (!skip && CLOCK_TANGENT(apex_point, portal_right, right) <= 0) {
+				//process
+				if (Math::is_zero_approx(portal_right.distance_squared_to(apex_point)) || CLOCK_TANGENT(apex_point, right, portal_left) < 0) {
+					right_poly = p;
+					portal_right = right;
+				} else {
 
-					closest_point = spoint;
-					closest_point_d = d;
-					owner = E->get().owner;
+					apex_point = portal_left;
+					p = left_poly;
+					right_poly = p;
+					portal_right = apex_point;
+					portal_left = apex_point;
+					if (!path.size() || !Math::is_zero_approx(path[path.size() - 1].distance_to(apex_point)))
+						path.push_back(apex_point);
 				}
 			}
+
+			if (p != begin_poly)
+				p = edges[polygons[p].first_edge + ps[p].prev_edge].link;
+			else
+				p = -1;
+		}
+
+	} else {
+		//midpoints
+		int p = end_poly;
+
+		while (true) {
+			const QueryPolygon &qp = polygons[p];
+			int prev = ps[p].prev_edge;
+			int prev_n = (prev + 1) % qp.edge_count;
+			Vector2 point = (edges[qp.first_edge + prev].point + edges[qp.first_edge + prev_n].point) * 0.5;
+			path.push_back(point);
+			p = edges[qp.first_edge + prev].link;
+			if (p == begin_poly)
+				break;
 		}
 	}
 
-	return owner;
+	_free_query_state(state);
+
+	if (!path.size() || !Math::is_zero_approx(path[path.size() - 1].distance_squared_to(begin_point))) {
+		path.push_back(begin_point); // Add the begin point
+	} else {
+		path[path.size() - 1] = begin_point; // Replace first midpoint by the exact begin point
+	}
+
+	// Add the end point, or replace the last midpoint by the exact end point
+	bool replace_end = path.size() > 1 && Math::is_zero_approx(path[0].distance_squared_to(end_point));
+
+	Vector<Vector2> result;
+	result.resize(path.size() + (replace_end ? 0 : 1));
+	Vector2 *w = result.ptrw();
+	for (int i = 0; i < path.size(); i++) {
+		w[i] = path[path.size() - i - 1];
+	}
+	w[result.size() - 1] = end_point;
+
+	return result;
+}
+
+Vector2 Navigation2D::get_closest_point(const Vector2 &p_point) {
+
+	_update_query_data();
+	RWLockRead r(query_lock);
+
+	Vector2 closest_point;
+	_find_closest_polygon(p_point, closest_point);
+
+	return closest_point;
+}
+
+Object *Navigation2D::get_closest_point_owner(const Vector2 &p_point) {
+
+	_update_query_data();
+	RWLockRead r(query_lock);
+
+	Vector2 closest_point;
+	int polygon = _find_closest_polygon(p_point, closest_point);
+
+	return polygon >= 0 ? query_polygons[polygon].owner : NULL;
 }
 
 void Navigation2D::_bind_methods() {
@@ -736,4 +847,21 @@ Navigation2D::Navigation2D() {
 	ERR_FAIL_COND(sizeof(Point) != 8);
 	cell_size = 1; // one pixel
 	last_id = 1;
+
+	query_bvh_depth = 0;
+	query_dirty = false;
+	query_lock = RWLock::create();
+	state_mutex = Mutex::create();
+}
+
+Navigation2D::~Navigation2D() {
+
+	for (int i = 0; i < free_states.size(); i++) {
+		memdelete(free_states[i]);
+	}
+
+	if (query_lock)
+		memdelete(query_lock);
+	if (state_mutex)
+		memdelete(state_mutex);
 }
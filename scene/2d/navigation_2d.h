@@ -31,6 +31,8 @@
 #ifndef NAVIGATION_2D_H
 #define NAVIGATION_2D_H
 
+#include "core/os/mutex.h"
+#include "core/os/rw_lock.h"
 #include "scene/2d/navigation_polygon.h"
 #include "scene/2d/node_2d.h"
 
@@ -93,13 +95,10 @@ class Navigation2D : public Node2D {
 		Vector<Edge> edges;
 
 		Vector2 center;
-		Vector2 entry;
-
-		float distance;
-		int prev_edge;
 
 		bool clockwise;
 
+		int index; // Slot in query_polygons.
 		NavMesh *owner;
 	};
 
@@ -155,6 +154,106 @@ class Navigation2D : public Node2D {
 	Map<int, NavMesh> navpoly_map;
 	int last_id;
 
+	// Flat copy of the linked polygons, rebuilt lazily after edits. Queries
+	// only read it (under query_lock), so they can run from several threads.
+	struct QueryEdge {
+
+		Vector2 point;
+		int link; // Connected polygon, -1 if none.
+		int link_edge;
+	};
+
+	struct QueryPolygon {
+
+		int first_edge;
+		int edge_count;
+		Vector2 center;
+		bool clockwise;
+		Object *owner;
+	};
+
+	struct BVH {
+
+		Rect2 aabb;
+		Vector2 center; //used for sorting
+		int left;
+		int right;
+
+		int polygon_index;
+	};
+
+	struct BVHCmpX {
+
+		bool operator()(const BVH *p_left, const BVH *p_right) const {
+
+			return p_left->center.x < p_right->center.x;
+		}
+	};
+
+	struct BVHCmpY {
+
+		bool operator()(const BVH *p_left, const BVH *p_right) const {
+
+			return p_left->center.y < p_right->center.y;
+		}
+	};
+
+	// Path search scratch data, one per concurrent query.
+	struct QueryState {
+
+		struct PolygonState {
+
+			uint32_t pass;
+			uint32_t closed_pass;
+			int prev_edge;
+			float distance;
+			Vector2 entry;
+		};
+
+		struct OpenEntry {
+
+			float cost;
+			int polygon;
+		};
+
+		struct OpenComparator {
+
+			_FORCE_INLINE_ bool operator()(const OpenEntry &A, const OpenEntry &B) const { return A.cost > B.cost; }
+		};
+
+		Vector<PolygonState> polygons;
+		Vector<OpenEntry> open;
+		int open_size;
+		uint32_t pass;
+
+		uint32_t begin(int p_polygon_count);
+		void push(int p_polygon, float p_cost);
+		int pop();
+
+		QueryState() {
+			open_size = 0;
+			pass = 0;
+		}
+	};
+
+	Vector<QueryEdge> query_edges;
+	Vector<QueryPolygon> query_polygons;
+	Vector<BVH> query_bvh;
+	int query_bvh_depth;
+	bool query_dirty;
+
+	RWLock *query_lock;
+	Mutex *state_mutex;
+	Vector<QueryState *> free_states;
+
+	int _create_bvh(BVH *p_bvh, BVH **p_bb, int p_from, int p_size, int p_depth, int &r_max_depth, int &r_max_alloc);
+	void _update_query_data();
+	int _find_closest_polygon(const Vector2 &p_point, Vector2 &r_closest) const;
+	float _get_entry_cost(int p_polygon, const Vector2 &p_entry, const Vector2 &p_end_point) const;
+
+	QueryState *_alloc_query_state();
+	void _free_query_state(QueryState *p_state);
+
 protected:
 	static void _bind_methods();
 
@@ -169,6 +268,7 @@ public:
 	Object *get_closest_point_owner(const Vector2 &p_point);
 
 	Navigation2D();
+	~Navigation2D();
 };
 
 #endif // NAVIGATION_2D_H
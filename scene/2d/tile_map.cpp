@@ -281,6 +281,12 @@ void TileMap::update_dirty_quadrants() {
 
 		Quadrant &q = *dirty_quadrant_list.first()->self();
 
+		// canvas items are always redrawn, but physics shapes, navigation polygons and occluders
+		// are only rebuilt for the cells that changed, unless the whole quadrant is dirty
+		// (debug drawing hangs off the canvas items, so it forces a full rebuild too)
+		bool rebuild_all = q.dirty_all || debug_navigation;
+		bool rebuild_shapes = rebuild_all || q.shapes_dirty || debug_shapes;
+
 		for (List<RID>::Element *E = q.canvas_items.front(); E; E = E->next()) {
 
 			vs->free(E->get());
@@ -288,21 +294,44 @@ void TileMap::update_dirty_quadrants() {
 
 		q.canvas_items.clear();
 
-		ps->body_clear_shapes(q.body);
+		if (rebuild_shapes) {
+			ps->body_clear_shapes(q.body);
+		}
 		int shape_idx = 0;
 
-		if (navigation) {
-			for (Map<PosKey, Quadrant::NavPoly>::Element *E = q.navpoly_ids.front(); E; E = E->next()) {
+		if (rebuild_all) {
+			if (navigation) {
+				for (Map<PosKey, Quadrant::NavPoly>::Element *E = q.navpoly_ids.front(); E; E = E->next()) {
 
-				navigation->navpoly_remove(E->get().id);
+					navigation->navpoly_remove(E->get().id);
+				}
+				q.navpoly_ids.clear();
 			}
-			q.navpoly_ids.clear();
-		}
 
-		for (Map<PosKey, Quadrant::Occluder>::Element *E = q.occluder_instances.front(); E; E = E->next()) {
-			VS::get_singleton()->free(E->get().id);
+			for (Map<PosKey, Quadrant::Occluder>::Element *E = q.occluder_instances.front(); E; E = E->next()) {
+				VS::get_singleton()->free(E->get().id);
+			}
+			q.occluder_instances.clear();
+		} else {
+			for (int i = 0; i < q.dirty_cells.size(); i++) {
+
+				const PosKey &pk = q.dirty_cells[i];
+
+				if (navigation) {
+					Map<PosKey, Quadrant::NavPoly>::Element *E = q.navpoly_ids.find(pk);
+					if (E) {
+						navigation->navpoly_remove(E->get().id);
+						q.navpoly_ids.erase(E);
+					}
+				}
+
+				Map<PosKey, Quadrant::Occluder>::Element *E = q.occluder_instances.find(pk);
+				if (E) {
+					VS::get_singleton()->free(E->get().id);
+					q.occluder_instances.erase(E);
+				}
+			}
 		}
-		q.occluder_instances.clear();
 		Ref<ShaderMaterial> prev_material;
 		int prev_z_index = 0;
 		RID prev_canvas_item;
@@ -310,15 +339,17 @@ void TileMap::update_dirty_quadrants() {
 
 		for (int i = 0; i < q.cells.size(); i++) {
 
-			Map<PosKey, Cell>::Element *E = tile_map.find(q.cells[i]);
-			Cell &c = E->get();
+			const PosKey &pk = q.cells[i];
+			Cell &c = *_get_cell(pk);
 			//moment of truth
 			if (!tile_set->has_tile(c.id))
 				continue;
 			Ref<Texture> tex = tile_set->tile_get_texture(c.id);
 			Vector2 tile_ofs = tile_set->tile_get_texture_offset(c.id);
 
-			Vector2 wofs = _map_to_world(E->key().x, E->key().y);
+			bool cell_dirty = rebuild_all || q.dirty_cells.has(pk);
+
+			Vector2 wofs = _map_to_world(pk.x, pk.y);
 			Vector2 offset = wofs - q.pos + tofs;
 
 			if (!tex.is_valid())
@@ -460,7 +491,10 @@ void TileMap::update_dirty_quadrants() {
 				tex->draw_rect_region(canvas_item, rect, r, modulate, c.transpose, normal_map, clip_uv);
 			}
 
-			Vector<TileSet::ShapeData> shapes = tile_set->tile_get_shapes(c.id);
+			Vector<TileSet::ShapeData> shapes;
+			if (rebuild_shapes) {
+				shapes = tile_set->tile_get_shapes(c.id);
+			}
 
 			for (int j = 0; j < shapes.size(); j++) {
 				Ref<Shape2D> shape = shapes[j].shape;
@@ -486,7 +520,7 @@ void TileMap::update_dirty_quadrants() {
 								Ref<ConvexPolygonShape2D> convex = _shapes[k];
 								if (convex.is_valid()) {
 									ps->body_add_shape(q.body, convex->get_rid(), xform);
-									ps->body_set_shape_metadata(q.body, shape_idx, Vector2(E->key().x, E->key().y));
+									ps->body_set_shape_metadata(q.body, shape_idx, Vector2(pk.x, pk.y));
 									ps->body_set_shape_as_one_way_collision(q.body, shape_idx, shapes[j].one_way_collision, shapes[j].one_way_collision_margin);
 									shape_idx++;
 #ifdef DEBUG_ENABLED
@@ -497,7 +531,7 @@ void TileMap::update_dirty_quadrants() {
 							}
 						} else {
 							ps->body_add_shape(q.body, shape->get_rid(), xform);
-							ps->body_set_shape_metadata(q.body, shape_idx, Vector2(E->key().x, E->key().y));
+							ps->body_set_shape_metadata(q.body, shape_idx, Vector2(pk.x, pk.y));
 							ps->body_set_shape_as_one_way_collision(q.body, shape_idx, shapes[j].one_way_collision, shapes[j].one_way_collision_margin);
 							shape_idx++;
 						}
@@ -509,7 +543,7 @@ void TileMap::update_dirty_quadrants() {
 				vs->canvas_item_add_set_transform(debug_canvas_item, Transform2D());
 			}
 
-			if (navigation) {
+			if (navigation && cell_dirty) {
 				Ref<NavigationPolygon> navpoly;
 				Vector2 npoly_ofs;
 				if (tile_set->tile_get_tile_mode(c.id) == TileSet::AUTO_TILE || tile_set->tile_get_tile_mode(c.id) == TileSet::ATLAS_TILE) {
@@ -530,7 +564,7 @@ void TileMap::update_dirty_quadrants() {
 					Quadrant::NavPoly np;
 					np.id = pid;
 					np.xform = xform;
-					q.navpoly_ids[E->key()] = np;
+					q.navpoly_ids[pk] = np;
 
 					if (debug_navigation) {
 						RID debug_navigation_item = vs->canvas_item_create();
@@ -583,6 +617,9 @@ void TileMap::update_dirty_quadrants() {
 				}
 			}
 
+			if (!cell_dirty)
+				continue;
+
 			Ref<OccluderPolygon2D> occluder;
 			if (tile_set->tile_get_tile_mode(c.id) == TileSet::AUTO_TILE || tile_set->tile_get_tile_mode(c.id) == TileSet::ATLAS_TILE) {
 				occluder = tile_set->autotile_get_light_occluder(c.id, Vector2(c.autotile_coord_x, c.autotile_coord_y));
@@ -603,10 +640,14 @@ void TileMap::update_dirty_quadrants() {
 				Quadrant::Occluder oc;
 				oc.xform = xform;
 				oc.id = orid;
-				q.occluder_instances[E->key()] = oc;
+				q.occluder_instances[pk] = oc;
 			}
 		}
 
+		q.dirty_all = false;
+		q.shapes_dirty = false;
+		q.dirty_cells.clear();
+
 		dirty_quadrant_list.remove(dirty_quadrant_list.first());
 		quadrant_order_dirty = true;
 	}
@@ -728,6 +769,23 @@ void TileMap::_erase_quadrant(Map<PosKey, Quadrant>::Element *Q) {
 void TileMap::_make_quadrant_dirty(Map<PosKey, Quadrant>::Element *Q, bool update) {
 
 	Quadrant &q = Q->get();
+	q.dirty_all = true;
+	q.dirty_cells.clear();
+	_queue_quadrant_update(q, update);
+}
+
+void TileMap::_make_quadrant_cell_dirty(Map<PosKey, Quadrant>::Element *Q, const PosKey &p_pk, bool p_shapes_changed) {
+
+	Quadrant &q = Q->get();
+	if (!q.dirty_all)
+		q.dirty_cells.insert(p_pk);
+	if (p_shapes_changed)
+		q.shapes_dirty = true;
+	_queue_quadrant_update(q, true);
+}
+
+void TileMap::_queue_quadrant_update(Quadrant &q, bool update) {
+
 	if (!q.dirty_list.in_list())
 		dirty_quadrant_list.add(&q.dirty_list);
 
@@ -742,6 +800,90 @@ void TileMap::_make_quadrant_dirty(Map<PosKey, Quadrant>::Element *Q, bool updat
 	}
 }
 
+TileMap::Cell *TileMap::_insert_cell(const PosKey &p_pk) {
+
+	PosKey ck = _get_chunk_key(p_pk);
+	CellChunk *chunk = tile_map.getptr(ck);
+	if (!chunk) {
+		chunk = &tile_map.set(ck, CellChunk())->value();
+	}
+
+	Cell *c = &chunk->cells[_get_chunk_index(p_pk)];
+	if (c->id == INVALID_CELL) {
+		c->_u64t = 0;
+		chunk->used++;
+		used_cell_count++;
+	}
+	return c;
+}
+
+void TileMap::_erase_cell(const PosKey &p_pk) {
+
+	PosKey ck = _get_chunk_key(p_pk);
+	CellChunk *chunk = tile_map.getptr(ck);
+	if (!chunk)
+		return;
+
+	Cell &c = chunk->cells[_get_chunk_index(p_pk)];
+	if (c.id == INVALID_CELL)
+		return;
+
+	c.id = INVALID_CELL;
+	used_cell_count--;
+	chunk->used--;
+	if (chunk->used == 0) {
+		tile_map.erase(ck);
+	}
+}
+
+void TileMap::_get_used_cells_sorted(Vector<PosKey> &r_cells) const {
+
+	// same order as sorting the cells by row then column: chunks sharing a row are walked
+	// together, one cell row at a time
+	Vector<PosKey> chunk_keys;
+	const PosKey *K = NULL;
+	while ((K = tile_map.next(K))) {
+		chunk_keys.push_back(*K);
+	}
+	chunk_keys.sort();
+
+	r_cells.resize(used_cell_count);
+	PosKey *w = r_cells.ptrw();
+	int idx = 0;
+
+	Vector<const CellChunk *> row_chunks;
+	int from = 0;
+	while (from < chunk_keys.size()) {
+
+		int to = from;
+		row_chunks.clear();
+		while (to < chunk_keys.size() && chunk_keys[to].y == chunk_keys[from].y) {
+			row_chunks.push_back(tile_map.getptr(chunk_keys[to]));
+			to++;
+		}
+
+		for (int y = 0; y < CHUNK_SIZE; y++) {
+			for (int i = 0; i < row_chunks.size(); i++) {
+
+				const Cell *row = &row_chunks[i]->cells[y << CHUNK_SHIFT];
+				const PosKey &ck = chunk_keys[from + i];
+				for (int x = 0; x < CHUNK_SIZE; x++) {
+					if (row[x].id != INVALID_CELL) {
+						w[idx++] = PosKey(ck.x * CHUNK_SIZE + x, ck.y * CHUNK_SIZE + y);
+					}
+				}
+			}
+		}
+
+		from = to;
+	}
+}
+
+bool TileMap::_cell_has_shapes(const Cell &p_cell) const {
+
+	return tile_set.is_valid() && tile_set->has_tile(p_cell.id) && tile_set->tile_get_shape_count(p_cell.id) > 0;
+}
+
 void TileMap::set_cellv(const Vector2 &p_pos, int p_tile, bool p_flip_x, bool p_flip_y, bool p_transpose) {
 
 	set_cell(p_pos.x, p_pos.y, p_tile, p_flip_x, p_flip_y, p_transpose);
@@ -757,58 +899,115 @@ void TileMap::_set_celld(const Vector2 &p_pos, const Dictionary &p_data) {
 
 void TileMap::set_cell(int p_x, int p_y, int p_tile, bool p_flip_x, bool p_flip_y, bool p_transpose, Vector2 p_autotile_coord) {
 
-	PosKey pk(p_x, p_y);
+	_set_cell(PosKey(p_x, p_y), p_tile, p_flip_x, p_flip_y, p_transpose, p_autotile_coord);
+}
 
-	Map<PosKey, Cell>::Element *E = tile_map.find(pk);
-	if (!E && p_tile == INVALID_CELL)
+void TileMap::_set_cell(const PosKey &p_pk, int p_tile, bool p_flip_x, bool p_flip_y, bool p_transpose, const Vector2 &p_autotile_coord, Map<PosKey, Quadrant>::Element **r_last_quadrant) {
+
+	Cell *c = _get_cell(p_pk);
+	if (!c && p_tile == INVALID_CELL)
 		return; //nothing to do
 
-	PosKey qk(p_x / _get_quadrant_size(), p_y / _get_quadrant_size());
+	PosKey qk(p_pk.x / _get_quadrant_size(), p_pk.y / _get_quadrant_size());
+
+	// bulk setters pass the last quadrant they touched, neighbouring cells usually share it
+	Map<PosKey, Quadrant>::Element *Q;
+	if (r_last_quadrant && *r_last_quadrant && (*r_last_quadrant)->key() == qk) {
+		Q = *r_last_quadrant;
+	} else {
+		Q = quadrant_map.find(qk);
+	}
+
 	if (p_tile == INVALID_CELL) {
 		//erase existing
-		tile_map.erase(pk);
-		Map<PosKey, Quadrant>::Element *Q = quadrant_map.find(qk);
+		bool had_shapes = _cell_has_shapes(*c);
+		_erase_cell(p_pk);
 		ERR_FAIL_COND(!Q);
 		Quadrant &q = Q->get();
-		q.cells.erase(pk);
-		if (q.cells.size() == 0)
+		q.cells.erase(p_pk);
+		if (q.cells.size() == 0) {
 			_erase_quadrant(Q);
-		else
-			_make_quadrant_dirty(Q);
+			Q = NULL;
+		} else {
+			_make_quadrant_cell_dirty(Q, p_pk, had_shapes);
+		}
 
+		if (r_last_quadrant)
+			*r_last_quadrant = Q;
 		used_size_cache_dirty = true;
 		return;
 	}
 
-	Map<PosKey, Quadrant>::Element *Q = quadrant_map.find(qk);
+	bool shapes_changed = false;
 
-	if (!E) {
-		E = tile_map.insert(pk, Cell());
+	if (!c) {
+		c = _insert_cell(p_pk);
 		if (!Q) {
 			Q = _create_quadrant(qk);
 		}
 		Quadrant &q = Q->get();
-		q.cells.insert(pk);
+		q.cells.insert(p_pk);
 	} else {
 		ERR_FAIL_COND(!Q); // quadrant should exist...
 
-		if (E->get().id == p_tile && E->get().flip_h == p_flip_x && E->get().flip_v == p_flip_y && E->get().transpose == p_transpose && E->get().autotile_coord_x == (uint16_t)p_autotile_coord.x && E->get().autotile_coord_y == (uint16_t)p_autotile_coord.y)
+		if (c->id == p_tile && c->flip_h == p_flip_x && c->flip_v == p_flip_y && c->transpose == p_transpose && c->autotile_coord_x == (uint16_t)p_autotile_coord.x && c->autotile_coord_y == (uint16_t)p_autotile_coord.y)
 			return; //nothing changed
+
+		shapes_changed = _cell_has_shapes(*c);
 	}
 
-	Cell &c = E->get();
+	c->id = p_tile;
+	c->flip_h = p_flip_x;
+	c->flip_v = p_flip_y;
+	c->transpose = p_transpose;
+	c->autotile_coord_x = (uint16_t)p_autotile_coord.x;
+	c->autotile_coord_y = (uint16_t)p_autotile_coord.y;
 
-	c.id = p_tile;
-	c.flip_h = p_flip_x;
-	c.flip_v = p_flip_y;
-	c.transpose = p_transpose;
-	c.autotile_coord_x = (uint16_t)p_autotile_coord.x;
-	c.autotile_coord_y = (uint16_t)p_autotile_coord.y;
+	shapes_changed = shapes_changed || _cell_has_shapes(*c);
 
-	_make_quadrant_dirty(Q);
+	_make_quadrant_cell_dirty(Q, p_pk, shapes_changed);
+	if (r_last_quadrant)
+		*r_last_quadrant = Q;
 	used_size_cache_dirty = true;
 }
 
+void TileMap::set_cells(const PoolVector2Array &p_positions, const PoolIntArray &p_tiles) {
+
+	int count = p_positions.size();
+	ERR_FAIL_COND(p_tiles.size() != count && p_tiles.size() != 1);
+
+	bool single = p_tiles.size() == 1;
+	PoolVector2Array::Read pr = p_positions.read();
+	PoolIntArray::Read tr = p_tiles.read();
+	Map<PosKey, Quadrant>::Element *Q = NULL;
+
+	for (int i = 0; i < count; i++) {
+
+		_set_cell(PosKey(pr[i].x, pr[i].y), single ? tr[0] : tr[i], false, false, false, Vector2(), &Q);
+	}
+}
+
+void TileMap::set_cells_rect(const Rect2 &p_rect, const PoolIntArray &p_tiles) {
+
+	int from_x = p_rect.position.x;
+	int from_y = p_rect.position.y;
+	int width = p_rect.size.x;
+	int height = p_rect.size.y;
+	ERR_FAIL_COND(width < 0 || height < 0);
+	ERR_FAIL_COND(p_tiles.size() != width * height && p_tiles.size() != 1);
+
+	bool single = p_tiles.size() == 1;
+	PoolIntArray::Read tr = p_tiles.read();
+	Map<PosKey, Quadrant>::Element *Q = NULL;
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+
+			_set_cell(PosKey(from_x + x, from_y + y), single ? tr[0] : tr[y * width + x], false, false, false, Vector2(), &Q);
+		}
+	}
+}
+
 int TileMap::get_cellv(const Vector2 &p_pos) const {
 
 	return get_cell(p_pos.x, p_pos.y);
@@ -858,9 +1057,9 @@ void TileMap::update_bitmask_region(const Vector2 &p_start, const Vector2 &p_end
 void TileMap::update_cell_bitmask(int p_x, int p_y) {
 
 	PosKey p(p_x, p_y);
-	Map<PosKey, Cell>::Element *E = tile_map.find(p);
-	if (E != NULL) {
-		int id = get_cell(p_x, p_y);
+	Cell *c = _get_cell(p);
+	if (c != NULL) {
+		int id = c->id;
 		if (tile_set->tile_get_tile_mode(id) == TileSet::AUTO_TILE) {
 			uint16_t mask = 0;
 			if (tile_set->autotile_get_bitmask_mode(id) == TileSet::BITMASK_2X2) {
@@ -919,16 +1118,16 @@ void TileMap::update_cell_bitmask(int p_x, int p_y) {
 				}
 			}
 			Vector2 coord = tile_set->autotile_get_subtile_for_bitmask(id, mask, this, Vector2(p_x, p_y));
-			E->get().autotile_coord_x = (int)coord.x;
-			E->get().autotile_coord_y = (int)coord.y;
+			c->autotile_coord_x = (int)coord.x;
+			c->autotile_coord_y = (int)coord.y;
 
 			PosKey qk(p_x / _get_quadrant_size(), p_y / _get_quadrant_size());
 			Map<PosKey, Quadrant>::Element *Q = quadrant_map.find(qk);
-			_make_quadrant_dirty(Q);
+			_make_quadrant_cell_dirty(Q, p, _cell_has_shapes(*c));
 
 		} else if (tile_set->tile_get_tile_mode(id) == TileSet::SINGLE_TILE) {
-			E->get().autotile_coord_x = 0;
-			E->get().autotile_coord_y = 0;
+			c->autotile_coord_x = 0;
+			c->autotile_coord_y = 0;
 		}
 	}
 }
@@ -943,10 +1142,13 @@ void TileMap::update_dirty_bitmask() {
 
 void TileMap::fix_invalid_tiles() {
 
-	for (Map<PosKey, Cell>::Element *E = tile_map.front(); E; E = E->next()) {
+	Vector<PosKey> cells;
+	_get_used_cells_sorted(cells);
 
-		if (!tile_set->has_tile(get_cell(E->key().x, E->key().y))) {
-			set_cell(E->key().x, E->key().y, INVALID_CELL);
+	for (int i = 0; i < cells.size(); i++) {
+
+		if (!tile_set->has_tile(get_cell(cells[i].x, cells[i].y))) {
+			set_cell(cells[i].x, cells[i].y, INVALID_CELL);
 		}
 	}
 }
@@ -955,60 +1157,58 @@ int TileMap::get_cell(int p_x, int p_y) const {
 
 	PosKey pk(p_x, p_y);
 
-	const Map<PosKey, Cell>::Element *E = tile_map.find(pk);
+	const Cell *c = _get_cell(pk);
 
-	if (!E)
+	if (!c)
 		return INVALID_CELL;
 
-	return E->get().id;
+	return c->id;
 }
 bool TileMap::is_cell_x_flipped(int p_x, int p_y) const {
 
 	PosKey pk(p_x, p_y);
 
-	const Map<PosKey, Cell>::Element *E = tile_map.find(pk);
+	const Cell *c = _get_cell(pk);
 
-	if (!E)
+	if (!c)
 		return false;
 
-	return E->get().flip_h;
+	return c->flip_h;
 }
 bool TileMap::is_cell_y_flipped(int p_x, int p_y) const {
 
 	PosKey pk(p_x, p_y);
 
-	const Map<PosKey, Cell>::Element *E = tile_map.find(pk);
+	const Cell *c = _get_cell(pk);
 
-	if (!E)
+	if (!c)
 		return false;
 
-	return E->get().flip_v;
+	return c->flip_v;
 }
 bool TileMap::is_cell_transposed(int p_x, int p_y) const {
 
 	PosKey pk(p_x, p_y);
 
-	const Map<PosKey, Cell>::Element *E = tile_map.find(pk);
+	const Cell *c = _get_cell(pk);
 
-	if (!E)
+	if (!c)
 		return false;
 
-	return E->get().transpose;
+	return c->transpose;
 }
 
 void TileMap::set_cell_autotile_coord(int p_x, int p_y, const Vector2 &p_coord) {
 
 	PosKey pk(p_x, p_y);
 
-	const Map<PosKey, Cell>::Element *E = tile_map.find(pk);
+	Cell *c = _get_cell(pk);
 
-	if (!E)
+	if (!c)
 		return;
 
-	Cell c = E->get();
-	c.autotile_coord_x = p_coord.x;
-	c.autotile_coord_y = p_coord.y;
-	tile_map[pk] = c;
+	c->autotile_coord_x = p_coord.x;
+	c->autotile_coord_y = p_coord.y;
 
 	PosKey qk(p_x / _get_quadrant_size(), p_y / _get_quadrant_size());
 	Map<PosKey, Quadrant>::Element *Q = quadrant_map.find(qk);
@@ -1016,36 +1216,42 @@ void TileMap::set_cell_autotile_coord(int p_x, int p_y, const Vector2 &p_coord)
 	if (!Q)
 		return;
 
-	_make_quadrant_dirty(Q);
+	_make_quadrant_cell_dirty(Q, pk, _cell_has_shapes(*c));
 }
 
 Vector2 TileMap::get_cell_autotile_coord(int p_x, int p_y) const {
 
 	PosKey pk(p_x, p_y);
 
-	const Map<PosKey, Cell>::Element *E = tile_map.find(pk);
+	const Cell *c = _get_cell(pk);
 
-	if (!E)
+	if (!c)
 		return Vector2();
 
-	return Vector2(E->get().autotile_coord_x, E->get().autotile_coord_y);
+	return Vector2(c->autotile_coord_x, c->autotile_coord_y);
 }
 
 void TileMap::_recreate_quadrants() {
 
 	_clear_quadrants();
 
-	for (Map<PosKey, Cell>::Element *E = tile_map.front(); E; E = E->next()) {
+	Vector<PosKey> cells;
+	_get_used_cells_sorted(cells);
 
-		PosKey qk(E->key().x / _get_quadrant_size(), E->key().y / _get_quadrant_size());
+	Map<PosKey, Quadrant>::Element *Q = NULL;
+	for (int i = 0; i < cells.size(); i++) {
 
-		Map<PosKey, Quadrant>::Element *Q = quadrant_map.find(qk);
-		if (!Q) {
-			Q = _create_quadrant(qk);
-			dirty_quadrant_list.add(&Q->get().dirty_list);
+		PosKey qk(cells[i].x / _get_quadrant_size(), cells[i].y / _get_quadrant_size());
+
+		if (!Q || !(Q->key() == qk)) {
+			Q = quadrant_map.find(qk);
+			if (!Q) {
+				Q = _create_quadrant(qk);
+				dirty_quadrant_list.add(&Q->get().dirty_list);
+			}
 		}
 
-		Q->get().cells.insert(E->key());
+		Q->get().cells.insert(cells[i]);
 		_make_quadrant_dirty(Q, false);
 	}
 	update_dirty_quadrants();
@@ -1091,6 +1297,7 @@ void TileMap::clear() {
 
 	_clear_quadrants();
 	tile_map.clear();
+	used_cell_count = 0;
 	used_size_cache_dirty = true;
 }
 
@@ -1102,6 +1309,7 @@ void TileMap::_set_tile_data(const PoolVector<int> &p_data) {
 	int offset = (format == FORMAT_2) ? 3 : 2;
 
 	clear();
+	Map<PosKey, Quadrant>::Element *Q = NULL;
 	for (int i = 0; i < c; i += offset) {
 
 		const uint8_t *ptr = (const uint8_t *)&r[i];
@@ -1139,7 +1347,7 @@ void TileMap::_set_tile_data(const PoolVector<int> &p_data) {
 		if (x<-20 || y <-20 || x>4000 || y>4000)
 			continue;
 		*/
-		set_cell(x, y, v, flip_h, flip_v, transpose, Vector2(coord_x, coord_y));
+		_set_cell(PosKey(x, y), v, flip_h, flip_v, transpose, Vector2(coord_x, coord_y), &Q);
 	}
 
 	format = FORMAT_2;
@@ -1147,27 +1355,31 @@ void TileMap::_set_tile_data(const PoolVector<int> &p_data) {
 
 PoolVector<int> TileMap::_get_tile_data() const {
 
+	Vector<PosKey> cells;
+	_get_used_cells_sorted(cells);
+
 	PoolVector<int> data;
-	data.resize(tile_map.size() * 3);
+	data.resize(cells.size() * 3);
 	PoolVector<int>::Write w = data.write();
 
 	format = FORMAT_2;
 
 	int idx = 0;
-	for (const Map<PosKey, Cell>::Element *E = tile_map.front(); E; E = E->next()) {
+	for (int i = 0; i < cells.size(); i++) {
+		const Cell &c = *_get_cell(cells[i]);
 		uint8_t *ptr = (uint8_t *)&w[idx];
-		encode_uint16(E->key().x, &ptr[0]);
-		encode_uint16(E->key().y, &ptr[2]);
-		uint32_t val = E->get().id;
-		if (E->get().flip_h)
+		encode_uint16(cells[i].x, &ptr[0]);
+		encode_uint16(cells[i].y, &ptr[2]);
+		uint32_t val = c.id;
+		if (c.flip_h)
 			val |= (1 << 29);
-		if (E->get().flip_v)
+		if (c.flip_v)
 			val |= (1 << 30);
-		if (E->get().transpose)
+		if (c.transpose)
 			val |= (1 << 31);
 		encode_uint32(val, &ptr[4]);
-		encode_uint16(E->get().autotile_coord_x, &ptr[8]);
-		encode_uint16(E->get().autotile_coord_y, &ptr[10]);
+		encode_uint16(c.autotile_coord_x, &ptr[8]);
+		encode_uint16(c.autotile_coord_y, &ptr[10]);
 		idx += 3;
 	}
 
@@ -1512,13 +1724,15 @@ bool TileMap::is_y_sort_mode_enabled() const {
 
 Array TileMap::get_used_cells() const {
 
+	Vector<PosKey> cells;
+	_get_used_cells_sorted(cells);
+
 	Array a;
-	a.resize(tile_map.size());
-	int i = 0;
-	for (Map<PosKey, Cell>::Element *E = tile_map.front(); E; E = E->next()) {
+	a.resize(cells.size());
+	for (int i = 0; i < cells.size(); i++) {
 
-		Vector2 p(E->key().x, E->key().y);
-		a[i++] = p;
+		Vector2 p(cells[i].x, cells[i].y);
+		a[i] = p;
 	}
 
 	return a;
@@ -1526,11 +1740,14 @@ Array TileMap::get_used_cells() const {
 
 Array TileMap::get_used_cells_by_id(int p_id) const {
 
+	Vector<PosKey> cells;
+	_get_used_cells_sorted(cells);
+
 	Array a;
-	for (Map<PosKey, Cell>::Element *E = tile_map.front(); E; E = E->next()) {
+	for (int i = 0; i < cells.size(); i++) {
 
-		if (E->value().id == p_id) {
-			Vector2 p(E->key().x, E->key().y);
+		if (_get_cell(cells[i])->id == p_id) {
+			Vector2 p(cells[i].x, cells[i].y);
 			a.push_back(p);
 		}
 	}
@@ -1541,11 +1758,26 @@ Array TileMap::get_used_cells_by_id(int p_id) const {
 Rect2 TileMap::get_used_rect() { // Not const because of cache
 
 	if (used_size_cache_dirty) {
-		if (tile_map.size() > 0) {
-			used_size_cache = Rect2(tile_map.front()->key().x, tile_map.front()->key().y, 0, 0);
+		if (used_cell_count > 0) {
+			bool first = true;
+
+			const PosKey *K = NULL;
+			while ((K = tile_map.next(K))) {
+
+				const CellChunk &chunk = tile_map.get(*K);
+				for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++) {
 
-			for (Map<PosKey, Cell>::Element *E = tile_map.front(); E; E = E->next()) {
-				used_size_cache.expand_to(Vector2(E->key().x, E->key().y));
+					if (chunk.cells[i].id == INVALID_CELL)
+						continue;
+
+					Vector2 p(K->x * CHUNK_SIZE + (i & CHUNK_MASK), K->y * CHUNK_SIZE + (i >> CHUNK_SHIFT));
+					if (first) {
+						used_size_cache = Rect2(p, Size2());
+						first = false;
+					} else {
+						used_size_cache.expand_to(p);
+					}
+				}
 			}
 
 			used_size_cache.size += Vector2(1, 1);
@@ -1660,6 +1892,8 @@ void TileMap::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_cell", "x", "y", "tile", "flip_x", "flip_y", "transpose", "autotile_coord"), &TileMap::set_cell, DEFVAL(false), DEFVAL(false), DEFVAL(false), DEFVAL(Vector2()));
 	ClassDB::bind_method(D_METHOD("set_cellv", "position", "tile", "flip_x", "flip_y", "transpose"), &TileMap::set_cellv, DEFVAL(false), DEFVAL(false), DEFVAL(false));
 	ClassDB::bind_method(D_METHOD("_set_celld", "position", "data"), &TileMap::_set_celld);
+	ClassDB::bind_method(D_METHOD("set_cells", "positions", "tiles"), &TileMap::set_cells);
+	ClassDB::bind_method(D_METHOD("set_cells_rect", "rect", "tiles"), &TileMap::set_cells_rect);
 	ClassDB::bind_method(D_METHOD("get_cell", "x", "y"), &TileMap::get_cell);
 	ClassDB::bind_method(D_METHOD("get_cellv", "position"), &TileMap::get_cellv);
 	ClassDB::bind_method(D_METHOD("is_cell_x_flipped", "x", "y"), &TileMap::is_cell_x_flipped);
@@ -1737,6 +1971,7 @@ void TileMap::_changed_callback(Object *p_changed, const char *p_prop) {
 
 TileMap::TileMap() {
 
+	used_cell_count = 0;
 	rect_cache_dirty = true;
 	used_size_cache_dirty = true;
 	pending_update = false;
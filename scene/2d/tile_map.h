@@ -31,6 +31,7 @@
 #ifndef TILE_MAP_H
 #define TILE_MAP_H
 
+#include "core/hash_map.h"
 #include "core/self_list.h"
 #include "core/vset.h"
 #include "scene/2d/navigation_2d.h"
@@ -115,9 +116,51 @@ private:
 		Cell() { _u64t = 0; }
 	};
 
-	Map<PosKey, Cell> tile_map;
+	struct PosKeyHasher {
+		static _FORCE_INLINE_ uint32_t hash(const PosKey &p_key) { return hash_one_uint64(p_key.key); }
+	};
+
+	enum {
+		CHUNK_SHIFT = 4,
+		CHUNK_SIZE = 1 << CHUNK_SHIFT,
+		CHUNK_MASK = CHUNK_SIZE - 1
+	};
+
+	// cells are stored in dense square chunks, looked up by hash, so large maps don't pay a tree node per cell
+	struct CellChunk {
+		Cell cells[CHUNK_SIZE * CHUNK_SIZE];
+		int used;
+
+		CellChunk() {
+			Cell empty;
+			empty.id = INVALID_CELL;
+			for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++) {
+				cells[i] = empty;
+			}
+			used = 0;
+		}
+	};
+
+	HashMap<PosKey, CellChunk, PosKeyHasher> tile_map;
+	int used_cell_count;
 	List<PosKey> dirty_bitmask;
 
+	_FORCE_INLINE_ static PosKey _get_chunk_key(const PosKey &p_pk) { return PosKey(p_pk.x >> CHUNK_SHIFT, p_pk.y >> CHUNK_SHIFT); }
+	_FORCE_INLINE_ static int _get_chunk_index(const PosKey &p_pk) { return ((p_pk.y & CHUNK_MASK) << CHUNK_SHIFT) | (p_pk.x & CHUNK_MASK); }
+
+	_FORCE_INLINE_ const Cell *_get_cell(const PosKey &p_pk) const {
+		const CellChunk *chunk = tile_map.getptr(_get_chunk_key(p_pk));
+		if (!chunk)
+			return NULL;
+		const Cell *c = &chunk->cells[_get_chunk_index(p_pk)];
+		return c->id == INVALID_CELL ? NULL : c;
+	}
+	_FORCE_INLINE_ Cell *_get_cell(const PosKey &p_pk) { return const_cast<Cell *>(static_cast<const TileMap *>(this)->_get_cell(p_pk)); }
+	Cell *_insert_cell(const PosKey &p_pk);
+	void _erase_cell(const PosKey &p_pk);
+	void _get_used_cells_sorted(Vector<PosKey> &r_cells) const;
+	bool _cell_has_shapes(const Cell &p_cell) const;
+
 	struct Quadrant {
 
 		Vector2 pos;
@@ -141,6 +184,11 @@ private:
 
 		VSet<PosKey> cells;
 
+		// what the next update must redo: everything, or only the listed cells (plus shapes if any of them had or has some)
+		bool dirty_all;
+		bool shapes_dirty;
+		VSet<PosKey> dirty_cells;
+
 		void operator=(const Quadrant &q) {
 			pos = q.pos;
 			canvas_items = q.canvas_items;
@@ -148,6 +196,9 @@ private:
 			cells = q.cells;
 			navpoly_ids = q.navpoly_ids;
 			occluder_instances = q.occluder_instances;
+			dirty_all = q.dirty_all;
+			shapes_dirty = q.shapes_dirty;
+			dirty_cells = q.dirty_cells;
 		}
 		Quadrant(const Quadrant &q) :
 				dirty_list(this) {
@@ -157,9 +208,15 @@ private:
 			cells = q.cells;
 			occluder_instances = q.occluder_instances;
 			navpoly_ids = q.navpoly_ids;
+			dirty_all = q.dirty_all;
+			shapes_dirty = q.shapes_dirty;
+			dirty_cells = q.dirty_cells;
 		}
 		Quadrant() :
-				dirty_list(this) {}
+				dirty_list(this) {
+			dirty_all = true;
+			shapes_dirty = true;
+		}
 	};
 
 	Map<PosKey, Quadrant> quadrant_map;
@@ -191,6 +248,9 @@ private:
 	Map<PosKey, Quadrant>::Element *_create_quadrant(const PosKey &p_qk);
 	void _erase_quadrant(Map<PosKey, Quadrant>::Element *Q);
 	void _make_quadrant_dirty(Map<PosKey, Quadrant>::Element *Q, bool update = true);
+	void _make_quadrant_cell_dirty(Map<PosKey, Quadrant>::Element *Q, const PosKey &p_pk, bool p_shapes_changed);
+	void _queue_quadrant_update(Quadrant &q, bool update);
+	void _set_cell(const PosKey &p_pk, int p_tile, bool p_flip_x, bool p_flip_y, bool p_transpose, const Vector2 &p_autotile_coord, Map<PosKey, Quadrant>::Element **r_last_quadrant = NULL);
 	void _recreate_quadrants();
 	void _clear_quadrants();
 	void _update_quadrant_space(const RID &p_space);
@@ -237,6 +297,8 @@ public:
 	int get_quadrant_size() const;
 
 	void set_cell(int p_x, int p_y, int p_tile, bool p_flip_x = false, bool p_flip_y = false, bool p_transpose = false, Vector2 p_autotile_coord = Vector2());
+	void set_cells(const PoolVector2Array &p_positions, const PoolIntArray &p_tiles);
+	void set_cells_rect(const Rect2 &p_rect, const PoolIntArray &p_tiles);
 	int get_cell(int p_x, int p_y) const;
 	bool is_cell_x_flipped(int p_x, int p_y) const;
 	bool is_cell_y_flipped(int p_x, int p_y) const;
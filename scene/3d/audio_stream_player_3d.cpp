@@ -34,6 +34,7 @@
 #include "scene/3d/camera.h"
 #include "scene/3d/listener.h"
 #include "scene/main/viewport.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 void AudioStreamPlayer3D::_mix_audio() {
 
@@ -45,6 +46,7 @@ void AudioStreamPlayer3D::_mix_audio() {
 	bool started = false;
 	if (setseek >= 0.0) {
 		stream_playback->start(setseek);
+		AudioServer::get_singleton()->voice_reset(voice);
 		setseek = -1.0; //reset seek
 		started = true;
 	}
@@ -58,6 +60,17 @@ void AudioStreamPlayer3D::_mix_audio() {
 		buffer_size = MIN(buffer_size, 128);
 	}
 
+	if (AudioServer::get_singleton()->thread_voice_advance(voice, stream_playback.ptr(), stream->get_length(), pitch_scale, buffer_size)) {
+		//virtual voice, its time is tracked but nothing is mixed
+		if (!stream_playback->is_playing()) {
+			active = false;
+		}
+		output_ready = false;
+		stream_paused_fade_in = false;
+		stream_paused_fade_out = false;
+		return;
+	}
+
 	// Mix if we're not paused or we're fading out
 	if ((output_count > 0 || out_of_range_mode == OUT_OF_RANGE_MIX)) {
 
@@ -172,18 +185,10 @@ void AudioStreamPlayer3D::_mix_audio() {
 					AudioFrame rvol_inc = (current.reverb_vol[k] - prev_outputs[i].reverb_vol[k]) / float(buffer_size);
 					AudioFrame rvol = prev_outputs[i].reverb_vol[k];
 
-					for (int j = 0; j < buffer_size; j++) {
-
-						rtarget[j] += buffer[j] * rvol;
-						rvol += rvol_inc;
-					}
+					AudioMixKernels::mix_volume_ramp(rtarget, buffer, buffer_size, rvol, rvol_inc);
 				} else {
 
-					AudioFrame rvol = current.reverb_vol[k];
-					for (int j = 0; j < buffer_size; j++) {
-
-						rtarget[j] += buffer[j] * rvol;
-					}
+					AudioMixKernels::mix_volume_ramp(rtarget, buffer, buffer_size, current.reverb_vol[k], AudioFrame(0, 0));
 				}
 			}
 		}
@@ -241,6 +246,8 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 	if (p_what == NOTIFICATION_ENTER_TREE) {
 
 		velocity_tracker->reset(get_global_transform().origin);
+		voice = AudioServer::get_singleton()->voice_create();
+		AudioServer::get_singleton()->voice_set_priority(voice, voice_priority);
 		AudioServer::get_singleton()->add_callback(_mix_audios, this);
 		if (autoplay && !Engine::get_singleton()->is_editor_hint()) {
 			play();
@@ -250,6 +257,8 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 	if (p_what == NOTIFICATION_EXIT_TREE) {
 
 		AudioServer::get_singleton()->remove_callback(_mix_audios, this);
+		AudioServer::get_singleton()->voice_free(voice);
+		voice = NULL;
 	}
 
 	if (p_what == NOTIFICATION_PAUSED) {
@@ -566,6 +575,15 @@ void AudioStreamPlayer3D::_notification(int p_what) {
 					break;
 			}
 
+			float audibility = 0;
+			int channels = AudioServer::get_singleton()->get_channel_count();
+			for (int i = 0; i < new_output_count; i++) {
+				for (int k = 0; k < channels; k++) {
+					audibility = MAX(audibility, MAX(outputs[i].vol[k].l, outputs[i].vol[k].r));
+				}
+			}
+			AudioServer::get_singleton()->voice_set_audibility(voice, audibility);
+
 			output_count = new_output_count;
 			output_ready = true;
 		}
@@ -678,6 +696,12 @@ void AudioStreamPlayer3D::stop() {
 		set_physics_process_internal(false);
 		setplay = -1;
 	}
+
+	if (voice) {
+		AudioServer::get_singleton()->lock();
+		AudioServer::get_singleton()->voice_reset(voice);
+		AudioServer::get_singleton()->unlock();
+	}
 }
 
 bool AudioStreamPlayer3D::is_playing() const {
@@ -882,6 +906,19 @@ bool AudioStreamPlayer3D::get_stream_paused() const {
 	return stream_paused;
 }
 
+void AudioStreamPlayer3D::set_voice_priority(int p_priority) {
+
+	voice_priority = p_priority;
+	if (voice) {
+		AudioServer::get_singleton()->voice_set_priority(voice, voice_priority);
+	}
+}
+
+int AudioStreamPlayer3D::get_voice_priority() const {
+
+	return voice_priority;
+}
+
 Ref<AudioStreamPlayback> AudioStreamPlayer3D::get_stream_playback() {
 	return stream_playback;
 }
@@ -952,6 +989,9 @@ void AudioStreamPlayer3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_stream_paused", "pause"), &AudioStreamPlayer3D::set_stream_paused);
 	ClassDB::bind_method(D_METHOD("get_stream_paused"), &AudioStreamPlayer3D::get_stream_paused);
 
+	ClassDB::bind_method(D_METHOD("set_voice_priority", "priority"), &AudioStreamPlayer3D::set_voice_priority);
+	ClassDB::bind_method(D_METHOD("get_voice_priority"), &AudioStreamPlayer3D::get_voice_priority);
+
 	ClassDB::bind_method(D_METHOD("get_stream_playback"), &AudioStreamPlayer3D::get_stream_playback);
 
 	ClassDB::bind_method(D_METHOD("_bus_layout_changed"), &AudioStreamPlayer3D::_bus_layout_changed);
@@ -969,6 +1009,7 @@ void AudioStreamPlayer3D::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "out_of_range_mode", PROPERTY_HINT_ENUM, "Mix,Pause"), "set_out_of_range_mode", "get_out_of_range_mode");
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "bus", PROPERTY_HINT_ENUM, ""), "set_bus", "get_bus");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "area_mask", PROPERTY_HINT_LAYERS_2D_PHYSICS), "set_area_mask", "get_area_mask");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "voice_priority", PROPERTY_HINT_RANGE, "-128,127,1"), "set_voice_priority", "get_voice_priority");
 	ADD_GROUP("Emission Angle", "emission_angle");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "emission_angle_enabled"), "set_emission_angle_enabled", "is_emission_angle_enabled");
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "emission_angle_degrees", PROPERTY_HINT_RANGE, "0.1,90,0.1"), "set_emission_angle", "get_emission_angle");
@@ -1020,6 +1061,8 @@ AudioStreamPlayer3D::AudioStreamPlayer3D() {
 	stream_paused = false;
 	stream_paused_fade_in = false;
 	stream_paused_fade_out = false;
+	voice = NULL;
+	voice_priority = 0;
 
 	velocity_tracker.instance();
 	AudioServer::get_singleton()->connect("bus_layout_changed", this, "_bus_layout_changed");
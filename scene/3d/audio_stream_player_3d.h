@@ -138,6 +138,9 @@ private:
 
 	OutOfRangeMode out_of_range_mode;
 
+	AudioServer::Voice *voice;
+	int voice_priority;
+
 	float _get_attenuation_db(float p_distance) const;
 
 protected:
@@ -206,6 +209,9 @@ public:
 	void set_stream_paused(bool p_pause);
 	bool get_stream_paused() const;
 
+	void set_voice_priority(int p_priority);
+	int get_voice_priority() const;
+
 	Ref<AudioStreamPlayback> get_stream_playback();
 
 	AudioStreamPlayer3D();
@@ -30,6 +30,8 @@
 
 #include "cpu_particles.h"
 
+#include "core/os/thread_work_pool.h"
+#include "core/project_settings.h"
 #include "scene/3d/camera.h"
 #include "scene/3d/particles.h"
 #include "scene/resources/particles_material.h"
@@ -489,6 +491,22 @@ static float rand_from_seed(uint32_t &seed) {
 	return float(seed % uint32_t(65536)) / 65535.0;
 }
 
+Basis CPUParticles::_get_hue_rot_matrix(float p_angle) {
+
+	float hue_rot_c = Math::cos(p_angle);
+	float hue_rot_s = Math::sin(p_angle);
+
+	Basis hue_rot_mat;
+	Basis mat1(0.299, 0.587, 0.114, 0.299, 0.587, 0.114, 0.299, 0.587, 0.114);
+	Basis mat2(0.701, -0.587, -0.114, -0.299, 0.413, -0.114, -0.300, -0.588, 0.886);
+	Basis mat3(0.168, 0.330, -0.497, -0.328, 0.035, 0.292, 1.250, -1.050, -0.203);
+
+	for (int j = 0; j < 3; j++) {
+		hue_rot_mat[j] = mat1[j] + mat2[j] * hue_rot_c + mat3[j] * hue_rot_s;
+	}
+	return hue_rot_mat;
+}
+
 void CPUParticles::_particles_process(float p_delta) {
 
 	p_delta *= speed_scale;
@@ -515,9 +533,19 @@ void CPUParticles::_particles_process(float p_delta) {
 		velocity_xform = emission_xform.basis;
 	}
 
+	if (particle_steps.size() != pcount) {
+		particle_steps.resize(pcount);
+		particle_deltas.resize(pcount);
+	}
+
+	uint8_t *steps = particle_steps.ptrw();
+	float *deltas = particle_deltas.ptrw();
+
+	// emission draws from the global random generator, so it stays serial and in index order
 	for (int i = 0; i < pcount; i++) {
 
 		Particle &p = parray[i];
+		steps[i] = STEP_SKIP;
 
 		if (!emitting && !p.active)
 			continue;
@@ -678,9 +706,62 @@ void CPUParticles::_particles_process(float p_delta) {
 				p.transform.origin.z = 0.0;
 			}
 
+			steps[i] = STEP_EMITTED;
 		} else if (!p.active) {
 			continue;
 		} else {
+			steps[i] = STEP_UPDATE;
+		}
+
+		deltas[i] = local_delta;
+	}
+
+	// state shared by the processing jobs, so they don't touch references or lazily sorted data
+	process_count = pcount;
+	process_emission_origin = emission_xform.origin;
+
+	for (int i = 0; i < PARAM_MAX; i++) {
+		process_curves[i] = curve_parameters[i].ptr();
+	}
+
+	process_color_ramp = color_ramp.ptr();
+	if (process_color_ramp) {
+		process_color_ramp->get_color_at_offset(0); // sorts the gradient points if needed
+	}
+
+	process_hue_rot_constant = !process_curves[PARAM_HUE_VARIATION] && randomness[PARAM_HUE_VARIATION] == 0.0;
+	if (process_hue_rot_constant) {
+		process_hue_rot = _get_hue_rot_matrix(parameters[PARAM_HUE_VARIATION] * Math_PI * 2.0);
+	}
+
+	int chunks = (pcount + PROCESS_CHUNK_SIZE - 1) / PROCESS_CHUNK_SIZE;
+
+	if (process_pool && chunks > 1) {
+		process_pool->do_work(chunks, this, &CPUParticles::_particles_process_chunk, parray);
+	} else {
+		for (int i = 0; i < chunks; i++) {
+			_particles_process_chunk(i, parray);
+		}
+	}
+}
+
+void CPUParticles::_particles_process_chunk(uint32_t p_chunk, Particle *p_particles) {
+
+	int from = p_chunk * PROCESS_CHUNK_SIZE;
+	int to = MIN(from + PROCESS_CHUNK_SIZE, process_count);
+
+	const uint8_t *steps = particle_steps.ptr();
+	const float *deltas = particle_deltas.ptr();
+
+	for (int i = from; i < to; i++) {
+
+		if (steps[i] == STEP_SKIP)
+			continue;
+
+		Particle &p = p_particles[i];
+		float local_delta = deltas[i];
+
+		if (steps[i] == STEP_UPDATE) {
 
 			uint32_t alt_seed = p.seed;
 
@@ -688,8 +769,8 @@ void CPUParticles::_particles_process(float p_delta) {
 			p.custom[1] = p.time / lifetime;
 
 			float tex_linear_velocity = 0.0;
-			if (curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY].is_valid()) {
-				tex_linear_velocity = curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_INITIAL_LINEAR_VELOCITY]) {
+				tex_linear_velocity = process_curves[PARAM_INITIAL_LINEAR_VELOCITY]->interpolate(p.custom[1]);
 			}
 			/*
 			float tex_orbit_velocity = 0.0;
@@ -702,42 +783,42 @@ void CPUParticles::_particles_process(float p_delta) {
 			}
 */
 			float tex_angular_velocity = 0.0;
-			if (curve_parameters[PARAM_ANGULAR_VELOCITY].is_valid()) {
-				tex_angular_velocity = curve_parameters[PARAM_ANGULAR_VELOCITY]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_ANGULAR_VELOCITY]) {
+				tex_angular_velocity = process_curves[PARAM_ANGULAR_VELOCITY]->interpolate(p.custom[1]);
 			}
 
 			float tex_linear_accel = 0.0;
-			if (curve_parameters[PARAM_LINEAR_ACCEL].is_valid()) {
-				tex_linear_accel = curve_parameters[PARAM_LINEAR_ACCEL]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_LINEAR_ACCEL]) {
+				tex_linear_accel = process_curves[PARAM_LINEAR_ACCEL]->interpolate(p.custom[1]);
 			}
 
 			float tex_tangential_accel = 0.0;
-			if (curve_parameters[PARAM_TANGENTIAL_ACCEL].is_valid()) {
-				tex_tangential_accel = curve_parameters[PARAM_TANGENTIAL_ACCEL]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_TANGENTIAL_ACCEL]) {
+				tex_tangential_accel = process_curves[PARAM_TANGENTIAL_ACCEL]->interpolate(p.custom[1]);
 			}
 
 			float tex_radial_accel = 0.0;
-			if (curve_parameters[PARAM_RADIAL_ACCEL].is_valid()) {
-				tex_radial_accel = curve_parameters[PARAM_RADIAL_ACCEL]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_RADIAL_ACCEL]) {
+				tex_radial_accel = process_curves[PARAM_RADIAL_ACCEL]->interpolate(p.custom[1]);
 			}
 
 			float tex_damping = 0.0;
-			if (curve_parameters[PARAM_DAMPING].is_valid()) {
-				tex_damping = curve_parameters[PARAM_DAMPING]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_DAMPING]) {
+				tex_damping = process_curves[PARAM_DAMPING]->interpolate(p.custom[1]);
 			}
 
 			float tex_angle = 0.0;
-			if (curve_parameters[PARAM_ANGLE].is_valid()) {
-				tex_angle = curve_parameters[PARAM_ANGLE]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_ANGLE]) {
+				tex_angle = process_curves[PARAM_ANGLE]->interpolate(p.custom[1]);
 			}
 			float tex_anim_speed = 0.0;
-			if (curve_parameters[PARAM_ANIM_SPEED].is_valid()) {
-				tex_anim_speed = curve_parameters[PARAM_ANIM_SPEED]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_ANIM_SPEED]) {
+				tex_anim_speed = process_curves[PARAM_ANIM_SPEED]->interpolate(p.custom[1]);
 			}
 
 			float tex_anim_offset = 0.0;
-			if (curve_parameters[PARAM_ANIM_OFFSET].is_valid()) {
-				tex_anim_offset = curve_parameters[PARAM_ANIM_OFFSET]->interpolate(p.custom[1]);
+			if (process_curves[PARAM_ANIM_OFFSET]) {
+				tex_anim_offset = process_curves[PARAM_ANIM_OFFSET]->interpolate(p.custom[1]);
 			}
 
 			Vector3 force = gravity;
@@ -748,7 +829,7 @@ void CPUParticles::_particles_process(float p_delta) {
 			//apply linear acceleration
 			force += p.velocity.length() > 0.0 ? p.velocity.normalized() * (parameters[PARAM_LINEAR_ACCEL] + tex_linear_accel) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_LINEAR_ACCEL]) : Vector3();
 			//apply radial acceleration
-			Vector3 org = emission_xform.origin;
+			Vector3 org = process_emission_origin;
 			Vector3 diff = position - org;
 			force += diff.length() > 0.0 ? diff.normalized() * (parameters[PARAM_RADIAL_ACCEL] + tex_radial_accel) * Math::lerp(1.0f, rand_from_seed(alt_seed), randomness[PARAM_RADIAL_ACCEL]) : Vector3();
 			//apply tangential acceleration;
@@ -776,7 +857,7 @@ void CPUParticles::_particles_process(float p_delta) {
 				}
 			}
 #endif
-			if (curve_parameters[PARAM_INITIAL_LINEAR_VELOCITY].is_valid()) {
+			if (process_curves[PARAM_INITIAL_LINEAR_VELOCITY]) {
 				p.velocity = p.velocity.normalized() * tex_linear_velocity;
 			}
 			if (parameters[PARAM_DAMPING] + tex_damping > 0.0) {
@@ -799,32 +880,23 @@ void CPUParticles::_particles_process(float p_delta) {
 		//apply hue rotation
 
 		float tex_scale = 1.0;
-		if (curve_parameters[PARAM_SCALE].is_valid()) {
-			tex_scale = curve_parameters[PARAM_SCALE]->interpolate(p.custom[1]);
+		if (process_curves[PARAM_SCALE]) {
+			tex_scale = process_curves[PARAM_SCALE]->interpolate(p.custom[1]);
 		}
 
 		float tex_hue_variation = 0.0;
-		if (curve_parameters[PARAM_HUE_VARIATION].is_valid()) {
-			tex_hue_variation = curve_parameters[PARAM_HUE_VARIATION]->interpolate(p.custom[1]);
+		if (process_curves[PARAM_HUE_VARIATION]) {
+			tex_hue_variation = process_curves[PARAM_HUE_VARIATION]->interpolate(p.custom[1]);
 		}
 
-		float hue_rot_angle = (parameters[PARAM_HUE_VARIATION] + tex_hue_variation) * Math_PI * 2.0 * Math::lerp(1.0f, p.hue_rot_rand * 2.0f - 1.0f, randomness[PARAM_HUE_VARIATION]);
-		float hue_rot_c = Math::cos(hue_rot_angle);
-		float hue_rot_s = Math::sin(hue_rot_angle);
-
-		Basis hue_rot_mat;
-		{
-			Basis mat1(0.299, 0.587, 0.114, 0.299, 0.587, 0.114, 0.299, 0.587, 0.114);
-			Basis mat2(0.701, -0.587, -0.114, -0.299, 0.413, -0.114, -0.300, -0.588, 0.886);
-			Basis mat3(0.168, 0.330, -0.497, -0.328, 0.035, 0.292, 1.250, -1.050, -0.203);
-
-			for (int j = 0; j < 3; j++) {
-				hue_rot_mat[j] = mat1[j] + mat2[j] * hue_rot_c + mat3[j] * hue_rot_s;
-			}
+		Basis hue_rot_mat = process_hue_rot;
+		if (!process_hue_rot_constant) {
+			float hue_rot_angle = (parameters[PARAM_HUE_VARIATION] + tex_hue_variation) * Math_PI * 2.0 * Math::lerp(1.0f, p.hue_rot_rand * 2.0f - 1.0f, randomness[PARAM_HUE_VARIATION]);
+			hue_rot_mat = _get_hue_rot_matrix(hue_rot_angle);
 		}
 
-		if (color_ramp.is_valid()) {
-			p.color = color_ramp->get_color_at_offset(p.custom[1]) * color;
+		if (process_color_ramp) {
+			p.color = process_color_ramp->get_color_at_offset(p.custom[1]) * color;
 		} else {
 			p.color = color;
 		}
@@ -894,6 +966,56 @@ void CPUParticles::_particles_process(float p_delta) {
 	}
 }
 
+void CPUParticles::_update_particle_data_chunk(uint32_t p_chunk, const DataBufferJob *p_job) {
+
+	int from = p_chunk * PROCESS_CHUNK_SIZE;
+	int to = MIN(from + PROCESS_CHUNK_SIZE, p_job->count);
+
+	float *ptr = p_job->data + from * 17;
+
+	for (int i = from; i < to; i++) {
+
+		int idx = p_job->order ? p_job->order[i] : i;
+
+		Transform t = p_job->particles[idx].transform;
+
+		if (!local_coords) {
+			t = p_job->un_transform * t;
+		}
+
+		if (p_job->particles[idx].active) {
+			ptr[0] = t.basis.elements[0][0];
+			ptr[1] = t.basis.elements[0][1];
+			ptr[2] = t.basis.elements[0][2];
+			ptr[3] = t.origin.x;
+			ptr[4] = t.basis.elements[1][0];
+			ptr[5] = t.basis.elements[1][1];
+			ptr[6] = t.basis.elements[1][2];
+			ptr[7] = t.origin.y;
+			ptr[8] = t.basis.elements[2][0];
+			ptr[9] = t.basis.elements[2][1];
+			ptr[10] = t.basis.elements[2][2];
+			ptr[11] = t.origin.z;
+		} else {
+			zeromem(ptr, sizeof(float) * 12);
+		}
+
+		Color c = p_job->particles[idx].color;
+		uint8_t *data8 = (uint8_t *)&ptr[12];
+		data8[0] = CLAMP(c.r * 255.0, 0, 255);
+		data8[1] = CLAMP(c.g * 255.0, 0, 255);
+		data8[2] = CLAMP(c.b * 255.0, 0, 255);
+		data8[3] = CLAMP(c.a * 255.0, 0, 255);
+
+		ptr[13] = p_job->particles[idx].custom[0];
+		ptr[14] = p_job->particles[idx].custom[1];
+		ptr[15] = p_job->particles[idx].custom[2];
+		ptr[16] = p_job->particles[idx].custom[3];
+
+		ptr += 17;
+	}
+}
+
 void CPUParticles::_update_particle_data_buffer() {
 #ifndef NO_THREADS
 	update_mutex->lock();
@@ -943,46 +1065,21 @@ void CPUParticles::_update_particle_data_buffer() {
 			}
 		}
 
-		for (int i = 0; i < pc; i++) {
-
-			int idx = order ? order[i] : i;
+		int chunks = (pc + PROCESS_CHUNK_SIZE - 1) / PROCESS_CHUNK_SIZE;
 
-			Transform t = r[idx].transform;
-
-			if (!local_coords) {
-				t = un_transform * t;
-			}
+		DataBufferJob job;
+		job.data = ptr;
+		job.order = order;
+		job.particles = r.ptr();
+		job.un_transform = un_transform;
+		job.count = pc;
 
-			if (r[idx].active) {
-				ptr[0] = t.basis.elements[0][0];
-				ptr[1] = t.basis.elements[0][1];
-				ptr[2] = t.basis.elements[0][2];
-				ptr[3] = t.origin.x;
-				ptr[4] = t.basis.elements[1][0];
-				ptr[5] = t.basis.elements[1][1];
-				ptr[6] = t.basis.elements[1][2];
-				ptr[7] = t.origin.y;
-				ptr[8] = t.basis.elements[2][0];
-				ptr[9] = t.basis.elements[2][1];
-				ptr[10] = t.basis.elements[2][2];
-				ptr[11] = t.origin.z;
-			} else {
-				zeromem(ptr, sizeof(float) * 12);
+		if (process_pool && chunks > 1) {
+			process_pool->do_work(chunks, this, &CPUParticles::_update_particle_data_chunk, &job);
+		} else {
+			for (int i = 0; i < chunks; i++) {
+				_update_particle_data_chunk(i, &job);
 			}
-
-			Color c = r[idx].color;
-			uint8_t *data8 = (uint8_t *)&ptr[12];
-			data8[0] = CLAMP(c.r * 255.0, 0, 255);
-			data8[1] = CLAMP(c.g * 255.0, 0, 255);
-			data8[2] = CLAMP(c.b * 255.0, 0, 255);
-			data8[3] = CLAMP(c.a * 255.0, 0, 255);
-
-			ptr[13] = r[idx].custom[0];
-			ptr[14] = r[idx].custom[1];
-			ptr[15] = r[idx].custom[2];
-			ptr[16] = r[idx].custom[3];
-
-			ptr += 17;
 		}
 
 		can_update = true;
@@ -1385,6 +1482,30 @@ void CPUParticles::_bind_methods() {
 	BIND_ENUM_CONSTANT(EMISSION_SHAPE_DIRECTED_POINTS);
 }
 
+void CPUParticles::init_process_threads() {
+
+	int threads = GLOBAL_DEF("rendering/cpu_particles/threads", 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/cpu_particles/threads", PropertyInfo(Variant::INT, "rendering/cpu_particles/threads", PROPERTY_HINT_RANGE, "0,64,1"));
+
+	if (threads == 1)
+		return; //process every emitter on the calling thread
+
+	process_pool = memnew(ThreadWorkPool);
+	process_pool->init(threads > 0 ? threads : -1);
+}
+
+void CPUParticles::finish_process_threads() {
+
+	if (!process_pool)
+		return;
+
+	process_pool->finish();
+	memdelete(process_pool);
+	process_pool = NULL;
+}
+
+ThreadWorkPool *CPUParticles::process_pool = NULL;
+
 CPUParticles::CPUParticles() {
 
 	time = 0;
@@ -1440,6 +1561,13 @@ CPUParticles::CPUParticles() {
 
 	can_update = false;
 
+	process_count = 0;
+	for (int i = 0; i < PARAM_MAX; i++) {
+		process_curves[i] = NULL;
+	}
+	process_color_ramp = NULL;
+	process_hue_rot_constant = false;
+
 	set_color(Color(1, 1, 1, 1));
 
 #ifndef NO_THREADS
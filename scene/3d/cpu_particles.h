@@ -34,6 +34,8 @@
 #include "core/rid.h"
 #include "scene/3d/visual_instance.h"
 
+class ThreadWorkPool;
+
 /**
 	@author Juan Linietsky <reduzio@gmail.com>
 */
@@ -172,8 +174,42 @@ private:
 
 	Vector3 gravity;
 
+	enum {
+		PROCESS_CHUNK_SIZE = 256 // particles per work item when processing in parallel
+	};
+
+	enum ProcessStep {
+		STEP_SKIP,
+		STEP_EMITTED,
+		STEP_UPDATE
+	};
+
+	struct DataBufferJob {
+		float *data;
+		const int *order;
+		const Particle *particles;
+		Transform un_transform;
+		int count;
+	};
+
+	// filled serially each step, read by the processing jobs
+	Vector<uint8_t> particle_steps;
+	Vector<float> particle_deltas;
+	int process_count;
+	Vector3 process_emission_origin;
+	Curve *process_curves[PARAM_MAX];
+	Gradient *process_color_ramp;
+	bool process_hue_rot_constant;
+	Basis process_hue_rot;
+
+	static ThreadWorkPool *process_pool;
+
+	static Basis _get_hue_rot_matrix(float p_angle);
+
 	void _particles_process(float p_delta);
+	void _particles_process_chunk(uint32_t p_chunk, Particle *p_particles);
 	void _update_particle_data_buffer();
+	void _update_particle_data_chunk(uint32_t p_chunk, const DataBufferJob *p_job);
 
 	Mutex *update_mutex;
 
@@ -278,6 +314,9 @@ public:
 
 	void convert_from_particles(Node *p_particles);
 
+	static void init_process_threads();
+	static void finish_process_threads();
+
 	CPUParticles();
 	~CPUParticles();
 };
@@ -30,6 +30,8 @@
 
 #include "navigation.h"
 
+#include "core/sort_array.h"
+
 #define USE_ENTRY_POINT
 
 void Navigation::_navmesh_link(int p_id) {
@@ -206,6 +208,9 @@ void Navigation::_navmesh_unlink(int p_id) {
 
 int Navigation::navmesh_add(const Ref<NavigationMesh> &p_mesh, const Transform &p_xform, Object *p_owner) {
 
+	RWLockWrite w(query_lock);
+	query_dirty = true;
+
 	int id = last_id++;
 	NavMesh nm;
 	nm.linked = false;
@@ -225,6 +230,10 @@ void Navigation::navmesh_set_transform(int p_id, const Transform &p_xform) {
 	NavMesh &nm = navmesh_map[p_id];
 	if (nm.xform == p_xform)
 		return; //bleh
+
+	RWLockWrite w(query_lock);
+	query_dirty = true;
+
 	_navmesh_unlink(p_id);
 	nm.xform = p_xform;
 	_navmesh_link(p_id);
@@ -232,11 +241,332 @@ void Navigation::navmesh_set_transform(int p_id, const Transform &p_xform) {
 void Navigation::navmesh_remove(int p_id) {
 
 	ERR_FAIL_COND(!navmesh_map.has(p_id));
+
+	RWLockWrite w(query_lock);
+	query_dirty = true;
+
 	_navmesh_unlink(p_id);
 	navmesh_map.erase(p_id);
 }
 
-void Navigation::_clip_path(Vector<Vector3> &path, Polygon *from_poly, const Vector3 &p_to_point, Polygon *p_to_poly) {
+static _FORCE_INLINE_ float _get_aabb_distance_squared(const AABB &p_aabb, const Vector3 &p_point) {
+
+	Vector3 from = p_aabb.position;
+	Vector3 to = p_aabb.position + p_aabb.size;
+	Vector3 closest(CLAMP(p_point.x, from.x, to.x), CLAMP(p_point.y, from.y, to.y), CLAMP(p_point.z, from.z, to.z));
+	return closest.distance_squared_to(p_point);
+}
+
+static _FORCE_INLINE_ float _get_aabb_distance_squared(const AABB &p_a, const AABB &p_b) {
+
+	Vector3 gap;
+	for (int i = 0; i < 3; i++) {
+		gap[i] = MAX(0, MAX(p_a.position[i] - (p_b.position[i] + p_b.size[i]), p_b.position[i] - (p_a.position[i] + p_a.size[i])));
+	}
+	return gap.length_squared();
+}
+
+uint32_t Navigation::QueryState::begin(int p_polygon_count) {
+
+	int from = polygons.size();
+	if (from < p_polygon_count) {
+		polygons.resize(p_polygon_count);
+		PolygonState *w = polygons.ptrw();
+		for (int i = from; i < p_polygon_count; i++) {
+			w[i].pass = 0;
+			w[i].closed_pass = 0;
+		}
+	}
+
+	pass++;
+	if (pass == 0) {
+		// Wrapped around, forget every mark left by old searches.
+		PolygonState *w = polygons.ptrw();
+		for (int i = 0; i < polygons.size(); i++) {
+			w[i].pass = 0;
+			w[i].closed_pass = 0;
+		}
+		pass = 1;
+	}
+
+	open_size = 0;
+	return pass;
+}
+
+void Navigation::QueryState::push(int p_polygon, float p_cost) {
+
+	if (open_size == open.size()) {
+		open.resize(MAX(open_size * 2, 64));
+	}
+
+	OpenEntry e;
+	e.cost = p_cost;
+	e.polygon = p_polygon;
+
+	SortArray<OpenEntry, OpenComparator> sorter;
+	sorter.push_heap(0, open_size, 0, e, open.ptrw());
+	open_size++;
+}
+
+int Navigation::QueryState::pop() {
+
+	OpenEntry *o = open.ptrw();
+	int polygon = o[0].polygon;
+
+	SortArray<OpenEntry, OpenComparator> sorter;
+	sorter.pop_heap(0, open_size, o);
+	open_size--;
+
+	return polygon;
+}
+
+int Navigation::_create_bvh(BVH *p_bvh, BVH **p_bb, int p_from, int p_size, int p_depth, int &r_max_depth, int &r_max_alloc) {
+
+	if (p_depth > r_max_depth) {
+		r_max_depth = p_depth;
+	}
+
+	if (p_size == 1) {
+
+		return p_bb[p_from] - p_bvh;
+	} else if (p_size == 0) {
+
+		return -1;
+	}
+
+	AABB aabb;
+	aabb = p_bb[p_from]->aabb;
+	for (int i = 1; i < p_size; i++) {
+
+		aabb.merge_with(p_bb[p_from + i]->aabb);
+	}
+
+	int li = aabb.get_longest_axis_index();
+
+	switch (li) {
+
+		case Vector3::AXIS_X: {
+			SortArray<BVH *, BVHCmpX> sort_x;
+			sort_x.nth_element(0, p_size, p_size / 2, &p_bb[p_from]);
+		} break;
+		case Vector3::AXIS_Y: {
+			SortArray<BVH *, BVHCmpY> sort_y;
+			sort_y.nth_element(0, p_size, p_size / 2, &p_bb[p_from]);
+		} break;
+		case Vector3::AXIS_Z: {
+			SortArray<BVH *, BVHCmpZ> sort_z;
+			sort_z.nth_element(0, p_size, p_size / 2, &p_bb[p_from]);
+		} break;
+	}
+
+	int left = _create_bvh(p_bvh, p_bb, p_from, p_size / 2, p_depth + 1, r_max_depth, r_max_alloc);
+	int right = _create_bvh(p_bvh, p_bb, p_from + p_size / 2, p_size - p_size / 2, p_depth + 1, r_max_depth, r_max_alloc);
+
+	int index = r_max_alloc++;
+	BVH *_new = &p_bvh[index];
+	_new->aabb = aabb;
+	_new->center = aabb.position + aabb.size * 0.5;
+	_new->polygon_index = -1;
+	_new->left = left;
+	_new->right = right;
+
+	return index;
+}
+
+void Navigation::_update_query_data() {
+
+	if (!query_dirty)
+		return;
+
+	RWLockWrite w(query_lock);
+
+	if (!query_dirty)
+		return; // Rebuilt by another query meanwhile.
+
+	int polygon_count = 0;
+	int edge_count = 0;
+
+	for (Map<int, NavMesh>::Element *E = navmesh_map.front(); E; E = E->next()) {
+
+		if (!E->get().linked)
+			continue;
+		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
+
+			F->get().index = polygon_count++;
+			edge_count += F->get().edges.size();
+		}
+	}
+
+	query_polygons.resize(polygon_count);
+	query_edges.resize(edge_count);
+	query_bvh.resize(polygon_count * 2);
+
+	QueryPolygon *qp = query_polygons.ptrw();
+	QueryEdge *qe = query_edges.ptrw();
+	BVH *bvh = query_bvh.ptrw();
+	Vector<BVH *> bb;
+	bb.resize(polygon_count);
+
+	int pi = 0;
+	int ei = 0;
+
+	for (Map<int, NavMesh>::Element *E = navmesh_map.front(); E; E = E->next()) {
+
+		if (!E->get().linked)
+			continue;
+		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
+
+			const Polygon &p = F->get();
+			int es = p.edges.size();
+
+			qp[pi].first_edge = ei;
+			qp[pi].edge_count = es;
+			qp[pi].center = p.center;
+			qp[pi].clockwise = p.clockwise;
+			qp[pi].owner = E->get().owner;
+
+			AABB aabb;
+			for (int i = 0; i < es; i++) {
+
+				const Polygon::Edge &e = p.edges[i];
+				qe[ei + i].point = _get_vertex(e.point);
+				qe[ei + i].link = e.C ? e.C->index : -1;
+				qe[ei + i].link_edge = e.C_edge;
+
+				if (i == 0) {
+					aabb.position = qe[ei].point;
+				} else {
+					aabb.expand_to(qe[ei + i].point);
+				}
+			}
+
+			bvh[pi].aabb = aabb;
+			bvh[pi].center = aabb.position + aabb.size * 0.5;
+			bvh[pi].left = -1;
+			bvh[pi].right = -1;
+			bvh[pi].polygon_index = pi;
+			bb.write[pi] = &bvh[pi];
+
+			ei += es;
+			pi++;
+		}
+	}
+
+	int max_alloc = polygon_count;
+	query_bvh_depth = 0;
+	_create_bvh(bvh, bb.ptrw(), 0, polygon_count, 1, query_bvh_depth, max_alloc);
+	query_bvh.resize(max_alloc); // The root is the last node.
+
+	query_dirty = false;
+}
+
+int Navigation::_find_closest_polygon(const Vector3 &p_point, Vector3 &r_closest, Vector3 *r_normal) const {
+
+	if (query_bvh.empty())
+		return -1;
+
+	const BVH *bvh = query_bvh.ptr();
+	const QueryPolygon *polygons = query_polygons.ptr();
+	const QueryEdge *edges = query_edges.ptr();
+
+	int *stack = (int *)alloca(sizeof(int) * (query_bvh_depth + 1));
+	int stack_size = 1;
+	stack[0] = query_bvh.size() - 1;
+
+	int closest = -1;
+	float closest_d = 1e20;
+
+	while (stack_size) {
+
+		const BVH &b = bvh[stack[--stack_size]];
+		if (_get_aabb_distance_squared(b.aabb, p_point) > closest_d)
+			continue;
+
+		if (b.polygon_index >= 0) {
+
+			const QueryPolygon &p = polygons[b.polygon_index];
+			const QueryEdge *pe = &edges[p.first_edge];
+
+			for (int i = 2; i < p.edge_count; i++) {
+
+				Face3 f(pe[0].point, pe[i - 1].point, pe[i].point);
+				Vector3 spoint = f.get_closest_point_to(p_point);
+				float d = spoint.distance_squared_to(p_point);
+				if (d < closest_d) {
+					closest_d = d;
+					closest = b.polygon_index;
+					r_closest = spoint;
+					if (r_normal) {
+						*r_normal = f.get_plane().normal;
+					}
+				}
+			}
+		} else {
+
+			// Visit the nearest child first.
+			if (_get_aabb_distance_squared(bvh[b.left].aabb, p_point) < _get_aabb_distance_squared(bvh[b.right].aabb, p_point)) {
+				stack[stack_size++] = b.right;
+				stack[stack_size++] = b.left;
+			} else {
+				stack[stack_size++] = b.left;
+				stack[stack_size++] = b.right;
+			}
+		}
+	}
+
+	return closest;
+}
+
+float Navigation::_get_entry_cost(int p_polygon, const Vector3 &p_entry, const Vector3 &p_end_point) const {
+
+	const QueryPolygon &p = query_polygons[p_polygon];
+
+#ifdef USE_ENTRY_POINT
+	const QueryEdge *pe = &query_edges[p.first_edge];
+	float shortest_distance = 1e30;
+
+	for (int i = 0; i < p.edge_count; i++) {
+
+		if (pe[i].link < 0)
+			continue;
+
+		Vector3 edge[2] = {
+			pe[i].point,
+			pe[(i + 1) % p.edge_count].point
+		};
+
+		Vector3 edge_point = Geometry::get_closest_point_to_segment(p_entry, edge);
+		float dist = p_entry.distance_to(edge_point);
+		if (dist < shortest_distance)
+			shortest_distance = dist;
+	}
+
+	return shortest_distance;
+#else
+	return p.center.distance_to(p_end_point);
+#endif
+}
+
+Navigation::QueryState *Navigation::_alloc_query_state() {
+
+	MutexLock lock(state_mutex);
+
+	if (free_states.empty()) {
+		return memnew(QueryState);
+	}
+
+	QueryState *state = free_states[free_states.size() - 1];
+	free_states.resize(free_states.size() - 1);
+	return state;
+}
+
+void Navigation::_free_query_state(QueryState *p_state) {
+
+	MutexLock lock(state_mutex);
+	free_states.push_back(p_state);
+}
+
+void Navigation::_clip_path(const QueryState *p_state, FrameVector<Vector3> &path, int p_from_poly, const Vector3 &p_to_point, int p_to_poly) {
 
 	Vector3 from = path[path.size() - 1];
 
@@ -249,14 +579,17 @@ void Navigation::_clip_path(Vector<Vector3> &path, Polygon *from_poly, const Vec
 	cut_plane.normal.normalize();
 	cut_plane.d = cut_plane.normal.dot(from);
 
+	int from_poly = p_from_poly;
+
 	while (from_poly != p_to_poly) {
 
-		int pe = from_poly->prev_edge;
-		Vector3 a = _get_vertex(from_poly->edges[pe].point);
-		Vector3 b = _get_vertex(from_poly->edges[(pe + 1) % from_poly->edges.size()].point);
+		const QueryPolygon &p = query_polygons[from_poly];
+		int pe = p_state->polygons[from_poly].prev_edge;
+		Vector3 a = query_edges[p.first_edge + pe].point;
+		Vector3 b = query_edges[p.first_edge + (pe + 1) % p.edge_count].point;
 
-		from_poly = from_poly->edges[pe].C;
-		ERR_FAIL_COND(!from_poly);
+		from_poly = query_edges[p.first_edge + pe].link;
+		ERR_FAIL_COND(from_poly < 0);
 
 		if (a.distance_to(b) > CMP_EPSILON) {
 
@@ -272,45 +605,15 @@ void Navigation::_clip_path(Vector<Vector3> &path, Polygon *from_poly, const Vec
 
 Vector<Vector3> Navigation::get_simple_path(const Vector3 &p_start, const Vector3 &p_end, bool p_optimize) {
 
-	Polygon *begin_poly = NULL;
-	Polygon *end_poly = NULL;
+	_update_query_data();
+	RWLockRead r(query_lock);
+
 	Vector3 begin_point;
 	Vector3 end_point;
-	float begin_d = 1e20;
-	float end_d = 1e20;
-
-	for (Map<int, NavMesh>::Element *E = navmesh_map.front(); E; E = E->next()) {
-
-		if (!E->get().linked)
-			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
-
-			Polygon &p = F->get();
-			for (int i = 2; i < p.edges.size(); i++) {
-
-				Face3 f(_get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point));
-				Vector3 spoint = f.get_closest_point_to(p_start);
-				float dpoint = spoint.distance_to(p_start);
-				if (dpoint < begin_d) {
-					begin_d = dpoint;
-					begin_poly = &p;
-					begin_point = spoint;
-				}
-
-				spoint = f.get_closest_point_to(p_end);
-				dpoint = spoint.distance_to(p_end);
-				if (dpoint < end_d) {
-					end_d = dpoint;
-					end_poly = &p;
-					end_point = spoint;
-				}
-			}
-
-			p.prev_edge = -1;
-		}
-	}
+	int begin_poly = _find_closest_polygon(p_start, begin_point, NULL);
+	int end_poly = _find_closest_polygon(p_end, end_point, NULL);
 
-	if (!begin_poly || !end_poly) {
+	if (begin_poly < 0 || end_poly < 0) {
 
 		return Vector<Vector3>(); //no path
 	}
@@ -324,141 +627,119 @@ Vector<Vector3> Navigation::get_simple_path(const Vector3 &p_start, const Vector
 		return path;
 	}
 
-	bool found_route = false;
+	const QueryPolygon *polygons = query_polygons.ptr();
+	const QueryEdge *edges = query_edges.ptr();
 
-	List<Polygon *> open_list;
+	QueryState *state = _alloc_query_state();
+	uint32_t pass = state->begin(query_polygons.size());
+	QueryState::PolygonState *ps = state->polygons.ptrw();
 
-	for (int i = 0; i < begin_poly->edges.size(); i++) {
+	bool found_route = false;
 
-		if (begin_poly->edges[i].C) {
+	ps[begin_poly].pass = pass;
+	ps[begin_poly].closed_pass = pass;
+	ps[begin_poly].prev_edge = -1;
+	ps[begin_poly].distance = 0;
+	ps[begin_poly].entry = begin_point;
 
-			begin_poly->edges[i].C->prev_edge = begin_poly->edges[i].C_edge;
-#ifdef USE_ENTRY_POINT
-			Vector3 edge[2] = {
-				_get_vertex(begin_poly->edges[i].point),
-				_get_vertex(begin_poly->edges[(i + 1) % begin_poly->edges.size()].point)
-			};
+	const QueryPolygon &bp = polygons[begin_poly];
+	for (int i = 0; i < bp.edge_count; i++) {
 
-			Vector3 entry = Geometry::get_closest_point_to_segment(begin_poly->entry, edge);
-			begin_poly->edges[i].C->distance = begin_poly->entry.distance_to(entry);
-			begin_poly->edges[i].C->entry = entry;
-#else
-			begin_poly->edges[i].C->distance = begin_poly->center.distance_to(begin_poly->edges[i].C->center);
-#endif
-			open_list.push_back(begin_poly->edges[i].C);
+		const QueryEdge &e = edges[bp.first_edge + i];
+		if (e.link < 0)
+			continue;
 
-			if (begin_poly->edges[i].C == end_poly) {
-				found_route = true;
-			}
-		}
-	}
+		Vector3 edge[2] = {
+			e.point,
+			edges[bp.first_edge + (i + 1) % bp.edge_count].point
+		};
 
-	while (!found_route) {
+		QueryState::PolygonState &c = ps[e.link];
+		c.entry = Geometry::get_closest_point_to_segment(begin_point, edge);
+		c.distance = begin_point.distance_to(c.entry);
+		c.prev_edge = e.link_edge;
+		c.pass = pass;
+		state->push(e.link, c.distance + _get_entry_cost(e.link, c.entry, end_point));
 
-		if (open_list.size() == 0) {
-			break;
+		if (e.link == end_poly) {
+			found_route = true;
 		}
-		//check open list
-
-		List<Polygon *>::Element *least_cost_poly = NULL;
-		float least_cost = 1e30;
-
-		//this could be faster (cache previous results)
-		for (List<Polygon *>::Element *E = open_list.front(); E; E = E->next()) {
-
-			Polygon *p = E->get();
-
-			float cost = p->distance;
-#ifdef USE_ENTRY_POINT
-			int es = p->edges.size();
-
-			float shortest_distance = 1e30;
-
-			for (int i = 0; i < es; i++) {
-				Polygon::Edge &e = p->edges.write[i];
-
-				if (!e.C)
-					continue;
+	}
 
-				Vector3 edge[2] = {
-					_get_vertex(p->edges[i].point),
-					_get_vertex(p->edges[(i + 1) % es].point)
-				};
+	while (!found_route && state->open_size) {
 
-				Vector3 edge_point = Geometry::get_closest_point_to_segment(p->entry, edge);
-				float dist = p->entry.distance_to(edge_point);
-				if (dist < shortest_distance)
-					shortest_distance = dist;
-			}
+		int pi = state->pop();
+		if (ps[pi].closed_pass == pass)
+			continue; // Stale entry, reached again with a lower cost.
+		ps[pi].closed_pass = pass;
 
-			cost += shortest_distance;
-#else
-			cost += p->center.distance_to(end_point);
-#endif
-			if (cost < least_cost) {
-				least_cost_poly = E;
-				least_cost = cost;
-			}
-		}
+		const QueryPolygon &p = polygons[pi];
 
-		Polygon *p = least_cost_poly->get();
 		//open the neighbours for search
+		for (int i = 0; i < p.edge_count; i++) {
 
-		for (int i = 0; i < p->edges.size(); i++) {
+			const QueryEdge &e = edges[p.first_edge + i];
+			if (e.link < 0)
+				continue;
 
-			Polygon::Edge &e = p->edges.write[i];
+			Vector3 edge[2] = {
+				e.point,
+				edges[p.first_edge + (i + 1) % p.edge_count].point
+			};
 
-			if (!e.C)
-				continue;
+			Vector3 edge_entry = Geometry::get_closest_point_to_segment(ps[pi].entry, edge);
+			float distance = p.center.distance_to(polygons[e.link].center) + ps[pi].distance;
 
-			float distance = p->center.distance_to(e.C->center) + p->distance;
+			QueryState::PolygonState &c = ps[e.link];
 
-			if (e.C->prev_edge != -1) {
+			if (c.pass == pass) {
 				//oh this was visited already, can we win the cost?
 
-				if (e.C->distance > distance) {
+				if (c.distance > distance) {
 
-					e.C->prev_edge = e.C_edge;
-					e.C->distance = distance;
+					c.prev_edge = e.link_edge;
+					c.distance = distance;
+					c.entry = edge_entry;
+					if (c.closed_pass != pass) {
+						state->push(e.link, distance + _get_entry_cost(e.link, edge_entry, end_point));
+					}
 				}
 			} else {
 				//add to open neighbours
 
-				e.C->prev_edge = e.C_edge;
-				e.C->distance = distance;
-				open_list.push_back(e.C);
+				c.prev_edge = e.link_edge;
+				c.distance = distance;
+				c.entry = edge_entry;
+				c.pass = pass;
+				state->push(e.link, distance + _get_entry_cost(e.link, edge_entry, end_point));
 
-				if (e.C == end_poly) {
+				if (e.link == end_poly) {
 					//oh my reached end! stop algorithm
 					found_route = true;
 					break;
 				}
 			}
 		}
-
-		if (found_route)
-			break;
-
-		open_list.erase(least_cost_poly);
 	}
 
-	if (found_route) {
+	// built backwards in frame memory, then copied out in order
+	FrameVector<Vector3> path;
 
-		Vector<Vector3> path;
+	if (found_route) {
 
 		if (p_optimize) {
 			//string pulling
 
-			Polygon *apex_poly = end_poly;
+			int apex_poly = end_poly;
 			Vector3 apex_point = end_point;
 			Vector3 portal_left = apex_point;
 			Vector3 portal_right = apex_point;
-			Polygon *left_poly = end_poly;
-			Polygon *right_poly = end_poly;
-			Polygon *p = end_poly;
+			int left_poly = end_poly;
+			int right_poly = end_poly;
+			int p = end_poly;
 			path.push_back(end_point);
 
-			while (p) {
+			while (p != -1) {
 
 				Vector3 left;
 				Vector3 right;
@@ -469,13 +750,14 @@ Vector<Vector3> Navigation::get_simple_path(const Vector3 &p_start, const Vector
 					left = begin_point;
 					right = begin_point;
 				} else {
-					int prev = p->prev_edge;
-					int prev_n = (p->prev_edge + 1) % p->edges.size();
-					left = _get_vertex(p->edges[prev].point);
-					right = _get_vertex(p->edges[prev_n].point);
+					const QueryPolygon &qp = polygons[p];
+					int prev = ps[p].prev_edge;
+					int prev_n = (prev + 1) % qp.edge_count;
+					left = edges[qp.first_edge + prev].point;
+					right = edges[qp.first_edge + prev_n].point;
 
 					//if (CLOCK_TANGENT(apex_point,left,(left+right)*0.5).dot(up) < 0){
-					if (p->clockwise) {
+					if (qp.clockwise) {
 						SWAP(left, right);
 					}
 				}
@@ -489,7 +771,7 @@ Vector<Vector3> Navigation::get_simple_path(const Vector3 &p_start, const Vector
 						portal_left = left;
 					} else {
 
-						_clip_path(path, apex_poly, portal_right, right_poly);
+						_clip_path(state, path, apex_poly, portal_right, right_poly);
 
 						apex_point = portal_right;
 						p = right_poly;
@@ -509,7 +791,7 @@ Vector<Vector3> Navigation::get_simple_path(const Vector3 &p_start, const Vector
 						portal_right = right;
 					} else {
 
-						_clip_path(path, apex_poly, portal_left, left_poly);
+						_clip_path(state, path, apex_poly, portal_left, left_poly);
 
 						apex_point = portal_left;
 						p = left_poly;
@@ -522,116 +804,133 @@ Vector<Vector3> Navigation::get_simple_path(const Vector3 &p_start, const Vector
 				}
 
 				if (p != begin_poly)
-					p = p->edges[p->prev_edge].C;
+					p = edges[polygons[p].first_edge + ps[p].prev_edge].link;
 				else
-					p = NULL;
+					p = -1;
 			}
 
 			if (path[path.size() - 1] != begin_point)
 				path.push_back(begin_point);
 
-			path.invert();
-
 		} else {
 			//midpoints
-			Polygon *p = end_poly;
+			int p = end_poly;
 
 			path.push_back(end_point);
 			while (true) {
-				int prev = p->prev_edge;
-				int prev_n = (p->prev_edge + 1) % p->edges.size();
-				Vector3 point = (_get_vertex(p->edges[prev].point) + _get_vertex(p->edges[prev_n].point)) * 0.5;
+				const QueryPolygon &qp = polygons[p];
+				int prev = ps[p].prev_edge;
+				int prev_n = (prev + 1) % qp.edge_count;
+				Vector3 point = (edges[qp.first_edge + prev].point + edges[qp.first_edge + prev_n].point) * 0.5;
 				path.push_back(point);
-				p = p->edges[prev].C;
+				p = edges[qp.first_edge + prev].link;
 				if (p == begin_poly)
 					break;
 			}
 
 			path.push_back(begin_point);
-
-			path.invert();
 		}
+	}
 
-		return path;
+	_free_query_state(state);
+
+	Vector<Vector3> result;
+	result.resize(path.size());
+	Vector3 *w = result.ptrw();
+	for (int i = 0; i < path.size(); i++) {
+		w[i] = path[path.size() - i - 1];
 	}
 
-	return Vector<Vector3>();
+	return result;
 }
 
 Vector3 Navigation::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool &p_use_collision) {
 
-	bool use_collision = p_use_collision;
-	Vector3 closest_point;
-	float closest_point_d = 1e20;
-
-	for (Map<int, NavMesh>::Element *E = navmesh_map.front(); E; E = E->next()) {
+	_update_query_data();
+	RWLockRead r(query_lock);
 
-		if (!E->get().linked)
-			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
+	Vector3 closest_point;
+	if (query_bvh.empty())
+		return closest_point;
 
-			Polygon &p = F->get();
-			for (int i = 2; i < p.edges.size(); i++) {
+	const BVH *bvh = query_bvh.ptr();
+	const QueryPolygon *polygons = query_polygons.ptr();
+	const QueryEdge *edges = query_edges.ptr();
 
-				Face3 f(_get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point));
-				Vector3 inters;
-				if (f.intersects_segment(p_from, p_to, &inters)) {
+	int *stack = (int *)alloca(sizeof(int) * (query_bvh_depth + 1));
+	int stack_size = 1;
+	stack[0] = query_bvh.size() - 1;
 
-					if (!use_collision) {
-						closest_point = inters;
-						use_collision = true;
-						closest_point_d = p_from.distance_to(inters);
-					} else if (closest_point_d > inters.distance_to(p_from)) {
+	bool collided = false;
+	float closest_point_d = 1e20;
 
-						closest_point = inters;
-						closest_point_d = p_from.distance_to(inters);
-					}
-				}
-			}
+	// Closest intersection with the navmesh faces.
+	while (stack_size) {
 
-			if (!use_collision) {
+		const BVH &b = bvh[stack[--stack_size]];
+		if (!b.aabb.intersects_segment(p_from, p_to))
+			continue;
 
-				for (int i = 0; i < p.edges.size(); i++) {
+		if (b.polygon_index < 0) {
+			stack[stack_size++] = b.left;
+			stack[stack_size++] = b.right;
+			continue;
+		}
 
-					Vector3 a, b;
+		const QueryPolygon &p = polygons[b.polygon_index];
+		const QueryEdge *pe = &edges[p.first_edge];
 
-					Geometry::get_closest_points_between_segments(p_from, p_to, _get_vertex(p.edges[i].point), _get_vertex(p.edges[(i + 1) % p.edges.size()].point), a, b);
+		for (int i = 2; i < p.edge_count; i++) {
 
-					float d = a.distance_to(b);
-					if (d < closest_point_d) {
+			Face3 f(pe[0].point, pe[i - 1].point, pe[i].point);
+			Vector3 inters;
+			if (f.intersects_segment(p_from, p_to, &inters)) {
 
-						closest_point_d = d;
-						closest_point = b;
-					}
+				float d = p_from.distance_to(inters);
+				if (d < closest_point_d) {
+					closest_point = inters;
+					closest_point_d = d;
+					collided = true;
 				}
 			}
 		}
 	}
 
-	return closest_point;
-}
+	if (collided || p_use_collision)
+		return closest_point;
 
-Vector3 Navigation::get_closest_point(const Vector3 &p_point) {
+	// No intersection, look for the closest polygon edge instead.
+	AABB segment_aabb(p_from, Vector3());
+	segment_aabb.expand_to(p_to);
 
-	Vector3 closest_point;
-	float closest_point_d = 1e20;
+	stack_size = 1;
+	stack[0] = query_bvh.size() - 1;
 
-	for (Map<int, NavMesh>::Element *E = navmesh_map.front(); E; E = E->next()) {
+	while (stack_size) {
 
-		if (!E->get().linked)
+		const BVH &b = bvh[stack[--stack_size]];
+		if (_get_aabb_distance_squared(b.aabb, segment_aabb) > closest_point_d * closest_point_d)
 			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
 
-			Polygon &p = F->get();
-			for (int i = 2; i < p.edges.size(); i++) {
+		if (b.polygon_index < 0) {
+			stack[stack_size++] = b.left;
+			stack[stack_size++] = b.right;
+			continue;
+		}
 
-				Face3 f(_get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point));
-				Vector3 inters = f.get_closest_point_to(p_point);
-				float d = inters.distance_to(p_point);
-				if (d < closest_point_d) {
-					closest_point = inters;
-					closest_point_d = d;
-				}
+		const QueryPolygon &p = polygons[b.polygon_index];
+		const QueryEdge *pe = &edges[p.first_edge];
+
+		for (int i = 0; i < p.edge_count; i++) {
+
+			Vector3 a, c;
+			Geometry::get_closest_points_between_segments(p_from, p_to, pe[i].point, pe[(i + 1) % p.edge_count].point, a, c);
+
+			float d = a.distance_to(c);
+			if (d < closest_point_d) {
+
+				closest_point_d = d;
+				closest_point = c;
 			}
 		}
 	}
@@ -639,64 +938,38 @@ Vector3 Navigation::get_closest_point(const Vector3 &p_point) {
 	return closest_point;
 }
 
-Vector3 Navigation::get_closest_point_normal(const Vector3 &p_point) {
+Vector3 Navigation::get_closest_point(const Vector3 &p_point) {
+
+	_update_query_data();
+	RWLockRead r(query_lock);
 
 	Vector3 closest_point;
-	Vector3 closest_normal;
-	float closest_point_d = 1e20;
+	_find_closest_polygon(p_point, closest_point, NULL);
 
-	for (Map<int, NavMesh>::Element *E = navmesh_map.front(); E; E = E->next()) {
+	return closest_point;
+}
 
-		if (!E->get().linked)
-			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
+Vector3 Navigation::get_closest_point_normal(const Vector3 &p_point) {
 
-			Polygon &p = F->get();
-			for (int i = 2; i < p.edges.size(); i++) {
+	_update_query_data();
+	RWLockRead r(query_lock);
 
-				Face3 f(_get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point));
-				Vector3 inters = f.get_closest_point_to(p_point);
-				float d = inters.distance_to(p_point);
-				if (d < closest_point_d) {
-					closest_point = inters;
-					closest_point_d = d;
-					closest_normal = f.get_plane().normal;
-				}
-			}
-		}
-	}
+	Vector3 closest_point;
+	Vector3 closest_normal;
+	_find_closest_polygon(p_point, closest_point, &closest_normal);
 
 	return closest_normal;
 }
 
 Object *Navigation::get_closest_point_owner(const Vector3 &p_point) {
 
-	Vector3 closest_point;
-	Object *owner = NULL;
-	float closest_point_d = 1e20;
-
-	for (Map<int, NavMesh>::Element *E = navmesh_map.front(); E; E = E->next()) {
-
-		if (!E->get().linked)
-			continue;
-		for (List<Polygon>::Element *F = E->get().polygons.front(); F; F = F->next()) {
-
-			Polygon &p = F->get();
-			for (int i = 2; i < p.edges.size(); i++) {
+	_update_query_data();
+	RWLockRead r(query_lock);
 
-				Face3 f(_get_vertex(p.edges[0].point), _get_vertex(p.edges[i - 1].point), _get_vertex(p.edges[i].point));
-				Vector3 inters = f.get_closest_point_to(p_point);
-				float d = inters.distance_to(p_point);
-				if (d < closest_point_d) {
-					closest_point = inters;
-					closest_point_d = d;
-					owner = E->get().owner;
-				}
-			}
-		}
-	}
+	Vector3 closest_point;
+	int polygon = _find_closest_polygon(p_point, closest_point, NULL);
 
-	return owner;
+	return polygon >= 0 ? query_polygons[polygon].owner : NULL;
 }
 
 void Navigation::set_up_vector(const Vector3 &p_up) {
@@ -733,4 +1006,21 @@ Navigation::Navigation() {
 	cell_size = 0.01; //one centimeter
 	last_id = 1;
 	up = Vector3(0, 1, 0);
+
+	query_bvh_depth = 0;
+	query_dirty = false;
+	query_lock = RWLock::create();
+	state_mutex = Mutex::create();
+}
+
+Navigation::~Navigation() {
+
+	for (int i = 0; i < free_states.size(); i++) {
+		memdelete(free_states[i]);
+	}
+
+	if (query_lock)
+		memdelete(query_lock);
+	if (state_mutex)
+		memdelete(state_mutex);
 }
@@ -31,6 +31,9 @@
 #ifndef NAVIGATION_H
 #define NAVIGATION_H
 
+#include "core/frame_vector.h"
+#include "core/os/mutex.h"
+#include "core/os/rw_lock.h"
 #include "scene/3d/navigation_mesh.h"
 #include "scene/3d/spatial.h"
 
@@ -94,12 +97,9 @@ class Navigation : public Spatial {
 		Vector<Edge> edges;
 
 		Vector3 center;
-		Vector3 entry;
-
-		float distance;
-		int prev_edge;
 		bool clockwise;
 
+		int index; // Slot in query_polygons.
 		NavMesh *owner;
 	};
 
@@ -158,7 +158,116 @@ class Navigation : public Spatial {
 	int last_id;
 
 	Vector3 up;
-	void _clip_path(Vector<Vector3> &path, Polygon *from_poly, const Vector3 &p_to_point, Polygon *p_to_poly);
+
+	// Flat copy of the linked polygons, rebuilt lazily after edits. Queries
+	// only read it (under query_lock), so they can run from several threads.
+	struct QueryEdge {
+
+		Vector3 point;
+		int link; // Connected polygon, -1 if none.
+		int link_edge;
+	};
+
+	struct QueryPolygon {
+
+		int first_edge;
+		int edge_count;
+		Vector3 center;
+		bool clockwise;
+		Object *owner;
+	};
+
+	struct BVH {
+
+		AABB aabb;
+		Vector3 center; //used for sorting
+		int left;
+		int right;
+
+		int polygon_index;
+	};
+
+	struct BVHCmpX {
+
+		bool operator()(const BVH *p_left, const BVH *p_right) const {
+
+			return p_left->center.x < p_right->center.x;
+		}
+	};
+
+	struct BVHCmpY {
+
+		bool operator()(const BVH *p_left, const BVH *p_right) const {
+
+			return p_left->center.y < p_right->center.y;
+		}
+	};
+
+	struct BVHCmpZ {
+
+		bool operator()(const BVH *p_left, const BVH *p_right) const {
+
+			return p_left->center.z < p_right->center.z;
+		}
+	};
+
+	// Path search scratch data, one per concurrent query.
+	struct QueryState {
+
+		struct PolygonState {
+
+			uint32_t pass;
+			uint32_t closed_pass;
+			int prev_edge;
+			float distance;
+			Vector3 entry;
+		};
+
+		struct OpenEntry {
+
+			float cost;
+			int polygon;
+		};
+
+		struct OpenComparator {
+
+			_FORCE_INLINE_ bool operator()(const OpenEntry &A, const OpenEntry &B) const { return A.cost > B.cost; }
+		};
+
+		Vector<PolygonState> polygons;
+		Vector<OpenEntry> open;
+		int open_size;
+		uint32_t pass;
+
+		uint32_t begin(int p_polygon_count);
+		void push(int p_polygon, float p_cost);
+		int pop();
+
+		QueryState() {
+			open_size = 0;
+			pass = 0;
+		}
+	};
+
+	Vector<QueryEdge> query_edges;
+	Vector<QueryPolygon> query_polygons;
+	Vector<BVH> query_bvh;
+	int query_bvh_depth;
+	bool query_dirty;
+
+	RWLock *query_lock;
+	Mutex *state_mutex;
+	Vector<QueryState *> free_states;
+
+	int _create_bvh(BVH *p_bvh, BVH **p_bb, int p_from, int p_size, int p_depth, int &r_max_depth, int &r_max_alloc);
+	void _update_query_data();
+	int _find_closest_polygon(const Vector3 &p_point, Vector3 &r_closest, Vector3 *r_normal) const;
+	float _get_entry_cost(int p_polygon, const Vector3 &p_entry, const Vector3 &p_end_point) const;
+
+	QueryState *_alloc_query_state();
+	void _free_query_state(QueryState *p_state);
+
+	void _clip_path(const QueryState *p_state, FrameVector<Vector3> &path, int p_from_poly, const Vector3 &p_to_point, int p_to_poly);
 
 protected:
 	static void _bind_methods();
@@ -179,6 +288,7 @@ public:
 	Object *get_closest_point_owner(const Vector3 &p_point);
 
 	Navigation();
+	~Navigation();
 };
 
 #endif // NAVIGATION_H
@@ -216,6 +216,10 @@ void Skeleton::_notification(int p_what) {
 
 			vs->skeleton_allocate(skeleton, len); // if same size, nothing really happens
 
+			// structural changes (hierarchy, rests, enabled state, bone count) invalidate every bone,
+			// otherwise only bones whose pose changed and their descendants are recomputed
+			bool update_all = rest_global_inverse_dirty || process_order_dirty || bone_buffer.size() != len * 12;
+
 			_update_process_order();
 
 			const int *order = process_order.ptr();
@@ -239,67 +243,86 @@ void Skeleton::_notification(int p_what) {
 				rest_global_inverse_dirty = false;
 			}
 
-			for (int i = 0; i < len; i++) {
-
-				Bone &b = bonesptr[order[i]];
-
-				if (b.disable_rest) {
-					if (b.enabled) {
-
-						Transform pose = b.pose;
-						if (b.custom_pose_enable) {
-
-							pose = b.custom_pose * pose;
-						}
-
-						if (b.parent >= 0) {
+			if (bone_buffer.size() != len * 12) {
+				bone_buffer.resize(len * 12);
+			}
 
-							b.pose_global = bonesptr[b.parent].pose_global * pose;
-						} else {
+			// local transforms do not depend on the hierarchy, so build them in one pass over the bone array
+			for (int i = 0; i < len; i++) {
 
-							b.pose_global = pose;
-						}
-					} else {
+				Bone &b = bonesptr[i];
+				if (!update_all && !b.pose_dirty)
+					continue;
 
-						if (b.parent >= 0) {
+				if (b.enabled) {
 
-							b.pose_global = bonesptr[b.parent].pose_global;
-						} else {
+					Transform pose = b.pose;
+					if (b.custom_pose_enable) {
 
-							b.pose_global = Transform();
-						}
+						pose = b.custom_pose * pose;
 					}
-
+					b.pose_local = b.disable_rest ? pose : b.rest * pose;
 				} else {
-					if (b.enabled) {
 
-						Transform pose = b.pose;
-						if (b.custom_pose_enable) {
+					b.pose_local = b.disable_rest ? Transform() : b.rest;
+				}
+			}
 
-							pose = b.custom_pose * pose;
-						}
+			// concatenate in process order, propagating changes down the hierarchy
+			int changed = 0;
+			{
+				PoolVector<float>::Write w = bone_buffer.write();
+				float *dataptr = w.ptr();
 
-						if (b.parent >= 0) {
+				for (int i = 0; i < len; i++) {
 
-							b.pose_global = bonesptr[b.parent].pose_global * (b.rest * pose);
-						} else {
+					int idx = order[i];
+					Bone &b = bonesptr[idx];
 
-							b.pose_global = b.rest * pose;
-						}
-					} else {
+					b.global_changed = update_all || b.pose_dirty || (b.parent >= 0 && bonesptr[b.parent].global_changed);
+					b.pose_dirty = false;
+
+					if (!b.global_changed)
+						continue;
 
-						if (b.parent >= 0) {
+					if (b.parent >= 0) {
 
-							b.pose_global = bonesptr[b.parent].pose_global * b.rest;
-						} else {
+						b.pose_global = bonesptr[b.parent].pose_global * b.pose_local;
+					} else {
 
-							b.pose_global = b.rest;
-						}
+						b.pose_global = b.pose_local;
 					}
+
+					b.transform_final = b.pose_global * b.rest_global_inverse;
+
+					const Transform &t = b.transform_final;
+					float *dataw = &dataptr[idx * 12];
+					dataw[0] = t.basis.elements[0][0];
+					dataw[1] = t.basis.elements[0][1];
+					dataw[2] = t.basis.elements[0][2];
+					dataw[3] = t.origin.x;
+					dataw[4] = t.basis.elements[1][0];
+					dataw[5] = t.basis.elements[1][1];
+					dataw[6] = t.basis.elements[1][2];
+					dataw[7] = t.origin.y;
+					dataw[8] = t.basis.elements[2][0];
+					dataw[9] = t.basis.elements[2][1];
+					dataw[10] = t.basis.elements[2][2];
+					dataw[11] = t.origin.z;
+
+					changed++;
 				}
+			}
+
+			if (changed) {
+				vs->skeleton_set_as_bulk_array(skeleton, bone_buffer);
+			}
 
-				b.transform_final = b.pose_global * b.rest_global_inverse;
-				vs->skeleton_bone_set_transform(skeleton, order[i], b.transform_final);
+			for (int i = 0; changed && i < len; i++) {
+
+				Bone &b = bonesptr[order[i]];
+				if (!b.global_changed)
+					continue;
 
 				for (List<uint32_t>::Element *E = b.nodes_bound.front(); E; E = E->next()) {
 
@@ -447,6 +470,7 @@ void Skeleton::set_bone_disable_rest(int p_bone, bool p_disable) {
 
 	ERR_FAIL_INDEX(p_bone, bones.size());
 	bones.write[p_bone].disable_rest = p_disable;
+	_make_bone_dirty(p_bone);
 }
 
 bool Skeleton::is_bone_rest_disabled(int p_bone) const {
@@ -542,6 +566,7 @@ void Skeleton::set_bone_pose(int p_bone, const Transform &p_pose) {
 	ERR_FAIL_INDEX(p_bone, bones.size());
 
 	bones.write[p_bone].pose = p_pose;
+	bones.write[p_bone].pose_dirty = true;
 	if (is_inside_tree()) {
 		_make_dirty();
 	}
@@ -560,7 +585,7 @@ void Skeleton::set_bone_custom_pose(int p_bone, const Transform &p_custom_pose)
 	bones.write[p_bone].custom_pose_enable = (p_custom_pose != Transform());
 	bones.write[p_bone].custom_pose = p_custom_pose;
 
-	_make_dirty();
+	_make_bone_dirty(p_bone);
 }
 
 Transform Skeleton::get_bone_custom_pose(int p_bone) const {
@@ -569,6 +594,12 @@ Transform Skeleton::get_bone_custom_pose(int p_bone) const {
 	return bones[p_bone].custom_pose;
 }
 
+void Skeleton::_make_bone_dirty(int p_bone) {
+
+	bones.write[p_bone].pose_dirty = true;
+	_make_dirty();
+}
+
 void Skeleton::_make_dirty() {
 
 	if (dirty)
@@ -70,6 +70,10 @@ class Skeleton : public Spatial {
 
 		Transform transform_final;
 
+		Transform pose_local; // rest * custom_pose * pose, cached between updates
+		bool pose_dirty; // pose, custom pose or disable_rest changed since last update
+		bool global_changed; // pose_global changed in the current update
+
 #ifndef _3D_DISABLED
 		PhysicalBone *physical_bone;
 		PhysicalBone *cache_parent_physical_bone;
@@ -83,6 +87,8 @@ class Skeleton : public Spatial {
 			ignore_animation = false;
 			custom_pose_enable = false;
 			disable_rest = false;
+			pose_dirty = true;
+			global_changed = false;
 #ifndef _3D_DISABLED
 			physical_bone = NULL;
 			cache_parent_physical_bone = NULL;
@@ -98,7 +104,10 @@ class Skeleton : public Spatial {
 
 	RID skeleton;
 
+	PoolVector<float> bone_buffer; // 12 floats per bone, uploaded in bulk
+
 	void _make_dirty();
+	void _make_bone_dirty(int p_bone);
 	bool dirty;
 	bool use_bones_in_world_transform;
 
@@ -33,6 +33,7 @@
 #include "animation_blend_tree.h"
 #include "core/engine.h"
 #include "core/method_bind_ext.gen.inc"
+#include "core/project_settings.h"
 #include "scene/scene_string_names.h"
 #include "servers/audio/audio_stream.h"
 
@@ -110,7 +111,7 @@ void AnimationNode::blend_animation(const StringName &p_animation, float p_time,
 
 	AnimationState anim_state;
 	anim_state.blend = p_blend;
-	anim_state.track_blends = &blends;
+	anim_state.track_blends = blends;
 	anim_state.delta = p_delta;
 	anim_state.time = p_time;
 	anim_state.animation = animation;
@@ -535,6 +536,18 @@ AnimationTree::AnimationProcessMode AnimationTree::get_process_mode() const {
 }
 
 void AnimationTree::_node_removed(Node *p_node) {
+
+	if (pending_blend.in_list()) {
+		//the pending blend still applies, minus the tracks that point to the removed node
+		const NodePath *K = NULL;
+		while ((K = track_cache.next(K))) {
+			TrackCache *track = track_cache[*K];
+			if (track->node == p_node) {
+				track->setup_pass = 0; //skipped until the caches are updated
+			}
+		}
+	}
+
 	cache_valid = false;
 }
 
@@ -691,6 +704,7 @@ bool AnimationTree::_update_caches(AnimationPlayer *player) {
 					}
 				}
 
+				track->node = child;
 				track_cache[path] = track;
 			}
 
@@ -733,6 +747,11 @@ bool AnimationTree::_update_caches(AnimationPlayer *player) {
 
 void AnimationTree::_clear_caches() {
 
+	if (pending_blend.in_list()) {
+		pending_blends->remove(&pending_blend); //the caches it would blend into are going away
+		state.animation_states.clear();
+	}
+
 	const NodePath *K = NULL;
 	while ((K = track_cache.next(K))) {
 		memdelete(track_cache[*K]);
@@ -743,13 +762,25 @@ void AnimationTree::_clear_caches() {
 	cache_valid = false;
 }
 
-void AnimationTree::_process_graph(float p_delta) {
+void AnimationTree::_process_graph(float p_delta, bool p_allow_deferred) {
+
+	if (pending_blend.in_list()) {
+		// still waiting for the last frame's blend, finish it first
+		pending_blends->remove(&pending_blend);
+		_blend_tracks();
+		_apply_tracks();
+	}
 
 	_update_properties(); //if properties need updating, update them
 
 	//check all tracks, see if they need modification
 
-	root_motion_transform = Transform();
+	bool deferred = p_allow_deferred && blend_pool && is_inside_tree();
+
+	if (!deferred) {
+		// when deferred, the previous root motion stays readable until the new one is applied
+		root_motion_transform = Transform();
+	}
 
 	if (!root.is_valid()) {
 		ERR_PRINT("AnimationTree: root AnimationNode is not set, disabling playback.");
@@ -837,99 +868,131 @@ void AnimationTree::_process_graph(float p_delta) {
 	}
 
 	if (!state.valid) {
+		root_motion_transform = Transform();
 		return; //state is not valid. do nothing.
 	}
-	//apply value/transform/bezier blends to track caches and execute method/audio/animation tracks
 
-	{
+	if (deferred) {
+		pending_blends->add(&pending_blend);
+		return; //sampled and blended along with the other trees in flush_pending_blends()
+	}
 
-		bool can_call = is_inside_tree() && !Engine::get_singleton()->is_editor_hint();
+	_blend_tracks();
+	_apply_tracks();
+}
 
-		for (List<AnimationNode::AnimationState>::Element *E = state.animation_states.front(); E; E = E->next()) {
+static bool _is_track_blended(const Ref<Animation> &p_animation, int p_track) {
 
-			const AnimationNode::AnimationState &as = E->get();
+	switch (p_animation->track_get_type(p_track)) {
 
-			Ref<Animation> a = as.animation;
-			float time = as.time;
-			float delta = as.delta;
-			bool seeked = as.seeked;
+		case Animation::TYPE_TRANSFORM:
+		case Animation::TYPE_BEZIER: {
 
-			for (int i = 0; i < a->get_track_count(); i++) {
+			return true;
+		}
+		case Animation::TYPE_VALUE: {
 
-				NodePath path = a->track_get_path(i);
+			Animation::UpdateMode update_mode = p_animation->value_track_get_update_mode(p_track);
+			return update_mode == Animation::UPDATE_CONTINUOUS || update_mode == Animation::UPDATE_CAPTURE; //delta == 0 means seek
+		}
+		default: {
 
-				ERR_CONTINUE(!track_cache.has(path));
+			return false;
+		}
+	}
+}
 
-				TrackCache *track = track_cache[path];
-				if (track->type != a->track_get_type(i)) {
-					continue; //may happen should not
-				}
+AnimationTree::TrackCache *AnimationTree::_get_blended_track(const AnimationNode::AnimationState &p_state, int p_track, float *r_blend) {
 
-				track->root_motion = root_motion_track == path;
+	NodePath path = p_state.animation->track_get_path(p_track);
 
-				ERR_CONTINUE(!state.track_map.has(path));
-				int blend_idx = state.track_map[path];
+	TrackCache **track_ptr = track_cache.getptr(path);
+	ERR_FAIL_COND_V(!track_ptr, NULL);
 
-				ERR_CONTINUE(blend_idx < 0 || blend_idx >= state.track_count);
+	TrackCache *track = *track_ptr;
+	if (track->type != p_state.animation->track_get_type(p_track)) {
+		return NULL; //may happen should not
+	}
 
-				float blend = (*as.track_blends)[blend_idx];
+	if (track->setup_pass != setup_pass) {
+		return NULL; //its node was removed
+	}
 
-				if (blend < CMP_EPSILON)
-					continue; //nothing to blend
+	track->root_motion = root_motion_track == path;
 
-				switch (track->type) {
+	const int *blend_idx = state.track_map.getptr(path);
+	ERR_FAIL_COND_V(!blend_idx, NULL);
+	ERR_FAIL_COND_V(*blend_idx < 0 || *blend_idx >= state.track_count, NULL);
 
-					case Animation::TYPE_TRANSFORM: {
+	float blend = p_state.track_blends[*blend_idx];
 
-						TrackCacheTransform *t = static_cast<TrackCacheTransform *>(track);
+	if (blend < CMP_EPSILON)
+		return NULL; //nothing to blend
 
-						if (track->root_motion) {
+	*r_blend = blend;
+	return track;
+}
 
-							if (t->process_pass != process_pass) {
+// Samples and blends transform, value and bezier tracks into the track caches.
+// Only touches this tree's own state, so different trees can run it in parallel.
+void AnimationTree::_blend_tracks() {
 
-								t->process_pass = process_pass;
-								t->loc = Vector3();
-								t->rot = Quat();
-								t->rot_blend_accum = 0;
-								t->scale = Vector3(1, 1, 1);
-							}
+	for (List<AnimationNode::AnimationState>::Element *E = state.animation_states.front(); E; E = E->next()) {
 
-							float prev_time = time - delta;
-							if (prev_time < 0) {
-								if (!a->has_loop()) {
-									prev_time = 0;
-								} else {
-									prev_time = a->get_length() + prev_time;
-								}
-							}
+		const AnimationNode::AnimationState &as = E->get();
 
-							Vector3 loc[2];
-							Quat rot[2];
-							Vector3 scale[2];
+		Ref<Animation> a = as.animation;
+		float time = as.time;
+		float delta = as.delta;
 
-							if (prev_time > time) {
+		for (int i = 0; i < a->get_track_count(); i++) {
 
-								Error err = a->transform_track_interpolate(i, prev_time, &loc[0], &rot[0], &scale[0]);
-								if (err != OK) {
-									continue;
-								}
+			if (!_is_track_blended(a, i))
+				continue; //handled by _apply_tracks()
+
+			float blend;
+			TrackCache *track = _get_blended_track(as, i, &blend);
+			if (!track)
+				continue;
 
-								a->transform_track_interpolate(i, a->get_length(), &loc[1], &rot[1], &scale[1]);
+			switch (track->type) {
+
+				case Animation::TYPE_TRANSFORM: {
 
-								t->loc += (loc[1] - loc[0]) * blend;
-								t->scale += (scale[1] - scale[0]) * blend;
-								Quat q = Quat().slerp(rot[0].normalized().inverse() * rot[1].normalized(), blend).normalized();
-								t->rot = (t->rot * q).normalized();
+					TrackCacheTransform *t = static_cast<TrackCacheTransform *>(track);
+
+					if (track->root_motion) {
+
+						if (t->process_pass != process_pass) {
 
+							t->process_pass = process_pass;
+							t->loc = Vector3();
+							t->rot = Quat();
+							t->rot_blend_accum = 0;
+							t->scale = Vector3(1, 1, 1);
+						}
+
+						float prev_time = time - delta;
+						if (prev_time < 0) {
+							if (!a->has_loop()) {
 								prev_time = 0;
+							} else {
+								prev_time = a->get_length() + prev_time;
 							}
+						}
+
+						Vector3 loc[2];
+						Quat rot[2];
+						Vector3 scale[2];
+
+						if (prev_time > time) {
 
 							Error err = a->transform_track_interpolate(i, prev_time, &loc[0], &rot[0], &scale[0]);
 							if (err != OK) {
 								continue;
 							}
 
-							a->transform_track_interpolate(i, time, &loc[1], &rot[1], &scale[1]);
+							a->transform_track_interpolate(i, a->get_length(), &loc[1], &rot[1], &scale[1]);
 
 							t->loc += (loc[1] - loc[0]) * blend;
 							t->scale += (scale[1] - scale[0]) * blend;
@@ -937,127 +1000,216 @@ void AnimationTree::_process_graph(float p_delta) {
 							t->rot = (t->rot * q).normalized();
 
 							prev_time = 0;
+						}
 
-						} else {
-							Vector3 loc;
-							Quat rot;
-							Vector3 scale;
+						Error err = a->transform_track_interpolate(i, prev_time, &loc[0], &rot[0], &scale[0]);
+						if (err != OK) {
+							continue;
+						}
 
-							Error err = a->transform_track_interpolate(i, time, &loc, &rot, &scale);
-							//ERR_CONTINUE(err!=OK); //used for testing, should be removed
+						a->transform_track_interpolate(i, time, &loc[1], &rot[1], &scale[1]);
 
-							if (t->process_pass != process_pass) {
+						t->loc += (loc[1] - loc[0]) * blend;
+						t->scale += (scale[1] - scale[0]) * blend;
+						Quat q = Quat().slerp(rot[0].normalized().inverse() * rot[1].normalized(), blend).normalized();
+						t->rot = (t->rot * q).normalized();
 
-								t->process_pass = process_pass;
-								t->loc = loc;
-								t->rot = rot;
-								t->rot_blend_accum = 0;
-								t->scale = scale;
-							}
+						prev_time = 0;
 
-							if (err != OK)
-								continue;
+					} else {
+						Vector3 loc;
+						Quat rot;
+						Vector3 scale;
 
-							t->loc = t->loc.linear_interpolate(loc, blend);
-							if (t->rot_blend_accum == 0) {
-								t->rot = rot;
-								t->rot_blend_accum = blend;
-							} else {
-								float rot_total = t->rot_blend_accum + blend;
-								t->rot = rot.slerp(t->rot, t->rot_blend_accum / rot_total).normalized();
-								t->rot_blend_accum = rot_total;
-							}
-							t->scale = t->scale.linear_interpolate(scale, blend);
+						Error err = a->transform_track_interpolate(i, time, &loc, &rot, &scale);
+						//ERR_CONTINUE(err!=OK); //used for testing, should be removed
+
+						if (t->process_pass != process_pass) {
+
+							t->process_pass = process_pass;
+							t->loc = loc;
+							t->rot = rot;
+							t->rot_blend_accum = 0;
+							t->scale = scale;
 						}
 
-					} break;
-					case Animation::TYPE_VALUE: {
+						if (err != OK)
+							continue;
 
-						TrackCacheValue *t = static_cast<TrackCacheValue *>(track);
+						t->loc = t->loc.linear_interpolate(loc, blend);
+						if (t->rot_blend_accum == 0) {
+							t->rot = rot;
+							t->rot_blend_accum = blend;
+						} else {
+							float rot_total = t->rot_blend_accum + blend;
+							t->rot = rot.slerp(t->rot, t->rot_blend_accum / rot_total).normalized();
+							t->rot_blend_accum = rot_total;
+						}
+						t->scale = t->scale.linear_interpolate(scale, blend);
+					}
 
-						Animation::UpdateMode update_mode = a->value_track_get_update_mode(i);
+				} break;
+				case Animation::TYPE_VALUE: {
 
-						if (update_mode == Animation::UPDATE_CONTINUOUS || update_mode == Animation::UPDATE_CAPTURE) { //delta == 0 means seek
+					TrackCacheValue *t = static_cast<TrackCacheValue *>(track);
 
-							Variant value = a->value_track_interpolate(i, time);
+					Variant value = a->value_track_interpolate(i, time);
 
-							if (value == Variant())
-								continue;
+					if (value == Variant())
+						continue;
 
-							if (t->process_pass != process_pass) {
-								t->value = value;
-								t->process_pass = process_pass;
-							}
+					if (t->process_pass != process_pass) {
+						t->value = value;
+						t->process_pass = process_pass;
+					}
 
-							Variant::interpolate(t->value, value, blend, t->value);
+					Variant::interpolate(t->value, value, blend, t->value);
 
-						} else if (delta != 0) {
+				} break;
+				case Animation::TYPE_BEZIER: {
 
-							List<int> indices;
-							a->value_track_get_key_indices(i, time, delta, &indices);
+					TrackCacheBezier *t = static_cast<TrackCacheBezier *>(track);
 
-							for (List<int>::Element *F = indices.front(); F; F = F->next()) {
+					float bezier = a->bezier_track_interpolate(i, time);
 
-								Variant value = a->track_get_key_value(i, F->get());
-								t->object->set_indexed(t->subpath, value);
-							}
-						}
+					if (t->process_pass != process_pass) {
+						t->value = bezier;
+						t->process_pass = process_pass;
+					}
 
-					} break;
-					case Animation::TYPE_METHOD: {
+					t->value = Math::lerp(t->value, bezier, blend);
 
-						if (delta == 0) {
-							continue;
-						}
-						TrackCacheMethod *t = static_cast<TrackCacheMethod *>(track);
+				} break;
+				default: {
+				}
+			}
+		}
+	}
+}
 
-						List<int> indices;
+// Runs method, audio, animation and discrete value tracks, then writes the
+// blended caches to the nodes. Must run on the main thread.
+void AnimationTree::_apply_tracks() {
 
-						a->method_track_get_key_indices(i, time, delta, &indices);
+	bool can_call = is_inside_tree() && !Engine::get_singleton()->is_editor_hint();
 
-						for (List<int>::Element *F = indices.front(); F; F = F->next()) {
+	for (List<AnimationNode::AnimationState>::Element *E = state.animation_states.front(); E; E = E->next()) {
 
-							StringName method = a->method_track_get_name(i, F->get());
-							Vector<Variant> params = a->method_track_get_params(i, F->get());
+		const AnimationNode::AnimationState &as = E->get();
 
-							int s = params.size();
+		Ref<Animation> a = as.animation;
+		float time = as.time;
+		float delta = as.delta;
+		bool seeked = as.seeked;
 
-							ERR_CONTINUE(s > VARIANT_ARG_MAX);
-							if (can_call) {
-								t->object->call_deferred(
-										method,
-										s >= 1 ? params[0] : Variant(),
-										s >= 2 ? params[1] : Variant(),
-										s >= 3 ? params[2] : Variant(),
-										s >= 4 ? params[3] : Variant(),
-										s >= 5 ? params[4] : Variant());
-							}
-						}
+		for (int i = 0; i < a->get_track_count(); i++) {
 
-					} break;
-					case Animation::TYPE_BEZIER: {
+			if (_is_track_blended(a, i))
+				continue; //handled by _blend_tracks()
 
-						TrackCacheBezier *t = static_cast<TrackCacheBezier *>(track);
+			float blend;
+			TrackCache *track = _get_blended_track(as, i, &blend);
+			if (!track)
+				continue;
 
-						float bezier = a->bezier_track_interpolate(i, time);
+			switch (track->type) {
 
-						if (t->process_pass != process_pass) {
-							t->value = bezier;
-							t->process_pass = process_pass;
+				case Animation::TYPE_VALUE: {
+
+					if (delta == 0) {
+						continue;
+					}
+					TrackCacheValue *t = static_cast<TrackCacheValue *>(track);
+
+					List<int> indices;
+					a->value_track_get_key_indices(i, time, delta, &indices);
+
+					for (List<int>::Element *F = indices.front(); F; F = F->next()) {
+
+						Variant value = a->track_get_key_value(i, F->get());
+						t->object->set_indexed(t->subpath, value);
+					}
+
+				} break;
+				case Animation::TYPE_METHOD: {
+
+					if (delta == 0) {
+						continue;
+					}
+					TrackCacheMethod *t = static_cast<TrackCacheMethod *>(track);
+
+					List<int> indices;
+
+					a->method_track_get_key_indices(i, time, delta, &indices);
+
+					for (List<int>::Element *F = indices.front(); F; F = F->next()) {
+
+						StringName method = a->method_track_get_name(i, F->get());
+						Vector<Variant> params = a->method_track_get_params(i, F->get());
+
+						int s = params.size();
+
+						ERR_CONTINUE(s > VARIANT_ARG_MAX);
+						if (can_call) {
+							t->object->call_deferred(
+									method,
+									s >= 1 ? params[0] : Variant(),
+									s >= 2 ? params[1] : Variant(),
+									s >= 3 ? params[2] : Variant(),
+									s >= 4 ? params[3] : Variant(),
+									s >= 5 ? params[4] : Variant());
 						}
+					}
 
-						t->value = Math::lerp(t->value, bezier, blend);
+				} break;
+				case Animation::TYPE_AUDIO: {
 
-					} break;
-					case Animation::TYPE_AUDIO: {
+					TrackCacheAudio *t = static_cast<TrackCacheAudio *>(track);
+
+					if (seeked) {
+						//find whathever should be playing
+						int idx = a->track_find_key(i, time);
+						if (idx < 0)
+							continue;
 
-						TrackCacheAudio *t = static_cast<TrackCacheAudio *>(track);
+						Ref<AudioStream> stream = a->audio_track_get_key_stream(i, idx);
+						if (!stream.is_valid()) {
+							t->object->call("stop");
+							t->playing = false;
+							playing_caches.erase(t);
+						} else {
+							float start_ofs = a->audio_track_get_key_start_offset(i, idx);
+							start_ofs += time - a->track_get_key_time(i, idx);
+							float end_ofs = a->audio_track_get_key_end_offset(i, idx);
+							float len = stream->get_length();
 
-						if (seeked) {
-							//find whathever should be playing
-							int idx = a->track_find_key(i, time);
-							if (idx < 0)
+							if (start_ofs > len - end_ofs) {
+								t->object->call("stop");
+								t->playing = false;
+								playing_caches.erase(t);
 								continue;
+							}
+
+							t->object->call("set_stream", stream);
+							t->object->call("play", start_ofs);
+
+							t->playing = true;
+							playing_caches.insert(t);
+							if (len && end_ofs > 0) { //force a end at a time
+								t->len = len - start_ofs - end_ofs;
+							} else {
+								t->len = 0;
+							}
+
+							t->start = time;
+						}
+
+					} else {
+						//find stuff to play
+						List<int> to_play;
+						a->track_get_key_indices_in_range(i, time, delta, &to_play);
+						if (to_play.size()) {
+							int idx = to_play.back()->get();
 
 							Ref<AudioStream> stream = a->audio_track_get_key_stream(i, idx);
 							if (!stream.is_valid()) {
@@ -1066,17 +1218,9 @@ void AnimationTree::_process_graph(float p_delta) {
 								playing_caches.erase(t);
 							} else {
 								float start_ofs = a->audio_track_get_key_start_offset(i, idx);
-								start_ofs += time - a->track_get_key_time(i, idx);
 								float end_ofs = a->audio_track_get_key_end_offset(i, idx);
 								float len = stream->get_length();
 
-								if (start_ofs > len - end_ofs) {
-									t->object->call("stop");
-									t->playing = false;
-									playing_caches.erase(t);
-									continue;
-								}
-
 								t->object->call("set_stream", stream);
 								t->object->call("play", start_ofs);
 
@@ -1090,145 +1234,117 @@ void AnimationTree::_process_graph(float p_delta) {
 
 								t->start = time;
 							}
+						} else if (t->playing) {
 
-						} else {
-							//find stuff to play
-							List<int> to_play;
-							a->track_get_key_indices_in_range(i, time, delta, &to_play);
-							if (to_play.size()) {
-								int idx = to_play.back()->get();
-
-								Ref<AudioStream> stream = a->audio_track_get_key_stream(i, idx);
-								if (!stream.is_valid()) {
-									t->object->call("stop");
-									t->playing = false;
-									playing_caches.erase(t);
-								} else {
-									float start_ofs = a->audio_track_get_key_start_offset(i, idx);
-									float end_ofs = a->audio_track_get_key_end_offset(i, idx);
-									float len = stream->get_length();
-
-									t->object->call("set_stream", stream);
-									t->object->call("play", start_ofs);
-
-									t->playing = true;
-									playing_caches.insert(t);
-									if (len && end_ofs > 0) { //force a end at a time
-										t->len = len - start_ofs - end_ofs;
-									} else {
-										t->len = 0;
-									}
-
-									t->start = time;
-								}
-							} else if (t->playing) {
+							bool loop = a->has_loop();
 
-								bool loop = a->has_loop();
+							bool stop = false;
 
-								bool stop = false;
+							if (!loop && time < t->start) {
+								stop = true;
+							} else if (t->len > 0) {
+								float len = t->start > time ? (a->get_length() - t->start) + time : time - t->start;
 
-								if (!loop && time < t->start) {
+								if (len > t->len) {
 									stop = true;
-								} else if (t->len > 0) {
-									float len = t->start > time ? (a->get_length() - t->start) + time : time - t->start;
-
-									if (len > t->len) {
-										stop = true;
-									}
 								}
+							}
 
-								if (stop) {
-									//time to stop
-									t->object->call("stop");
-									t->playing = false;
-									playing_caches.erase(t);
-								}
+							if (stop) {
+								//time to stop
+								t->object->call("stop");
+								t->playing = false;
+								playing_caches.erase(t);
 							}
 						}
+					}
 
-						float db = Math::linear2db(MAX(blend, 0.00001));
-						if (t->object->has_method("set_unit_db")) {
-							t->object->call("set_unit_db", db);
-						} else {
-							t->object->call("set_volume_db", db);
-						}
-					} break;
-					case Animation::TYPE_ANIMATION: {
+					float db = Math::linear2db(MAX(blend, 0.00001));
+					if (t->object->has_method("set_unit_db")) {
+						t->object->call("set_unit_db", db);
+					} else {
+						t->object->call("set_volume_db", db);
+					}
+				} break;
+				case Animation::TYPE_ANIMATION: {
 
-						TrackCacheAnimation *t = static_cast<TrackCacheAnimation *>(track);
+					TrackCacheAnimation *t = static_cast<TrackCacheAnimation *>(track);
 
-						AnimationPlayer *player2 = Object::cast_to<AnimationPlayer>(t->object);
+					AnimationPlayer *player2 = Object::cast_to<AnimationPlayer>(t->object);
 
-						if (!player2)
+					if (!player2)
+						continue;
+
+					if (delta == 0 || seeked) {
+						//seek
+						int idx = a->track_find_key(i, time);
+						if (idx < 0)
 							continue;
 
-						if (delta == 0 || seeked) {
-							//seek
-							int idx = a->track_find_key(i, time);
-							if (idx < 0)
-								continue;
+						float pos = a->track_get_key_time(i, idx);
 
-							float pos = a->track_get_key_time(i, idx);
+						StringName anim_name = a->animation_track_get_key_animation(i, idx);
+						if (String(anim_name) == "[stop]" || !player2->has_animation(anim_name))
+							continue;
 
-							StringName anim_name = a->animation_track_get_key_animation(i, idx);
-							if (String(anim_name) == "[stop]" || !player2->has_animation(anim_name))
-								continue;
+						Ref<Animation> anim = player2->get_animation(anim_name);
 
-							Ref<Animation> anim = player2->get_animation(anim_name);
+						float at_anim_pos;
 
-							float at_anim_pos;
+						if (anim->has_loop()) {
+							at_anim_pos = Math::fposmod(time - pos, anim->get_length()); //seek to loop
+						} else {
+							at_anim_pos = MAX(anim->get_length(), time - pos); //seek to end
+						}
 
-							if (anim->has_loop()) {
-								at_anim_pos = Math::fposmod(time - pos, anim->get_length()); //seek to loop
-							} else {
-								at_anim_pos = MAX(anim->get_length(), time - pos); //seek to end
-							}
+						if (player2->is_playing() || seeked) {
+							player2->play(anim_name);
+							player2->seek(at_anim_pos);
+							t->playing = true;
+							playing_caches.insert(t);
+						} else {
+							player2->set_assigned_animation(anim_name);
+							player2->seek(at_anim_pos, true);
+						}
+					} else {
+						//find stuff to play
+						List<int> to_play;
+						a->track_get_key_indices_in_range(i, time, delta, &to_play);
+						if (to_play.size()) {
+							int idx = to_play.back()->get();
 
-							if (player2->is_playing() || seeked) {
+							StringName anim_name = a->animation_track_get_key_animation(i, idx);
+							if (String(anim_name) == "[stop]" || !player2->has_animation(anim_name)) {
+
+								if (playing_caches.has(t)) {
+									playing_caches.erase(t);
+									player2->stop();
+									t->playing = false;
+								}
+							} else {
 								player2->play(anim_name);
-								player2->seek(at_anim_pos);
 								t->playing = true;
 								playing_caches.insert(t);
-							} else {
-								player2->set_assigned_animation(anim_name);
-								player2->seek(at_anim_pos, true);
-							}
-						} else {
-							//find stuff to play
-							List<int> to_play;
-							a->track_get_key_indices_in_range(i, time, delta, &to_play);
-							if (to_play.size()) {
-								int idx = to_play.back()->get();
-
-								StringName anim_name = a->animation_track_get_key_animation(i, idx);
-								if (String(anim_name) == "[stop]" || !player2->has_animation(anim_name)) {
-
-									if (playing_caches.has(t)) {
-										playing_caches.erase(t);
-										player2->stop();
-										t->playing = false;
-									}
-								} else {
-									player2->play(anim_name);
-									t->playing = true;
-									playing_caches.insert(t);
-								}
 							}
 						}
+					}
 
-					} break;
+				} break;
+				default: {
 				}
 			}
 		}
 	}
 
+	root_motion_transform = Transform();
+
 	{
 		// finally, set the tracks
 		const NodePath *K = NULL;
 		while ((K = track_cache.next(K))) {
 			TrackCache *track = track_cache[*K];
-			if (track->process_pass != process_pass)
-				continue; //not processed, ignore
+			if (track->process_pass != process_pass || track->setup_pass != setup_pass)
+				continue; //not processed or its node was removed, ignore
 
 			switch (track->type) {
 
@@ -1277,6 +1393,56 @@ void AnimationTree::_process_graph(float p_delta) {
 			}
 		}
 	}
+
+	state.animation_states.clear(); //releases the blend copies, so nodes can write theirs in place again
+}
+
+void AnimationTree::_blend_tree_job(uint32_t p_index, AnimationTree **p_trees) {
+
+	p_trees[p_index]->_blend_tracks();
+}
+
+void AnimationTree::flush_pending_blends() {
+
+	if (!pending_blends || !pending_blends->first())
+		return;
+
+	Vector<AnimationTree *> trees;
+	while (pending_blends->first()) {
+		trees.push_back(pending_blends->first()->self());
+		pending_blends->remove(pending_blends->first());
+	}
+
+	blend_pool->do_work(trees.size(), trees[0], &AnimationTree::_blend_tree_job, trees.ptrw());
+
+	for (int i = 0; i < trees.size(); i++) {
+		trees[i]->_apply_tracks();
+	}
+}
+
+void AnimationTree::init_blend_threads() {
+
+	int threads = GLOBAL_DEF("animation/blending_threads", 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("animation/blending_threads", PropertyInfo(Variant::INT, "animation/blending_threads", PROPERTY_HINT_RANGE, "0,64,1"));
+
+	if (threads == 1)
+		return; //blend each tree right away, as it is processed
+
+	pending_blends = memnew(SelfList<AnimationTree>::List);
+	blend_pool = memnew(ThreadWorkPool);
+	blend_pool->init(threads > 0 ? threads : -1);
+}
+
+void AnimationTree::finish_blend_threads() {
+
+	if (!blend_pool)
+		return;
+
+	blend_pool->finish();
+	memdelete(blend_pool);
+	blend_pool = NULL;
+	memdelete(pending_blends);
+	pending_blends = NULL;
 }
 
 void AnimationTree::advance(float p_time) {
@@ -1287,11 +1453,11 @@ void AnimationTree::advance(float p_time) {
 void AnimationTree::_notification(int p_what) {
 
 	if (active && p_what == NOTIFICATION_INTERNAL_PHYSICS_PROCESS && process_mode == ANIMATION_PROCESS_PHYSICS) {
-		_process_graph(get_physics_process_delta_time());
+		_process_graph(get_physics_process_delta_time(), true);
 	}
 
 	if (active && p_what == NOTIFICATION_INTERNAL_PROCESS && process_mode == ANIMATION_PROCESS_IDLE) {
-		_process_graph(get_process_delta_time());
+		_process_graph(get_process_delta_time(), true);
 	}
 
 	if (p_what == NOTIFICATION_EXIT_TREE) {
@@ -1574,7 +1740,11 @@ void AnimationTree::_bind_methods() {
 	BIND_ENUM_CONSTANT(ANIMATION_PROCESS_MANUAL);
 }
 
-AnimationTree::AnimationTree() {
+SelfList<AnimationTree>::List *AnimationTree::pending_blends = NULL;
+ThreadWorkPool *AnimationTree::blend_pool = NULL;
+
+AnimationTree::AnimationTree() :
+		pending_blend(this) {
 
 	process_mode = ANIMATION_PROCESS_IDLE;
 	active = false;
@@ -32,6 +32,8 @@
 #define ANIMATION_GRAPH_PLAYER_H
 
 #include "animation_player.h"
+#include "core/os/thread_work_pool.h"
+#include "core/self_list.h"
 #include "scene/3d/skeleton.h"
 #include "scene/3d/spatial.h"
 #include "scene/resources/animation.h"
@@ -66,7 +68,7 @@ public:
 		Ref<Animation> animation;
 		float time;
 		float delta;
-		const Vector<float> *track_blends;
+		Vector<float> track_blends; // copied, the node may be shared by trees that blend later
 		float blend;
 		bool seeked;
 	};
@@ -176,6 +178,7 @@ private:
 		uint64_t setup_pass;
 		uint64_t process_pass;
 		Animation::TrackType type;
+		Node *node; // The node the path resolved to, object may be one of its resources.
 		Object *object;
 		ObjectID object_id;
 
@@ -183,6 +186,7 @@ private:
 			root_motion = false;
 			setup_pass = 0;
 			process_pass = 0;
+			node = NULL;
 			object = NULL;
 			object_id = 0;
 		}
@@ -268,7 +272,16 @@ private:
 
 	void _clear_caches();
 	bool _update_caches(AnimationPlayer *player);
-	void _process_graph(float p_delta);
+	void _process_graph(float p_delta, bool p_allow_deferred = false);
+
+	TrackCache *_get_blended_track(const AnimationNode::AnimationState &p_state, int p_track, float *r_blend);
+	void _blend_tracks();
+	void _apply_tracks();
+
+	SelfList<AnimationTree> pending_blend;
+	static SelfList<AnimationTree>::List *pending_blends;
+	static ThreadWorkPool *blend_pool;
+	void _blend_tree_job(uint32_t p_index, AnimationTree **p_trees);
 
 	uint64_t setup_pass;
 	uint64_t process_pass;
@@ -335,6 +348,11 @@ public:
 	void rename_parameter(const String &p_base, const String &p_new_base);
 
 	uint64_t get_last_process_pass() const;
+
+	static void init_blend_threads();
+	static void finish_blend_threads();
+	static void flush_pending_blends();
+
 	AnimationTree();
 	~AnimationTree();
 };
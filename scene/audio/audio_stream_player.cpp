@@ -31,6 +31,7 @@
 #include "audio_stream_player.h"
 
 #include "core/engine.h"
+#include "servers/audio/audio_mix_kernels.h"
 
 
 void AudioStreamPlayer::_mix_to_bus(const AudioFrame *p_frames,int p_amount) {
@@ -60,9 +61,7 @@ void AudioStreamPlayer::_mix_to_bus(const AudioFrame *p_frames,int p_amount) {
 	for (int c = 0; c < 4; c++) {
 		if (!targets[c])
 			break;
-		for (int i = 0; i < p_amount; i++) {
-			targets[c][i] += p_frames[i];
-		}
+		AudioMixKernels::accumulate(targets[c], p_frames, p_amount);
 	}
 }
 
@@ -86,10 +85,7 @@ void AudioStreamPlayer::_mix_internal(bool p_fadeout) {
 	float vol = Math::db2linear(mix_volume_db);
 	float vol_inc = (Math::db2linear(target_volume) - vol) / float(buffer_size);
 
-	for (int i = 0; i < buffer_size; i++) {
-		buffer[i] *= vol;
-		vol += vol_inc;
-	}
+	AudioMixKernels::apply_volume_ramp(buffer, buffer_size, vol, vol_inc);
 
 	//set volume for next mix
 	mix_volume_db = target_volume;
@@ -195,10 +191,7 @@ void AudioStreamPlayer::set_stream(Ref<AudioStream> p_stream) {
 		float vol = Math::db2linear(mix_volume_db);
 		float vol_inc = (Math::db2linear(target_volume) - vol) / float(buffer_size);
 
-		for (int i = 0; i < buffer_size; i++) {
-			buffer[i] *= vol;
-			vol += vol_inc;
-		}
+		AudioMixKernels::apply_volume_ramp(buffer, buffer_size, vol, vol_inc);
 
 		use_fadeout=true;
 	}
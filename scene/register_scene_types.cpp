@@ -396,6 +396,7 @@ void register_scene_types() {
 	ClassDB::register_class<AnimationTreePlayer>();
 	ClassDB::register_class<Particles>();
 	ClassDB::register_class<CPUParticles>();
+	CPUParticles::init_process_threads();
 	ClassDB::register_class<Position3D>();
 	ClassDB::register_class<NavigationMeshInstance>();
 	ClassDB::register_class<NavigationMesh>();
@@ -405,6 +406,8 @@ void register_scene_types() {
 	ClassDB::set_class_enabled("RootMotionView", false); //disabled by default, enabled by editor
 
 	ClassDB::register_class<AnimationTree>();
+	SceneTree::add_idle_callback(AnimationTree::flush_pending_blends);
+	AnimationTree::init_blend_threads();
 	ClassDB::register_class<AnimationNode>();
 	ClassDB::register_class<AnimationRootNode>();
 	ClassDB::register_class<AnimationNodeBlendTree>();
@@ -531,6 +534,7 @@ void register_scene_types() {
 	CanvasItemMaterial::init_shaders();
 	ClassDB::register_class<Node2D>();
 	ClassDB::register_class<CPUParticles2D>();
+	CPUParticles2D::init_process_threads();
 	ClassDB::register_class<Particles2D>();
 	//ClassDB::register_class<ParticleAttractor2D>();
 	ClassDB::register_class<Sprite>();
@@ -785,8 +789,12 @@ void unregister_scene_types() {
 	//SpatialMaterial is not initialised when 3D is disabled, so it shouldn't be cleaned up either
 #ifndef _3D_DISABLED
 	SpatialMaterial::finish_shaders();
+	AnimationTree::finish_blend_threads();
+	CPUParticles::finish_process_threads();
 #endif // _3D_DISABLED
 
+	CPUParticles2D::finish_process_threads();
+
 	ParticlesMaterial::finish_shaders();
 	CanvasItemMaterial::finish_shaders();
 	SceneStringNames::free();
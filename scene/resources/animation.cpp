@@ -31,6 +31,7 @@
 #include "animation.h"
 #include "scene/scene_string_names.h"
 
+#include "core/io/marshalls.h"
 #include "core/math/geometry.h"
 
 #define ANIM_MIN_LENGTH 0.001
@@ -86,11 +87,21 @@ bool Animation::_set(const StringName &p_name, const Variant &p_value) {
 			track_set_imported(track, p_value);
 		else if (what == "enabled")
 			track_set_enabled(track, p_value);
-		else if (what == "keys" || what == "key_values") {
+		else if (what == "compressed") {
+
+			ERR_FAIL_COND_V(track_get_type(track) != TYPE_TRANSFORM, false);
+			TransformTrack *tt = static_cast<TransformTrack *>(tracks[track]);
+			CompressedTransforms comp;
+			ERR_FAIL_COND_V(!_compressed_transforms_from_bytes(p_value, &comp), false);
+			tt->transforms.clear();
+			tt->compressed = comp;
+
+		} else if (what == "keys" || what == "key_values") {
 
 			if (track_get_type(track) == TYPE_TRANSFORM) {
 
 				TransformTrack *tt = static_cast<TransformTrack *>(tracks[track]);
+				tt->compressed = CompressedTransforms();
 				PoolVector<float> values = p_value;
 				int vcount = values.size();
 				ERR_FAIL_COND_V(vcount % 12, false); // shuld be multiple of 11
@@ -369,7 +380,14 @@ bool Animation::_get(const StringName &p_name, Variant &r_ret) const {
 			r_ret = track_is_imported(track);
 		else if (what == "enabled")
 			r_ret = track_is_enabled(track);
-		else if (what == "keys") {
+		else if (what == "compressed") {
+
+			if (!transform_track_is_compressed(track))
+				return false;
+			const TransformTrack *tt = static_cast<const TransformTrack *>(tracks[track]);
+			r_ret = _compressed_transforms_to_bytes(tt->compressed);
+
+		} else if (what == "keys") {
 
 			if (track_get_type(track) == TYPE_TRANSFORM) {
 
@@ -622,7 +640,10 @@ void Animation::_get_property_list(List<PropertyInfo> *p_list) const {
 		p_list->push_back(PropertyInfo(Variant::BOOL, "tracks/" + itos(i) + "/loop_wrap", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
 		p_list->push_back(PropertyInfo(Variant::BOOL, "tracks/" + itos(i) + "/imported", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
 		p_list->push_back(PropertyInfo(Variant::BOOL, "tracks/" + itos(i) + "/enabled", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
-		p_list->push_back(PropertyInfo(Variant::ARRAY, "tracks/" + itos(i) + "/keys", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
+		if (transform_track_is_compressed(i))
+			p_list->push_back(PropertyInfo(Variant::POOL_BYTE_ARRAY, "tracks/" + itos(i) + "/compressed", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
+		else
+			p_list->push_back(PropertyInfo(Variant::ARRAY, "tracks/" + itos(i) + "/keys", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL));
 	}
 }
 
@@ -849,6 +870,21 @@ Error Animation::transform_track_get_key(int p_track, int p_key, Vector3 *r_loc,
 
 	TransformTrack *tt = static_cast<TransformTrack *>(t);
 	ERR_FAIL_COND_V(t->type != TYPE_TRANSFORM, ERR_INVALID_PARAMETER);
+
+	if (tt->compressed.frame_count) {
+
+		ERR_FAIL_INDEX_V(p_key, tt->compressed.frame_count, ERR_INVALID_PARAMETER);
+		TransformKey tk;
+		_compressed_transforms_get_frame(tt->compressed, p_key, &tk);
+		if (r_loc)
+			*r_loc = tk.loc;
+		if (r_rot)
+			*r_rot = tk.rot;
+		if (r_scale)
+			*r_scale = tk.scale;
+		return OK;
+	}
+
 	ERR_FAIL_INDEX_V(p_key, tt->transforms.size(), ERR_INVALID_PARAMETER);
 
 	if (r_loc)
@@ -868,6 +904,7 @@ int Animation::transform_track_insert_key(int p_track, float p_time, const Vecto
 	ERR_FAIL_COND_V(t->type != TYPE_TRANSFORM, -1);
 
 	TransformTrack *tt = static_cast<TransformTrack *>(t);
+	_transform_track_decompress(tt);
 
 	TKey<TransformKey> tkey;
 	tkey.time = p_time;
@@ -896,6 +933,7 @@ void Animation::track_remove_key(int p_track, int p_idx) {
 		case TYPE_TRANSFORM: {
 
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			_transform_track_decompress(tt);
 			ERR_FAIL_INDEX(p_idx, tt->transforms.size());
 			tt->transforms.remove(p_idx);
 
@@ -949,6 +987,23 @@ int Animation::track_find_key(int p_track, float p_time, bool p_exact) const {
 		case TYPE_TRANSFORM: {
 
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+
+			if (tt->compressed.frame_count) {
+
+				const CompressedTransforms &ct = tt->compressed;
+				if (p_time < 0)
+					return -1;
+				int k = MIN(int(p_time * ct.fps), ct.frame_count - 1);
+				// correct rounding so the result agrees with track_get_key_time()
+				if (k + 1 < ct.frame_count && (k + 1) / ct.fps <= p_time)
+					k++;
+				else if (k > 0 && k / ct.fps > p_time)
+					k--;
+				if (k / ct.fps != p_time && p_exact)
+					return -1;
+				return k;
+			}
+
 			int k = _find(tt->transforms, p_time);
 			if (k < 0 || k >= tt->transforms.size())
 				return -1;
@@ -1134,6 +1189,8 @@ int Animation::track_get_key_count(int p_track) const {
 		case TYPE_TRANSFORM: {
 
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			if (tt->compressed.frame_count)
+				return tt->compressed.frame_count;
 			return tt->transforms.size();
 		} break;
 		case TYPE_VALUE: {
@@ -1177,12 +1234,20 @@ Variant Animation::track_get_key_value(int p_track, int p_key_idx) const {
 		case TYPE_TRANSFORM: {
 
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
-			ERR_FAIL_INDEX_V(p_key_idx, tt->transforms.size(), Variant());
+
+			TransformKey tk;
+			if (tt->compressed.frame_count) {
+				ERR_FAIL_INDEX_V(p_key_idx, tt->compressed.frame_count, Variant());
+				_compressed_transforms_get_frame(tt->compressed, p_key_idx, &tk);
+			} else {
+				ERR_FAIL_INDEX_V(p_key_idx, tt->transforms.size(), Variant());
+				tk = tt->transforms[p_key_idx].value;
+			}
 
 			Dictionary d;
-			d["location"] = tt->transforms[p_key_idx].value.loc;
-			d["rotation"] = tt->transforms[p_key_idx].value.rot;
-			d["scale"] = tt->transforms[p_key_idx].value.scale;
+			d["location"] = tk.loc;
+			d["rotation"] = tk.rot;
+			d["scale"] = tk.scale;
 
 			return d;
 		} break;
@@ -1253,6 +1318,10 @@ float Animation::track_get_key_time(int p_track, int p_key_idx) const {
 		case TYPE_TRANSFORM: {
 
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			if (tt->compressed.frame_count) {
+				ERR_FAIL_INDEX_V(p_key_idx, tt->compressed.frame_count, -1);
+				return p_key_idx / tt->compressed.fps;
+			}
 			ERR_FAIL_INDEX_V(p_key_idx, tt->transforms.size(), -1);
 			return tt->transforms[p_key_idx].time;
 		} break;
@@ -1306,6 +1375,10 @@ float Animation::track_get_key_transition(int p_track, int p_key_idx) const {
 		case TYPE_TRANSFORM: {
 
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			if (tt->compressed.frame_count) {
+				ERR_FAIL_INDEX_V(p_key_idx, tt->compressed.frame_count, -1);
+				return 1.0; // easing is baked into the frames
+			}
 			ERR_FAIL_INDEX_V(p_key_idx, tt->transforms.size(), -1);
 			return tt->transforms[p_key_idx].transition;
 		} break;
@@ -1350,6 +1423,7 @@ void Animation::track_set_key_value(int p_track, int p_key_idx, const Variant &p
 		case TYPE_TRANSFORM: {
 
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			_transform_track_decompress(tt);
 			ERR_FAIL_INDEX(p_key_idx, tt->transforms.size());
 			Dictionary d = p_value;
 			if (d.has("location"))
@@ -1428,6 +1502,7 @@ void Animation::track_set_key_transition(int p_track, int p_key_idx, float p_tra
 		case TYPE_TRANSFORM: {
 
 			TransformTrack *tt = static_cast<TransformTrack *>(t);
+			_transform_track_decompress(tt);
 			ERR_FAIL_INDEX(p_key_idx, tt->transforms.size());
 			tt->transforms.write[p_key_idx].transition = p_transition;
 		} break;
@@ -1797,7 +1872,11 @@ Error Animation::transform_track_interpolate(int p_track, float p_time, Vector3
 
 	bool ok = false;
 
-	TransformKey tk = _interpolate(tt->transforms, p_time, tt->interpolation, tt->loop_wrap, &ok);
+	TransformKey tk;
+	if (tt->compressed.frame_count)
+		tk = _compressed_transforms_interpolate(tt, p_time, &ok);
+	else
+		tk = _interpolate(tt->transforms, p_time, tt->interpolation, tt->loop_wrap, &ok);
 
 	if (!ok)
 		return ERR_UNAVAILABLE;
@@ -1989,8 +2068,13 @@ void Animation::track_get_key_indices_in_range(int p_track, float p_time, float
 				case TYPE_TRANSFORM: {
 
 					const TransformTrack *tt = static_cast<const TransformTrack *>(t);
-					_track_get_key_indices_in_range(tt->transforms, from_time, length, p_indices);
-					_track_get_key_indices_in_range(tt->transforms, 0, to_time, p_indices);
+					if (tt->compressed.frame_count) {
+						_compressed_transforms_get_key_indices_in_range(tt->compressed, from_time, length, p_indices);
+						_compressed_transforms_get_key_indices_in_range(tt->compressed, 0, to_time, p_indices);
+					} else {
+						_track_get_key_indices_in_range(tt->transforms, from_time, length, p_indices);
+						_track_get_key_indices_in_range(tt->transforms, 0, to_time, p_indices);
+					}
 
 				} break;
 				case TYPE_VALUE: {
@@ -2049,7 +2133,10 @@ void Animation::track_get_key_indices_in_range(int p_track, float p_time, float
 		case TYPE_TRANSFORM: {
 
 			const TransformTrack *tt = static_cast<const TransformTrack *>(t);
-			_track_get_key_indices_in_range(tt->transforms, from_time, to_time, p_indices);
+			if (tt->compressed.frame_count)
+				_compressed_transforms_get_key_indices_in_range(tt->compressed, from_time, to_time, p_indices);
+			else
+				_track_get_key_indices_in_range(tt->transforms, from_time, to_time, p_indices);
 
 		} break;
 		case TYPE_VALUE: {
@@ -2639,6 +2726,11 @@ void Animation::copy_track(int p_track, Ref<Animation> p_to_animation) {
 	p_to_animation->track_set_interpolation_type(dst_track, track_get_interpolation_type(p_track));
 	p_to_animation->track_set_interpolation_loop_wrap(dst_track, track_get_interpolation_loop_wrap(p_track));
 	p_to_animation->value_track_set_update_mode(dst_track, value_track_get_update_mode(p_track));
+	if (transform_track_is_compressed(p_track)) {
+		static_cast<TransformTrack *>(p_to_animation->tracks[dst_track])->compressed = static_cast<TransformTrack *>(tracks[p_track])->compressed;
+		p_to_animation->emit_changed();
+		return;
+	}
 	for (int i = 0; i < track_get_key_count(p_track); i++) {
 		p_to_animation->track_insert_key(dst_track, track_get_key_time(p_track, i), track_get_key_value(p_track, i), track_get_key_transition(p_track, i));
 	}
@@ -2729,6 +2821,9 @@ void Animation::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("clear"), &Animation::clear);
 	ClassDB::bind_method(D_METHOD("copy_track", "track", "to_animation"), &Animation::copy_track);
 
+	ClassDB::bind_method(D_METHOD("compress", "fps"), &Animation::compress, DEFVAL(30));
+	ClassDB::bind_method(D_METHOD("transform_track_is_compressed", "idx"), &Animation::transform_track_is_compressed);
+
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "length", PROPERTY_HINT_RANGE, "0.001,99999,0.001"), "set_length", "get_length");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "loop"), "set_loop", "has_loop");
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "step", PROPERTY_HINT_RANGE, "0,4096,0.001"), "set_step", "get_step");
@@ -2981,11 +3076,390 @@ void Animation::optimize(float p_allowed_linear_err, float p_allowed_angular_err
 
 	for (int i = 0; i < tracks.size(); i++) {
 
-		if (tracks[i]->type == TYPE_TRANSFORM)
+		if (tracks[i]->type == TYPE_TRANSFORM && !transform_track_is_compressed(i))
 			_transform_track_optimize(i, p_allowed_linear_err, p_allowed_angular_err, p_max_optimizable_angle);
 	}
 }
 
+/* COMPRESSED TRANSFORM TRACKS */
+
+// frame_count, fps, flags, loc_min, loc_range, scale_min, scale_range, rot
+#define COMPRESSED_TRANSFORMS_HEADER_SIZE (4 * (3 + 3 * 4 + 4))
+
+static _FORCE_INLINE_ uint16_t _compressed_quantize(real_t p_value, real_t p_min, real_t p_range) {
+
+	if (p_range <= 0)
+		return 0;
+	return uint16_t(Math::fast_ftoi(CLAMP((p_value - p_min) / p_range, 0, 1) * 65535.0f));
+}
+
+static void _compressed_encode_rot(const Quat &p_rot, uint16_t *r_dst) {
+
+	Quat q = p_rot.normalized();
+	float c[4] = { q.x, q.y, q.z, q.w };
+
+	// the largest component is dropped and rebuilt from the other three,
+	// which then all fit in [-sqrt(0.5), sqrt(0.5)]
+	int largest = 0;
+	for (int i = 1; i < 4; i++) {
+		if (Math::abs(c[i]) > Math::abs(c[largest]))
+			largest = i;
+	}
+	float sign = c[largest] < 0 ? -1.0f : 1.0f;
+
+	int j = 0;
+	for (int i = 0; i < 4; i++) {
+		if (i == largest)
+			continue;
+		float n = CLAMP((c[i] * sign + Math_SQRT12) / Math_SQRT2, 0, 1);
+		r_dst[j++] = uint16_t(Math::fast_ftoi(n * 32767.0f));
+	}
+
+	r_dst[0] |= (largest & 1) << 15;
+	r_dst[1] |= (largest >> 1) << 15;
+}
+
+static bool _compressed_is_same_rot(const Quat &p_a, const Quat &p_b) {
+
+	Quat b = p_a.dot(p_b) < 0 ? -p_b : p_b;
+	return Math::is_equal_approx(p_a.x, b.x) && Math::is_equal_approx(p_a.y, b.y) && Math::is_equal_approx(p_a.z, b.z) && Math::is_equal_approx(p_a.w, b.w);
+}
+
+void Animation::_compressed_transforms_update(CompressedTransforms *p_comp) {
+
+	int ofs = 0;
+	if (!(p_comp->flags & CompressedTransforms::FLAG_CONSTANT_LOC))
+		ofs += 3;
+	p_comp->rot_ofs = ofs;
+	if (!(p_comp->flags & CompressedTransforms::FLAG_CONSTANT_ROT))
+		ofs += 3;
+	p_comp->scale_ofs = ofs;
+	if (!(p_comp->flags & CompressedTransforms::FLAG_CONSTANT_SCALE))
+		ofs += 3;
+	p_comp->stride = ofs;
+
+	p_comp->loc_step = p_comp->loc_range / 65535.0;
+	p_comp->scale_step = p_comp->scale_range / 65535.0;
+}
+
+void Animation::_compressed_transforms_get_frame(const CompressedTransforms &p_comp, int p_frame, TransformKey *r_key) {
+
+	const uint16_t *f = p_comp.data.ptr() + p_frame * p_comp.stride;
+
+	if (p_comp.flags & CompressedTransforms::FLAG_CONSTANT_LOC) {
+		r_key->loc = p_comp.loc_min;
+	} else {
+		r_key->loc = p_comp.loc_min + Vector3(f[0], f[1], f[2]) * p_comp.loc_step;
+	}
+
+	if (p_comp.flags & CompressedTransforms::FLAG_CONSTANT_ROT) {
+		r_key->rot = p_comp.rot;
+	} else {
+		const uint16_t *r = f + p_comp.rot_ofs;
+		const real_t unit = Math_SQRT2 / 32767.0;
+		real_t a = (r[0] & 0x7FFF) * unit - Math_SQRT12;
+		real_t b = (r[1] & 0x7FFF) * unit - Math_SQRT12;
+		real_t c = r[2] * unit - Math_SQRT12;
+		real_t d = Math::sqrt(MAX(0, 1 - a * a - b * b - c * c));
+
+		switch ((r[0] >> 15) | ((r[1] >> 15) << 1)) {
+			case 0: r_key->rot = Quat(d, a, b, c); break;
+			case 1: r_key->rot = Quat(a, d, b, c); break;
+			case 2: r_key->rot = Quat(a, b, d, c); break;
+			default: r_key->rot = Quat(a, b, c, d); break;
+		}
+	}
+
+	if (p_comp.flags & CompressedTransforms::FLAG_CONSTANT_SCALE) {
+		r_key->scale = p_comp.scale_min;
+	} else {
+		const uint16_t *s = f + p_comp.scale_ofs;
+		r_key->scale = p_comp.scale_min + Vector3(s[0], s[1], s[2]) * p_comp.scale_step;
+	}
+}
+
+PoolVector<uint8_t> Animation::_compressed_transforms_to_bytes(const CompressedTransforms &p_comp) {
+
+	PoolVector<uint8_t> bytes;
+	bytes.resize(COMPRESSED_TRANSFORMS_HEADER_SIZE + p_comp.data.size() * 2);
+
+	PoolVector<uint8_t>::Write w = bytes.write();
+	uint8_t *ptr = w.ptr();
+
+	ptr += encode_uint32(p_comp.frame_count, ptr);
+	ptr += encode_float(p_comp.fps, ptr);
+	ptr += encode_uint32(p_comp.flags, ptr);
+	for (int i = 0; i < 3; i++)
+		ptr += encode_float(p_comp.loc_min[i], ptr);
+	for (int i = 0; i < 3; i++)
+		ptr += encode_float(p_comp.loc_range[i], ptr);
+	for (int i = 0; i < 3; i++)
+		ptr += encode_float(p_comp.scale_min[i], ptr);
+	for (int i = 0; i < 3; i++)
+		ptr += encode_float(p_comp.scale_range[i], ptr);
+	ptr += encode_float(p_comp.rot.x, ptr);
+	ptr += encode_float(p_comp.rot.y, ptr);
+	ptr += encode_float(p_comp.rot.z, ptr);
+	ptr += encode_float(p_comp.rot.w, ptr);
+
+	const uint16_t *src = p_comp.data.ptr();
+	for (int i = 0; i < p_comp.data.size(); i++)
+		ptr += encode_uint16(src[i], ptr);
+
+	return bytes;
+}
+
+bool Animation::_compressed_transforms_from_bytes(const PoolVector<uint8_t> &p_bytes, CompressedTransforms *r_comp) {
+
+	int size = p_bytes.size();
+	ERR_FAIL_COND_V(size < COMPRESSED_TRANSFORMS_HEADER_SIZE, false);
+
+	PoolVector<uint8_t>::Read r = p_bytes.read();
+	const uint8_t *ptr = r.ptr();
+
+	r_comp->frame_count = decode_uint32(&ptr[0]);
+	r_comp->fps = decode_float(&ptr[4]);
+	r_comp->flags = decode_uint32(&ptr[8]);
+	ptr += 12;
+	for (int i = 0; i < 3; i++)
+		r_comp->loc_min[i] = decode_float(&ptr[i * 4]);
+	ptr += 12;
+	for (int i = 0; i < 3; i++)
+		r_comp->loc_range[i] = decode_float(&ptr[i * 4]);
+	ptr += 12;
+	for (int i = 0; i < 3; i++)
+		r_comp->scale_min[i] = decode_float(&ptr[i * 4]);
+	ptr += 12;
+	for (int i = 0; i < 3; i++)
+		r_comp->scale_range[i] = decode_float(&ptr[i * 4]);
+	ptr += 12;
+	r_comp->rot = Quat(decode_float(&ptr[0]), decode_float(&ptr[4]), decode_float(&ptr[8]), decode_float(&ptr[12]));
+	ptr += 16;
+
+	ERR_FAIL_COND_V(r_comp->frame_count <= 0 || r_comp->fps <= 0, false);
+	_compressed_transforms_update(r_comp);
+	ERR_FAIL_COND_V(size != COMPRESSED_TRANSFORMS_HEADER_SIZE + r_comp->frame_count * r_comp->stride * 2, false);
+
+	int count = r_comp->frame_count * r_comp->stride;
+	r_comp->data.resize(count);
+	uint16_t *dst = r_comp->data.ptrw();
+	for (int i = 0; i < count; i++)
+		dst[i] = decode_uint16(&ptr[i * 2]);
+
+	return true;
+}
+
+Animation::TransformKey Animation::_compressed_transforms_interpolate(const TransformTrack *tt, float p_time, bool *p_ok) const {
+
+	// same rules as _interpolate(), with keys at fixed frame times, so the
+	// key lookup is a multiply instead of a binary search
+	const CompressedTransforms &ct = tt->compressed;
+	int last = ct.frame_count - 1;
+	float last_time = last / ct.fps;
+	int idx = 0;
+	int next = 0;
+	float c = 0;
+
+	if (p_time < 0) {
+
+		if (loop && tt->loop_wrap) {
+			idx = last;
+			next = 0;
+			float endtime = MAX(length - last_time, 0);
+			c = Math::is_zero_approx(endtime) ? 0 : (endtime + p_time) / endtime;
+		} else if (!loop) {
+			*p_ok = false;
+			return TransformKey();
+		}
+
+	} else {
+
+		float f = p_time * ct.fps;
+		idx = int(f);
+		if (idx < last) {
+			next = idx + 1;
+			c = f - idx;
+		} else {
+			idx = last;
+			next = last;
+			if (loop && tt->loop_wrap) {
+				next = 0;
+				float delta = length - last_time;
+				c = Math::is_zero_approx(delta) ? 0 : (p_time - last_time) / delta;
+			}
+		}
+	}
+
+	*p_ok = true;
+
+	TransformKey a;
+	_compressed_transforms_get_frame(ct, idx, &a);
+	if (idx == next || tt->interpolation == INTERPOLATION_NEAREST)
+		return a;
+
+	TransformKey b;
+	_compressed_transforms_get_frame(ct, next, &b);
+	if (tt->interpolation == INTERPOLATION_LINEAR)
+		return _interpolate(a, b, c);
+
+	int pre = MAX(idx - 1, 0);
+	int post = next + 1 > last ? next : next + 1;
+	TransformKey pa;
+	TransformKey pb;
+	_compressed_transforms_get_frame(ct, pre, &pa);
+	_compressed_transforms_get_frame(ct, post, &pb);
+
+	// decoded rotations may land on either hemisphere, and cubic_slerp does
+	// not pick the shortest path on its own
+	if (a.rot.dot(b.rot) < 0)
+		b.rot = -b.rot;
+	if (a.rot.dot(pa.rot) < 0)
+		pa.rot = -pa.rot;
+	if (b.rot.dot(pb.rot) < 0)
+		pb.rot = -pb.rot;
+
+	return _cubic_interpolate(pa, a, b, pb, c);
+}
+
+void Animation::_compressed_transforms_get_key_indices_in_range(const CompressedTransforms &p_comp, float from_time, float to_time, List<int> *p_indices) const {
+
+	if (from_time != length && to_time == length)
+		to_time = length * 1.01; //include a little more if at the end
+
+	int from = MAX(int(Math::ceil(from_time * p_comp.fps)), 0);
+	int to = MIN(int(Math::ceil(to_time * p_comp.fps)) - 1, p_comp.frame_count - 1);
+
+	for (int i = from; i <= to; i++)
+		p_indices->push_back(i);
+}
+
+bool Animation::_transform_track_compress(TransformTrack *tt, float p_fps) {
+
+	_transform_track_decompress(tt);
+
+	if (tt->transforms.size() == 0)
+		return false;
+	if (!loop && tt->transforms[0].time > 0)
+		return false; // the track is undefined before the first key, frames can't express that
+
+	int frame_count = int(Math::floor(length * p_fps + CMP_EPSILON)) + 1;
+
+	Vector<TransformKey> frames;
+	frames.resize(frame_count);
+
+	Vector3 loc_max;
+	Vector3 scale_max;
+	CompressedTransforms comp;
+	bool constant_rot = true;
+
+	for (int i = 0; i < frame_count; i++) {
+
+		bool ok = false;
+		TransformKey tk = _interpolate(tt->transforms, i / p_fps, tt->interpolation, tt->loop_wrap, &ok);
+		if (!ok)
+			return false;
+		tk.rot.normalize();
+		frames.write[i] = tk;
+
+		if (i == 0) {
+			comp.loc_min = loc_max = tk.loc;
+			comp.scale_min = scale_max = tk.scale;
+			continue;
+		}
+
+		for (int j = 0; j < 3; j++) {
+			comp.loc_min[j] = MIN(comp.loc_min[j], tk.loc[j]);
+			loc_max[j] = MAX(loc_max[j], tk.loc[j]);
+			comp.scale_min[j] = MIN(comp.scale_min[j], tk.scale[j]);
+			scale_max[j] = MAX(scale_max[j], tk.scale[j]);
+		}
+		if (constant_rot && !_compressed_is_same_rot(frames[0].rot, tk.rot))
+			constant_rot = false;
+	}
+
+	comp.fps = p_fps;
+	comp.frame_count = frame_count;
+	comp.loc_range = loc_max - comp.loc_min;
+	comp.scale_range = scale_max - comp.scale_min;
+	comp.rot = frames[0].rot;
+
+	if (comp.loc_range.length_squared() < CMP_EPSILON2) {
+		comp.flags |= CompressedTransforms::FLAG_CONSTANT_LOC;
+		comp.loc_min = frames[0].loc;
+		comp.loc_range = Vector3();
+	}
+	if (constant_rot)
+		comp.flags |= CompressedTransforms::FLAG_CONSTANT_ROT;
+	if (comp.scale_range.length_squared() < CMP_EPSILON2) {
+		comp.flags |= CompressedTransforms::FLAG_CONSTANT_SCALE;
+		comp.scale_min = frames[0].scale;
+		comp.scale_range = Vector3();
+	}
+
+	_compressed_transforms_update(&comp);
+	comp.data.resize(frame_count * comp.stride);
+	uint16_t *w = comp.data.ptrw();
+
+	for (int i = 0; i < frame_count; i++) {
+
+		const TransformKey &tk = frames[i];
+		uint16_t *f = w + i * comp.stride;
+
+		if (!(comp.flags & CompressedTransforms::FLAG_CONSTANT_LOC)) {
+			for (int j = 0; j < 3; j++)
+				f[j] = _compressed_quantize(tk.loc[j], comp.loc_min[j], comp.loc_range[j]);
+		}
+		if (!(comp.flags & CompressedTransforms::FLAG_CONSTANT_ROT)) {
+			_compressed_encode_rot(tk.rot, f + comp.rot_ofs);
+		}
+		if (!(comp.flags & CompressedTransforms::FLAG_CONSTANT_SCALE)) {
+			for (int j = 0; j < 3; j++)
+				f[comp.scale_ofs + j] = _compressed_quantize(tk.scale[j], comp.scale_min[j], comp.scale_range[j]);
+		}
+	}
+
+	tt->transforms.clear();
+	tt->compressed = comp;
+	return true;
+}
+
+void Animation::_transform_track_decompress(TransformTrack *tt) {
+
+	const CompressedTransforms &ct = tt->compressed;
+	if (ct.frame_count == 0)
+		return;
+
+	tt->transforms.resize(ct.frame_count);
+	for (int i = 0; i < ct.frame_count; i++) {
+		TKey<TransformKey> &tk = tt->transforms.write[i];
+		tk.time = i / ct.fps;
+		tk.transition = 1.0;
+		_compressed_transforms_get_frame(ct, i, &tk.value);
+	}
+
+	tt->compressed = CompressedTransforms();
+}
+
+void Animation::compress(float p_fps) {
+
+	ERR_FAIL_COND(p_fps <= 0);
+
+	for (int i = 0; i < tracks.size(); i++) {
+
+		if (tracks[i]->type == TYPE_TRANSFORM)
+			_transform_track_compress(static_cast<TransformTrack *>(tracks[i]), p_fps);
+	}
+	emit_changed();
+}
+
+bool Animation::transform_track_is_compressed(int p_track) const {
+
+	ERR_FAIL_INDEX_V(p_track, tracks.size(), false);
+	if (tracks[p_track]->type != TYPE_TRANSFORM)
+		return false;
+	return static_cast<const TransformTrack *>(tracks[p_track])->compressed.frame_count > 0;
+}
+
 Animation::Animation() {
 
 	step = 0.1;
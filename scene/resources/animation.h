@@ -106,9 +106,49 @@ private:
 
 	/* TRANSFORM TRACK */
 
+	// Fixed-rate, quantized storage for a transform track. Each frame holds
+	// only the non-constant channels, as 16-bit values: location and scale
+	// relative to the track bounds, rotation as the three smallest quaternion
+	// components with the index of the dropped one in the high bits.
+	struct CompressedTransforms {
+
+		enum {
+			FLAG_CONSTANT_LOC = 1,
+			FLAG_CONSTANT_ROT = 2,
+			FLAG_CONSTANT_SCALE = 4,
+		};
+
+		float fps;
+		int frame_count;
+		uint32_t flags;
+		Vector3 loc_min;
+		Vector3 loc_range;
+		Vector3 scale_min;
+		Vector3 scale_range;
+		Quat rot; // only used when the rotation is constant
+		Vector<uint16_t> data;
+
+		// derived, not saved
+		int stride;
+		int rot_ofs;
+		int scale_ofs;
+		Vector3 loc_step;
+		Vector3 scale_step;
+
+		CompressedTransforms() {
+			fps = 0;
+			frame_count = 0;
+			flags = 0;
+			stride = 0;
+			rot_ofs = 0;
+			scale_ofs = 0;
+		}
+	};
+
 	struct TransformTrack : public Track {
 
 		Vector<TKey<TransformKey> > transforms;
+		CompressedTransforms compressed; // used instead of transforms when frame_count > 0
 
 		TransformTrack() { type = TYPE_TRANSFORM; }
 	};
@@ -224,6 +264,16 @@ private:
 	template <class T>
 	_FORCE_INLINE_ void _track_get_key_indices_in_range(const Vector<T> &p_array, float from_time, float to_time, List<int> *p_indices) const;
 
+	static void _compressed_transforms_update(CompressedTransforms *p_comp);
+	static void _compressed_transforms_get_frame(const CompressedTransforms &p_comp, int p_frame, TransformKey *r_key);
+	static PoolVector<uint8_t> _compressed_transforms_to_bytes(const CompressedTransforms &p_comp);
+	static bool _compressed_transforms_from_bytes(const PoolVector<uint8_t> &p_bytes, CompressedTransforms *r_comp);
+	TransformKey _compressed_transforms_interpolate(const TransformTrack *tt, float p_time, bool *p_ok) const;
+	void _compressed_transforms_get_key_indices_in_range(const CompressedTransforms &p_comp, float from_time, float to_time, List<int> *p_indices) const;
+
+	bool _transform_track_compress(TransformTrack *tt, float p_fps);
+	void _transform_track_decompress(TransformTrack *tt);
+
 	_FORCE_INLINE_ void _value_track_get_key_indices_in_range(const ValueTrack *vt, float from_time, float to_time, List<int> *p_indices) const;
 	_FORCE_INLINE_ void _method_track_get_key_indices_in_range(const MethodTrack *mt, float from_time, float to_time, List<int> *p_indices) const;
 
@@ -371,6 +421,9 @@ public:
 
 	void optimize(float p_allowed_linear_err = 0.05, float p_allowed_angular_err = 0.01, float p_max_optimizable_angle = Math_PI * 0.125);
 
+	void compress(float p_fps = 30);
+	bool transform_track_is_compressed(int p_track) const;
+
 	Animation();
 	~Animation();
 };
@@ -70,6 +70,21 @@ int AudioStreamPlaybackSample::get_loop_count() const {
 	return 0;
 }
 
+bool AudioStreamPlaybackSample::is_looping() const {
+
+	return base->loop_mode != AudioStreamSample::LOOP_DISABLED;
+}
+
+float AudioStreamPlaybackSample::get_loop_begin() const {
+
+	return float(base->loop_begin) / base->mix_rate;
+}
+
+float AudioStreamPlaybackSample::get_loop_end() const {
+
+	return float(base->loop_end) / base->mix_rate;
+}
+
 float AudioStreamPlaybackSample::get_playback_position() const {
 
 	return float(offset >> MIX_FRAC_BITS) / base->mix_rate;
@@ -210,8 +225,9 @@ void AudioStreamPlaybackSample::do_resample(const Depth *p_src, AudioFrame *p_ds
 			final_r = final; //copy to right channel if stereo
 		}
 
-		p_dst->l = final / 32767.0;
-		p_dst->r = final_r / 32767.0;
+		//multiply instead of dividing in double precision, this loop runs for every frame of every voice
+		p_dst->l = final * (1.0f / 32767.0f);
+		p_dst->r = final_r * (1.0f / 32767.0f);
 		p_dst++;
 
 		offset += increment;
@@ -0,0 +1,190 @@
+/*************************************************************************/
+/*  audio_mix_kernels.cpp                                                */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "audio_mix_kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_MIX_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AUDIO_MIX_NEON
+#include <arm_neon.h>
+#endif
+
+// Vector loops handle frames two at a time (l0 r0 l1 r1), the odd frame left is done by the scalar tail.
+
+void AudioMixKernels::clear(AudioFrame *p_buffer, int p_frames) {
+
+	int i = 0;
+#if defined(AUDIO_MIX_SSE2)
+	float *buf = (float *)p_buffer;
+	__m128 zero = _mm_setzero_ps();
+	for (; i + 1 < p_frames; i += 2) {
+		_mm_storeu_ps(buf + i * 2, zero);
+	}
+#elif defined(AUDIO_MIX_NEON)
+	float *buf = (float *)p_buffer;
+	float32x4_t zero = vdupq_n_f32(0);
+	for (; i + 1 < p_frames; i += 2) {
+		vst1q_f32(buf + i * 2, zero);
+	}
+#endif
+	for (; i < p_frames; i++) {
+		p_buffer[i] = AudioFrame(0, 0);
+	}
+}
+
+void AudioMixKernels::accumulate(AudioFrame *p_dst, const AudioFrame *p_src, int p_frames) {
+
+	int i = 0;
+#if defined(AUDIO_MIX_SSE2)
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	for (; i + 1 < p_frames; i += 2) {
+		_mm_storeu_ps(dst + i * 2, _mm_add_ps(_mm_loadu_ps(dst + i * 2), _mm_loadu_ps(src + i * 2)));
+	}
+#elif defined(AUDIO_MIX_NEON)
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	for (; i + 1 < p_frames; i += 2) {
+		vst1q_f32(dst + i * 2, vaddq_f32(vld1q_f32(dst + i * 2), vld1q_f32(src + i * 2)));
+	}
+#endif
+	for (; i < p_frames; i++) {
+		p_dst[i] += p_src[i];
+	}
+}
+
+void AudioMixKernels::apply_volume_ramp(AudioFrame *p_buffer, int p_frames, float p_volume, float p_increment) {
+
+	int i = 0;
+#if defined(AUDIO_MIX_SSE2)
+	float *buf = (float *)p_buffer;
+	__m128 vol = _mm_setr_ps(p_volume, p_volume, p_volume + p_increment, p_volume + p_increment);
+	__m128 inc = _mm_set1_ps(p_increment * 2.0);
+	for (; i + 1 < p_frames; i += 2) {
+		_mm_storeu_ps(buf + i * 2, _mm_mul_ps(_mm_loadu_ps(buf + i * 2), vol));
+		vol = _mm_add_ps(vol, inc);
+	}
+#elif defined(AUDIO_MIX_NEON)
+	float *buf = (float *)p_buffer;
+	float init[4] = { p_volume, p_volume, p_volume + p_increment, p_volume + p_increment };
+	float32x4_t vol = vld1q_f32(init);
+	float32x4_t inc = vdupq_n_f32(p_increment * 2.0);
+	for (; i + 1 < p_frames; i += 2) {
+		vst1q_f32(buf + i * 2, vmulq_f32(vld1q_f32(buf + i * 2), vol));
+		vol = vaddq_f32(vol, inc);
+	}
+#endif
+	float volume = p_volume + p_increment * i;
+	for (; i < p_frames; i++) {
+		p_buffer[i] *= volume;
+		volume += p_increment;
+	}
+}
+
+void AudioMixKernels::mix_volume_ramp(AudioFrame *p_dst, const AudioFrame *p_src, int p_frames, const AudioFrame &p_volume, const AudioFrame &p_increment) {
+
+	int i = 0;
+#if defined(AUDIO_MIX_SSE2)
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	__m128 vol = _mm_setr_ps(p_volume.l, p_volume.r, p_volume.l + p_increment.l, p_volume.r + p_increment.r);
+	__m128 inc = _mm_setr_ps(p_increment.l * 2.0, p_increment.r * 2.0, p_increment.l * 2.0, p_increment.r * 2.0);
+	for (; i + 1 < p_frames; i += 2) {
+		_mm_storeu_ps(dst + i * 2, _mm_add_ps(_mm_loadu_ps(dst + i * 2), _mm_mul_ps(_mm_loadu_ps(src + i * 2), vol)));
+		vol = _mm_add_ps(vol, inc);
+	}
+#elif defined(AUDIO_MIX_NEON)
+	float *dst = (float *)p_dst;
+	const float *src = (const float *)p_src;
+	float init[4] = { p_volume.l, p_volume.r, p_volume.l + p_increment.l, p_volume.r + p_increment.r };
+	float incs[4] = { p_increment.l * 2.0f, p_increment.r * 2.0f, p_increment.l * 2.0f, p_increment.r * 2.0f };
+	float32x4_t vol = vld1q_f32(init);
+	float32x4_t inc = vld1q_f32(incs);
+	for (; i + 1 < p_frames; i += 2) {
+		vst1q_f32(dst + i * 2, vmlaq_f32(vld1q_f32(dst + i * 2), vld1q_f32(src + i * 2), vol));
+		vol = vaddq_f32(vol, inc);
+	}
+#endif
+	AudioFrame volume = p_volume + p_increment * float(i);
+	for (; i < p_frames; i++) {
+		p_dst[i] += p_src[i] * volume;
+		volume += p_increment;
+	}
+}
+
+AudioFrame AudioMixKernels::apply_volume_get_peak(AudioFrame *p_buffer, int p_frames, float p_volume) {
+
+	AudioFrame peak(0, 0);
+	int i = 0;
+#if defined(AUDIO_MIX_SSE2)
+	float *buf = (float *)p_buffer;
+	__m128 vol = _mm_set1_ps(p_volume);
+	__m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	__m128 vpeak = _mm_setzero_ps();
+	for (; i + 1 < p_frames; i += 2) {
+		__m128 v = _mm_mul_ps(_mm_loadu_ps(buf + i * 2), vol);
+		_mm_storeu_ps(buf + i * 2, v);
+		vpeak = _mm_max_ps(vpeak, _mm_and_ps(v, abs_mask));
+	}
+	float p[4];
+	_mm_storeu_ps(p, vpeak);
+	peak.l = MAX(p[0], p[2]);
+	peak.r = MAX(p[1], p[3]);
+#elif defined(AUDIO_MIX_NEON)
+	float *buf = (float *)p_buffer;
+	float32x4_t vpeak = vdupq_n_f32(0);
+	for (; i + 1 < p_frames; i += 2) {
+		float32x4_t v = vmulq_n_f32(vld1q_f32(buf + i * 2), p_volume);
+		vst1q_f32(buf + i * 2, v);
+		vpeak = vmaxq_f32(vpeak, vabsq_f32(v));
+	}
+	float p[4];
+	vst1q_f32(p, vpeak);
+	peak.l = MAX(p[0], p[2]);
+	peak.r = MAX(p[1], p[3]);
+#endif
+	for (; i < p_frames; i++) {
+
+		p_buffer[i] *= p_volume;
+
+		float l = ABS(p_buffer[i].l);
+		if (l > peak.l) {
+			peak.l = l;
+		}
+		float r = ABS(p_buffer[i].r);
+		if (r > peak.r) {
+			peak.r = r;
+		}
+	}
+
+	return peak;
+}
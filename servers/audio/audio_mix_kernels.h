@@ -0,0 +1,56 @@
+/*************************************************************************/
+/*  audio_mix_kernels.h                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                      https://godotengine.org                          */
+/*************************************************************************/
+/* Copyright (c) 2007-2019 Juan Linietsky, Ariel Manzur.                 */
+/* Copyright (c) 2014-2019 Godot Engine contributors (cf. AUTHORS.md)    */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#ifndef AUDIO_MIX_KERNELS_H
+#define AUDIO_MIX_KERNELS_H
+
+#include "core/math/audio_frame.h"
+
+/**
+ * Inner loops of the mixer (volume ramps, bus sends, peak metering).
+ * AudioFrame buffers are interleaved stereo floats, so these process two
+ * frames per SSE2/NEON register when available, falling back to plain loops.
+ */
+
+class AudioMixKernels {
+public:
+	// p_buffer[i] = 0
+	static void clear(AudioFrame *p_buffer, int p_frames);
+	// p_dst[i] += p_src[i]
+	static void accumulate(AudioFrame *p_dst, const AudioFrame *p_src, int p_frames);
+	// p_buffer[i] *= p_volume + p_increment * i
+	static void apply_volume_ramp(AudioFrame *p_buffer, int p_frames, float p_volume, float p_increment);
+	// p_dst[i] += p_src[i] * (p_volume + p_increment * i)
+	static void mix_volume_ramp(AudioFrame *p_dst, const AudioFrame *p_src, int p_frames, const AudioFrame &p_volume, const AudioFrame &p_increment);
+	// p_buffer[i] *= p_volume, returns the largest absolute sample of each side
+	static AudioFrame apply_volume_get_peak(AudioFrame *p_buffer, int p_frames, float p_volume);
+};
+
+#endif // AUDIO_MIX_KERNELS_H
@@ -339,6 +339,30 @@ int AudioStreamPlaybackRandomPitch::get_loop_count() const {
 	return 0;
 }
 
+bool AudioStreamPlaybackRandomPitch::is_looping() const {
+	if (playing.is_valid()) {
+		return playing->is_looping();
+	}
+
+	return false;
+}
+
+float AudioStreamPlaybackRandomPitch::get_loop_begin() const {
+	if (playing.is_valid()) {
+		return playing->get_loop_begin();
+	}
+
+	return 0;
+}
+
+float AudioStreamPlaybackRandomPitch::get_loop_end() const {
+	if (playing.is_valid()) {
+		return playing->get_loop_end();
+	}
+
+	return -1;
+}
+
 float AudioStreamPlaybackRandomPitch::get_playback_position() const {
 	if (playing.is_valid()) {
 		return playing->get_playback_position();
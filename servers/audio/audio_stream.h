@@ -46,6 +46,9 @@ public:
 	virtual bool is_playing() const = 0;
 
 	virtual int get_loop_count() const = 0; //times it looped
+	virtual bool is_looping() const { return false; } //restarts when reaching the end
+	virtual float get_loop_begin() const { return 0; } //where it restarts from, in seconds
+	virtual float get_loop_end() const { return -1; } //negative for the end of the stream
 
 	virtual float get_playback_position() const = 0;
 	virtual void seek(float p_time) = 0;
@@ -194,6 +197,9 @@ public:
 	virtual bool is_playing() const;
 
 	virtual int get_loop_count() const; //times it looped
+	virtual bool is_looping() const;
+	virtual float get_loop_begin() const;
+	virtual float get_loop_end() const;
 
 	virtual float get_playback_position() const;
 	virtual void seek(float p_time);
@@ -35,6 +35,8 @@
 #include "core/project_settings.h"
 #include "scene/resources/audio_stream_sample.h"
 #include "servers/audio/audio_driver_dummy.h"
+#include "servers/audio/audio_mix_kernels.h"
+#include "servers/audio/audio_stream.h"
 #include "servers/audio/effects/audio_effect_compressor.h"
 #ifdef TOOLS_ENABLED
 
@@ -332,139 +334,319 @@ void AudioServer::_mix_step() {
 		}
 	}
 
+	_update_voices();
+
 	//make callbacks for mixing the audio
 	for (Set<CallbackItem>::Element *E = callbacks.front(); E; E = E->next()) {
 
 		E->get().callback(E->get().userdata);
 	}
 
-	for (int i = buses.size() - 1; i >= 0; i--) {
-		//go bus by bus
-		Bus *bus = buses[i];
-
-		for (int k = 0; k < bus->channels.size(); k++) {
+	//buses only send to buses before them, so sorting them by distance to master
+	//gives groups that don't depend on each other and can be processed in parallel
+	int max_depth = 0;
 
-			if (bus->channels[k].active && !bus->channels[k].used) {
-				//buffer was not used, but it's still active, so it must be cleaned
-				AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
+	for (int i = 0; i < buses.size(); i++) {
+		Bus *bus = buses[i];
 
-				for (uint32_t j = 0; j < buffer_size; j++) {
+		Bus *send = NULL;
 
-					buf[j] = AudioFrame(0, 0);
+		if (i > 0) {
+			//everything has a send save for master bus
+			if (!bus_map.has(bus->send)) {
+				send = buses[0];
+			} else {
+				send = bus_map[bus->send];
+				if (send->index_cache >= bus->index_cache) { //invalid, send to master
+					send = buses[0];
 				}
 			}
 		}
 
-		//process effects
+		bus->mix_send = send;
+		bus->mix_depth = send ? send->mix_depth + 1 : 0;
+		max_depth = MAX(max_depth, bus->mix_depth);
+
+		//sidechained compressors read another bus while processing
+		bus->mix_serial = false;
 		if (!bus->bypass) {
 			for (int j = 0; j < bus->effects.size(); j++) {
+				const AudioEffectCompressor *compressor = Object::cast_to<AudioEffectCompressor>(*bus->effects[j].effect);
+				if (bus->effects[j].enabled && compressor && compressor->get_sidechain() != StringName()) {
+					bus->mix_serial = true;
+					break;
+				}
+			}
+		}
 
-				if (!bus->effects[j].enabled)
-					continue;
+		bus->mix_volume = Math::db2linear(bus->volume_db);
 
-#ifdef DEBUG_ENABLED
-				uint64_t ticks = OS::get_singleton()->get_ticks_usec();
-#endif
+		if (solo_mode) {
+			if (!bus->soloed) {
+				bus->mix_volume = 0.0;
+			}
+		} else {
+			if (bus->mute) {
+				bus->mix_volume = 0.0;
+			}
+		}
+	}
 
-				for (int k = 0; k < bus->channels.size(); k++) {
+	if (mix_bus_list.size() < buses.size()) {
+		mix_bus_list.resize(buses.size());
+	}
 
-					if (!(bus->channels[k].active || bus->channels[k].effect_instances[j]->process_silence()))
-						continue;
-					bus->channels.write[k].effect_instances.write[j]->process(bus->channels[k].buffer.ptr(), temp_buffer.write[k].ptrw(), buffer_size);
-				}
+	for (int depth = max_depth; depth >= 0; depth--) {
 
-				//swap buffers, so internal buffer always has the right data
-				for (int k = 0; k < bus->channels.size(); k++) {
+		int count = 0;
+		for (int i = buses.size() - 1; i >= 0; i--) {
+			if (buses[i]->mix_depth == depth && !buses[i]->mix_serial) {
+				mix_bus_list.write[count++] = buses[i];
+			}
+		}
 
-					if (!(buses[i]->channels[k].active || bus->channels[k].effect_instances[j]->process_silence()))
-						continue;
-					SWAP(bus->channels.write[k].buffer, temp_buffer.write[k]);
-				}
+		bus_work_pool.do_work(count, this, &AudioServer::_mix_step_bus, mix_bus_list.ptrw());
 
-#ifdef DEBUG_ENABLED
-				bus->effects.write[j].prof_time += OS::get_singleton()->get_ticks_usec() - ticks;
-#endif
+		for (int i = buses.size() - 1; i >= 0; i--) {
+			if (buses[i]->mix_depth == depth && buses[i]->mix_serial) {
+				_mix_bus(buses[i]);
 			}
 		}
 
-		//process send
+		//process sends, several buses may send to the same one so this stays serial
+		for (int i = buses.size() - 1; i >= 0; i--) {
 
-		Bus *send = NULL;
+			Bus *bus = buses[i];
+			if (bus->mix_depth != depth || !bus->mix_send) {
+				continue;
+			}
 
-		if (i > 0) {
-			//everything has a send save for master bus
-			if (!bus_map.has(bus->send)) {
-				send = buses[0];
-			} else {
-				send = bus_map[bus->send];
-				if (send->index_cache >= bus->index_cache) { //invalid, send to master
-					send = buses[0];
-				}
+			for (int k = 0; k < bus->channels.size(); k++) {
+
+				if (!bus->channels[k].active)
+					continue;
+
+				AudioFrame *target_buf = thread_get_channel_mix_buffer(bus->mix_send->index_cache, k);
+				AudioMixKernels::accumulate(target_buf, bus->channels[k].buffer.ptr(), buffer_size);
 			}
 		}
+	}
 
-		for (int k = 0; k < bus->channels.size(); k++) {
+	mix_frames += buffer_size;
+	to_mix = buffer_size;
+}
 
-			if (!bus->channels[k].active)
-				continue;
+struct AudioVoiceSort {
 
-			AudioFrame *buf = bus->channels.write[k].buffer.ptrw();
+	_FORCE_INLINE_ float _score(const AudioServer::Voice *p_voice) const {
+		//real voices are favored a bit, so similar voices don't keep swapping slots
+		return p_voice->virtualized ? p_voice->audibility : p_voice->audibility * 1.5;
+	}
 
-			AudioFrame peak = AudioFrame(0, 0);
+	_FORCE_INLINE_ bool operator()(const AudioServer::Voice *p_a, const AudioServer::Voice *p_b) const {
+		if (p_a->priority != p_b->priority) {
+			return p_a->priority > p_b->priority;
+		}
+		return _score(p_a) > _score(p_b);
+	}
+};
 
-			float volume = Math::db2linear(bus->volume_db);
+void AudioServer::_update_voices() {
 
-			if (solo_mode) {
-				if (!bus->soloed) {
-					volume = 0.0;
-				}
-			} else {
-				if (bus->mute) {
-					volume = 0.0;
-				}
-			}
+	//voices that mixed (or skipped) last step are playing, the rest start real when they play
+	float silence = Math::db2linear(channel_disable_threshold_db);
+	int playing = 0;
 
-			//apply volume and compute peak
-			for (uint32_t j = 0; j < buffer_size; j++) {
+	for (int i = 0; i < voices.size(); i++) {
+		Voice *voice = voices[i];
+		if (voice->last_mix_step != voice_mix_step) {
+			voice->virtualized = false;
+			continue;
+		}
+		if (max_real_voices > 0 && voice->audibility <= silence) {
+			voice->virtualized = true; //can't be heard, don't even compete
+			continue;
+		}
+		voice_sort.write[playing++] = voice;
+	}
 
-				buf[j] *= volume;
+	if (max_real_voices > 0 && playing > max_real_voices) {
+		SortArray<Voice *, AudioVoiceSort> sorter;
+		sorter.sort(voice_sort.ptrw(), playing);
+	}
 
-				float l = ABS(buf[j].l);
-				if (l > peak.l) {
-					peak.l = l;
-				}
-				float r = ABS(buf[j].r);
-				if (r > peak.r) {
-					peak.r = r;
+	real_voice_count = 0;
+	for (int i = 0; i < playing; i++) {
+		bool real = max_real_voices <= 0 || i < max_real_voices;
+		voice_sort[i]->virtualized = !real;
+		if (real) {
+			real_voice_count++;
+		}
+	}
+	virtual_voice_count = 0;
+	for (int i = 0; i < voices.size(); i++) {
+		if (voices[i]->last_mix_step == voice_mix_step && voices[i]->virtualized) {
+			virtual_voice_count++;
+		}
+	}
+
+	voice_mix_step++;
+}
+
+AudioServer::Voice *AudioServer::voice_create() {
+
+	Voice *voice = memnew(Voice);
+	voice->priority = 0;
+	voice->audibility = 1.0;
+	voice->virtualized = false;
+	voice->last_mix_step = 0;
+	voice->virtual_from = 0;
+	voice->virtual_time = 0;
+
+	lock();
+	voices.push_back(voice);
+	voice_sort.resize(voices.size());
+	unlock();
+
+	return voice;
+}
+
+void AudioServer::voice_free(Voice *p_voice) {
+
+	lock();
+	voices.erase(p_voice);
+	voice_sort.resize(voices.size());
+	unlock();
+
+	memdelete(p_voice);
+}
+
+bool AudioServer::thread_voice_advance(Voice *p_voice, AudioStreamPlayback *p_playback, float p_length, float p_pitch_scale, int p_frames) {
+
+	p_voice->last_mix_step = voice_mix_step;
+
+	if (p_length <= 0) {
+		//streaming from somewhere (generator, microphone), can't skip without losing data
+		return false;
+	}
+
+	if (p_voice->virtualized) {
+
+		if (p_voice->virtual_time == 0) {
+			p_voice->virtual_from = p_playback->get_playback_position();
+		}
+		p_voice->virtual_time += p_frames * p_pitch_scale / get_mix_rate();
+
+		if (!p_playback->is_looping() && p_voice->virtual_from + p_voice->virtual_time >= p_length) {
+			//would have finished by now
+			p_playback->stop();
+			p_voice->virtual_time = 0;
+		}
+		return true;
+	}
+
+	if (p_voice->virtual_time > 0) {
+		//back to real, continue from where it would be had it been mixed
+		float pos = p_voice->virtual_from + p_voice->virtual_time;
+		if (p_playback->is_looping()) {
+			//wrap into the loop region, streams may loop back to a point past the start
+			float loop_begin = CLAMP(p_playback->get_loop_begin(), 0, p_length);
+			float loop_end = p_playback->get_loop_end();
+			if (loop_end <= loop_begin || loop_end > p_length) {
+				loop_end = p_length;
+			}
+			if (pos >= loop_end) {
+				if (loop_end > loop_begin) {
+					pos = loop_begin + Math::fmod(pos - loop_begin, loop_end - loop_begin);
+				} else {
+					pos = Math::fmod(pos, p_length);
 				}
 			}
+		}
+		p_playback->seek(pos);
+		p_voice->virtual_time = 0;
+	}
+
+	return false;
+}
 
-			bus->channels.write[k].peak_volume = AudioFrame(Math::linear2db(peak.l + 0.0000000001), Math::linear2db(peak.r + 0.0000000001));
+int AudioServer::get_real_voice_count() const {
 
-			if (!bus->channels[k].used) {
-				//see if any audio is contained, because channel was not used
+	return real_voice_count;
+}
 
-				if (MAX(peak.r, peak.l) > Math::db2linear(channel_disable_threshold_db)) {
-					bus->channels.write[k].last_mix_with_audio = mix_frames;
-				} else if (mix_frames - bus->channels[k].last_mix_with_audio > channel_disable_frames) {
-					bus->channels.write[k].active = false;
-					continue; //went inactive, don't mix.
-				}
+int AudioServer::get_virtual_voice_count() const {
+
+	return virtual_voice_count;
+}
+
+void AudioServer::_mix_step_bus(uint32_t p_index, Bus **p_buses) {
+
+	_mix_bus(p_buses[p_index]);
+}
+
+void AudioServer::_mix_bus(Bus *p_bus) {
+
+	for (int k = 0; k < p_bus->channels.size(); k++) {
+
+		if (p_bus->channels[k].active && !p_bus->channels[k].used) {
+			//buffer was not used, but it's still active, so it must be cleaned
+			AudioMixKernels::clear(p_bus->channels.write[k].buffer.ptrw(), buffer_size);
+		}
+	}
+
+	//process effects
+	if (!p_bus->bypass) {
+		for (int j = 0; j < p_bus->effects.size(); j++) {
+
+			if (!p_bus->effects[j].enabled)
+				continue;
+
+#ifdef DEBUG_ENABLED
+			uint64_t ticks = OS::get_singleton()->get_ticks_usec();
+#endif
+
+			for (int k = 0; k < p_bus->channels.size(); k++) {
+
+				if (!(p_bus->channels[k].active || p_bus->channels[k].effect_instances[j]->process_silence()))
+					continue;
+				p_bus->channels.write[k].effect_instances.write[j]->process(p_bus->channels[k].buffer.ptr(), p_bus->channels.write[k].effect_buffer.ptrw(), buffer_size);
 			}
 
-			if (send) {
-				//if not master bus, send
-				AudioFrame *target_buf = thread_get_channel_mix_buffer(send->index_cache, k);
+			//swap buffers, so internal buffer always has the right data
+			for (int k = 0; k < p_bus->channels.size(); k++) {
 
-				for (uint32_t j = 0; j < buffer_size; j++) {
-					target_buf[j] += buf[j];
-				}
+				if (!(p_bus->channels[k].active || p_bus->channels[k].effect_instances[j]->process_silence()))
+					continue;
+				SWAP(p_bus->channels.write[k].buffer, p_bus->channels.write[k].effect_buffer);
 			}
+
+#ifdef DEBUG_ENABLED
+			p_bus->effects.write[j].prof_time += OS::get_singleton()->get_ticks_usec() - ticks;
+#endif
 		}
 	}
 
-	mix_frames += buffer_size;
-	to_mix = buffer_size;
+	for (int k = 0; k < p_bus->channels.size(); k++) {
+
+		if (!p_bus->channels[k].active)
+			continue;
+
+		//apply volume and compute peak
+		AudioFrame peak = AudioMixKernels::apply_volume_get_peak(p_bus->channels.write[k].buffer.ptrw(), buffer_size, p_bus->mix_volume);
+
+		p_bus->channels.write[k].peak_volume = AudioFrame(Math::linear2db(peak.l + 0.0000000001), Math::linear2db(peak.r + 0.0000000001));
+
+		if (!p_bus->channels[k].used) {
+			//see if any audio is contained, because channel was not used
+
+			if (MAX(peak.r, peak.l) > Math::db2linear(channel_disable_threshold_db)) {
+				p_bus->channels.write[k].last_mix_with_audio = mix_frames;
+			} else if (mix_frames - p_bus->channels[k].last_mix_with_audio > channel_disable_frames) {
+				p_bus->channels.write[k].active = false; //went inactive, don't send
+			}
+		}
+	}
 }
 
 bool AudioServer::thread_has_channel_mix_buffer(int p_bus, int p_buffer) const {
@@ -815,6 +997,7 @@ void AudioServer::_update_bus_effects(int p_bus) {
 
 	for (int i = 0; i < buses[p_bus]->channels.size(); i++) {
 		buses.write[p_bus]->channels.write[i].effect_instances.resize(buses[p_bus]->effects.size());
+		buses.write[p_bus]->channels.write[i].effect_buffer.resize(buses[p_bus]->effects.size() ? buffer_size : 0);
 		for (int j = 0; j < buses[p_bus]->effects.size(); j++) {
 			Ref<AudioEffectInstance> fx = buses.write[p_bus]->effects.write[j].effect->instance();
 			if (Object::cast_to<AudioEffectCompressorInstance>(*fx)) {
@@ -946,16 +1129,12 @@ bool AudioServer::is_bus_channel_active(int p_bus, int p_channel) const {
 
 void AudioServer::init_channels_and_buffers() {
 	channel_count = get_channel_count();
-	temp_buffer.resize(channel_count);
-
-	for (int i = 0; i < temp_buffer.size(); i++) {
-		temp_buffer.write[i].resize(buffer_size);
-	}
 
 	for (int i = 0; i < buses.size(); i++) {
 		buses[i]->channels.resize(channel_count);
 		for (int j = 0; j < channel_count; j++) {
 			buses.write[i]->channels.write[j].buffer.resize(buffer_size);
+			buses.write[i]->channels.write[j].effect_buffer.resize(buses[i]->effects.size() ? buffer_size : 0);
 		}
 	}
 }
@@ -967,6 +1146,14 @@ void AudioServer::init() {
 	ProjectSettings::get_singleton()->set_custom_property_info("audio/channel_disable_time", PropertyInfo(Variant::REAL, "audio/channel_disable_time", PROPERTY_HINT_RANGE, "0,5,0.01,or_greater"));
 	buffer_size = 1024; //hardcoded for now
 
+	max_real_voices = GLOBAL_DEF_RST("audio/max_real_voices", 0);
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/max_real_voices", PropertyInfo(Variant::INT, "audio/max_real_voices", PROPERTY_HINT_RANGE, "0,1024,1"));
+
+	int threads = GLOBAL_DEF_RST("audio/mixing_threads", 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("audio/mixing_threads", PropertyInfo(Variant::INT, "audio/mixing_threads", PROPERTY_HINT_RANGE, "0,64,1"));
+	//0 means one thread per logical core
+	bus_work_pool.init(threads > 0 ? threads : -1);
+
 	init_channels_and_buffers();
 
 	mix_count = 0;
@@ -1068,6 +1255,8 @@ void AudioServer::finish() {
 		AudioDriverManager::get_driver(i)->finish();
 	}
 
+	bus_work_pool.finish();
+
 	for (int i = 0; i < buses.size(); i++) {
 		memdelete(buses[i]);
 	}
@@ -1396,6 +1585,10 @@ AudioServer::AudioServer() {
 #endif
 	mix_time = 0;
 	mix_size = 0;
+	voice_mix_step = 0;
+	max_real_voices = 0;
+	real_voice_count = 0;
+	virtual_voice_count = 0;
 }
 
 AudioServer::~AudioServer() {
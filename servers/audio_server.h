@@ -34,11 +34,13 @@
 #include "core/math/audio_frame.h"
 #include "core/object.h"
 #include "core/os/os.h"
+#include "core/os/thread_work_pool.h"
 #include "core/variant.h"
 #include "servers/audio/audio_effect.h"
 
 class AudioDriverDummy;
 class AudioStream;
+class AudioStreamPlayback;
 class AudioStreamSample;
 
 class AudioDriver {
@@ -163,6 +165,18 @@ public:
 
 	typedef void (*AudioCallback)(void *p_userdata);
 
+	//a playing sound, voices compete for a limited amount of real (mixed) slots
+	struct Voice {
+		int priority;
+		float audibility; //loudest output volume, linear
+
+		//audio thread
+		bool virtualized;
+		uint64_t last_mix_step;
+		float virtual_from; //playback position when it went virtual
+		float virtual_time; //seconds played while virtual
+	};
+
 private:
 	uint64_t mix_time;
 	int mix_size;
@@ -195,6 +209,7 @@ private:
 			bool active;
 			AudioFrame peak_volume;
 			Vector<AudioFrame> buffer;
+			Vector<AudioFrame> effect_buffer; //effects write here, then it's swapped with buffer
 			Vector<Ref<AudioEffectInstance> > effect_instances;
 			uint64_t last_mix_with_audio;
 			Channel() {
@@ -219,9 +234,14 @@ private:
 		float volume_db;
 		StringName send;
 		int index_cache;
+
+		//computed at the start of each mix step
+		Bus *mix_send;
+		int mix_depth; //distance to master through sends
+		bool mix_serial; //has effects reading other buses, can't be mixed in parallel
+		float mix_volume;
 	};
 
-	Vector<Vector<AudioFrame> > temp_buffer; //temp_buffer for each level
 	Vector<Bus *> buses;
 	Map<StringName, Bus *> bus_map;
 
@@ -242,7 +262,21 @@ private:
 
 	void init_channels_and_buffers();
 
+	Vector<Voice *> voices;
+	Vector<Voice *> voice_sort;
+	uint64_t voice_mix_step;
+	int max_real_voices;
+	int real_voice_count;
+	int virtual_voice_count;
+
+	void _update_voices();
+
+	ThreadWorkPool bus_work_pool;
+	Vector<Bus *> mix_bus_list;
+
 	void _mix_step();
+	void _mix_step_bus(uint32_t p_index, Bus **p_buses);
+	void _mix_bus(Bus *p_bus);
 
 #if 0
 	struct AudioInBlock {
@@ -368,6 +402,21 @@ public:
 	void add_callback(AudioCallback p_callback, void *p_userdata);
 	void remove_callback(AudioCallback p_callback, void *p_userdata);
 
+	Voice *voice_create();
+	void voice_free(Voice *p_voice);
+	_FORCE_INLINE_ void voice_set_priority(Voice *p_voice, int p_priority) { p_voice->priority = p_priority; }
+	_FORCE_INLINE_ void voice_set_audibility(Voice *p_voice, float p_audibility) { p_voice->audibility = p_audibility; }
+
+	//call when the playback was started, seeked or stopped, from mix callbacks or with the server locked
+	//the virtual position is taken again from the playback on the next advance
+	_FORCE_INLINE_ void voice_reset(Voice *p_voice) { p_voice->virtual_time = 0; }
+
+	//called from mix callbacks, returns true if the voice must not be mixed this step
+	bool thread_voice_advance(Voice *p_voice, AudioStreamPlayback *p_playback, float p_length, float p_pitch_scale, int p_frames);
+
+	int get_real_voice_count() const;
+	int get_virtual_voice_count() const;
+
 	void add_update_callback(AudioCallback p_callback, void *p_userdata);
 	void remove_update_callback(AudioCallback p_callback, void *p_userdata);
 
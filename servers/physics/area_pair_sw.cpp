@@ -31,15 +31,20 @@
 #include "area_pair_sw.h"
 #include "collision_solver_sw.h"
 
-bool AreaPairSW::setup(real_t p_step) {
+void AreaPairSW::compute_contacts(real_t p_step) {
 
-	bool result = false;
+	overlapping = false;
 
 	if (area->is_shape_set_as_disabled(area_shape) || body->is_shape_set_as_disabled(body_shape)) {
-		result = false;
+		overlapping = false;
 	} else if (area->test_collision_mask(body) && CollisionSolverSW::solve_static(body->get_shape(body_shape), body->get_transform() * body->get_shape_transform(body_shape), area->get_shape(area_shape), area->get_transform() * area->get_shape_transform(area_shape), NULL, this)) {
-		result = true;
+		overlapping = true;
 	}
+}
+
+bool AreaPairSW::setup(real_t p_step) {
+
+	bool result = overlapping;
 
 	if (result != colliding) {
 
@@ -74,6 +79,7 @@ AreaPairSW::AreaPairSW(BodySW *p_body, int p_body_shape, AreaSW *p_area, int p_a
 	body_shape = p_body_shape;
 	area_shape = p_area_shape;
 	colliding = false;
+	overlapping = false;
 	body->add_constraint(this, 0);
 	area->add_constraint(this);
 	if (p_body->get_mode() == PhysicsServer::BODY_MODE_KINEMATIC)
@@ -95,14 +101,19 @@ AreaPairSW::~AreaPairSW() {
 
 ////////////////////////////////////////////////////
 
-bool Area2PairSW::setup(real_t p_step) {
+void Area2PairSW::compute_contacts(real_t p_step) {
 
-	bool result = false;
+	overlapping = false;
 	if (area_a->is_shape_set_as_disabled(shape_a) || area_b->is_shape_set_as_disabled(shape_b)) {
-		result = false;
+		overlapping = false;
 	} else if (area_a->test_collision_mask(area_b) && CollisionSolverSW::solve_static(area_a->get_shape(shape_a), area_a->get_transform() * area_a->get_shape_transform(shape_a), area_b->get_shape(shape_b), area_b->get_transform() * area_b->get_shape_transform(shape_b), NULL, this)) {
-		result = true;
+		overlapping = true;
 	}
+}
+
+bool Area2PairSW::setup(real_t p_step) {
+
+	bool result = overlapping;
 
 	if (result != colliding) {
 
@@ -139,6 +150,7 @@ Area2PairSW::Area2PairSW(AreaSW *p_area_a, int p_shape_a, AreaSW *p_area_b, int
 	shape_a = p_shape_a;
 	shape_b = p_shape_b;
 	colliding = false;
+	overlapping = false;
 	area_a->add_constraint(this);
 	area_b->add_constraint(this);
 }
@@ -219,23 +219,42 @@ real_t combine_friction(BodySW *A, BodySW *B) {
 	return ABS(MIN(A->get_friction(), B->get_friction()));
 }
 
-bool BodyPairSW::setup(real_t p_step) {
+void BodyPairSW::compute_contacts(real_t p_step) {
+
+	collision_tested = false;
 
 	//cannot collide
 	if (!A->test_collision_mask(B) || A->has_exception(B->get_self()) || B->has_exception(A->get_self()) || (A->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC && B->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC && A->get_max_contacts_reported() == 0 && B->get_max_contacts_reported() == 0)) {
 		collided = false;
-		return false;
+		return;
 	}
 
 	if (A->is_shape_set_as_disabled(shape_A) || B->is_shape_set_as_disabled(shape_B)) {
 		collided = false;
-		return false;
+		return;
 	}
 
 	offset_B = B->get_transform().get_origin() - A->get_transform().get_origin();
 
 	validate_contacts();
 
+	Transform xform_Au = Transform(A->get_transform().basis, Vector3());
+	Transform xform_A = xform_Au * A->get_shape_transform(shape_A);
+
+	Transform xform_Bu = B->get_transform();
+	xform_Bu.origin -= A->get_transform().get_origin();
+	Transform xform_B = xform_Bu * B->get_shape_transform(shape_B);
+
+	collided = CollisionSolverSW::solve_static(A->get_shape(shape_A), xform_A, B->get_shape(shape_B), xform_B, _contact_added_callback, this, &sep_axis);
+	collision_tested = true;
+}
+
+bool BodyPairSW::setup(real_t p_step) {
+
+	if (!collision_tested)
+		return false;
+
+	//transforms did not change since compute_contacts()
 	Vector3 offset_A = A->get_transform().get_origin();
 	Transform xform_Au = Transform(A->get_transform().basis, Vector3());
 	Transform xform_A = xform_Au * A->get_shape_transform(shape_A);
@@ -247,9 +266,6 @@ bool BodyPairSW::setup(real_t p_step) {
 	ShapeSW *shape_A_ptr = A->get_shape(shape_A);
 	ShapeSW *shape_B_ptr = B->get_shape(shape_B);
 
-	bool collided = CollisionSolverSW::solve_static(shape_A_ptr, xform_A, shape_B_ptr, xform_B, _contact_added_callback, this, &sep_axis);
-	this->collided = collided;
-
 	if (!collided) {
 
 		//test ccd (currently just a raycast)
@@ -486,6 +502,7 @@ BodyPairSW::BodyPairSW(BodySW *p_A, int p_shape_A, BodySW *p_B, int p_shape_B) :
 	B->add_constraint(this, 1);
 	contact_count = 0;
 	collided = false;
+	collision_tested = false;
 }
 
 BodyPairSW::~BodyPairSW() {
@@ -76,6 +76,7 @@ class BodyPairSW : public ConstraintSW {
 	Contact contacts[MAX_CONTACTS];
 	int contact_count;
 	bool collided;
+	bool collision_tested;
 
 	static void _contact_added_callback(const Vector3 &p_point_A, const Vector3 &p_point_B, void *p_userdata);
 
@@ -87,6 +88,7 @@ class BodyPairSW : public ConstraintSW {
 	SpaceSW *space;
 
 public:
+	void compute_contacts(real_t p_step);
 	bool setup(real_t p_step);
 	void solve(real_t p_step);
 
@@ -34,6 +34,32 @@
 #include "core/project_settings.h"
 #include "physics_server_sw.h"
 
+// Cull buffers for the batch queries run on the work pool, the space's own
+// are shared. Allocated on a thread's first batch query and kept until it exits.
+struct SpaceBatchCullBuffers {
+
+	CollisionObjectSW **results;
+	int *subindices;
+
+	_FORCE_INLINE_ void ensure(int p_max) {
+
+		if (unlikely(!results)) {
+			results = (CollisionObjectSW **)Memory::alloc_static(sizeof(CollisionObjectSW *) * p_max);
+			subindices = (int *)Memory::alloc_static(sizeof(int) * p_max);
+		}
+	}
+
+	~SpaceBatchCullBuffers() {
+
+		if (results) {
+			Memory::free_static(results);
+			Memory::free_static(subindices);
+		}
+	}
+};
+
+static thread_local SpaceBatchCullBuffers thread_cull_buffers;
+
 _FORCE_INLINE_ static bool _can_collide_with(CollisionObjectSW *p_object, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
 	if (!(p_object->get_collision_layer() & p_collision_mask)) {
@@ -93,9 +119,7 @@ int PhysicsDirectSpaceStateSW::intersect_point(const Vector3 &p_point, ShapeResu
 	return cc;
 }
 
-bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3 &p_from, const Vector3 &p_to, RayResult &r_result, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_pick_ray) {
-
-	ERR_FAIL_COND_V(space->locked, false);
+bool PhysicsDirectSpaceStateSW::_intersect_ray_impl(const Vector3 &p_from, const Vector3 &p_to, RayResult &r_result, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_pick_ray, CollisionObjectSW **r_cull_results, int *r_cull_subindices) {
 
 	Vector3 begin, end;
 	Vector3 normal;
@@ -103,7 +127,7 @@ bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3 &p_from, const Vecto
 	end = p_to;
 	normal = (end - begin).normalized();
 
-	int amount = space->broadphase->cull_segment(begin, end, space->intersection_query_results, SpaceSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+	int amount = space->broadphase->cull_segment(begin, end, r_cull_results, SpaceSW::INTERSECTION_QUERY_MAX, r_cull_subindices);
 
 	//todo, create another array that references results, compute AABBs and check closest point to ray origin, sort, and stop evaluating results when beyond first collision
 
@@ -115,18 +139,18 @@ bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3 &p_from, const Vecto
 
 	for (int i = 0; i < amount; i++) {
 
-		if (!_can_collide_with(space->intersection_query_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
+		if (!_can_collide_with(r_cull_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
 			continue;
 
-		if (p_pick_ray && !(static_cast<CollisionObjectSW *>(space->intersection_query_results[i])->is_ray_pickable()))
+		if (p_pick_ray && !(static_cast<CollisionObjectSW *>(r_cull_results[i])->is_ray_pickable()))
 			continue;
 
-		if (p_exclude.has(space->intersection_query_results[i]->get_self()))
+		if (p_exclude.has(r_cull_results[i]->get_self()))
 			continue;
 
-		const CollisionObjectSW *col_obj = space->intersection_query_results[i];
+		const CollisionObjectSW *col_obj = r_cull_results[i];
 
-		int shape_idx = space->intersection_query_subindex_results[i];
+		int shape_idx = r_cull_subindices[i];
 		Transform inv_xform = col_obj->get_shape_inv_transform(shape_idx) * col_obj->get_inv_transform();
 
 		Vector3 local_from = inv_xform.xform(begin);
@@ -171,6 +195,13 @@ bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3 &p_from, const Vecto
 	return true;
 }
 
+bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3 &p_from, const Vector3 &p_to, RayResult &r_result, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_pick_ray) {
+
+	ERR_FAIL_COND_V(space->locked, false);
+
+	return _intersect_ray_impl(p_from, p_to, r_result, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, p_pick_ray, space->intersection_query_results, space->intersection_query_subindex_results);
+}
+
 int PhysicsDirectSpaceStateSW::intersect_shape(const RID &p_shape, const Transform &p_xform, real_t p_margin, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
 	if (p_result_max <= 0)
@@ -222,23 +253,20 @@ int PhysicsDirectSpaceStateSW::intersect_shape(const RID &p_shape, const Transfo
 	return cc;
 }
 
-bool PhysicsDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transform &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_info) {
+bool PhysicsDirectSpaceStateSW::_cast_motion_impl(ShapeSW *p_shape, const Transform &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_info, CollisionObjectSW **r_cull_results, int *r_cull_subindices) {
 
-	ShapeSW *shape = static_cast<PhysicsServerSW *>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
-	ERR_FAIL_COND_V(!shape, false);
-
-	AABB aabb = p_xform.xform(shape->get_aabb());
+	AABB aabb = p_xform.xform(p_shape->get_aabb());
 	aabb = aabb.merge(AABB(aabb.position + p_motion, aabb.size)); //motion
 	aabb = aabb.grow(p_margin);
 
-	int amount = space->broadphase->cull_aabb(aabb, space->intersection_query_results, SpaceSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+	int amount = space->broadphase->cull_aabb(aabb, r_cull_results, SpaceSW::INTERSECTION_QUERY_MAX, r_cull_subindices);
 
 	real_t best_safe = 1;
 	real_t best_unsafe = 1;
 
 	Transform xform_inv = p_xform.affine_inverse();
 	MotionShapeSW mshape;
-	mshape.shape = shape;
+	mshape.shape = p_shape;
 	mshape.motion = xform_inv.basis.xform(p_motion);
 
 	bool best_first = true;
@@ -247,14 +275,14 @@ bool PhysicsDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transform
 
 	for (int i = 0; i < amount; i++) {
 
-		if (!_can_collide_with(space->intersection_query_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
+		if (!_can_collide_with(r_cull_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
 			continue;
 
-		if (p_exclude.has(space->intersection_query_results[i]->get_self()))
+		if (p_exclude.has(r_cull_results[i]->get_self()))
 			continue; //ignore excluded
 
-		const CollisionObjectSW *col_obj = space->intersection_query_results[i];
-		int shape_idx = space->intersection_query_subindex_results[i];
+		const CollisionObjectSW *col_obj = r_cull_results[i];
+		int shape_idx = r_cull_subindices[i];
 
 		Vector3 point_A, point_B;
 		Vector3 sep_axis = p_motion.normalized();
@@ -268,7 +296,7 @@ bool PhysicsDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transform
 		//test initial overlap
 		sep_axis = p_motion.normalized();
 
-		if (!CollisionSolverSW::solve_distance(shape, p_xform, col_obj->get_shape(shape_idx), col_obj_xform, point_A, point_B, aabb, &sep_axis)) {
+		if (!CollisionSolverSW::solve_distance(p_shape, p_xform, col_obj->get_shape(shape_idx), col_obj_xform, point_A, point_B, aabb, &sep_axis)) {
 			return false;
 		}
 
@@ -328,6 +356,14 @@ bool PhysicsDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transform
 	return true;
 }
 
+bool PhysicsDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transform &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_info) {
+
+	ShapeSW *shape = static_cast<PhysicsServerSW *>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ERR_FAIL_COND_V(!shape, false);
+
+	return _cast_motion_impl(shape, p_xform, p_motion, p_margin, p_closest_safe, p_closest_unsafe, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, r_info, space->intersection_query_results, space->intersection_query_subindex_results);
+}
+
 bool PhysicsDirectSpaceStateSW::collide_shape(RID p_shape, const Transform &p_shape_xform, real_t p_margin, Vector3 *r_results, int p_result_max, int &r_result_count, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
 	if (p_result_max <= 0)
@@ -501,9 +537,113 @@ Vector3 PhysicsDirectSpaceStateSW::get_closest_point_to_object_volume(RID p_obje
 	}
 }
 
+void PhysicsDirectSpaceStateSW::_intersect_ray_batch_work(uint32_t p_index, RayBatch *p_batch) {
+
+	SpaceBatchCullBuffers &buffers = thread_cull_buffers;
+	buffers.ensure(SpaceSW::INTERSECTION_QUERY_MAX);
+
+	p_batch->hits[p_index] = _intersect_ray_impl(p_batch->from[p_index], p_batch->to[p_index], p_batch->results[p_index], *p_batch->exclude, p_batch->collision_mask, p_batch->collide_with_bodies, p_batch->collide_with_areas, false, buffers.results, buffers.subindices);
+}
+
+int PhysicsDirectSpaceStateSW::intersect_ray_batch(const Vector3 *p_from, const Vector3 *p_to, int p_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_threaded) {
+
+	ERR_FAIL_COND_V(space->locked, 0);
+
+	RayBatch batch;
+	batch.from = p_from;
+	batch.to = p_to;
+	batch.results = r_results;
+	batch.hits = r_hits;
+	batch.exclude = &p_exclude;
+	batch.collision_mask = p_collision_mask;
+	batch.collide_with_bodies = p_collide_with_bodies;
+	batch.collide_with_areas = p_collide_with_areas;
+
+	if (_use_threads(p_threaded)) {
+		work_pool.do_work(p_count, this, &PhysicsDirectSpaceStateSW::_intersect_ray_batch_work, &batch);
+	} else {
+		for (int i = 0; i < p_count; i++) {
+			r_hits[i] = _intersect_ray_impl(p_from[i], p_to[i], r_results[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, false, space->intersection_query_results, space->intersection_query_subindex_results);
+		}
+	}
+
+	int hit_count = 0;
+	for (int i = 0; i < p_count; i++) {
+		if (r_hits[i])
+			hit_count++;
+	}
+	return hit_count;
+}
+
+void PhysicsDirectSpaceStateSW::_cast_motion_batch_work(uint32_t p_index, MotionBatch *p_batch) {
+
+	SpaceBatchCullBuffers &buffers = thread_cull_buffers;
+	buffers.ensure(SpaceSW::INTERSECTION_QUERY_MAX);
+
+	if (!_cast_motion_impl(p_batch->shape, p_batch->xforms[p_index], p_batch->motions[p_index], p_batch->margin, p_batch->closest_safe[p_index], p_batch->closest_unsafe[p_index], *p_batch->exclude, p_batch->collision_mask, p_batch->collide_with_bodies, p_batch->collide_with_areas, NULL, buffers.results, buffers.subindices)) {
+		p_batch->closest_safe[p_index] = 0;
+		p_batch->closest_unsafe[p_index] = 0;
+	}
+}
+
+int PhysicsDirectSpaceStateSW::cast_motion_batch(const RID &p_shape, const Transform *p_xforms, const Vector3 *p_motions, int p_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_threaded) {
+
+	ERR_FAIL_COND_V(space->locked, 0);
+
+	ShapeSW *shape = static_cast<PhysicsServerSW *>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ERR_FAIL_COND_V(!shape, 0);
+
+	MotionBatch batch;
+	batch.shape = shape;
+	batch.xforms = p_xforms;
+	batch.motions = p_motions;
+	batch.margin = p_margin;
+	batch.closest_safe = r_closest_safe;
+	batch.closest_unsafe = r_closest_unsafe;
+	batch.exclude = &p_exclude;
+	batch.collision_mask = p_collision_mask;
+	batch.collide_with_bodies = p_collide_with_bodies;
+	batch.collide_with_areas = p_collide_with_areas;
+
+	if (_use_threads(p_threaded)) {
+		work_pool.do_work(p_count, this, &PhysicsDirectSpaceStateSW::_cast_motion_batch_work, &batch);
+	} else {
+		for (int i = 0; i < p_count; i++) {
+			if (!_cast_motion_impl(shape, p_xforms[i], p_motions[i], p_margin, r_closest_safe[i], r_closest_unsafe[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, NULL, space->intersection_query_results, space->intersection_query_subindex_results)) {
+				r_closest_safe[i] = 0; // stuck from the start
+				r_closest_unsafe[i] = 0;
+			}
+		}
+	}
+
+	int blocked_count = 0;
+	for (int i = 0; i < p_count; i++) {
+		if (r_closest_safe[i] < 1)
+			blocked_count++;
+	}
+	return blocked_count;
+}
+
+bool PhysicsDirectSpaceStateSW::_use_threads(bool p_threaded) {
+
+	// Culls must not modify the broadphase for queries to run concurrently, so pending moves are applied here.
+	if (!p_threaded || !space->broadphase->is_cull_thread_safe())
+		return false;
+
+	space->broadphase->update();
+
+	if (!work_pool_initialized) {
+		work_pool.init();
+		work_pool_initialized = true;
+	}
+
+	return true;
+}
+
 PhysicsDirectSpaceStateSW::PhysicsDirectSpaceStateSW() {
 
 	space = NULL;
+	work_pool_initialized = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
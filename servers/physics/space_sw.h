@@ -38,6 +38,7 @@
 #include "broad_phase_sw.h"
 #include "collision_object_sw.h"
 #include "core/hash_map.h"
+#include "core/os/thread_work_pool.h"
 #include "core/project_settings.h"
 #include "core/typedefs.h"
 
@@ -45,6 +46,39 @@ class PhysicsDirectSpaceStateSW : public PhysicsDirectSpaceState {
 
 	GDCLASS(PhysicsDirectSpaceStateSW, PhysicsDirectSpaceState);
 
+	struct RayBatch {
+		const Vector3 *from;
+		const Vector3 *to;
+		RayResult *results;
+		bool *hits;
+		const Set<RID> *exclude;
+		uint32_t collision_mask;
+		bool collide_with_bodies;
+		bool collide_with_areas;
+	};
+
+	struct MotionBatch {
+		ShapeSW *shape;
+		const Transform *xforms;
+		const Vector3 *motions;
+		real_t margin;
+		real_t *closest_safe;
+		real_t *closest_unsafe;
+		const Set<RID> *exclude;
+		uint32_t collision_mask;
+		bool collide_with_bodies;
+		bool collide_with_areas;
+	};
+
+	ThreadWorkPool work_pool;
+	bool work_pool_initialized;
+
+	bool _intersect_ray_impl(const Vector3 &p_from, const Vector3 &p_to, RayResult &r_result, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_pick_ray, CollisionObjectSW **r_cull_results, int *r_cull_subindices);
+	bool _cast_motion_impl(ShapeSW *p_shape, const Transform &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_info, CollisionObjectSW **r_cull_results, int *r_cull_subindices);
+	void _intersect_ray_batch_work(uint32_t p_index, RayBatch *p_batch);
+	void _cast_motion_batch_work(uint32_t p_index, MotionBatch *p_batch);
+	bool _use_threads(bool p_threaded);
+
 public:
 	SpaceSW *space;
 
@@ -56,6 +90,9 @@ public:
 	virtual bool rest_info(RID p_shape, const Transform &p_shape_xform, real_t p_margin, ShapeRestInfo *r_info, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual Vector3 get_closest_point_to_object_volume(RID p_object, const Vector3 p_point) const;
 
+	virtual int intersect_ray_batch(const Vector3 *p_from, const Vector3 *p_to, int p_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, bool p_threaded = false);
+	virtual int cast_motion_batch(const RID &p_shape, const Transform *p_xforms, const Vector3 *p_motions, int p_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude = Set<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, bool p_threaded = false);
+
 	PhysicsDirectSpaceStateSW();
 };
 
@@ -32,6 +32,7 @@
 #include "joints_sw.h"
 
 #include "core/os/os.h"
+#include "core/project_settings.h"
 
 void StepSW::_populate_island(BodySW *p_body, BodySW **p_island, ConstraintSW **p_constraint_island) {
 
@@ -107,6 +108,16 @@ void StepSW::_solve_island(ConstraintSW *p_island, int p_iterations, real_t p_de
 	}
 }
 
+void StepSW::_compute_contacts_work(uint32_t p_index, void *p_userdata) {
+
+	all_constraints[p_index]->compute_contacts(solve_delta);
+}
+
+void StepSW::_solve_island_work(uint32_t p_index, void *p_userdata) {
+
+	_solve_island(constraint_islands[p_index], solve_iterations, solve_delta);
+}
+
 void StepSW::_check_suspend(BodySW *p_island, real_t p_delta) {
 
 	bool can_sleep = true;
@@ -228,6 +239,25 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 		profile_begtime = profile_endtime;
 	}
 
+	/* COMPUTE CONTACTS */
+
+	{
+		//narrow phase for every pair runs in parallel, results are applied serially in setup
+		all_constraints.clear();
+		ConstraintSW *ci = constraint_island_list;
+		while (ci) {
+			ConstraintSW *c = ci;
+			while (c) {
+				all_constraints.push_back(c);
+				c = c->get_island_next();
+			}
+			ci = ci->get_island_list_next();
+		}
+
+		solve_delta = p_delta;
+		work_pool.do_work(all_constraints.size(), this, &StepSW::_compute_contacts_work, (void *)NULL);
+	}
+
 	/* SETUP CONSTRAINT ISLANDS */
 
 	{
@@ -247,7 +277,20 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SOLVE CONSTRAINT ISLANDS */
 
-	{
+	if (work_pool.get_thread_count() > 1) {
+		//islands never share dynamic bodies, so they can be solved in parallel
+		//each island is still solved by a single thread, so results stay deterministic
+		constraint_islands.clear();
+		ConstraintSW *ci = constraint_island_list;
+		while (ci) {
+			constraint_islands.push_back(ci);
+			ci = ci->get_island_list_next();
+		}
+
+		solve_iterations = p_iterations;
+		solve_delta = p_delta;
+		work_pool.do_work(constraint_islands.size(), this, &StepSW::_solve_island_work, (void *)NULL);
+	} else {
 		ConstraintSW *ci = constraint_island_list;
 		while (ci) {
 			//iterating each island separatedly improves cache efficiency
@@ -296,4 +339,16 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 StepSW::StepSW() {
 
 	_step = 1;
+	solve_iterations = 0;
+	solve_delta = 0;
+
+	int threads = GLOBAL_DEF("physics/3d/worker_threads", 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("physics/3d/worker_threads", PropertyInfo(Variant::INT, "physics/3d/worker_threads", PROPERTY_HINT_RANGE, "0,64,1"));
+	//0 means one thread per logical core
+	work_pool.init(threads > 0 ? threads : -1);
+}
+
+StepSW::~StepSW() {
+
+	work_pool.finish();
 }
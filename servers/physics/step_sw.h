@@ -33,18 +33,29 @@
 
 #include "space_sw.h"
 
+#include "core/os/thread_work_pool.h"
+
 class StepSW {
 
 	uint64_t _step;
 
+	ThreadWorkPool work_pool;
+	Vector<ConstraintSW *> all_constraints;
+	Vector<ConstraintSW *> constraint_islands;
+	int solve_iterations;
+	real_t solve_delta;
+
 	void _populate_island(BodySW *p_body, BodySW **p_island, ConstraintSW **p_constraint_island);
 	void _setup_island(ConstraintSW *p_island, real_t p_delta);
 	void _solve_island(ConstraintSW *p_island, int p_iterations, real_t p_delta);
+	void _compute_contacts_work(uint32_t p_index, void *p_userdata);
+	void _solve_island_work(uint32_t p_index, void *p_userdata);
 	void _check_suspend(BodySW *p_island, real_t p_delta);
 
 public:
 	void step(SpaceSW *p_space, real_t p_delta, int p_iterations);
 	StepSW();
+	~StepSW();
 };
 
 #endif // STEP__SW_H
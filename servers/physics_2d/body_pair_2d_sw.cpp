@@ -227,17 +227,19 @@ real_t combine_friction(Body2DSW *A, Body2DSW *B) {
 	return ABS(MIN(A->get_friction(), B->get_friction()));
 }
 
-bool BodyPair2DSW::setup(real_t p_step) {
+void BodyPair2DSW::_test_collision() {
+
+	collision_tested = false;
 
 	//cannot collide
 	if (!A->test_collision_mask(B) || A->has_exception(B->get_self()) || B->has_exception(A->get_self()) || (A->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC && B->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC && A->get_max_contacts_reported() == 0 && B->get_max_contacts_reported() == 0)) {
 		collided = false;
-		return false;
+		return;
 	}
 
 	if (A->is_shape_set_as_disabled(shape_A) || B->is_shape_set_as_disabled(shape_B)) {
 		collided = false;
-		return false;
+		return;
 	}
 
 	//use local A coordinates to avoid numerical issues on collision detection
@@ -245,7 +247,6 @@ bool BodyPair2DSW::setup(real_t p_step) {
 
 	_validate_contacts();
 
-	Vector2 offset_A = A->get_transform().get_origin();
 	Transform2D xform_Au = A->get_transform().untranslated();
 	Transform2D xform_A = xform_Au * A->get_shape_transform(shape_A);
 
@@ -253,9 +254,6 @@ bool BodyPair2DSW::setup(real_t p_step) {
 	xform_Bu.elements[2] -= A->get_transform().get_origin();
 	Transform2D xform_B = xform_Bu * B->get_shape_transform(shape_B);
 
-	Shape2DSW *shape_A_ptr = A->get_shape(shape_A);
-	Shape2DSW *shape_B_ptr = B->get_shape(shape_B);
-
 	Vector2 motion_A, motion_B;
 
 	if (A->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_SHAPE) {
@@ -266,9 +264,40 @@ bool BodyPair2DSW::setup(real_t p_step) {
 	}
 	//faster to set than to check..
 
-	//bool prev_collided=collided;
+	collided = CollisionSolver2DSW::solve(A->get_shape(shape_A), xform_A, motion_A, B->get_shape(shape_B), xform_B, motion_B, _add_contact, this, &sep_axis);
+	collision_tested = true;
+}
+
+void BodyPair2DSW::compute_contacts(real_t p_step) {
+
+	collision_tested = false;
+
+	if (_is_casting_shape())
+		return; //shape casting is CCD too, it is tested in setup() like the other modes
+
+	_test_collision();
+}
+
+bool BodyPair2DSW::setup(real_t p_step) {
+
+	if (_is_casting_shape())
+		_test_collision(); //in island order, same as the single-threaded path
+
+	if (!collision_tested)
+		return false;
+
+	//transforms did not change since compute_contacts()
+	Vector2 offset_A = A->get_transform().get_origin();
+	Transform2D xform_Au = A->get_transform().untranslated();
+	Transform2D xform_A = xform_Au * A->get_shape_transform(shape_A);
+
+	Transform2D xform_Bu = B->get_transform();
+	xform_Bu.elements[2] -= A->get_transform().get_origin();
+	Transform2D xform_B = xform_Bu * B->get_shape_transform(shape_B);
+
+	Shape2DSW *shape_A_ptr = A->get_shape(shape_A);
+	Shape2DSW *shape_B_ptr = B->get_shape(shape_B);
 
-	collided = CollisionSolver2DSW::solve(shape_A_ptr, xform_A, motion_A, shape_B_ptr, xform_B, motion_B, _add_contact, this, &sep_axis);
 	if (!collided) {
 
 		//test ccd (currently just a raycast)
@@ -522,6 +551,7 @@ BodyPair2DSW::BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_sh
 	B->add_constraint(this, 1);
 	contact_count = 0;
 	collided = false;
+	collision_tested = false;
 	oneway_disabled = false;
 }
 
@@ -77,15 +77,22 @@ class BodyPair2DSW : public Constraint2DSW {
 	Contact contacts[MAX_CONTACTS];
 	int contact_count;
 	bool collided;
+	bool collision_tested;
 	bool oneway_disabled;
 	int cc;
 
+	void _test_collision();
 	bool _test_ccd(real_t p_step, Body2DSW *p_A, int p_shape_A, const Transform2D &p_xform_A, Body2DSW *p_B, int p_shape_B, const Transform2D &p_xform_B, bool p_swap_result = false);
 	void _validate_contacts();
 	static void _add_contact(const Vector2 &p_point_A, const Vector2 &p_point_B, void *p_self);
 	_FORCE_INLINE_ void _contact_added_callback(const Vector2 &p_point_A, const Vector2 &p_point_B);
+	_FORCE_INLINE_ bool _is_casting_shape() const {
+
+		return A->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_SHAPE || B->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_SHAPE;
+	}
 
 public:
+	void compute_contacts(real_t p_step);
 	bool setup(real_t p_step);
 	void solve(real_t p_step);
 
@@ -66,6 +66,9 @@ public:
 
 	virtual void update() = 0;
 
+	// True if the cull methods don't modify the broadphase once update() has run, so they can then be called from several threads at once.
+	virtual bool is_cull_thread_safe() const { return false; }
+
 	virtual ~BroadPhase2DSW();
 };
 
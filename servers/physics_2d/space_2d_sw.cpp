@@ -34,6 +34,33 @@
 #include "core/os/os.h"
 #include "core/pair.h"
 #include "physics_2d_server_sw.h"
+
+// Cull buffers for the batch queries run on the work pool, the space's own
+// are shared. Allocated on a thread's first batch query and kept until it exits.
+struct Space2DBatchCullBuffers {
+
+	CollisionObject2DSW **results;
+	int *subindices;
+
+	_FORCE_INLINE_ void ensure(int p_max) {
+
+		if (unlikely(!results)) {
+			results = (CollisionObject2DSW **)Memory::alloc_static(sizeof(CollisionObject2DSW *) * p_max);
+			subindices = (int *)Memory::alloc_static(sizeof(int) * p_max);
+		}
+	}
+
+	~Space2DBatchCullBuffers() {
+
+		if (results) {
+			Memory::free_static(results);
+			Memory::free_static(subindices);
+		}
+	}
+};
+
+static thread_local Space2DBatchCullBuffers thread_cull_buffers;
+
 _FORCE_INLINE_ static bool _can_collide_with(CollisionObject2DSW *p_object, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
 	if (!(p_object->get_collision_layer() & p_collision_mask)) {
@@ -113,9 +140,7 @@ int Physics2DDirectSpaceStateSW::intersect_point_on_canvas(const Vector2 &p_poin
 	return _intersect_point_impl(p_point, r_results, p_result_max, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, p_pick_point, true, p_canvas_instance_id);
 }
 
-bool Physics2DDirectSpaceStateSW::intersect_ray(const Vector2 &p_from, const Vector2 &p_to, RayResult &r_result, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
-
-	ERR_FAIL_COND_V(space->locked, false);
+bool Physics2DDirectSpaceStateSW::_intersect_ray_impl(const Vector2 &p_from, const Vector2 &p_to, RayResult &r_result, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, CollisionObject2DSW **r_cull_results, int *r_cull_subindices) {
 
 	Vector2 begin, end;
 	Vector2 normal;
@@ -123,7 +148,7 @@ bool Physics2DDirectSpaceStateSW::intersect_ray(const Vector2 &p_from, const Vec
 	end = p_to;
 	normal = (end - begin).normalized();
 
-	int amount = space->broadphase->cull_segment(begin, end, space->intersection_query_results, Space2DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+	int amount = space->broadphase->cull_segment(begin, end, r_cull_results, Space2DSW::INTERSECTION_QUERY_MAX, r_cull_subindices);
 
 	//todo, create another array that references results, compute AABBs and check closest point to ray origin, sort, and stop evaluating results when beyond first collision
 
@@ -135,15 +160,15 @@ bool Physics2DDirectSpaceStateSW::intersect_ray(const Vector2 &p_from, const Vec
 
 	for (int i = 0; i < amount; i++) {
 
-		if (!_can_collide_with(space->intersection_query_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
+		if (!_can_collide_with(r_cull_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
 			continue;
 
-		if (p_exclude.has(space->intersection_query_results[i]->get_self()))
+		if (p_exclude.has(r_cull_results[i]->get_self()))
 			continue;
 
-		const CollisionObject2DSW *col_obj = space->intersection_query_results[i];
+		const CollisionObject2DSW *col_obj = r_cull_results[i];
 
-		int shape_idx = space->intersection_query_subindex_results[i];
+		int shape_idx = r_cull_subindices[i];
 		Transform2D inv_xform = col_obj->get_shape_inv_transform(shape_idx) * col_obj->get_inv_transform();
 
 		Vector2 local_from = inv_xform.xform(begin);
@@ -193,6 +218,13 @@ bool Physics2DDirectSpaceStateSW::intersect_ray(const Vector2 &p_from, const Vec
 	return true;
 }
 
+bool Physics2DDirectSpaceStateSW::intersect_ray(const Vector2 &p_from, const Vector2 &p_to, RayResult &r_result, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	ERR_FAIL_COND_V(space->locked, false);
+
+	return _intersect_ray_impl(p_from, p_to, r_result, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, space->intersection_query_results, space->intersection_query_subindex_results);
+}
+
 int Physics2DDirectSpaceStateSW::intersect_shape(const RID &p_shape, const Transform2D &p_xform, const Vector2 &p_motion, real_t p_margin, ShapeResult *r_results, int p_result_max, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
 	if (p_result_max <= 0)
@@ -238,39 +270,36 @@ int Physics2DDirectSpaceStateSW::intersect_shape(const RID &p_shape, const Trans
 	return cc;
 }
 
-bool Physics2DDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transform2D &p_xform, const Vector2 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+bool Physics2DDirectSpaceStateSW::_cast_motion_impl(Shape2DSW *p_shape, const Transform2D &p_xform, const Vector2 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, CollisionObject2DSW **r_cull_results, int *r_cull_subindices) {
 
-	Shape2DSW *shape = Physics2DServerSW::singletonsw->shape_owner.get(p_shape);
-	ERR_FAIL_COND_V(!shape, false);
-
-	Rect2 aabb = p_xform.xform(shape->get_aabb());
+	Rect2 aabb = p_xform.xform(p_shape->get_aabb());
 	aabb = aabb.merge(Rect2(aabb.position + p_motion, aabb.size)); //motion
 	aabb = aabb.grow(p_margin);
 
-	int amount = space->broadphase->cull_aabb(aabb, space->intersection_query_results, Space2DSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+	int amount = space->broadphase->cull_aabb(aabb, r_cull_results, Space2DSW::INTERSECTION_QUERY_MAX, r_cull_subindices);
 
 	real_t best_safe = 1;
 	real_t best_unsafe = 1;
 
 	for (int i = 0; i < amount; i++) {
 
-		if (!_can_collide_with(space->intersection_query_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
+		if (!_can_collide_with(r_cull_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas))
 			continue;
 
-		if (p_exclude.has(space->intersection_query_results[i]->get_self()))
+		if (p_exclude.has(r_cull_results[i]->get_self()))
 			continue; //ignore excluded
 
-		const CollisionObject2DSW *col_obj = space->intersection_query_results[i];
-		int shape_idx = space->intersection_query_subindex_results[i];
+		const CollisionObject2DSW *col_obj = r_cull_results[i];
+		int shape_idx = r_cull_subindices[i];
 
 		Transform2D col_obj_xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
 		//test initial overlap, does it collide if going all the way?
-		if (!CollisionSolver2DSW::solve(shape, p_xform, p_motion, col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, NULL, p_margin)) {
+		if (!CollisionSolver2DSW::solve(p_shape, p_xform, p_motion, col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, NULL, p_margin)) {
 			continue;
 		}
 
 		//test initial overlap
-		if (CollisionSolver2DSW::solve(shape, p_xform, Vector2(), col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, NULL, p_margin)) {
+		if (CollisionSolver2DSW::solve(p_shape, p_xform, Vector2(), col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, NULL, p_margin)) {
 
 			return false;
 		}
@@ -285,7 +314,7 @@ bool Physics2DDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transfor
 			real_t ofs = (low + hi) * 0.5;
 
 			Vector2 sep = mnormal; //important optimization for this to work fast enough
-			bool collided = CollisionSolver2DSW::solve(shape, p_xform, p_motion * ofs, col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, &sep, p_margin);
+			bool collided = CollisionSolver2DSW::solve(p_shape, p_xform, p_motion * ofs, col_obj->get_shape(shape_idx), col_obj_xform, Vector2(), NULL, NULL, &sep, p_margin);
 
 			if (collided) {
 
@@ -308,6 +337,14 @@ bool Physics2DDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transfor
 	return true;
 }
 
+bool Physics2DDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transform2D &p_xform, const Vector2 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+
+	Shape2DSW *shape = Physics2DServerSW::singletonsw->shape_owner.get(p_shape);
+	ERR_FAIL_COND_V(!shape, false);
+
+	return _cast_motion_impl(shape, p_xform, p_motion, p_margin, p_closest_safe, p_closest_unsafe, p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, space->intersection_query_results, space->intersection_query_subindex_results);
+}
+
 bool Physics2DDirectSpaceStateSW::collide_shape(RID p_shape, const Transform2D &p_shape_xform, const Vector2 &p_motion, real_t p_margin, Vector2 *r_results, int p_result_max, int &r_result_count, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 
 	if (p_result_max <= 0)
@@ -464,9 +501,113 @@ bool Physics2DDirectSpaceStateSW::rest_info(RID p_shape, const Transform2D &p_sh
 	return true;
 }
 
+void Physics2DDirectSpaceStateSW::_intersect_ray_batch_work(uint32_t p_index, RayBatch *p_batch) {
+
+	Space2DBatchCullBuffers &buffers = thread_cull_buffers;
+	buffers.ensure(Space2DSW::INTERSECTION_QUERY_MAX);
+
+	p_batch->hits[p_index] = _intersect_ray_impl(p_batch->from[p_index], p_batch->to[p_index], p_batch->results[p_index], *p_batch->exclude, p_batch->collision_mask, p_batch->collide_with_bodies, p_batch->collide_with_areas, buffers.results, buffers.subindices);
+}
+
+int Physics2DDirectSpaceStateSW::intersect_ray_batch(const Vector2 *p_from, const Vector2 *p_to, int p_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_threaded) {
+
+	ERR_FAIL_COND_V(space->locked, 0);
+
+	RayBatch batch;
+	batch.from = p_from;
+	batch.to = p_to;
+	batch.results = r_results;
+	batch.hits = r_hits;
+	batch.exclude = &p_exclude;
+	batch.collision_mask = p_collision_mask;
+	batch.collide_with_bodies = p_collide_with_bodies;
+	batch.collide_with_areas = p_collide_with_areas;
+
+	if (_use_threads(p_threaded)) {
+		work_pool.do_work(p_count, this, &Physics2DDirectSpaceStateSW::_intersect_ray_batch_work, &batch);
+	} else {
+		for (int i = 0; i < p_count; i++) {
+			r_hits[i] = _intersect_ray_impl(p_from[i], p_to[i], r_results[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, space->intersection_query_results, space->intersection_query_subindex_results);
+		}
+	}
+
+	int hit_count = 0;
+	for (int i = 0; i < p_count; i++) {
+		if (r_hits[i])
+			hit_count++;
+	}
+	return hit_count;
+}
+
+void Physics2DDirectSpaceStateSW::_cast_motion_batch_work(uint32_t p_index, MotionBatch *p_batch) {
+
+	Space2DBatchCullBuffers &buffers = thread_cull_buffers;
+	buffers.ensure(Space2DSW::INTERSECTION_QUERY_MAX);
+
+	if (!_cast_motion_impl(p_batch->shape, p_batch->xforms[p_index], p_batch->motions[p_index], p_batch->margin, p_batch->closest_safe[p_index], p_batch->closest_unsafe[p_index], *p_batch->exclude, p_batch->collision_mask, p_batch->collide_with_bodies, p_batch->collide_with_areas, buffers.results, buffers.subindices)) {
+		p_batch->closest_safe[p_index] = 0;
+		p_batch->closest_unsafe[p_index] = 0;
+	}
+}
+
+int Physics2DDirectSpaceStateSW::cast_motion_batch(const RID &p_shape, const Transform2D *p_xforms, const Vector2 *p_motions, int p_count, real_t p_margin, real_t *r_closest_safe, real_t *r_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_threaded) {
+
+	ERR_FAIL_COND_V(space->locked, 0);
+
+	Shape2DSW *shape = Physics2DServerSW::singletonsw->shape_owner.get(p_shape);
+	ERR_FAIL_COND_V(!shape, 0);
+
+	MotionBatch batch;
+	batch.shape = shape;
+	batch.xforms = p_xforms;
+	batch.motions = p_motions;
+	batch.margin = p_margin;
+	batch.closest_safe = r_closest_safe;
+	batch.closest_unsafe = r_closest_unsafe;
+	batch.exclude = &p_exclude;
+	batch.collision_mask = p_collision_mask;
+	batch.collide_with_bodies = p_collide_with_bodies;
+	batch.collide_with_areas = p_collide_with_areas;
+
+	if (_use_threads(p_threaded)) {
+		work_pool.do_work(p_count, this, &Physics2DDirectSpaceStateSW::_cast_motion_batch_work, &batch);
+	} else {
+		for (int i = 0; i < p_count; i++) {
+			if (!_cast_motion_impl(shape, p_xforms[i], p_motions[i], p_margin, r_closest_safe[i], r_closest_unsafe[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, space->intersection_query_results, space->intersection_query_subindex_results)) {
+				r_closest_safe[i] = 0; // stuck from the start
+				r_closest_unsafe[i] = 0;
+			}
+		}
+	}
+
+	int blocked_count = 0;
+	for (int i = 0; i < p_count; i++) {
+		if (r_closest_safe[i] < 1)
+			blocked_count++;
+	}
+	return blocked_count;
+}
+
+bool Physics2DDirectSpaceStateSW::_use_threads(bool p_threaded) {
+
+	// Culls must not modify the broadphase for queries to run concurrently, so pending moves are applied here.
+	if (!p_threaded || !space->broadphase->is_cull_thread_safe())
+		return false;
+
+	space->broadphase->update();
+
+	if (!work_pool_initialized) {
+		work_pool.init();
+		work_pool_initialized = true;
+	}
+
+	return true;
+}
+
 Physics2DDirectSpaceStateSW::Physics2DDirectSpaceStateSW() {
 
 	space = NULL;
+	work_pool_initialized = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +30,7 @@
 
 #include "step_2d_sw.h"
 #include "core/os/os.h"
+#include "core/project_settings.h"
 
 void Step2DSW::_populate_island(Body2DSW *p_body, Body2DSW **p_island, Constraint2DSW **p_constraint_island) {
 
@@ -131,6 +132,11 @@ void Step2DSW::_check_suspend(Body2DSW *p_island, real_t p_delta) {
 	}
 }
 
+void Step2DSW::_compute_contacts_work(uint32_t p_index, void *p_userdata) {
+
+	all_constraints[p_index]->compute_contacts(step_delta);
+}
+
 void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	p_space->lock(); // can't access space during this
@@ -215,6 +221,25 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 		profile_begtime = profile_endtime;
 	}
 
+	/* COMPUTE CONTACTS */
+
+	{
+		//narrow phase for every pair runs in parallel, results are applied serially in setup
+		all_constraints.clear();
+		Constraint2DSW *ci = constraint_island_list;
+		while (ci) {
+			Constraint2DSW *c = ci;
+			while (c) {
+				all_constraints.push_back(c);
+				c = c->get_island_next();
+			}
+			ci = ci->get_island_list_next();
+		}
+
+		step_delta = p_delta;
+		work_pool.do_work(all_constraints.size(), this, &Step2DSW::_compute_contacts_work, (void *)NULL);
+	}
+
 	/* SETUP CONSTRAINT ISLANDS */
 
 	{
@@ -313,4 +338,15 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 Step2DSW::Step2DSW() {
 
 	_step = 1;
+	step_delta = 0;
+
+	int threads = GLOBAL_DEF("physics/2d/worker_threads", 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("physics/2d/worker_threads", PropertyInfo(Variant::INT, "physics/2d/worker_threads", PROPERTY_HINT_RANGE, "0,64,1"));
+	//0 means one thread per logical core
+	work_pool.init(threads > 0 ? threads : -1);
+}
+
+Step2DSW::~Step2DSW() {
+
+	work_pool.finish();
 }
@@ -33,18 +33,26 @@
 
 #include "space_2d_sw.h"
 
+#include "core/os/thread_work_pool.h"
+
 class Step2DSW {
 
 	uint64_t _step;
 
+	ThreadWorkPool work_pool;
+	Vector<Constraint2DSW *> all_constraints;
+	real_t step_delta;
+
 	void _populate_island(Body2DSW *p_body, Body2DSW **p_island, Constraint2DSW **p_constraint_island);
 	bool _setup_island(Constraint2DSW *p_island, real_t p_delta);
 	void _solve_island(Constraint2DSW *p_island, int p_iterations, real_t p_delta);
 	void _check_suspend(Body2DSW *p_island, real_t p_delta);
+	void _compute_contacts_work(uint32_t p_index, void *p_userdata);
 
 public:
 	void step(Space2DSW *p_space, real_t p_delta, int p_iterations);
 	Step2DSW();
+	~Step2DSW();
 };
 
 #endif // STEP_2D_SW_H
@@ -356,6 +356,135 @@ Dictionary PhysicsDirectSpaceState::_get_rest_info(const Ref<PhysicsShapeQueryPa
 	return r;
 }
 
+Dictionary PhysicsDirectSpaceState::_intersect_ray_batch(const PoolVector3Array &p_from, const PoolVector3Array &p_to, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_threaded) {
+
+	ERR_FAIL_COND_V(p_from.size() != p_to.size(), Dictionary());
+
+	int count = p_from.size();
+
+	Set<RID> exclude;
+	for (int i = 0; i < p_exclude.size(); i++)
+		exclude.insert(p_exclude[i]);
+
+	Vector<RayResult> results;
+	results.resize(count);
+	Vector<bool> hits;
+	hits.resize(count);
+
+	{
+		PoolVector3Array::Read from = p_from.read();
+		PoolVector3Array::Read to = p_to.read();
+		intersect_ray_batch(from.ptr(), to.ptr(), count, results.ptrw(), hits.ptrw(), exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas, p_threaded);
+	}
+
+	PoolByteArray hit;
+	PoolVector3Array position;
+	PoolVector3Array normal;
+	PoolIntArray collider_id;
+	PoolIntArray shape;
+	hit.resize(count);
+	position.resize(count);
+	normal.resize(count);
+	collider_id.resize(count);
+	shape.resize(count);
+
+	{
+		PoolByteArray::Write hitw = hit.write();
+		PoolVector3Array::Write positionw = position.write();
+		PoolVector3Array::Write normalw = normal.write();
+		PoolIntArray::Write collider_idw = collider_id.write();
+		PoolIntArray::Write shapew = shape.write();
+
+		for (int i = 0; i < count; i++) {
+
+			if (hits[i]) {
+				const RayResult &rr = results[i];
+				hitw[i] = 1;
+				positionw[i] = rr.position;
+				normalw[i] = rr.normal;
+				collider_idw[i] = rr.collider_id;
+				shapew[i] = rr.shape;
+			} else {
+				hitw[i] = 0;
+				positionw[i] = Vector3();
+				normalw[i] = Vector3();
+				collider_idw[i] = 0;
+				shapew[i] = -1;
+			}
+		}
+	}
+
+	Dictionary d;
+	d["hit"] = hit;
+	d["position"] = position;
+	d["normal"] = normal;
+	d["collider_id"] = collider_id;
+	d["shape"] = shape;
+
+	return d;
+}
+
+Dictionary PhysicsDirectSpaceState::_cast_motion_batch(const Ref<PhysicsShapeQueryParameters> &p_shape_query, const PoolVector3Array &p_origins, const PoolVector3Array &p_motions, bool p_threaded) {
+
+	ERR_FAIL_COND_V(!p_shape_query.is_valid(), Dictionary());
+	ERR_FAIL_COND_V(p_origins.size() != p_motions.size(), Dictionary());
+
+	int count = p_origins.size();
+
+	Vector<Transform> xforms;
+	xforms.resize(count);
+	{
+		PoolVector3Array::Read origins = p_origins.read();
+		for (int i = 0; i < count; i++) {
+			xforms.write[i] = Transform(p_shape_query->transform.basis, origins[i]);
+		}
+	}
+
+	PoolRealArray safe;
+	PoolRealArray unsafe;
+	safe.resize(count);
+	unsafe.resize(count);
+
+	{
+		PoolVector3Array::Read motions = p_motions.read();
+		PoolRealArray::Write safew = safe.write();
+		PoolRealArray::Write unsafew = unsafe.write();
+		cast_motion_batch(p_shape_query->shape, xforms.ptr(), motions.ptr(), count, p_shape_query->margin, safew.ptr(), unsafew.ptr(), p_shape_query->exclude, p_shape_query->collision_mask, p_shape_query->collide_with_bodies, p_shape_query->collide_with_areas, p_threaded);
+	}
+
+	Dictionary d;
+	d["safe"] = safe;
+	d["unsafe"] = unsafe;
+
+	return d;
+}
+
+int PhysicsDirectSpaceState::intersect_ray_batch(const Vector3 *p_from, const Vector3 *p_to, int p_count, RayResult *r_results, bool *r_hits, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_threaded) {
+
+	int hit_count = 0;
+	for (int i = 0; i < p_count; i++) {
+		r_hits[i] = intersect_ray(p_from[i], p_to[i], r_results[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+		if (r_hits[i])
+			hit_count++;
+	}
+	return hit_count;
+}
+
+int PhysicsDirectSpaceState::cast_motion_batch(const RID &p_shape, const Transform *p_xforms, const Vector3 *p_motions, int p_count, float p_margin, float *r_closest_safe, float *r_closest_unsafe, const Set<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, bool p_threaded) {
+
+	int blocked_count = 0;
+	for (int i = 0; i < p_count; i++) {
+		if (!cast_motion(p_shape, p_xforms[i], p_motions[i], p_margin, r_closest_safe[i], r_closest_unsafe[i], p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
+			// Stuck from the start.
+			r_closest_safe[i] = 0;
+			r_closest_unsafe[i] = 0;
+		}
+		if (r_closest_safe[i] < 1)
+			blocked_count++;
+	}
+	return blocked_count;
+}
+
 PhysicsDirectSpaceState::PhysicsDirectSpaceState() {
 }
 
@@ -366,6 +495,8 @@ void PhysicsDirectSpaceState::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("cast_motion", "shape", "motion"), &PhysicsDirectSpaceState::_cast_motion);
 	ClassDB::bind_method(D_METHOD("collide_shape", "shape", "max_results"), &PhysicsDirectSpaceState::_collide_shape, DEFVAL(32));
 	ClassDB::bind_method(D_METHOD("get_rest_info", "shape"), &PhysicsDirectSpaceState::_get_rest_info);
+	ClassDB::bind_method(D_METHOD("intersect_ray_batch", "from", "to", "exclude", "collision_mask", "collide_with_bodies", "collide_with_areas", "threaded"), &PhysicsDirectSpaceState::_intersect_ray_batch, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("cast_motion_batch", "shape", "origins", "motions", "threaded"), &PhysicsDirectSpaceState::_cast_motion_batch, DEFVAL(false));
 }
 
 int PhysicsShapeQueryResult::get_result_count() const {
@@ -295,6 +295,7 @@ public:
 	BIND2RC(Transform, skeleton_bone_get_transform, RID, int)
 	BIND3(skeleton_bone_set_transform_2d, RID, int, const Transform2D &)
 	BIND2RC(Transform2D, skeleton_bone_get_transform_2d, RID, int)
+	BIND2(skeleton_set_as_bulk_array, RID, const PoolVector<float> &)
 	BIND2(skeleton_set_base_transform_2d, RID, const Transform2D &)
 	BIND3(skeleton_set_world_transform, RID, bool, const Transform &)
 
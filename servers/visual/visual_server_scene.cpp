@@ -30,6 +30,7 @@
 
 #include "visual_server_scene.h"
 #include "core/os/os.h"
+#include "core/project_settings.h"
 #include "visual_server_globals.h"
 #include "visual_server_raster.h"
 #include <new>
@@ -102,7 +103,7 @@ void VisualServerScene::camera_set_use_vertical_aspect(RID p_camera, bool p_enab
 
 /* SCENARIO API */
 
-void *VisualServerScene::_instance_pair(void *p_self, OctreeElementID, Instance *p_A, int, OctreeElementID, Instance *p_B, int) {
+void *VisualServerScene::_instance_pair(void *p_self, SpatialPartitionID, Instance *p_A, int, SpatialPartitionID, Instance *p_B, int) {
 
 	//VisualServerScene *self = (VisualServerScene*)p_self;
 	Instance *A = p_A;
@@ -181,7 +182,7 @@ void *VisualServerScene::_instance_pair(void *p_self, OctreeElementID, Instance
 
 	return NULL;
 }
-void VisualServerScene::_instance_unpair(void *p_self, OctreeElementID, Instance *p_A, int, OctreeElementID, Instance *p_B, int, void *udata) {
+void VisualServerScene::_instance_unpair(void *p_self, SpatialPartitionID, Instance *p_A, int, SpatialPartitionID, Instance *p_B, int, void *udata) {
 
 	//VisualServerScene *self = (VisualServerScene*)p_self;
 	Instance *A = p_A;
@@ -250,6 +251,121 @@ void VisualServerScene::_instance_unpair(void *p_self, OctreeElementID, Instance
 	}
 }
 
+/* SPATIAL PARTITIONING */
+
+VisualServerScene::SpatialPartitionID VisualServerScene::SpatialPartitioningSceneOctree::create(Instance *p_userdata, const AABB &p_aabb, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+
+	return octree.create(p_userdata, p_aabb, 0, p_pairable, p_pairable_type, p_pairable_mask);
+}
+
+void VisualServerScene::SpatialPartitioningSceneOctree::erase(SpatialPartitionID p_id) {
+
+	octree.erase(p_id);
+}
+
+void VisualServerScene::SpatialPartitioningSceneOctree::move(SpatialPartitionID p_id, const AABB &p_aabb) {
+
+	octree.move(p_id, p_aabb);
+}
+
+void VisualServerScene::SpatialPartitioningSceneOctree::set_pairable(SpatialPartitionID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+
+	octree.set_pairable(p_id, p_pairable, p_pairable_type, p_pairable_mask);
+}
+
+int VisualServerScene::SpatialPartitioningSceneOctree::cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask) {
+
+	return octree.cull_convex(p_convex, p_result_array, p_result_max, p_mask);
+}
+
+int VisualServerScene::SpatialPartitioningSceneOctree::cull_convex_read_only(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask) const {
+
+	return octree.cull_convex_read_only(p_convex, p_result_array, p_result_max, p_mask);
+}
+
+int VisualServerScene::SpatialPartitioningSceneOctree::cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, uint32_t p_mask) {
+
+	return octree.cull_aabb(p_aabb, p_result_array, p_result_max, NULL, p_mask);
+}
+
+int VisualServerScene::SpatialPartitioningSceneOctree::cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, uint32_t p_mask) {
+
+	return octree.cull_segment(p_from, p_to, p_result_array, p_result_max, NULL, p_mask);
+}
+
+void VisualServerScene::SpatialPartitioningSceneOctree::set_pair_callback(PairCallback p_callback, void *p_userdata) {
+
+	octree.set_pair_callback(p_callback, p_userdata);
+}
+
+void VisualServerScene::SpatialPartitioningSceneOctree::set_unpair_callback(UnpairCallback p_callback, void *p_userdata) {
+
+	octree.set_unpair_callback(p_callback, p_userdata);
+}
+
+VisualServerScene::SpatialPartitioningSceneOctree::SpatialPartitioningSceneOctree() :
+		octree(true) {
+}
+
+VisualServerScene::SpatialPartitionID VisualServerScene::SpatialPartitioningSceneBVH::create(Instance *p_userdata, const AABB &p_aabb, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+
+	return bvh.create(p_userdata, p_aabb, 0, p_pairable, p_pairable_type, p_pairable_mask);
+}
+
+void VisualServerScene::SpatialPartitioningSceneBVH::erase(SpatialPartitionID p_id) {
+
+	bvh.erase(p_id);
+}
+
+void VisualServerScene::SpatialPartitioningSceneBVH::move(SpatialPartitionID p_id, const AABB &p_aabb) {
+
+	bvh.move(p_id, p_aabb);
+}
+
+void VisualServerScene::SpatialPartitioningSceneBVH::set_pairable(SpatialPartitionID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) {
+
+	bvh.set_pairable(p_id, p_pairable, p_pairable_type, p_pairable_mask);
+}
+
+void VisualServerScene::SpatialPartitioningSceneBVH::update() {
+
+	bvh.update();
+}
+
+int VisualServerScene::SpatialPartitioningSceneBVH::cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask) {
+
+	return bvh.cull_convex(p_convex, p_result_array, p_result_max, p_mask);
+}
+
+int VisualServerScene::SpatialPartitioningSceneBVH::cull_convex_read_only(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask) const {
+
+	return bvh.cull_convex(p_convex, p_result_array, p_result_max, p_mask);
+}
+
+int VisualServerScene::SpatialPartitioningSceneBVH::cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, uint32_t p_mask) {
+
+	return bvh.cull_aabb(p_aabb, p_result_array, p_result_max, NULL, p_mask);
+}
+
+int VisualServerScene::SpatialPartitioningSceneBVH::cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, uint32_t p_mask) {
+
+	return bvh.cull_segment(p_from, p_to, p_result_array, p_result_max, NULL, p_mask);
+}
+
+void VisualServerScene::SpatialPartitioningSceneBVH::set_pair_callback(PairCallback p_callback, void *p_userdata) {
+
+	bvh.set_pair_callback(p_callback, p_userdata);
+}
+
+void VisualServerScene::SpatialPartitioningSceneBVH::set_unpair_callback(UnpairCallback p_callback, void *p_userdata) {
+
+	bvh.set_unpair_callback(p_callback, p_userdata);
+}
+
+VisualServerScene::SpatialPartitioningSceneBVH::SpatialPartitioningSceneBVH(real_t p_fat_margin) :
+		bvh(p_fat_margin) {
+}
+
 RID VisualServerScene::scenario_create() {
 
 	Scenario *scenario = memnew(Scenario);
@@ -257,8 +373,14 @@ RID VisualServerScene::scenario_create() {
 	RID scenario_rid = scenario_owner.make_rid(scenario);
 	scenario->self = scenario_rid;
 
-	scenario->octree.set_pair_callback(_instance_pair, this);
-	scenario->octree.set_unpair_callback(_instance_unpair, this);
+	if (GLOBAL_GET("rendering/quality/spatial_partitioning/use_bvh")) {
+		scenario->sps = memnew(SpatialPartitioningSceneBVH(GLOBAL_GET("rendering/quality/spatial_partitioning/bvh_fat_margin")));
+	} else {
+		scenario->sps = memnew(SpatialPartitioningSceneOctree);
+	}
+
+	scenario->sps->set_pair_callback(_instance_pair, this);
+	scenario->sps->set_unpair_callback(_instance_unpair, this);
 	scenario->reflection_probe_shadow_atlas = VSG::scene_render->shadow_atlas_create();
 	VSG::scene_render->shadow_atlas_set_size(scenario->reflection_probe_shadow_atlas, 1024); //make enough shadows for close distance, don't bother with rest
 	VSG::scene_render->shadow_atlas_set_quadrant_subdivision(scenario->reflection_probe_shadow_atlas, 0, 4);
@@ -355,9 +477,9 @@ void VisualServerScene::instance_set_base(RID p_instance, RID p_base) {
 			}
 		}
 
-		if (scenario && instance->octree_id) {
-			scenario->octree.erase(instance->octree_id); //make dependencies generated by the octree go away
-			instance->octree_id = 0;
+		if (scenario && instance->spatial_partition_id) {
+			scenario->sps->erase(instance->spatial_partition_id); //make dependencies generated by the spatial index go away
+			instance->spatial_partition_id = 0;
 		}
 
 		switch (instance->base_type) {
@@ -508,9 +630,9 @@ void VisualServerScene::instance_set_scenario(RID p_instance, RID p_scenario) {
 
 		instance->scenario->instances.remove(&instance->scenario_item);
 
-		if (instance->octree_id) {
-			instance->scenario->octree.erase(instance->octree_id); //make dependencies generated by the octree go away
-			instance->octree_id = 0;
+		if (instance->spatial_partition_id) {
+			instance->scenario->sps->erase(instance->spatial_partition_id); //make dependencies generated by the spatial index go away
+			instance->spatial_partition_id = 0;
 		}
 
 		switch (instance->base_type) {
@@ -662,26 +784,26 @@ void VisualServerScene::instance_set_visible(RID p_instance, bool p_visible) {
 
 	switch (instance->base_type) {
 		case VS::INSTANCE_LIGHT: {
-			if (VSG::storage->light_get_type(instance->base) != VS::LIGHT_DIRECTIONAL && instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << VS::INSTANCE_LIGHT, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
+			if (VSG::storage->light_get_type(instance->base) != VS::LIGHT_DIRECTIONAL && instance->spatial_partition_id && instance->scenario) {
+				instance->scenario->sps->set_pairable(instance->spatial_partition_id, p_visible, 1 << VS::INSTANCE_LIGHT, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case VS::INSTANCE_REFLECTION_PROBE: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << VS::INSTANCE_REFLECTION_PROBE, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
+			if (instance->spatial_partition_id && instance->scenario) {
+				instance->scenario->sps->set_pairable(instance->spatial_partition_id, p_visible, 1 << VS::INSTANCE_REFLECTION_PROBE, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case VS::INSTANCE_LIGHTMAP_CAPTURE: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << VS::INSTANCE_LIGHTMAP_CAPTURE, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
+			if (instance->spatial_partition_id && instance->scenario) {
+				instance->scenario->sps->set_pairable(instance->spatial_partition_id, p_visible, 1 << VS::INSTANCE_LIGHTMAP_CAPTURE, p_visible ? VS::INSTANCE_GEOMETRY_MASK : 0);
 			}
 
 		} break;
 		case VS::INSTANCE_GI_PROBE: {
-			if (instance->octree_id && instance->scenario) {
-				instance->scenario->octree.set_pairable(instance->octree_id, p_visible, 1 << VS::INSTANCE_GI_PROBE, p_visible ? (VS::INSTANCE_GEOMETRY_MASK | (1 << VS::INSTANCE_LIGHT)) : 0);
+			if (instance->spatial_partition_id && instance->scenario) {
+				instance->scenario->sps->set_pairable(instance->spatial_partition_id, p_visible, 1 << VS::INSTANCE_GI_PROBE, p_visible ? (VS::INSTANCE_GEOMETRY_MASK | (1 << VS::INSTANCE_LIGHT)) : 0);
 			}
 
 		} break;
@@ -785,7 +907,7 @@ Vector<ObjectID> VisualServerScene::instances_cull_aabb(const AABB &p_aabb, RID
 
 	int culled = 0;
 	Instance *cull[1024];
-	culled = scenario->octree.cull_aabb(p_aabb, cull, 1024);
+	culled = scenario->sps->cull_aabb(p_aabb, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 
@@ -808,7 +930,7 @@ Vector<ObjectID> VisualServerScene::instances_cull_ray(const Vector3 &p_from, co
 
 	int culled = 0;
 	Instance *cull[1024];
-	culled = scenario->octree.cull_segment(p_from, p_from + p_to * 10000, cull, 1024);
+	culled = scenario->sps->cull_segment(p_from, p_from + p_to * 10000, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 		Instance *instance = cull[i];
@@ -831,7 +953,7 @@ Vector<ObjectID> VisualServerScene::instances_cull_convex(const Vector<Plane> &p
 	int culled = 0;
 	Instance *cull[1024];
 
-	culled = scenario->octree.cull_convex(p_convex, cull, 1024);
+	culled = scenario->sps->cull_convex(p_convex, cull, 1024);
 
 	for (int i = 0; i < culled; i++) {
 
@@ -960,7 +1082,7 @@ void VisualServerScene::_update_instance(Instance *p_instance) {
 		return;
 	}
 
-	if (p_instance->octree_id == 0) {
+	if (p_instance->spatial_partition_id == 0) {
 
 		uint32_t base_type = 1 << p_instance->base_type;
 		uint32_t pairable_mask = 0;
@@ -978,8 +1100,8 @@ void VisualServerScene::_update_instance(Instance *p_instance) {
 			pairable = true;
 		}
 
-		// not inside octree
-		p_instance->octree_id = p_instance->scenario->octree.create(p_instance, new_aabb, 0, pairable, base_type, pairable_mask);
+		// not inside the spatial index
+		p_instance->spatial_partition_id = p_instance->scenario->sps->create(p_instance, new_aabb, pairable, base_type, pairable_mask);
 
 	} else {
 
@@ -988,7 +1110,11 @@ void VisualServerScene::_update_instance(Instance *p_instance) {
 			return;
 		*/
 
-		p_instance->scenario->octree.move(p_instance->octree_id, new_aabb);
+		p_instance->scenario->sps->move(p_instance->spatial_partition_id, new_aabb);
+	}
+
+	if (!p_instance->scenario->update_item.in_list()) {
+		_scenario_update_list.add(&p_instance->scenario->update_item);
 	}
 }
 
@@ -1300,6 +1426,45 @@ void VisualServerScene::_update_instance_lightmap_captures(Instance *p_instance)
 	}
 }
 
+void VisualServerScene::_shadow_cull_job(uint32_t p_index, Scenario *p_scenario) {
+
+	ShadowCullJob &job = shadow_cull_jobs[p_index];
+	job.result_count = 0;
+	job.animated_material_found = false;
+
+	if (job.planes.empty()) {
+		return;
+	}
+
+	// Only reads the octree and the instances, several jobs can run at the same time.
+	int cull_count = p_scenario->sps->cull_convex_read_only(job.planes, job.result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
+
+	for (int j = 0; j < cull_count; j++) {
+
+		Instance *instance = job.result[j];
+		if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
+			cull_count--;
+			SWAP(job.result[j], job.result[cull_count]);
+			j--;
+		} else if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
+			job.animated_material_found = true;
+		}
+	}
+
+	job.result_count = cull_count;
+}
+
+void VisualServerScene::_cull_shadow_jobs(Scenario *p_scenario, int p_job_count) {
+
+	for (int i = 0; i < p_job_count; i++) {
+		if (!shadow_cull_jobs[i].result) {
+			shadow_cull_jobs[i].result = memnew_arr(Instance *, MAX_INSTANCE_CULL);
+		}
+	}
+
+	cull_work_pool.do_work(p_job_count, this, &VisualServerScene::_shadow_cull_job, p_scenario);
+}
+
 bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_shadow_atlas, Scenario *p_scenario) {
 
 	InstanceLightData *light = static_cast<InstanceLightData *>(p_instance->base_data);
@@ -1326,7 +1491,7 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 			if (depth_range_mode == VS::LIGHT_DIRECTIONAL_SHADOW_DEPTH_RANGE_OPTIMIZED) {
 				//optimize min/max
 				Vector<Plane> planes = p_cam_projection.get_projection_planes(p_cam_transform);
-				int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
+				int cull_count = p_scenario->sps->cull_convex_read_only(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
 				Plane base(p_cam_transform.origin, -p_cam_transform.basis.get_axis(2));
 				//check distance max and min
 
@@ -1389,8 +1554,28 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 			float first_radius = 0.0;
 
+			Transform transform = light_transform; //discard scale and stabilize light
+
+			Vector3 x_vec = transform.basis.get_axis(Vector3::AXIS_X).normalized();
+			Vector3 y_vec = transform.basis.get_axis(Vector3::AXIS_Y).normalized();
+			Vector3 z_vec = transform.basis.get_axis(Vector3::AXIS_Z).normalized();
+			//z_vec points agsint the camera, like in default opengl
+
+			struct SplitData {
+
+				float z_max;
+				float x_min_cam, x_max_cam;
+				float y_min_cam, y_max_cam;
+				float z_min_cam;
+				float bias_scale;
+			};
+
+			SplitData split_data[4];
+
 			for (int i = 0; i < splits; i++) {
 
+				shadow_cull_jobs[i].planes.clear(); // stays empty (nothing culled or rendered) if the split is invalid
+
 				// setup a camera matrix for that range!
 				CameraMatrix camera_matrix;
 
@@ -1415,13 +1600,6 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 				// obtain the light frustm ranges (given endpoints)
 
-				Transform transform = light_transform; //discard scale and stabilize light
-
-				Vector3 x_vec = transform.basis.get_axis(Vector3::AXIS_X).normalized();
-				Vector3 y_vec = transform.basis.get_axis(Vector3::AXIS_Y).normalized();
-				Vector3 z_vec = transform.basis.get_axis(Vector3::AXIS_Z).normalized();
-				//z_vec points agsint the camera, like in default opengl
-
 				float x_min = 0.f, x_max = 0.f;
 				float y_min = 0.f, y_max = 0.f;
 				float z_min = 0.f, z_max = 0.f;
@@ -1511,7 +1689,7 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 				//now that we now all ranges, we can proceed to make the light frustum planes, for culling octree
 
-				Vector<Plane> light_frustum_planes;
+				Vector<Plane> &light_frustum_planes = shadow_cull_jobs[i].planes;
 				light_frustum_planes.resize(6);
 
 				//right/left
@@ -1524,46 +1702,60 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 				light_frustum_planes.write[4] = Plane(z_vec, z_max + 1e6);
 				light_frustum_planes.write[5] = Plane(-z_vec, -z_min); // z_min is ok, since casters further than far-light plane are not needed
 
-				int cull_count = p_scenario->octree.cull_convex(light_frustum_planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
+				SplitData &split = split_data[i];
+				split.z_max = z_max;
+				split.x_min_cam = x_min_cam;
+				split.x_max_cam = x_max_cam;
+				split.y_min_cam = y_min_cam;
+				split.y_max_cam = y_max_cam;
+				split.z_min_cam = z_min_cam;
+				split.bias_scale = bias_scale;
+			}
+
+			_cull_shadow_jobs(p_scenario, splits);
 
-				// a pre pass will need to be needed to determine the actual z-near to be used
+			// a pre pass will need to be needed to determine the actual z-near to be used
 
-				Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
+			Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
 
-				for (int j = 0; j < cull_count; j++) {
+			for (int i = 0; i < splits; i++) {
+
+				const ShadowCullJob &job = shadow_cull_jobs[i];
+				if (job.planes.empty()) {
+					continue;
+				}
+
+				SplitData &split = split_data[i];
+
+				// depth is shared by all splits, so it's written right before each split is rendered
+				for (int j = 0; j < job.result_count; j++) {
 
 					float min, max;
-					Instance *instance = instance_shadow_cull_result[j];
-					if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-						cull_count--;
-						SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-						j--;
-						continue;
-					}
+					Instance *instance = job.result[j];
 
 					instance->transformed_aabb.project_range_in_plane(Plane(z_vec, 0), min, max);
 					instance->depth = near_plane.distance_to(instance->transform.origin);
 					instance->depth_layer = 0;
-					if (max > z_max)
-						z_max = max;
+					if (max > split.z_max)
+						split.z_max = max;
 				}
 
 				{
 
 					CameraMatrix ortho_camera;
-					real_t half_x = (x_max_cam - x_min_cam) * 0.5;
-					real_t half_y = (y_max_cam - y_min_cam) * 0.5;
+					real_t half_x = (split.x_max_cam - split.x_min_cam) * 0.5;
+					real_t half_y = (split.y_max_cam - split.y_min_cam) * 0.5;
 
-					ortho_camera.set_orthogonal(-half_x, half_x, -half_y, half_y, 0, (z_max - z_min_cam));
+					ortho_camera.set_orthogonal(-half_x, half_x, -half_y, half_y, 0, (split.z_max - split.z_min_cam));
 
 					Transform ortho_transform;
 					ortho_transform.basis = transform.basis;
-					ortho_transform.origin = x_vec * (x_min_cam + half_x) + y_vec * (y_min_cam + half_y) + z_vec * z_max;
+					ortho_transform.origin = x_vec * (split.x_min_cam + half_x) + y_vec * (split.y_min_cam + half_y) + z_vec * split.z_max;
 
-					VSG::scene_render->light_instance_set_shadow_transform(light->instance, ortho_camera, ortho_transform, 0, distances[i + 1], i, bias_scale);
+					VSG::scene_render->light_instance_set_shadow_transform(light->instance, ortho_camera, ortho_transform, 0, distances[i + 1], i, split.bias_scale);
 				}
 
-				VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+				VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)job.result, job.result_count);
 			}
 
 		} break;
@@ -1573,43 +1765,43 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 
 			if (shadow_mode == VS::LIGHT_OMNI_SHADOW_DUAL_PARABOLOID || !VSG::scene_render->light_instances_can_render_shadow_cube()) {
 
-				for (int i = 0; i < 2; i++) {
+				//using this one ensures that raster deferred will have it
 
-					//using this one ensures that raster deferred will have it
+				float radius = VSG::storage->light_get_param(p_instance->base, VS::LIGHT_PARAM_RANGE);
 
-					float radius = VSG::storage->light_get_param(p_instance->base, VS::LIGHT_PARAM_RANGE);
+				for (int i = 0; i < 2; i++) {
 
 					float z = i == 0 ? -1 : 1;
-					Vector<Plane> planes;
+					Vector<Plane> &planes = shadow_cull_jobs[i].planes;
 					planes.resize(5);
 					planes.write[0] = light_transform.xform(Plane(Vector3(0, 0, z), radius));
 					planes.write[1] = light_transform.xform(Plane(Vector3(1, 0, z).normalized(), radius));
 					planes.write[2] = light_transform.xform(Plane(Vector3(-1, 0, z).normalized(), radius));
 					planes.write[3] = light_transform.xform(Plane(Vector3(0, 1, z).normalized(), radius));
 					planes.write[4] = light_transform.xform(Plane(Vector3(0, -1, z).normalized(), radius));
+				}
 
-					int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
-					Plane near_plane(light_transform.origin, light_transform.basis.get_axis(2) * z);
+				_cull_shadow_jobs(p_scenario, 2);
 
-					for (int j = 0; j < cull_count; j++) {
+				for (int i = 0; i < 2; i++) {
 
-						Instance *instance = instance_shadow_cull_result[j];
-						if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-							cull_count--;
-							SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-							j--;
-						} else {
-							if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-								animated_material_found = true;
-							}
+					const ShadowCullJob &job = shadow_cull_jobs[i];
+					if (job.animated_material_found) {
+						animated_material_found = true;
+					}
 
-							instance->depth = near_plane.distance_to(instance->transform.origin);
-							instance->depth_layer = 0;
-						}
+					float z = i == 0 ? -1 : 1;
+					Plane near_plane(light_transform.origin, light_transform.basis.get_axis(2) * z);
+
+					for (int j = 0; j < job.result_count; j++) {
+
+						Instance *instance = job.result[j];
+						instance->depth = near_plane.distance_to(instance->transform.origin);
+						instance->depth_layer = 0;
 					}
 
 					VSG::scene_render->light_instance_set_shadow_transform(light->instance, CameraMatrix(), light_transform, radius, 0, i);
-					VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+					VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)job.result, job.result_count);
 				}
 			} else { //shadow cube
 
@@ -1617,52 +1809,53 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 				CameraMatrix cm;
 				cm.set_perspective(90, 1, 0.01, radius);
 
+				static const Vector3 view_normals[6] = {
+					Vector3(-1, 0, 0),
+					Vector3(+1, 0, 0),
+					Vector3(0, -1, 0),
+					Vector3(0, +1, 0),
+					Vector3(0, 0, -1),
+					Vector3(0, 0, +1)
+				};
+				static const Vector3 view_up[6] = {
+					Vector3(0, -1, 0),
+					Vector3(0, -1, 0),
+					Vector3(0, 0, -1),
+					Vector3(0, 0, +1),
+					Vector3(0, -1, 0),
+					Vector3(0, -1, 0)
+				};
+
+				Transform xforms[6];
+
 				for (int i = 0; i < 6; i++) {
 
 					//using this one ensures that raster deferred will have it
 
-					static const Vector3 view_normals[6] = {
-						Vector3(-1, 0, 0),
-						Vector3(+1, 0, 0),
-						Vector3(0, -1, 0),
-						Vector3(0, +1, 0),
-						Vector3(0, 0, -1),
-						Vector3(0, 0, +1)
-					};
-					static const Vector3 view_up[6] = {
-						Vector3(0, -1, 0),
-						Vector3(0, -1, 0),
-						Vector3(0, 0, -1),
-						Vector3(0, 0, +1),
-						Vector3(0, -1, 0),
-						Vector3(0, -1, 0)
-					};
-
-					Transform xform = light_transform * Transform().looking_at(view_normals[i], view_up[i]);
-
-					Vector<Plane> planes = cm.get_projection_planes(xform);
-
-					int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
-
-					Plane near_plane(xform.origin, -xform.basis.get_axis(2));
-					for (int j = 0; j < cull_count; j++) {
-
-						Instance *instance = instance_shadow_cull_result[j];
-						if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-							cull_count--;
-							SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-							j--;
-						} else {
-							if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-								animated_material_found = true;
-							}
-							instance->depth = near_plane.distance_to(instance->transform.origin);
-							instance->depth_layer = 0;
-						}
+					xforms[i] = light_transform * Transform().looking_at(view_normals[i], view_up[i]);
+					shadow_cull_jobs[i].planes = cm.get_projection_planes(xforms[i]);
+				}
+
+				_cull_shadow_jobs(p_scenario, 6);
+
+				for (int i = 0; i < 6; i++) {
+
+					const ShadowCullJob &job = shadow_cull_jobs[i];
+					if (job.animated_material_found) {
+						animated_material_found = true;
+					}
+
+					Plane near_plane(xforms[i].origin, -xforms[i].basis.get_axis(2));
+
+					for (int j = 0; j < job.result_count; j++) {
+
+						Instance *instance = job.result[j];
+						instance->depth = near_plane.distance_to(instance->transform.origin);
+						instance->depth_layer = 0;
 					}
 
-					VSG::scene_render->light_instance_set_shadow_transform(light->instance, cm, xform, radius, 0, i);
-					VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+					VSG::scene_render->light_instance_set_shadow_transform(light->instance, cm, xforms[i], radius, 0, i);
+					VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, i, (RasterizerScene::InstanceBase **)job.result, job.result_count);
 				}
 
 				//restore the regular DP matrix
@@ -1678,28 +1871,24 @@ bool VisualServerScene::_light_instance_update_shadow(Instance *p_instance, cons
 			CameraMatrix cm;
 			cm.set_perspective(angle * 2.0, 1.0, 0.01, radius);
 
-			Vector<Plane> planes = cm.get_projection_planes(light_transform);
-			int cull_count = p_scenario->octree.cull_convex(planes, instance_shadow_cull_result, MAX_INSTANCE_CULL, VS::INSTANCE_GEOMETRY_MASK);
+			shadow_cull_jobs[0].planes = cm.get_projection_planes(light_transform);
+			_cull_shadow_jobs(p_scenario, 1);
+
+			const ShadowCullJob &job = shadow_cull_jobs[0];
+			if (job.animated_material_found) {
+				animated_material_found = true;
+			}
 
 			Plane near_plane(light_transform.origin, -light_transform.basis.get_axis(2));
-			for (int j = 0; j < cull_count; j++) {
+			for (int j = 0; j < job.result_count; j++) {
 
-				Instance *instance = instance_shadow_cull_result[j];
-				if (!instance->visible || !((1 << instance->base_type) & VS::INSTANCE_GEOMETRY_MASK) || !static_cast<InstanceGeometryData *>(instance->base_data)->can_cast_shadows) {
-					cull_count--;
-					SWAP(instance_shadow_cull_result[j], instance_shadow_cull_result[cull_count]);
-					j--;
-				} else {
-					if (static_cast<InstanceGeometryData *>(instance->base_data)->material_is_animated) {
-						animated_material_found = true;
-					}
-					instance->depth = near_plane.distance_to(instance->transform.origin);
-					instance->depth_layer = 0;
-				}
+				Instance *instance = job.result[j];
+				instance->depth = near_plane.distance_to(instance->transform.origin);
+				instance->depth_layer = 0;
 			}
 
 			VSG::scene_render->light_instance_set_shadow_transform(light->instance, cm, light_transform, radius, 0, 0);
-			VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, 0, (RasterizerScene::InstanceBase **)instance_shadow_cull_result, cull_count);
+			VSG::scene_render->render_shadow(light->instance, p_shadow_atlas, 0, (RasterizerScene::InstanceBase **)job.result, job.result_count);
 
 		} break;
 	}
@@ -1842,6 +2031,81 @@ void VisualServerScene::render_camera(Ref<ARVRInterface> &p_interface, ARVRInter
 	_render_scene(cam_transform, camera_matrix, false, camera->env, p_scenario, p_shadow_atlas, RID(), -1);
 };
 
+void VisualServerScene::_camera_cull_job(uint32_t p_index, const CameraCullParams *p_params) {
+
+	int from = p_index * CAMERA_CULL_CHUNK_SIZE;
+	int to = MIN(from + CAMERA_CULL_CHUNK_SIZE, instance_cull_count);
+
+	for (int i = from; i < to; i++) {
+
+		Instance *ins = instance_cull_result[i];
+
+		if ((p_params->layer_mask & ins->layer_mask) == 0 || !ins->visible) {
+
+			instance_cull_state[i] = CAMERA_CULL_DISCARD;
+		} else if (ins->base_type == VS::INSTANCE_LIGHT || ins->base_type == VS::INSTANCE_REFLECTION_PROBE || ins->base_type == VS::INSTANCE_GI_PROBE) {
+
+			instance_cull_state[i] = CAMERA_CULL_SERIAL;
+		} else if (((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) && ins->cast_shadows != VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY) {
+
+			instance_cull_state[i] = CAMERA_CULL_GEOMETRY;
+
+			InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(ins->base_data);
+
+			if (geom->lighting_dirty) {
+				int l = 0;
+				//only called when lights AABB enter/exit this geometry
+				ins->light_instances.resize(geom->lighting.size());
+
+				for (List<Instance *>::Element *E = geom->lighting.front(); E; E = E->next()) {
+
+					InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
+
+					ins->light_instances.write[l++] = light->instance;
+				}
+
+				geom->lighting_dirty = false;
+			}
+
+			if (geom->reflection_dirty) {
+				int l = 0;
+				//only called when reflection probe AABB enter/exit this geometry
+				ins->reflection_probe_instances.resize(geom->reflection_probes.size());
+
+				for (List<Instance *>::Element *E = geom->reflection_probes.front(); E; E = E->next()) {
+
+					InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(E->get()->base_data);
+
+					ins->reflection_probe_instances.write[l++] = reflection_probe->instance;
+				}
+
+				geom->reflection_dirty = false;
+			}
+
+			if (geom->gi_probes_dirty) {
+				int l = 0;
+				//only called when reflection probe AABB enter/exit this geometry
+				ins->gi_probe_instances.resize(geom->gi_probes.size());
+
+				for (List<Instance *>::Element *E = geom->gi_probes.front(); E; E = E->next()) {
+
+					InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(E->get()->base_data);
+
+					ins->gi_probe_instances.write[l++] = gi_probe->probe_instance;
+				}
+
+				geom->gi_probes_dirty = false;
+			}
+
+			ins->depth = p_params->near_plane.distance_to(ins->transform.origin);
+			ins->depth_layer = CLAMP(int(ins->depth * 16 / p_params->z_far), 0, 15);
+		} else {
+
+			instance_cull_state[i] = CAMERA_CULL_DISCARD;
+		}
+	}
+}
+
 void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const CameraMatrix &p_cam_projection, bool p_cam_orthogonal, RID p_force_environment, uint32_t p_visible_layers, RID p_scenario, RID p_shadow_atlas, RID p_reflection_probe) {
 	// Note, in stereo rendering:
 	// - p_cam_transform will be a transform in the middle of our two eyes
@@ -1862,7 +2126,7 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 	float z_far = p_cam_projection.get_z_far();
 
 	/* STEP 2 - CULL */
-	instance_cull_count = scenario->octree.cull_convex(planes, instance_cull_result, MAX_INSTANCE_CULL);
+	instance_cull_count = scenario->sps->cull_convex(planes, instance_cull_result, MAX_INSTANCE_CULL);
 	light_cull_count = 0;
 
 	reflection_probe_cull_count = 0;
@@ -1881,16 +2145,23 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 
 	/* STEP 4 - REMOVE FURTHER CULLED OBJECTS, ADD LIGHTS */
 
+	CameraCullParams cull_params;
+	cull_params.layer_mask = camera_layer_mask;
+	cull_params.near_plane = near_plane;
+	cull_params.z_far = z_far;
+
+	cull_work_pool.do_work((instance_cull_count + CAMERA_CULL_CHUNK_SIZE - 1) / CAMERA_CULL_CHUNK_SIZE, this, &VisualServerScene::_camera_cull_job, &cull_params);
+
 	for (int i = 0; i < instance_cull_count; i++) {
 
 		Instance *ins = instance_cull_result[i];
 
 		bool keep = false;
 
-		if ((camera_layer_mask & ins->layer_mask) == 0) {
+		if (instance_cull_state[i] == CAMERA_CULL_DISCARD) {
 
 			//failure
-		} else if (ins->base_type == VS::INSTANCE_LIGHT && ins->visible) {
+		} else if (ins->base_type == VS::INSTANCE_LIGHT) {
 
 			if (light_cull_count < MAX_LIGHTS_CULLED) {
 
@@ -1907,7 +2178,7 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 					light_cull_count++;
 				}
 			}
-		} else if (ins->base_type == VS::INSTANCE_REFLECTION_PROBE && ins->visible) {
+		} else if (ins->base_type == VS::INSTANCE_REFLECTION_PROBE) {
 
 			if (reflection_probe_cull_count < MAX_REFLECTION_PROBES_CULLED) {
 
@@ -1936,19 +2207,18 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 				}
 			}
 
-		} else if (ins->base_type == VS::INSTANCE_GI_PROBE && ins->visible) {
+		} else if (ins->base_type == VS::INSTANCE_GI_PROBE) {
 
 			InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(ins->base_data);
 			if (!gi_probe->update_element.in_list()) {
 				gi_probe_update_list.add(&gi_probe->update_element);
 			}
 
-		} else if (((1 << ins->base_type) & VS::INSTANCE_GEOMETRY_MASK) && ins->visible && ins->cast_shadows != VS::SHADOW_CASTING_SETTING_SHADOWS_ONLY) {
+		} else {
+			//geometry, already prepared by the cull job
 
 			keep = true;
 
-			InstanceGeometryData *geom = static_cast<InstanceGeometryData *>(ins->base_data);
-
 			if (ins->redraw_if_visible) {
 				VisualServerRaster::redraw_request();
 			}
@@ -1964,60 +2234,13 @@ void VisualServerScene::_prepare_scene(const Transform p_cam_transform, const Ca
 					VisualServerRaster::redraw_request();
 				}
 			}
-
-			if (geom->lighting_dirty) {
-				int l = 0;
-				//only called when lights AABB enter/exit this geometry
-				ins->light_instances.resize(geom->lighting.size());
-
-				for (List<Instance *>::Element *E = geom->lighting.front(); E; E = E->next()) {
-
-					InstanceLightData *light = static_cast<InstanceLightData *>(E->get()->base_data);
-
-					ins->light_instances.write[l++] = light->instance;
-				}
-
-				geom->lighting_dirty = false;
-			}
-
-			if (geom->reflection_dirty) {
-				int l = 0;
-				//only called when reflection probe AABB enter/exit this geometry
-				ins->reflection_probe_instances.resize(geom->reflection_probes.size());
-
-				for (List<Instance *>::Element *E = geom->reflection_probes.front(); E; E = E->next()) {
-
-					InstanceReflectionProbeData *reflection_probe = static_cast<InstanceReflectionProbeData *>(E->get()->base_data);
-
-					ins->reflection_probe_instances.write[l++] = reflection_probe->instance;
-				}
-
-				geom->reflection_dirty = false;
-			}
-
-			if (geom->gi_probes_dirty) {
-				int l = 0;
-				//only called when reflection probe AABB enter/exit this geometry
-				ins->gi_probe_instances.resize(geom->gi_probes.size());
-
-				for (List<Instance *>::Element *E = geom->gi_probes.front(); E; E = E->next()) {
-
-					InstanceGIProbeData *gi_probe = static_cast<InstanceGIProbeData *>(E->get()->base_data);
-
-					ins->gi_probe_instances.write[l++] = gi_probe->probe_instance;
-				}
-
-				geom->gi_probes_dirty = false;
-			}
-
-			ins->depth = near_plane.distance_to(ins->transform.origin);
-			ins->depth_layer = CLAMP(int(ins->depth * 16 / z_far), 0, 15);
 		}
 
 		if (!keep) {
 			// remove, no reason to keep
 			instance_cull_count--;
 			SWAP(instance_cull_result[i], instance_cull_result[instance_cull_count]);
+			SWAP(instance_cull_state[i], instance_cull_state[instance_cull_count]);
 			i--;
 			ins->last_render_pass = 0; // make invalid
 		} else {
@@ -3460,9 +3683,20 @@ void VisualServerScene::update_dirty_instances() {
 
 	VSG::storage->update_dirty_resources();
 
-	while (_instance_update_list.first()) {
+	while (_instance_update_list.first() || _scenario_update_list.first()) {
+
+		while (_instance_update_list.first()) {
 
-		_update_dirty_instance(_instance_update_list.first()->self());
+			_update_dirty_instance(_instance_update_list.first()->self());
+		}
+
+		// Spatial indices may apply moves and pair instances in a batch, pairing can queue more instance updates.
+		while (_scenario_update_list.first()) {
+
+			Scenario *scenario = _scenario_update_list.first()->self();
+			_scenario_update_list.remove(&scenario->update_item);
+			scenario->sps->update();
+		}
 	}
 }
 
@@ -3522,12 +3756,34 @@ VisualServerScene::VisualServerScene() {
 	probe_bake_thread_exit = false;
 #endif
 
+	shadow_cull_jobs[0].result = instance_shadow_cull_result;
+	for (int i = 1; i < MAX_SHADOW_CULL_JOBS; i++) {
+		shadow_cull_jobs[i].result = NULL; // allocated on first use, most lights only need one or two
+	}
+
+	GLOBAL_DEF("rendering/quality/spatial_partitioning/use_bvh", false);
+	GLOBAL_DEF("rendering/quality/spatial_partitioning/bvh_fat_margin", 0.1);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/quality/spatial_partitioning/bvh_fat_margin", PropertyInfo(Variant::REAL, "rendering/quality/spatial_partitioning/bvh_fat_margin", PROPERTY_HINT_RANGE, "0,10,0.01"));
+
+	int threads = GLOBAL_DEF("rendering/threads/culling_threads", 1);
+	ProjectSettings::get_singleton()->set_custom_property_info("rendering/threads/culling_threads", PropertyInfo(Variant::INT, "rendering/threads/culling_threads", PROPERTY_HINT_RANGE, "0,64,1"));
+	//0 means one thread per logical core
+	cull_work_pool.init(threads > 0 ? threads : -1);
+
 	render_pass = 1;
 	singleton = this;
 }
 
 VisualServerScene::~VisualServerScene() {
 
+	cull_work_pool.finish();
+
+	for (int i = 1; i < MAX_SHADOW_CULL_JOBS; i++) {
+		if (shadow_cull_jobs[i].result) {
+			memdelete_arr(shadow_cull_jobs[i].result);
+		}
+	}
+
 #ifndef NO_THREADS
 	probe_bake_thread_exit = true;
 	probe_bake_sem->post();
@@ -33,10 +33,12 @@
 
 #include "servers/visual/rasterizer.h"
 
+#include "core/math/dynamic_bvh.h"
 #include "core/math/geometry.h"
 #include "core/math/octree.h"
 #include "core/os/semaphore.h"
 #include "core/os/thread.h"
+#include "core/os/thread_work_pool.h"
 #include "core/self_list.h"
 #include "servers/arvr/arvr_interface.h"
 
@@ -49,6 +51,7 @@ public:
 		MAX_REFLECTION_PROBES_CULLED = 4096,
 		MAX_ROOM_CULL = 32,
 		MAX_EXTERIOR_PORTALS = 128,
+		MAX_SHADOW_CULL_JOBS = 6, // one per cube map face
 	};
 
 	uint64_t render_pass;
@@ -119,12 +122,83 @@ public:
 
 	struct Instance;
 
+	typedef uint32_t SpatialPartitionID;
+
+	// Spatial index of a scenario, used for culling and for pairing geometry with lights and probes.
+	class SpatialPartitioningScene {
+	public:
+		typedef void *(*PairCallback)(void *, SpatialPartitionID, Instance *, int, SpatialPartitionID, Instance *, int);
+		typedef void (*UnpairCallback)(void *, SpatialPartitionID, Instance *, int, SpatialPartitionID, Instance *, int, void *);
+
+		virtual SpatialPartitionID create(Instance *p_userdata, const AABB &p_aabb, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) = 0;
+		virtual void erase(SpatialPartitionID p_id) = 0;
+		virtual void move(SpatialPartitionID p_id, const AABB &p_aabb) = 0;
+		virtual void set_pairable(SpatialPartitionID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask) = 0;
+		virtual void update() {} // called once all dirty instances have been updated, before culling
+
+		virtual int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) = 0;
+		// Can be called from several threads at the same time.
+		virtual int cull_convex_read_only(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) const = 0;
+		virtual int cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) = 0;
+		virtual int cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) = 0;
+
+		virtual void set_pair_callback(PairCallback p_callback, void *p_userdata) = 0;
+		virtual void set_unpair_callback(UnpairCallback p_callback, void *p_userdata) = 0;
+
+		virtual ~SpatialPartitioningScene() {}
+	};
+
+	class SpatialPartitioningSceneOctree : public SpatialPartitioningScene {
+
+		Octree<Instance, true> octree;
+
+	public:
+		virtual SpatialPartitionID create(Instance *p_userdata, const AABB &p_aabb, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask);
+		virtual void erase(SpatialPartitionID p_id);
+		virtual void move(SpatialPartitionID p_id, const AABB &p_aabb);
+		virtual void set_pairable(SpatialPartitionID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask);
+
+		virtual int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+		virtual int cull_convex_read_only(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) const;
+		virtual int cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+		virtual int cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+
+		virtual void set_pair_callback(PairCallback p_callback, void *p_userdata);
+		virtual void set_unpair_callback(UnpairCallback p_callback, void *p_userdata);
+
+		SpatialPartitioningSceneOctree();
+	};
+
+	// Cheaper to update than the octree when many instances move every frame, moves are applied in update().
+	class SpatialPartitioningSceneBVH : public SpatialPartitioningScene {
+
+		DynamicBVH<Instance, true> bvh;
+
+	public:
+		virtual SpatialPartitionID create(Instance *p_userdata, const AABB &p_aabb, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask);
+		virtual void erase(SpatialPartitionID p_id);
+		virtual void move(SpatialPartitionID p_id, const AABB &p_aabb);
+		virtual void set_pairable(SpatialPartitionID p_id, bool p_pairable, uint32_t p_pairable_type, uint32_t p_pairable_mask);
+		virtual void update();
+
+		virtual int cull_convex(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+		virtual int cull_convex_read_only(const Vector<Plane> &p_convex, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF) const;
+		virtual int cull_aabb(const AABB &p_aabb, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+		virtual int cull_segment(const Vector3 &p_from, const Vector3 &p_to, Instance **p_result_array, int p_result_max, uint32_t p_mask = 0xFFFFFFFF);
+
+		virtual void set_pair_callback(PairCallback p_callback, void *p_userdata);
+		virtual void set_unpair_callback(UnpairCallback p_callback, void *p_userdata);
+
+		SpatialPartitioningSceneBVH(real_t p_fat_margin);
+	};
+
 	struct Scenario : RID_Data {
 
 		VS::ScenarioDebugMode debug;
 		RID self;
 
-		Octree<Instance, true> octree;
+		SpatialPartitioningScene *sps;
+		SelfList<Scenario> update_item;
 
 		List<Instance *> directional_lights;
 		RID environment;
@@ -134,13 +208,24 @@ public:
 
 		SelfList<Instance>::List instances;
 
-		Scenario() { debug = VS::SCENARIO_DEBUG_DISABLED; }
+		Scenario() :
+				update_item(this) {
+			debug = VS::SCENARIO_DEBUG_DISABLED;
+			sps = NULL;
+		}
+
+		~Scenario() {
+			if (sps) {
+				memdelete(sps);
+			}
+		}
 	};
 
 	mutable RID_Owner<Scenario> scenario_owner;
+	SelfList<Scenario>::List _scenario_update_list;
 
-	static void *_instance_pair(void *p_self, OctreeElementID, Instance *p_A, int, OctreeElementID, Instance *p_B, int);
-	static void _instance_unpair(void *p_self, OctreeElementID, Instance *p_A, int, OctreeElementID, Instance *p_B, int, void *);
+	static void *_instance_pair(void *p_self, SpatialPartitionID, Instance *p_A, int, SpatialPartitionID, Instance *p_B, int);
+	static void _instance_unpair(void *p_self, SpatialPartitionID, Instance *p_A, int, SpatialPartitionID, Instance *p_B, int, void *);
 
 	virtual RID scenario_create();
 
@@ -160,7 +245,7 @@ public:
 
 		RID self;
 		//scenario stuff
-		OctreeElementID octree_id;
+		SpatialPartitionID spatial_partition_id;
 		Scenario *scenario;
 		SelfList<Instance> scenario_item;
 
@@ -203,7 +288,7 @@ public:
 				scenario_item(this),
 				update_item(this) {
 
-			octree_id = 0;
+			spatial_partition_id = 0;
 			scenario = NULL;
 
 			update_aabb = false;
@@ -448,6 +533,44 @@ public:
 	RID reflection_probe_instance_cull_result[MAX_REFLECTION_PROBES_CULLED];
 	int reflection_probe_cull_count;
 
+	// Shadow splits and cube faces are culled in parallel, each job into its own result array.
+	struct ShadowCullJob {
+
+		Vector<Plane> planes;
+		Instance **result;
+		int result_count;
+		bool animated_material_found;
+	};
+
+	ShadowCullJob shadow_cull_jobs[MAX_SHADOW_CULL_JOBS];
+	ThreadWorkPool cull_work_pool;
+
+	void _shadow_cull_job(uint32_t p_index, Scenario *p_scenario);
+	void _cull_shadow_jobs(Scenario *p_scenario, int p_job_count);
+
+	// The camera cull result is classified in parallel, in chunks. Geometry is fully prepared there,
+	// lights and probes touch shared lists and are left to the serial pass that follows.
+	enum {
+		CAMERA_CULL_CHUNK_SIZE = 256
+	};
+
+	enum CameraCullState {
+		CAMERA_CULL_DISCARD,
+		CAMERA_CULL_GEOMETRY,
+		CAMERA_CULL_SERIAL
+	};
+
+	struct CameraCullParams {
+
+		uint32_t layer_mask;
+		Plane near_plane;
+		float z_far;
+	};
+
+	uint8_t instance_cull_state[MAX_INSTANCE_CULL];
+
+	void _camera_cull_job(uint32_t p_index, const CameraCullParams *p_params);
+
 	RID_Owner<Instance> instance_owner;
 
 	// from can be mesh, light,  area and portal so far.
@@ -231,6 +231,7 @@ public:
 	FUNC2RC(Transform, skeleton_bone_get_transform, RID, int)
 	FUNC3(skeleton_bone_set_transform_2d, RID, int, const Transform2D &)
 	FUNC2RC(Transform2D, skeleton_bone_get_transform_2d, RID, int)
+	FUNC2(skeleton_set_as_bulk_array, RID, const PoolVector<float> &)
 	FUNC2(skeleton_set_base_transform_2d, RID, const Transform2D &)
 	FUNC3(skeleton_set_world_transform, RID, bool, const Transform &)
 